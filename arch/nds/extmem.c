@@ -405,4 +405,7 @@ void set_current_board_ext(struct world *mzx_world, struct board *cur_board)
   set_current_board(mzx_world, cur_board);
   if(has_extmem)
     retrieve_board_from_extram(cur_board);
+
+  if(cur_board->is_lazy)
+    load_board_lazy(mzx_world, cur_board);
 }
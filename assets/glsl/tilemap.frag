@@ -27,8 +27,6 @@
 #define TEX_DATA_WIDTH    512.0
 #define TEX_DATA_HEIGHT   1024.0
 #define TEX_DATA_PAL_Y    896.0
-#define TEX_DATA_LAYER_X  0.0
-#define TEX_DATA_LAYER_Y  901.0
 
 // This has to be slightly less than 14.0 to avoid propagating error
 // with some very old driver/video card combos.
@@ -38,6 +36,11 @@ uniform sampler2D baseMap;
 
 varying vec2 vTexcoord;
 
+// Where this layer's data starts in the texture (x, y) and its transparent
+// color (z), or -1 if it doesn't have one. Layers are drawn in batches, so
+// these are given per vertex instead of as uniforms.
+varying vec3 vLayer;
+
 float fract_(float v)
 {
   return clamp(fract(v + 0.001) - 0.001, 0.000, 0.999);
@@ -99,8 +102,8 @@ void main(void)
    * Get the packed char/color data for this position from the current layer.
    * vTexcoord will be provided in the range of x=[0..layer.w), y=[0..layer.h).
    */
-  float layer_x = (vTexcoord.x + TEX_DATA_LAYER_X) / TEX_DATA_WIDTH;
-  float layer_y = (vTexcoord.y + TEX_DATA_LAYER_Y) / TEX_DATA_HEIGHT;
+  float layer_x = (floor_(vTexcoord.x) + vLayer.x + 0.5) / TEX_DATA_WIDTH;
+  float layer_y = (floor_(vTexcoord.y) + vLayer.y + 0.5) / TEX_DATA_HEIGHT;
   vec4 layer_data = texture2D(baseMap, vec2(layer_x, layer_y));
 
   /**
@@ -136,6 +139,13 @@ void main(void)
     color = layer_get_bg_color(layer_data);
   }
 
-  gl_FragColor = texture2D(baseMap,
-   vec2(color, TEX_DATA_PAL_Y / TEX_DATA_HEIGHT));
+  if(abs(color * TEX_DATA_WIDTH - vLayer.z) < 0.5)
+  {
+    gl_FragColor = vec4(0.0, 0.0, 0.0, 0.0);
+  }
+  else
+  {
+    gl_FragColor = texture2D(baseMap,
+     vec2(color, TEX_DATA_PAL_Y / TEX_DATA_HEIGHT));
+  }
 }
@@ -26,14 +26,17 @@ uniform sampler2D baseMap;
 
 varying vec2 vTexcoord;
 
+// Where this layer's data starts in the texture (x, y) and its transparent
+// color (z), or -1 if it doesn't have one. Layers are drawn in batches, so
+// these are given per vertex instead of as uniforms.
+varying vec3 vLayer;
+
 // Keep these the same as in render_glsl.c
 #define CHARSET_COLS      64.0
 #define TEX_DATA_WIDTH    512.0
 #define TEX_DATA_HEIGHT   1024.0
 #define TEX_DATA_PAL_Y    896.0
 #define TEX_DATA_IDX_Y    897.0
-#define TEX_DATA_LAYER_X  0.0
-#define TEX_DATA_LAYER_Y  901.0
 
 #define COLOR_TRANSPARENT (272.0 - 0.001)
 #define PIXEL_X           1.0 / TEX_DATA_WIDTH
@@ -111,8 +114,8 @@ void main( void )
    * Get the packed char/color data for this position from the current layer.
    * vTexcoord will be provided in the range of x=[0..layer.w), y=[0..layer.h).
    */
-  float layer_x = (vTexcoord.x + TEX_DATA_LAYER_X) / TEX_DATA_WIDTH;
-  float layer_y = (vTexcoord.y + TEX_DATA_LAYER_Y) / TEX_DATA_HEIGHT;
+  float layer_x = (floor_(vTexcoord.x) + vLayer.x + 0.5) / TEX_DATA_WIDTH;
+  float layer_y = (floor_(vTexcoord.y) + vLayer.y + 0.5) / TEX_DATA_HEIGHT;
   vec4 layer_data = texture2D(baseMap, vec2(layer_x, layer_y));
 
   float fg_color = layer_get_fg_color(layer_data);
@@ -195,7 +198,14 @@ void main( void )
     // NOTE: This must use the x component.
     float real_col = texture2D(baseMap, vec2(smzx_tex_x, smzx_tex_y)).x * 255.001;
 
-    gl_FragColor = texture2D(baseMap,
-     vec2(real_col / TEX_DATA_WIDTH, TEX_DATA_PAL_Y / TEX_DATA_HEIGHT));
+    if(abs(real_col - vLayer.z) < 0.5)
+    {
+      gl_FragColor = vec4(0.0, 0.0, 0.0, 0.0);
+    }
+    else
+    {
+      gl_FragColor = texture2D(baseMap,
+       vec2(real_col / TEX_DATA_WIDTH, TEX_DATA_PAL_Y / TEX_DATA_HEIGHT));
+    }
   }
 }
@@ -23,11 +23,14 @@
 
 attribute vec2 Position;
 attribute vec2 Texcoord;
+attribute vec3 Layer;
 
 varying vec2 vTexcoord;
+varying vec3 vLayer;
 
 void main(void)
 {
   gl_Position = vec4(Position.x, Position.y, 0.0, 1.0);
   vTexcoord = Texcoord;
+  vLayer = Layer;
 }
@@ -74,6 +74,7 @@ usage() {
 	echo "  --disable-counter-hash  Disables hash tables for counter/string lookups."
 	echo "  --enable-meter          Enable load/save meter display."
 	echo "  --enable-debytecode     Enable experimental 'debytecode' transform."
+	echo "  --enable-predecode      Enable pre-decoded Robotic command records."
 	echo
 	echo "Graphics options:"
 	echo "  --disable-software      Disable software renderer."
@@ -83,6 +84,7 @@ usage() {
 	echo "  --disable-gl-prog       Disable GL renderers for programmable h/w."
 	echo "  --disable-overlay       Disable SDL 1.2 overlay renderers."
 	echo "  --enable-gp2x           Enables half-res software renderer."
+	echo "  --disable-headless      Disable headless (in-memory) renderer."
 	echo "  --disable-libpng        Disable PNG screendump support."
 	echo "  --disable-screenshots   Disable the screenshot hotkey."
 	echo "  --enable-fps            Enable frames-per-second counter."
@@ -145,6 +147,7 @@ GL_FIXED="true"
 GL_PROGRAM="true"
 OVERLAY="true"
 GP2X="false"
+HEADLESS="true"
 SCREENSHOTS="true"
 XMP="true"
 MODPLUG="false"
@@ -167,6 +170,7 @@ GLES="false"
 CHECK_ALLOC="true"
 COUNTER_HASH="true"
 DEBYTECODE="false"
+PREDECODE="false"
 LIBSDL2="true"
 TRACE_LOGGING="false"
 STDIO_REDIRECT="false"
@@ -306,6 +310,9 @@ while [ "$1" != "" ]; do
 	[ "$1" = "--disable-gp2x" ] && GP2X="false"
 	[ "$1" = "--enable-gp2x" ]  && GP2X="true"
 
+	[ "$1" = "--disable-headless" ] && HEADLESS="false"
+	[ "$1" = "--enable-headless" ]  && HEADLESS="true"
+
 	[ "$1" = "--disable-screenshots" ] && SCREENSHOTS="false"
 	[ "$1" = "--enable-screenshots" ]  && SCREENSHOTS="true"
 
@@ -378,6 +385,9 @@ while [ "$1" != "" ]; do
 	[ "$1" = "--enable-debytecode" ]  && DEBYTECODE="true"
 	[ "$1" = "--disable-debytecode" ] && DEBYTECODE="false"
 
+	[ "$1" = "--enable-predecode" ]  && PREDECODE="true"
+	[ "$1" = "--disable-predecode" ] && PREDECODE="false"
+
 	[ "$1" = "--enable-libsdl2" ]  && LIBSDL2="true"
 	[ "$1" = "--disable-libsdl2" ] && LIBSDL2="false"
 
@@ -800,6 +810,16 @@ if [ "$PLATFORM" = "psp" -o "$PLATFORM" = "gp2x" \
 	OVERLAY="false"
 fi
 
+#
+# Force-disable the headless renderer on platforms that can't run tests
+#
+if [ "$PLATFORM" = "psp" -o "$PLATFORM" = "gp2x" \
+  -o "$PLATFORM" = "3ds" -o "$PLATFORM" = "nds" \
+  -o "$PLATFORM" = "wii" -o "$PLATFORM" = "emscripten" ]; then
+	echo "Force-disabling headless renderer."
+	HEADLESS="false"
+fi
+
 #
 # Force-disable the softscale renderer for SDL 1.2 (requires SDL_Renderer).
 #
@@ -921,6 +941,14 @@ if [ "$DEBYTECODE" = "true" ]; then
 	UTILS="false"
 fi
 
+#
+# Pre-decoded commands are only implemented for legacy bytecode.
+#
+if [ "$DEBYTECODE" = "true" -a "$PREDECODE" = "true" ]; then
+	echo "Force-disabling pre-decoded commands (debytecode)."
+	PREDECODE="false"
+fi
+
 #
 # As GNU ld supports recursive dylib dependency tracking, we don't need to
 # explicitly link to as many libraries as the authors would have us provide.
@@ -1187,6 +1215,17 @@ else
 	echo "GP2X half-res renderer disabled."
 fi
 
+#
+# Headless renderer
+#
+if [ "$HEADLESS" = "true" ]; then
+	echo "Headless renderer enabled."
+	echo "#define CONFIG_RENDER_HEADLESS" >> src/config.h
+	echo "BUILD_RENDER_HEADLESS=1" >> platform.inc
+else
+	echo "Headless renderer disabled."
+fi
+
 #
 # Screenshot hotkey
 #
@@ -1406,6 +1445,17 @@ else
 	echo "Experimental 'debytecode' transform disabled."
 fi
 
+#
+# Pre-decoded Robotic command records, if enabled
+#
+if [ "$PREDECODE" = "true" ]; then
+	echo "Pre-decoded Robotic commands enabled."
+	echo "#define CONFIG_PREDECODE" >> src/config.h
+	echo "BUILD_PREDECODE=1" >> platform.inc
+else
+	echo "Pre-decoded Robotic commands disabled."
+fi
+
 #
 # SDL 2.0 support, if enabled
 #
@@ -0,0 +1,432 @@
+/* MegaZeux
+ *
+ * Copyright (C) 1996 Greg Janson
+ * Copyright (C) 1999 Charles Goetzman
+ * Copyright (C) 2002 Gilead Kutnick <exophase@adelphia.net>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Headless benchmark runner. Loads a world and runs a fixed number of game
+ * cycles as fast as possible with a fixed RNG seed, then reports the cycle
+ * rate and where the time went. There's no display, input, audio, or speed
+ * delay, so the results only depend on the world and the interpreter.
+ *
+ * With -r, each frame is also drawn with the headless renderer (if it was
+ * built) and the time spent rendering is reported separately.
+ *
+ * Usage: mzxbench [-c cycles] [-s seed] [-b board] [-r] world.mzx
+ *  [config=value..]
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _MSC_VER
+#include <unistd.h>
+#endif
+
+#include "compat.h"
+#include "platform.h"
+
+#include "configure.h"
+#include "core.h"
+#include "counter.h"
+#include "data.h"
+#include "event.h"
+#include "game_update.h"
+#include "graphics.h"
+#include "render.h"
+#include "renderers.h"
+#include "robot.h"
+#include "util.h"
+#include "world.h"
+#include "world_struct.h"
+#include "io/path.h"
+
+#ifndef VERSION
+#error Must define VERSION for MegaZeux version string
+#endif
+
+#define CAPTION "MegaZeux Benchmark " VERSION
+
+#define DEFAULT_CYCLES  1000
+#define DEFAULT_SEED    1
+
+enum bench_timer
+{
+  BENCH_ROBOTS,
+  BENCH_BOARD,
+  BENCH_SPRITES,
+  BENCH_DRAW,
+  BENCH_RENDER,
+  NUM_BENCH_TIMERS
+};
+
+static const char * const bench_timer_names[NUM_BENCH_TIMERS] =
+{
+  "robots",
+  "board update",
+  "sprites",
+  "draw",
+  "render",
+};
+
+/**
+ * Renderer that accepts everything and displays nothing. The video layers,
+ * charsets, and palette are still maintained by graphics.c, so drawing the
+ * world costs the same as it would with a real renderer minus the blit.
+ */
+
+static boolean bench_init_video(struct graphics_data *graphics,
+ struct config_info *conf)
+{
+  graphics->bits_per_pixel = 32;
+  return set_video_mode();
+}
+
+static boolean bench_set_video_mode(struct graphics_data *graphics,
+ int width, int height, int depth, boolean fullscreen, boolean resize)
+{
+  return true;
+}
+
+static void bench_update_colors(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 count) {}
+
+static void bench_render_graph(struct graphics_data *graphics) {}
+
+static void bench_render_layer(struct graphics_data *graphics,
+ struct video_layer *layer) {}
+
+static void bench_render_cursor(struct graphics_data *graphics, Uint32 x,
+ Uint32 y, Uint16 color, Uint8 lines, Uint8 offset) {}
+
+static void bench_render_mouse(struct graphics_data *graphics, Uint32 x,
+ Uint32 y, Uint8 w, Uint8 h) {}
+
+static void bench_sync_screen(struct graphics_data *graphics) {}
+
+static void bench_renderer_register(struct renderer *renderer)
+{
+  renderer->init_video = bench_init_video;
+  renderer->check_video_mode = bench_set_video_mode;
+  renderer->set_video_mode = bench_set_video_mode;
+  renderer->update_colors = bench_update_colors;
+  renderer->resize_screen = resize_screen_standard;
+  renderer->get_screen_coords = get_screen_coords_centered;
+  renderer->set_screen_coords = set_screen_coords_centered;
+  renderer->render_graph = bench_render_graph;
+  renderer->render_layer = bench_render_layer;
+  renderer->render_cursor = bench_render_cursor;
+  renderer->render_mouse = bench_render_mouse;
+  renderer->sync_screen = bench_sync_screen;
+}
+
+/**
+ * Load a world and prepare it for gameplay. This is load_world_gameplay
+ * without the fades and module.
+ */
+
+static boolean bench_load_world(struct world *mzx_world, char *name,
+ int start_board)
+{
+  boolean ignore;
+
+  if(!reload_world(mzx_world, name, &ignore))
+    return false;
+
+  if((start_board < 0) || (start_board >= mzx_world->num_boards) ||
+   !(mzx_world->board_list[start_board]))
+  {
+    start_board = mzx_world->first_board;
+  }
+
+  if(mzx_world->current_board_id != start_board)
+    change_board(mzx_world, start_board);
+
+  send_robot_def(mzx_world, 0, LABEL_JUSTENTERED);
+  send_robot_def(mzx_world, 0, LABEL_JUSTLOADED);
+
+  change_board_set_values(mzx_world);
+  change_board_load_assets(mzx_world);
+  return true;
+}
+
+/**
+ * Run one game cycle the way game_draw and game_idle would. Returns false if
+ * the world tried to exit.
+ */
+
+static boolean bench_cycle(context *ctx, uint64_t times[NUM_BENCH_TIMERS],
+ boolean render)
+{
+  struct world *mzx_world = ctx->world;
+  boolean ignore;
+  uint64_t start;
+  uint64_t update_end;
+  uint64_t draw_end;
+
+  mzx_world->change_game_state = CHANGE_STATE_NONE;
+
+  start = get_time_ns();
+  update_world(ctx, false);
+  update_end = get_time_ns();
+  draw_world(ctx, false);
+  draw_end = get_time_ns();
+
+  times[BENCH_BOARD] += update_end - start;
+  times[BENCH_DRAW] += draw_end - update_end;
+
+  if(render)
+  {
+    update_screen();
+    times[BENCH_RENDER] += get_time_ns() - draw_end;
+  }
+
+  switch(mzx_world->change_game_state)
+  {
+    case CHANGE_STATE_NONE:
+    case CHANGE_STATE_PLAY_GAME_ROBOTIC:
+      break;
+
+    case CHANGE_STATE_SWAP_WORLD:
+      send_robot_def(mzx_world, 0, LABEL_JUSTLOADED);
+      send_robot_def(mzx_world, 0, LABEL_JUSTENTERED);
+      return true;
+
+    case CHANGE_STATE_LOAD_GAME_ROBOTIC:
+      send_robot_def(mzx_world, 0, LABEL_JUSTLOADED);
+      return true;
+
+    case CHANGE_STATE_EXIT_GAME_ROBOTIC:
+    case CHANGE_STATE_REQUEST_EXIT:
+      return false;
+  }
+
+  start = get_time_ns();
+  update_resolve_target(mzx_world, &ignore);
+  times[BENCH_BOARD] += get_time_ns() - start;
+
+  // Don't let the benchmark write saves.
+  mzx_world->robotic_save_type = SAVE_NONE;
+  return true;
+}
+
+static void bench_report(const char *name, long cycles, uint64_t seed,
+ uint64_t times[NUM_BENCH_TIMERS], boolean render)
+{
+  uint64_t total = 0;
+  double total_ms;
+  int i;
+
+  for(i = 0; i < NUM_BENCH_TIMERS; i++)
+    total += times[i];
+
+  total_ms = total / 1000000.0;
+
+  fprintf(stdout, "World:   %s\n", name);
+  fprintf(stdout, "Seed:    %" PRIu64 "\n", seed);
+  fprintf(stdout, "Cycles:  %ld\n", cycles);
+  fprintf(stdout, "Time:    %.3f ms\n", total_ms);
+  fprintf(stdout, "Rate:    %.1f cycles/sec\n\n",
+   total ? cycles * 1000000000.0 / total : 0.0);
+
+  fprintf(stdout, "%-14s %12s %8s %12s\n",
+   "subsystem", "ms", "%", "us/cycle");
+
+  for(i = 0; i < NUM_BENCH_TIMERS; i++)
+  {
+    if(i == BENCH_RENDER && !render)
+      continue;
+
+    fprintf(stdout, "%-14s %12.3f %7.1f%% %12.3f\n",
+     bench_timer_names[i], times[i] / 1000000.0,
+     total ? times[i] * 100.0 / total : 0.0,
+     cycles ? times[i] / 1000.0 / cycles : 0.0);
+  }
+}
+
+static void usage(const char *argv0)
+{
+  fprintf(stderr,
+   "Usage: %s [options] world.mzx [config=value...]\n\n"
+   "  -c N   Number of cycles to run (default %d).\n"
+   "  -s N   RNG seed (default %d).\n"
+   "  -b N   Board to start on (default: the world's starting board).\n"
+#ifdef CONFIG_RENDER_HEADLESS
+   "  -r     Render each frame with the headless renderer.\n"
+#endif
+   , argv0, DEFAULT_CYCLES, DEFAULT_SEED);
+}
+
+int main(int argc, char *argv[])
+{
+  struct update_timers timers;
+  struct config_info *conf;
+  core_context *core_data;
+  context *ctx;
+  uint64_t times[NUM_BENCH_TIMERS];
+  uint64_t seed = DEFAULT_SEED;
+  long num_cycles = DEFAULT_CYCLES;
+  long cycles;
+  int start_board = -1;
+  boolean render = false;
+  char *world_file = NULL;
+  int err = 1;
+  int i;
+
+  // Keep this 7.2k structure off the stack..
+  static struct world mzx_world;
+
+  if(!platform_init())
+    goto err_out;
+
+  getcwd(current_dir, MAX_PATH);
+
+  if(mzx_res_init(argv[0], false))
+    goto err_free_res;
+
+  path_get_directory(config_dir, MAX_PATH, mzx_res_get_by_id(CONFIG_TXT));
+  chdir(config_dir);
+
+  default_config();
+  set_config_from_file(SYSTEM_CNF, mzx_res_get_by_id(CONFIG_TXT));
+  set_config_from_command_line(&argc, argv);
+  conf = get_config();
+
+  chdir(current_dir);
+
+  for(i = 1; i < argc; i++)
+  {
+#ifdef CONFIG_RENDER_HEADLESS
+    if(!strcmp(argv[i], "-r"))
+    {
+      render = true;
+      continue;
+    }
+#endif
+
+    if(argv[i][0] == '-' && argv[i][1] && !argv[i][2] && i + 1 < argc)
+    {
+      switch(argv[i][1])
+      {
+        case 'c':
+          num_cycles = strtol(argv[++i], NULL, 10);
+          continue;
+
+        case 's':
+          seed = strtoull(argv[++i], NULL, 10);
+          continue;
+
+        case 'b':
+          start_board = strtol(argv[++i], NULL, 10);
+          continue;
+      }
+    }
+
+    if(argv[i][0] == '-' || world_file)
+    {
+      usage(argv[0]);
+      goto err_free_config;
+    }
+    world_file = argv[i];
+  }
+
+  if(!world_file || num_cycles <= 0)
+  {
+    usage(argv[0]);
+    goto err_free_config;
+  }
+
+  counter_fsg();
+
+  set_mouse_mul(8, 14);
+
+  init_event(conf);
+
+#ifdef CONFIG_RENDER_HEADLESS
+  if(render)
+    set_renderer_override(render_headless_register);
+  else
+#endif
+    set_renderer_override(bench_renderer_register);
+
+  if(!init_video(conf, CAPTION))
+    goto err_free_config;
+
+  // Audio is deliberately never initialized.
+
+  core_data = core_init(&mzx_world);
+  ctx = (context *)core_data;
+
+  default_scroll_values(&mzx_world);
+  snprintf(curr_file, MAX_PATH, "%s", world_file);
+  mzx_world.mzx_speed = conf->mzx_speed;
+
+  // Seed before loading too, in case anything during the load uses it.
+  rng_set_seed(seed);
+
+  if(!bench_load_world(&mzx_world, curr_file, start_board))
+  {
+    fprintf(stderr, "Failed to load world '%s'\n", world_file);
+    goto err_free_core;
+  }
+
+  rng_set_seed(seed);
+
+  memset(&timers, 0, sizeof(struct update_timers));
+  memset(times, 0, sizeof(times));
+  timers.get_time = get_time_ns;
+  update_timers = &timers;
+
+  for(cycles = 0; cycles < num_cycles; cycles++)
+    if(!bench_cycle(ctx, times, render))
+      break;
+
+  update_timers = NULL;
+
+  // The robot and sprite time were measured inside of the update and draw.
+  times[BENCH_ROBOTS] = timers.time[UPDATE_TIMER_ROBOTS];
+  times[BENCH_SPRITES] = timers.time[UPDATE_TIMER_SPRITES];
+  times[BENCH_BOARD] -= times[BENCH_ROBOTS];
+  times[BENCH_DRAW] -= times[BENCH_SPRITES];
+
+  bench_report(world_file, cycles, seed, times, render);
+
+  if(cycles < num_cycles)
+    fprintf(stdout, "\nThe world exited after %ld cycles.\n", cycles);
+
+  err = 0;
+
+  clear_world(&mzx_world);
+  clear_global_data(&mzx_world);
+
+err_free_core:
+  core_free(core_data);
+  quit_video();
+  if(mzx_world.update_done)
+    free(mzx_world.update_done);
+err_free_config:
+  free_config();
+err_free_res:
+  mzx_res_free();
+  platform_quit();
+err_out:
+  return err;
+}
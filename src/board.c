@@ -245,6 +245,11 @@ err:
 
 static void default_board(struct board *cur_board)
 {
+  cur_board->robot_name_table = NULL;
+  cur_board->label_index = NULL;
+  cur_board->robot_name_list_dirty = false;
+  cur_board->is_lazy = false;
+  cur_board->extram_data = NULL;
   cur_board->mod_playing[0] = 0;
   cur_board->viewport_x = 0;
   cur_board->viewport_y = 0;
@@ -646,7 +651,6 @@ static int cmp_robots(const void *dest, const void *src)
   return strcasecmp(rdest->robot_name, rsrc->robot_name);
 }
 
-__editor_maybe_static
 int load_board_direct(struct world *mzx_world, struct board *cur_board,
  struct zip_archive *zp, int savegame, int file_version, unsigned int board_id)
 {
@@ -1125,6 +1129,45 @@ struct board *load_board_allocate(struct world *mzx_world,
   return cur_board;
 }
 
+/**
+ * Load only the board info of a board and skip the rest of its files. The rest
+ * of the board can be loaded later by seeking back to lazy_pos and calling
+ * load_board_direct, as long as the archive stays open.
+ */
+struct board *load_board_lazy_allocate(struct world *mzx_world,
+ struct zip_archive *zp, int savegame, int file_version, unsigned int board_id)
+{
+  struct board *cur_board = ccalloc(1, sizeof(struct board));
+  unsigned int pos = zp->pos;
+  unsigned int file_id;
+  unsigned int board_id_read;
+
+  cur_board->world_version = mzx_world->version;
+  default_board(cur_board);
+
+  if(load_board_info(cur_board, zp, savegame, &file_version))
+  {
+    // Let the regular loader report (and recover from) the error.
+    zip_set_position(zp, pos);
+    load_board_direct(mzx_world, cur_board, zp, savegame, file_version,
+     board_id);
+    return cur_board;
+  }
+
+  cur_board->is_lazy = true;
+  cur_board->lazy_pos = pos;
+
+  while(ZIP_SUCCESS == zip_get_next_prop(zp, &file_id, &board_id_read, NULL))
+  {
+    if(board_id_read != board_id)
+      break;
+
+    zip_skip_file(zp);
+  }
+
+  return cur_board;
+}
+
 struct board *duplicate_board(struct world *mzx_world,
  struct board *src_board)
 {
@@ -1182,6 +1225,9 @@ struct board *duplicate_board(struct world *mzx_world,
 
   dest_board->robot_list = dest_robot_list;
   dest_board->robot_list_name_sorted = dest_robot_name_list;
+  dest_board->robot_name_table = NULL;
+  dest_board->label_index = NULL;
+  dest_board->robot_name_list_dirty = false;
 
   for(i = 1; i <= src_board->num_robots; i++)
   {
@@ -1262,6 +1308,16 @@ void clear_board(struct board *cur_board)
   struct scroll **scroll_list = cur_board->scroll_list;
   struct sensor **sensor_list = cur_board->sensor_list;
 
+  // Nothing was allocated for the contents of a board that was never loaded.
+  if(cur_board->is_lazy)
+  {
+    free(cur_board);
+    return;
+  }
+
+  // A board can be cleared without being retrieved from extra memory first
+  // (e.g. the original of a temporary board), which leaves these NULL.
+  free(cur_board->extram_data);
   free(cur_board->level_id);
   free(cur_board->level_param);
   free(cur_board->level_color);
@@ -1275,6 +1331,10 @@ void clear_board(struct board *cur_board)
     free(cur_board->overlay_color);
   }
 
+  // This also brings the name list up to date.
+  clear_robot_name_table(cur_board);
+  clear_label_index(cur_board);
+
   for(i = 0; i < num_robots_active; i++)
     if(robot_name_list[i])
       clear_robot(robot_name_list[i]);
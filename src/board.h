@@ -34,6 +34,13 @@ CORE_LIBSPEC int save_board(struct world *mzx_world, struct board *cur_board,
 CORE_LIBSPEC struct board *load_board_allocate(struct world *mzx_world,
  struct zip_archive *zp, int savegame, int file_version, unsigned int board_id);
 
+CORE_LIBSPEC int load_board_direct(struct world *mzx_world,
+ struct board *cur_board,  struct zip_archive *zp, int savegame,
+ int file_version, unsigned int board_id);
+
+struct board *load_board_lazy_allocate(struct world *mzx_world,
+ struct zip_archive *zp, int savegame, int file_version, unsigned int board_id);
+
 CORE_LIBSPEC void clear_board(struct board *cur_board);
 
 struct board *duplicate_board(struct world *mzx_world,
@@ -43,12 +50,6 @@ void dummy_board(struct board *cur_board);
 
 int find_board(struct world *mzx_world, char *name);
 
-#ifdef CONFIG_EDITOR
-CORE_LIBSPEC int load_board_direct(struct world *mzx_world,
- struct board *cur_board,  struct zip_archive *zp, int savegame,
- int file_version, unsigned int board_id);
-#endif // CONFIG_EDITOR
-
 __M_END_DECLS
 
 #endif // __BOARD_H
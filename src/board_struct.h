@@ -94,12 +94,24 @@ struct board
   int num_robots_allocated;
   struct robot **robot_list;
   struct robot **robot_list_name_sorted;
+  void *robot_name_table;
+  void *label_index;
+  boolean robot_name_list_dirty;
   int num_scrolls;
   int num_scrolls_allocated;
   struct scroll **scroll_list;
   int num_sensors;
   int num_sensors_allocated;
   struct sensor **sensor_list;
+
+  // If set, only the board info has been loaded so far, and the rest of the
+  // board is loaded from file lazy_pos of the world file when it's needed.
+  boolean is_lazy;
+  unsigned int lazy_pos;
+
+  // If set, the contents of this board are compressed while it's in extra
+  // memory (see extmem.c).
+  void *extram_data;
 #ifdef DEBUG
   boolean is_extram;
 #endif
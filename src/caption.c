@@ -42,6 +42,7 @@ static boolean caption_updates;
 #endif
 #ifdef CONFIG_FPS
 static double caption_fps;
+static double caption_glyph_cache = -1.0;
 #endif
 
 /**
@@ -144,7 +145,12 @@ static void update_caption(void)
 
 #ifdef CONFIG_FPS
   if(caption_fps > 0.001)
+  {
     caption_append(caption, CAPTION_SPACER "FPS: %.2f", caption_fps);
+
+    if(caption_glyph_cache >= 0.0)
+      caption_append(caption, " (glyph cache: %.1f%%)", caption_glyph_cache);
+  }
 #endif /* CONFIG_FPS */
 
   caption[MAX_CAPTION_SIZE - 1] = 0;
@@ -244,4 +250,9 @@ void caption_set_fps(double fps)
   caption_fps = fps;
   update_caption();
 }
+
+void caption_set_glyph_cache(double rate)
+{
+  caption_glyph_cache = rate;
+}
 #endif
@@ -88,6 +88,18 @@ CORE_LIBSPEC void caption_set_updates_available(boolean available);
 void caption_set_fps(double fps);
 #endif
 
+/**
+ * Set the current glyph cache hit rate, displayed with the FPS. This doesn't
+ * update the caption by itself; call it before caption_set_fps.
+ *
+ * @param rate        Percentage of chars drawn from the glyph cache, or <0.0
+ *                    to hide the display.
+ */
+
+#ifdef CONFIG_FPS
+void caption_set_glyph_cache(double rate);
+#endif
+
 __M_END_DECLS
 
 #endif // __CAPTION_H
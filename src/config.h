@@ -0,0 +1,17 @@
+#define PLATFORM "linux-amd64"
+#define VERSION "GIT"
+#define VERSION_DATE " (20261018)"
+#define CONFDIR "./"
+#define CONFFILE "config.txt"
+#define SHAREDIR "."
+#define CONFIG_EDITOR
+#define CONFIG_HELPSYS
+#define CONFIG_UTILS
+#define CONFIG_RENDER_HEADLESS
+#define CONFIG_ENABLE_SCREENSHOTS
+#define CONFIG_PNG
+#define CONFIG_PTHREAD
+#define CONFIG_MODULAR
+#define CONFIG_CHECK_ALLOC
+#define CONFIG_COUNTER_HASH_TABLES
+#define CONFIG_FPS
@@ -30,6 +30,7 @@
 
 #include "configure.h"
 #include "counter.h"
+#include "counter_match.h"
 #include "event.h"
 #include "rasm.h"
 #include "util.h"
@@ -187,6 +188,9 @@ static const struct config_info user_conf_default =
   CONFIG_GL_FILTER_LINEAR,      // opengl filter method
   "",                           // opengl default scaling shader
   GL_VSYNC_DEFAULT,             // opengl vsync mode
+  0,                            // render_threads
+  0,                            // headless_dump_interval
+  "frame",                      // headless_dump_prefix
   true,                         // allow screenshots
 
   // Audio options
@@ -212,6 +216,9 @@ static const struct config_info user_conf_default =
   "caverns.mzx",                // startup_file
   "saved.sav",                  // default_save_name
   4,                            // mzx_speed
+  0,                            // frame_skip
+  1,                            // max_frame_updates
+  false,                        // frame_histogram
   ALLOW_CHEATS_NEVER,           // allow_cheats
   AUTO_DECRYPT_WORLDS,          // auto_decrypt_worlds
   false,                        // startup_editor
@@ -222,6 +229,10 @@ static const struct config_info user_conf_default =
   false,                        // save_slots
   "%w.",                        // save_slots_name
   ".sav",                       // save_slots_ext
+  0,                            // zip_threads
+  false,                        // lazy_boards
+  0,                            // board_compression
+  1024,                         // mzm_cache_size
 
   // Editor options
   false,                        // test_mode
@@ -528,6 +539,28 @@ static void config_set_mzx_speed(struct config_info *conf, char *name,
     conf->mzx_speed = result;
 }
 
+static void config_frame_skip(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  int result;
+  if(config_int(&result, value, 0, 16))
+    conf->frame_skip = result;
+}
+
+static void config_max_frame_updates(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  int result;
+  if(config_int(&result, value, 1, 16))
+    conf->max_frame_updates = result;
+}
+
+static void config_frame_histogram(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  config_boolean(&conf->frame_histogram, value);
+}
+
 static void config_set_pc_speaker(struct config_info *conf, char *name,
  char *value, char *extended_data)
 {
@@ -616,6 +649,36 @@ static void config_save_slots_ext(struct config_info *conf, char *name,
   config_string(conf->save_slots_ext, value);
 }
 
+static void config_zip_threads(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  int result;
+  if(config_int(&result, value, 0, 64))
+    conf->zip_threads = result;
+}
+
+static void config_lazy_boards(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  config_boolean(&conf->lazy_boards, value);
+}
+
+static void config_board_compression(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  int result;
+  if(config_int(&result, value, 0, 9))
+    conf->board_compression = result;
+}
+
+static void config_mzm_cache_size(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  int result;
+  if(config_int(&result, value, 0, 1048576))
+    conf->mzm_cache_size = result;
+}
+
 static void config_enable_oversampling(struct config_info *conf, char *name,
  char *value, char *extended_data)
 {
@@ -915,6 +978,28 @@ static void config_gl_vsync(struct config_info *conf, char *name,
     conf->gl_vsync = result;
 }
 
+static void config_render_threads(struct config_info *conf, char *name,
+ char *value, char *extended_data)
+{
+  int result;
+  if(config_int(&result, value, 0, 64))
+    conf->render_threads = result;
+}
+
+static void config_headless_dump_interval(struct config_info *conf,
+ char *name, char *value, char *extended_data)
+{
+  int result;
+  if(config_int(&result, value, 0, INT_MAX))
+    conf->headless_dump_interval = result;
+}
+
+static void config_headless_dump_prefix(struct config_info *conf,
+ char *name, char *value, char *extended_data)
+{
+  config_string(conf->headless_dump_prefix, value);
+}
+
 static void config_set_allow_screenshots(struct config_info *conf, char *name,
  char *value, char *extended_data)
 {
@@ -1002,9 +1087,12 @@ static const struct config_entry config_options[] =
   { "audio_buffer_samples", config_set_audio_buffer, false },
   { "audio_sample_rate", config_set_audio_freq, false },
   { "auto_decrypt_worlds", config_set_auto_decrypt_worlds, false },
+  { "board_compression", config_board_compression, false },
   { "enable_oversampling", config_enable_oversampling, false },
   { "enable_resizing", config_enable_resizing, false },
   { "force_bpp", config_force_bpp, false },
+  { "frame_histogram", config_frame_histogram, false },
+  { "frame_skip", config_frame_skip, false },
   { "fullscreen", config_set_fullscreen, false },
   { "fullscreen_resolution", config_set_resolution, false },
   { "fullscreen_windowed", config_set_fullscreen_windowed, false },
@@ -1019,6 +1107,8 @@ static const struct config_entry config_options[] =
   { "gl_scaling_shader", config_set_gl_scaling_shader, true },
   { "gl_vsync", config_gl_vsync, false },
   { "grab_mouse", config_grab_mouse, false },
+  { "headless_dump_interval", config_headless_dump_interval, false },
+  { "headless_dump_prefix", config_headless_dump_prefix, false },
   { "include*", include_config, true },
   { "joy!.*", joy_action_set, true },
   { "joy!axis!", joy_axis_set, true },
@@ -1029,12 +1119,15 @@ static const struct config_entry config_options[] =
   { "joy[!,!]button!", joy_button_set, true },
   { "joy[!,!]hat", joy_hat_set, true },
   { "joy_axis_threshold", config_set_joy_axis_threshold, false },
+  { "lazy_boards", config_lazy_boards, false },
   { "mask_midchars", config_mask_midchars, false },
+  { "max_frame_updates", config_max_frame_updates, false },
   { "max_simultaneous_samples", config_max_simultaneous_samples, false },
   { "modplug_resample_mode", config_mod_resample_mode, false },
   { "module_resample_mode", config_mod_resample_mode, false },
   { "music_on", config_set_music, false },
   { "music_volume", config_set_mod_volume, false },
+  { "mzm_cache_size", config_mzm_cache_size, false },
   { "mzx_speed", config_set_mzx_speed, true },
 #ifdef CONFIG_NETWORK
   { "network_enabled", config_set_network_enabled, false },
@@ -1044,6 +1137,7 @@ static const struct config_entry config_options[] =
   { "pause_on_unfocus", pause_on_unfocus, false },
   { "pc_speaker_on", config_set_pc_speaker, false },
   { "pc_speaker_volume", config_set_pcs_volume, false },
+  { "render_threads", config_render_threads, false },
   { "resample_mode", config_resample_mode, false },
   { "sample_volume", config_set_sam_volume, false },
   { "save_file", config_save_file, false },
@@ -1068,7 +1162,8 @@ static const struct config_entry config_options[] =
 #endif
   { "video_output", config_set_video_output, false },
   { "video_ratio", config_set_video_ratio, false },
-  { "window_resolution", config_window_resolution, false }
+  { "window_resolution", config_window_resolution, false },
+  { "zip_threads", config_zip_threads, false }
 };
 
 static const struct config_entry *find_option(char *name,
@@ -85,6 +85,9 @@ struct config_info
   enum gl_filter_type gl_filter_method;
   char gl_scaling_shader[32];
   int gl_vsync;
+  int render_threads;
+  int headless_dump_interval;
+  char headless_dump_prefix[256];
   boolean allow_screenshots;
 
   // Audio options
@@ -110,6 +113,9 @@ struct config_info
   char startup_file[256];
   char default_save_name[256];
   int mzx_speed;
+  int frame_skip;
+  int max_frame_updates;
+  boolean frame_histogram;
   enum allow_cheats_type allow_cheats;
   boolean auto_decrypt_worlds;
   boolean startup_editor;
@@ -120,6 +126,10 @@ struct config_info
   boolean save_slots;
   char save_slots_name[256];
   char save_slots_ext[256];
+  int zip_threads;
+  boolean lazy_boards;
+  int board_compression;
+  int mzm_cache_size;
 
   // Editor options
   boolean test_mode;
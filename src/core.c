@@ -28,9 +28,12 @@
 #include "core.h"
 #include "error.h"
 #include "event.h"
+#include "extmem.h"
 #include "game_menu.h"
 #include "graphics.h"
 #include "helpsys.h"
+#include "mzm.h"
+#include "pacing.h"
 #include "settings.h"
 #include "util.h"
 #include "world.h"
@@ -153,6 +156,7 @@ static void update_fps(int current_ticks)
     // Subtract off highest and lowest scores (outliers)
     total_fps -= max_fps;
     total_fps -= min_fps;
+    caption_set_glyph_cache(get_glyph_cache_hit_rate());
     if(fps_history_count > 2)
     {
       average_fps =
@@ -642,6 +646,7 @@ core_context *core_init(struct world *mzx_world)
   root->restart_on_exit = false;
   root->context_changed = false;
 
+  pacing_init(get_config());
   return root;
 }
 
@@ -742,11 +747,18 @@ static boolean core_draw(core_context *root)
   if(is_fullscreen() && ctx_data->context_type != CTX_EDITOR)
   {
     // If we're in fullscreen mode, draw an onscreen FPS display.
-    char fpsbuf[32];
-    snprintf(fpsbuf, 32, "  %.2f  ", average_fps);
+    char fpsbuf[64];
+    snprintf(fpsbuf, 64, "  %.2f  ", average_fps);
 
     select_layer(UI_LAYER);
     write_string(fpsbuf, 0, 0, 0x0f, false);
+
+    // Average time spent on each part of a frame.
+    snprintf(fpsbuf, 64, "  u %.2f  d %.2f  p %.2f  ",
+     pacing_get_average_ms(PACING_UPDATE), pacing_get_average_ms(PACING_DRAW),
+     pacing_get_average_ms(PACING_PRESENT));
+
+    write_string(fpsbuf, 0, 1, 0x0f, false);
     return true;
   }
 #endif
@@ -1015,12 +1027,10 @@ void core_run(core_context *root)
   // this doesn't break MZX, this function stops once the number of contexts
   // on the stack has dropped below the initial value.
   int initial_stack_size = root->stack.size;
-  int start_ticks = get_ticks();
-  int delta_ticks;
-  int total_ticks;
   boolean need_update_screen = true;
 #ifdef __EMSCRIPTEN__
   int emscripten_prev_ticks = get_ticks();
+  int delta_ticks;
 #endif
 
   // If there aren't any contexts on the stack, there's no reason to be here.
@@ -1049,14 +1059,20 @@ void core_run(core_context *root)
       continue;
     }
 
+    pacing_set_phase(PACING_DRAW);
     need_update_screen = core_draw(root);
+    pacing_set_phase(PACING_IDLE);
 
     // Context changed or an exit occurred? Skip the screen update and delay
     if(root->context_changed || root->full_exit)
       continue;
 
-    if(need_update_screen)
+    if(need_update_screen && pacing_should_present())
+    {
+      pacing_set_phase(PACING_PRESENT);
       update_screen();
+      pacing_set_phase(PACING_IDLE);
+    }
 
     // Delay and then handle events.
     ctx = root->stack.contents[root->stack.size - 1];
@@ -1088,18 +1104,9 @@ void core_run(core_context *root)
 
       case FRAMERATE_MZX_SPEED:
       {
-        // Delay according to mzx_speed and execution time.
+        // Delay so each frame takes 16 * (speed - 1) ms.
         if(ctx->world->mzx_speed > 1)
-        {
-          // Number of ms the update cycle took
-          delta_ticks = get_ticks() - start_ticks;
-          total_ticks = (16 * (ctx->world->mzx_speed - 1)) - delta_ticks;
-          if(total_ticks < 0)
-            total_ticks = 0;
-
-          // Delay for 16 * (speed - 1) since the beginning of the update
-          delay(total_ticks);
-        }
+          pacing_wait(16000000ULL * (ctx->world->mzx_speed - 1));
 #ifdef __EMSCRIPTEN__
         else
         {
@@ -1132,13 +1139,15 @@ void core_run(core_context *root)
     enable_f12_hack = conf->allow_screenshots;
     // FIXME end legacy loop hacks
 
-    start_ticks = get_ticks();
+    pacing_end_frame();
 
 #ifdef CONFIG_FPS
-    update_fps(start_ticks);
+    update_fps(get_ticks());
 #endif
 
+    pacing_set_phase(PACING_UPDATE);
     core_update(root);
+    pacing_set_phase(PACING_IDLE);
   }
   while(!root->full_exit && root->stack.size >= initial_stack_size);
 
@@ -1205,6 +1214,11 @@ void core_free(core_context *root)
 
   free(root->stack.contents);
   free(root);
+
+  pacing_print_histogram();
+  extram_print_stats();
+  mzm_cache_print_stats();
+  mzm_cache_clear();
 }
 
 // Deprecated.
@@ -1262,6 +1276,8 @@ int (*debug_robot_break)(context *ctx, struct robot *cur_robot,
  int id, int lines_run);
 int (*debug_robot_watch)(context *ctx, struct robot *cur_robot,
  int id, int lines_run);
+void (*debug_robot_profile)(struct world *mzx_world, struct robot *cur_robot,
+ int id, int program_pos);
 void (*debug_robot_config)(struct world *mzx_world);
 
 // Network external function pointers (NULL by default).
@@ -294,6 +294,8 @@ CORE_LIBSPEC extern int (*debug_robot_break)(context *ctx,
  struct robot *cur_robot, int id, int lines_run);
 CORE_LIBSPEC extern int (*debug_robot_watch)(context *ctx,
  struct robot *cur_robot, int id, int lines_run);
+CORE_LIBSPEC extern void (*debug_robot_profile)(struct world *mzx_world,
+ struct robot *cur_robot, int id, int program_pos);
 CORE_LIBSPEC extern void (*debug_robot_config)(struct world *mzx_world);
 
 // Network external function pointers.
@@ -37,6 +37,7 @@
 
 #include "configure.h"
 #include "counter.h"
+#include "counter_match.h"
 #include "data.h"
 #include "error.h"
 #include "event.h"
@@ -2580,308 +2581,30 @@ static void max_samples_write(struct world *mzx_world,
 
 static const struct function_counter builtin_counters[] =
 {
-  { "$*",               V262,   string_counter_read,  string_counter_write },
-  { "abs!",             V268,   abs_read,             NULL },
-  { "acos!",            V268,   acos_read,            NULL },
-  { "arctan!,!",        V284,   atan2_read,           NULL },
-  { "asin!",            V268,   asin_read,            NULL },
-  { "atan!",            V268,   atan_read,            NULL },
-  { "bch!,!",           V284,   bch_read,             NULL },
-  { "bco!,!",           V284,   bco_read,             NULL },
-  { "bid!,!",           V284,   bid_read,             bid_write },
-  { "bimesg",           V251s3, NULL,                 bimesg_write }, // s3.2
-  { "blue_value",       V260,   blue_value_read,      blue_value_write },
-  { "board_char",       V260,   board_char_read,      NULL },
-  { "board_color",      V260,   board_color_read,     NULL },
-  { "board_h",          V265,   board_h_read,         NULL },
-  { "board_id",         V265,   board_id_read,        board_id_write },
-  { "board_param",      V265,   board_param_read,     board_param_write },
-  { "board_w",          V265,   board_w_read,         NULL },
-  { "bpr!,!",           V284,   bpr_read,             bpr_write },
-  { "bullettype",       V100,   bullettype_read,      bullettype_write },
-  { "buttons",          V251s1, buttons_read,         NULL },
-  { "char_byte",        V260,   char_byte_read,       char_byte_write },
-  { "commands",         V260,   commands_read,        commands_write },
-  { "commands_stop",    V290,   commands_stop_read,   commands_stop_write },
-  { "cos!",             V268,   cos_read,             NULL },
-  { "c_divisions",      V268,   c_divisions_read,     c_divisions_write },
-  { "date_day",         V260,   date_day_read,        NULL },
-  { "date_month",       V260,   date_month_read,      NULL },
-  { "date_year",        V260,   date_year_read,       NULL },
-  { "divider",          V268,   divider_read,         divider_write },
-  { "exit_game",        V290,   NULL,                 exit_game_write },
-  { "fread",            V260,   fread_read,           NULL },
-  { "fread_counter",    V265,   fread_counter_read,   NULL },
-  { "fread_delimiter",  V284,   NULL,                 fread_delim_write },
-  { "fread_length",     V292,   fread_length_read,    NULL },
-  { "fread_open",       V260,   fread_open_read,      NULL },
-  { "fread_pos",        V260,   fread_pos_read,       fread_pos_write },
-  { "fwrite",           V260,   NULL,                 fwrite_write },
-  { "fwrite_append",    V260,   fwrite_append_read,   NULL },
-  { "fwrite_counter",   V265,   NULL,                 fwrite_counter_write },
-  { "fwrite_delimiter", V284,   NULL,                 fwrite_delim_write },
-  { "fwrite_length",    V292,   fwrite_length_read,   NULL },
-  { "fwrite_modify",    V269c,  fwrite_modify_read,   NULL },
-  { "fwrite_open",      V260,   fwrite_open_read,     NULL },
-  { "fwrite_pos",       V260,   fwrite_pos_read,      fwrite_pos_write },
-  { "goop_walk",        V290,   goop_walk_read,       goop_walk_write },
-  { "green_value",      V260,   green_value_read,     green_value_write },
-  { "horizpld",         V100,   horizpld_read,        NULL },
-  { "input",            V100,   input_read,           input_write },
-  { "inputsize",        V100,   inputsize_read,       inputsize_write },
-  { "int2bin",          V260,   int2bin_read,         int2bin_write },
-  { "joy!.*",           V292,   joyn_read,            NULL },
-  { "joy!active",       V292,   joyn_active_read,     NULL },
-  { "joy_simulate_keys",V292,   NULL,                 joy_simulate_keys_write },
-  { "key",              V100,   key_read,             key_write },
-  { "key!",             V269,   keyn_read,            NULL },
-  { "key_code",         V269,   key_code_read,        NULL },
-  { "key_pressed",      V260,   key_pressed_read,     NULL },
-  { "key_release",      V269,   key_release_read,     NULL },
-  { "lava_walk",        V260,   lava_walk_read,       lava_walk_write },
-  { "load_bc?",         V270,   load_bc_read,         NULL },
-  { "load_counters",    V290,   load_counters_read,   NULL },
-  { "load_game",        V268,   load_game_read,       NULL },
-  { "load_robot?",      V270,   load_robot_read,      NULL },
-  { "local",            V251s1, local_read,           local_write },
-  { "local!",           V269b,  localn_read,          localn_write },
-  { "loopcount",        V200,   loopcount_read,       loopcount_write },
-  { "max!,!",           V284,   maxval_read,          NULL },
-  { "max_samples",      V291,   max_samples_read,     max_samples_write },
-  { "mboardx",          V251s1, mboardx_read,         NULL },
-  { "mboardy",          V251s1, mboardy_read,         NULL },
-  { "min!,!",           V284,   minval_read,          NULL },
-  { "mod_frequency",    V281,   mod_freq_read,        mod_freq_write },
-  { "mod_length",       V291,   mod_length_read,      NULL },
-  { "mod_loopend",      V292,   mod_loopend_read,     mod_loopend_write },
-  { "mod_loopstart",    V292,   mod_loopstart_read,   mod_loopstart_write },
-  { "mod_order",        V262,   mod_order_read,       mod_order_write },
-  { "mod_position",     V281,   mod_position_read,    mod_position_write },
-  { "mousepx",          V282,   mousepx_read,         mousepx_write },
-  { "mousepy",          V282,   mousepy_read,         mousepy_write },
-  { "mousex",           V251s1, mousex_read,          mousex_write },
-  { "mousey",           V251s1, mousey_read,          mousey_write },
-  { "multiplier",       V268,   multiplier_read,      multiplier_write },
-  { "mzx_speed",        V260,   mzx_speed_read,       mzx_speed_write },
-  { "och!,!",           V284,   och_read,             NULL },
-  { "oco!,!",           V284,   oco_read,             NULL },
-  { "overlay_char",     V260,   overlay_char_read,    NULL },
-  { "overlay_color",    V260,   overlay_color_read,   NULL },
-  { "overlay_mode",     V260,   overlay_mode_read,    NULL },
-  { "pixel",            V260,   pixel_read,           pixel_write },
-  { "playerdist",       V100,   playerdist_read,      NULL },
-  { "playerfacedir",    V200,   playerfacedir_read,   playerfacedir_write },
-  { "playerlastdir",    V200,   playerlastdir_read,   playerlastdir_write },
-  { "playerx",          V251s1, playerx_read,         NULL },
-  { "playery",          V251s1, playery_read,         NULL },
-  { "play_game",        V290,   NULL,                 play_game_write },
-  { "r!.*",             V265,   r_read,               r_write },
-  { "random_seed!",     V291,   random_seed_read,     random_seed_write },
-  { "red_value",        V260,   red_value_read,       red_value_write },
-  { "rid*",             V269b,  rid_read,             NULL },
-  { "robot_id",         V260,   robot_id_read,        NULL },
-  { "robot_id_*",       V265,   robot_id_n_read,      NULL },
-  { "save_bc?",         V270,   save_bc_read,         NULL },
-  { "save_counters",    V290,   save_counters_read,   NULL },
-  { "save_game",        V268,   save_game_read,       NULL },
-  { "save_robot?",      V270,   save_robot_read,      NULL },
-  { "scrolledx",        V251s1, scrolledx_read,       NULL },
-  { "scrolledy",        V251s1, scrolledy_read,       NULL },
-  { "sin!",             V268,   sin_read,             NULL },
-  { "smzx_b!",          V269,   smzx_b_read,          smzx_b_write },
-  { "smzx_g!",          V269,   smzx_g_read,          smzx_g_write },
-  { "smzx_idx!,!",      V290,   smzx_idx_read,        smzx_idx_write },
-  { "smzx_indices",     V291,   smzx_indices_read,    NULL },
-  { "smzx_message",     V291,   smzx_message_read,    smzx_message_write },
-  { "smzx_mode",        V269,   smzx_mode_read,       smzx_mode_write },
-  { "smzx_palette",     V269,   smzx_palette_read,    NULL },
-  { "smzx_r!",          V269,   smzx_r_read,          smzx_r_write },
-  { "spacelock",        V284,   NULL,                 spacelock_write },
-  { "spr!_ccheck",      V265,   NULL,                 spr_ccheck_write },
-  { "spr!_cheight",     V265,   spr_cheight_read,     spr_cheight_write },
-  { "spr!_clist",       V265,   NULL,                 spr_clist_write },
-  { "spr!_cwidth",      V265,   spr_cwidth_read,      spr_cwidth_write },
-  { "spr!_cx",          V265,   spr_cx_read,          spr_cx_write },
-  { "spr!_cy",          V265,   spr_cy_read,          spr_cy_write },
-  { "spr!_height",      V265,   spr_height_read,      spr_height_write },
-  { "spr!_off",         V265,   spr_off_read,         spr_off_write },
-  { "spr!_offset",      V290,   spr_offset_read,      spr_offset_write },
-  { "spr!_overlaid",    V265,   NULL,                 spr_overlaid_write },
-  { "spr!_overlay",     V269c,  NULL,                 spr_overlaid_write },
-  { "spr!_refx",        V265,   spr_refx_read,        spr_refx_write },
-  { "spr!_refy",        V265,   spr_refy_read,        spr_refy_write },
-  { "spr!_setview",     V265,   NULL,                 spr_setview_write },
-  { "spr!_static",      V265,   NULL,                 spr_static_write },
-  { "spr!_swap",        V265,   NULL,                 spr_swap_write },
-  { "spr!_tcol",        V290,   spr_tcol_read,        spr_tcol_write },
-  { "spr!_unbound",     V290,   spr_unbound_read,     spr_unbound_write },
-  { "spr!_vlayer",      V269c,  NULL,                 spr_vlayer_write },
-  { "spr!_width",       V265,   spr_width_read,       spr_width_write },
-  { "spr!_x",           V265,   spr_x_read,           spr_x_write },
-  { "spr!_y",           V265,   spr_y_read,           spr_y_write },
-  { "spr!_z",           V292,   spr_z_read,           spr_z_write },
-  { "spr_clist!",       V265,   spr_clist_read,       NULL },
-  { "spr_collisions",   V265,   spr_collisions_read,  NULL },
-  { "spr_num",          V265,   spr_num_read,         spr_num_write },
-  { "spr_yorder",       V265,   NULL,                 spr_yorder_write },
-  { "sqrt!",            V268,   sqrt_read,            NULL },
-  { "tan!",             V268,   tan_read,             NULL },
-  { "thisx",            V200,   thisx_read,           NULL },
-  { "thisy",            V200,   thisy_read,           NULL },
-  { "this_char",        V260,   this_char_read,       NULL },
-  { "this_color",       V260,   this_color_read,      NULL },
-  { "timereset",        V200,   timereset_read,       timereset_write },
-  { "time_hours",       V260,   time_hours_read,      NULL },
-  { "time_millis",      V292,   time_millis_read,     NULL },
-  { "time_minutes",     V260,   time_minutes_read,    NULL },
-  { "time_seconds",     V260,   time_seconds_read,    NULL },
-  { "uch!,!",           V284,   uch_read,             NULL },
-  { "uco!,!",           V284,   uco_read,             NULL },
-  { "uid!,!",           V284,   uid_read,             uid_write },
-  { "upr!,!",           V284,   upr_read,             upr_write },
-  { "vch!,!",           V269c,  vch_read,             vch_write },
-  { "vco!,!",           V269c,  vco_read,             vco_write },
-  { "vertpld",          V100,   vertpld_read,         NULL },
-  { "vlayer_height",    V269c,  vlayer_height_read,   vlayer_height_write },
-  { "vlayer_size",      V281,   vlayer_size_read,     vlayer_size_write },
-  { "vlayer_width",     V269c,  vlayer_width_read,    vlayer_width_write },
+#define COUNTER(name, version, read, write) \
+  { name, version, read, write },
+
+#include "counter_list.h"
+
+#undef COUNTER
 };
 
 static const int num_builtin_counters = ARRAY_SIZE(builtin_counters);
-static int counter_first_letter[512];
+static struct function_counter_index builtin_counter_index;
 
 void counter_fsg(void)
 {
-  char cur_char = (builtin_counters[0]).name[0];
-  char old_char;
-  int i, i2;
-
-  for(i = 0, i2 = 0; i < 256; i++)
-  {
-    if(i != cur_char)
-    {
-      counter_first_letter[i * 2] = -1;
-      counter_first_letter[(i * 2) + 1] = -1;
-    }
-    else
-    {
-      counter_first_letter[i * 2] = i2;
-      old_char = cur_char;
-
-      while(cur_char == old_char)
-      {
-        i2++;
-        if(i2 == num_builtin_counters)
-          break;
-        cur_char = builtin_counters[i2].name[0];
-      }
-
-      counter_first_letter[(i * 2) + 1] = i2 - 1;
-    }
-  }
-}
-
-int match_function_counter(const char *dest, const char *src)
-{
-  int difference;
-  char cur_src, cur_dest;
-
-  while(1)
-  {
-    cur_src = *src;
-    cur_dest = *dest;
-
-    // Skip 1 or more letters
-    switch(cur_src)
-    {
-      // Make sure the first character is a number
-      case '!':
-      {
-        if(((cur_dest < '0') || (cur_dest > '9')) &&
-         (cur_dest != '-'))
-        {
-          // Don't want to accidentally match this char...
-          if(cur_dest == '!')
-            return 1;
-
-          break;
-        }
-
-        dest++;
-        cur_dest = *dest;
-
-        // Fall through, skip remaining numbers
-      }
-
-      /* fallthrough */
-
-      // Skip 0 or more number characters
-      case '?':
-      {
-        src++;
-        cur_src = *src;
-
-        while(((cur_dest >= '0') && (cur_dest <= '9')) ||
-         (cur_dest == '-'))
-        {
-          dest++;
-          cur_dest = *dest;
-        }
-        break;
-      }
-
-      // Match anything, instant winner
-      case '*':
-      {
-        return 0;
-      }
-    }
-
-    if((cur_src | cur_dest) == 0)
-    {
-      // Both hit the null terminator
-      return 0;
-    }
-
-    difference = (int)((cur_dest & 0xDF) - (cur_src & 0xDF));
-
-    if(difference)
-      return difference;
-
-    src++;
-    dest++;
-  }
-
-  return 0;
+  init_function_counter_index(&builtin_counter_index,
+   &(builtin_counters[0].name), sizeof(struct function_counter),
+   num_builtin_counters);
 }
 
 static const struct function_counter *find_function_counter(const char *name)
 {
-  const struct function_counter *base = builtin_counters;
-  int first_letter = tolower((int)name[0]) * 2;
-  int bottom, top, middle;
-  int cmpval;
+  int pos = find_function_counter_index(&builtin_counter_index, name);
 
-  bottom = counter_first_letter[first_letter];
-  top = counter_first_letter[first_letter + 1];
-
-  if(bottom != -1)
-  {
-    while(bottom <= top)
-    {
-      middle = (top + bottom) / 2;
-      cmpval = match_function_counter(name + 1, (base[middle]).name + 1);
-
-      if(cmpval > 0)
-        bottom = middle + 1;
-      else
-
-      if(cmpval < 0)
-        top = middle - 1;
-      else
-        return base + middle;
-    }
-  }
+  if(pos >= 0)
+    return builtin_counters + pos;
 
   return NULL;
 }
@@ -3693,8 +3416,8 @@ static struct counter *allocate_new_counter(const char *name, int name_length,
   return dest;
 }
 
-static void add_counter(struct counter_list *counter_list, const char *name,
- int value, unsigned int position)
+static struct counter *add_counter(struct counter_list *counter_list,
+ const char *name, int value, unsigned int position)
 {
   unsigned int count = counter_list->num_counters;
   unsigned int allocated = counter_list->num_counters_allocated;
@@ -3709,7 +3432,7 @@ static void add_counter(struct counter_list *counter_list, const char *name,
     {
       // Gracefully fail if this tries to go over 2b...
       if(allocated >= (size_t)(INT32_MAX))
-        return;
+        return NULL;
 
       allocated *= 2;
     }
@@ -3738,6 +3461,7 @@ static void add_counter(struct counter_list *counter_list, const char *name,
 #ifdef CONFIG_COUNTER_HASH_TABLES
   HASH_ADD(COUNTER, counter_list->hash_table, dest);
 #endif
+  return dest;
 }
 
 void set_counter(struct world *mzx_world, const char *name, int value, int id)
@@ -4026,12 +3750,270 @@ void mod_counter(struct world *mzx_world, const char *name, int value, int id)
   }
 }
 
+// Counter structs are never freed or moved until the list is cleared, so
+// handles only need to be invalidated when that happens.
+static unsigned int counter_handle_generation = 1;
+
+enum counter_slot
+{
+  COUNTER_SLOT_NONE,
+  COUNTER_SLOT_LOCAL,
+  COUNTER_SLOT_LOOPCOUNT,
+};
+
+// Determine whether a function counter can be accessed as a direct slot.
+// This is also where local! has its number parsed, so it only happens once.
+static void resolve_counter_slot(struct counter_handle *handle,
+ const char *name)
+{
+  const struct function_counter *fdest = handle->fdest;
+
+  handle->slot = COUNTER_SLOT_NONE;
+  handle->slot_index = 0;
+
+  if(!fdest)
+    return;
+
+  if(fdest->function_read == local_read)
+  {
+    handle->slot = COUNTER_SLOT_LOCAL;
+  }
+  else
+
+  if(fdest->function_read == localn_read)
+  {
+    handle->slot = COUNTER_SLOT_LOCAL;
+    if(name[5])
+      handle->slot_index = (strtol(name + 5, NULL, 10) - 1) & 31;
+  }
+  else
+
+  if(fdest->function_read == loopcount_read)
+    handle->slot = COUNTER_SLOT_LOOPCOUNT;
+}
+
+static inline void resolve_counter_handle(struct world *mzx_world,
+ struct counter_handle *handle, const char *name)
+{
+  if(handle->generation != counter_handle_generation ||
+   handle->version != mzx_world->version)
+  {
+    const struct function_counter *fdest = find_function_counter(name);
+
+    if(fdest && (mzx_world->version < fdest->minimum_version))
+      fdest = NULL;
+
+    handle->fdest = fdest;
+    handle->cdest = NULL;
+    handle->generation = counter_handle_generation;
+    handle->version = mzx_world->version;
+    resolve_counter_slot(handle, name);
+  }
+}
+
+static inline int *get_counter_slot(struct world *mzx_world,
+ struct counter_handle *handle, int id)
+{
+  struct robot *cur_robot = mzx_world->current_board->robot_list[id];
+
+  switch(handle->slot)
+  {
+    case COUNTER_SLOT_LOCAL:
+      return &(cur_robot->local[handle->slot_index]);
+
+    case COUNTER_SLOT_LOOPCOUNT:
+      return &(cur_robot->loop_count);
+  }
+  return NULL;
+}
+
+// Counters that don't exist yet may be created elsewhere at any time, so
+// keep looking for them until they're found.
+static inline struct counter *find_counter_handle(
+ struct counter_list *counter_list, struct counter_handle *handle,
+ const char *name, int *next)
+{
+  if(!handle->cdest)
+    handle->cdest = find_counter(counter_list, name, next);
+
+  return handle->cdest;
+}
+
+int get_counter_handle(struct world *mzx_world, struct counter_handle *handle,
+ const char *name, int id)
+{
+  const struct function_counter *fdest;
+  struct counter *cdest;
+  int next;
+
+  resolve_counter_handle(mzx_world, handle, name);
+  fdest = handle->fdest;
+
+  if(handle->slot)
+    return *get_counter_slot(mzx_world, handle, id);
+
+  if(fdest && fdest->function_read)
+    return fdest->function_read(mzx_world, fdest, name, id);
+
+  cdest = find_counter_handle(&(mzx_world->counter_list), handle, name, &next);
+
+  if(cdest)
+    return cdest->value;
+
+  return 0;
+}
+
+void set_counter_handle(struct world *mzx_world,
+ struct counter_handle *handle, const char *name, int value, int id)
+{
+  struct counter_list *counter_list = &(mzx_world->counter_list);
+  const struct function_counter *fdest;
+  struct counter *cdest;
+  int next = 0;
+
+  resolve_counter_handle(mzx_world, handle, name);
+  fdest = handle->fdest;
+
+  if(handle->slot)
+  {
+    *get_counter_slot(mzx_world, handle, id) = value;
+  }
+  else
+
+  if(fdest)
+  {
+    // See set_counter.
+    if(fdest->function_write)
+      fdest->function_write(mzx_world, fdest, name, value, id);
+    else
+      assert(fdest->function_read);
+  }
+  else
+  {
+    cdest = find_counter_handle(counter_list, handle, name, &next);
+
+    if(cdest)
+    {
+      if(cdest->gateway_write && cdest->gateway_write < NUM_GATEWAYS)
+      {
+        gateway_write_function gateway_write = gateways[cdest->gateway_write];
+        value = gateway_write(mzx_world, cdest, name, value, id, false);
+      }
+
+      cdest->value = value;
+    }
+    else
+    {
+      handle->cdest = add_counter(counter_list, name, value, next);
+    }
+  }
+}
+
+void inc_counter_handle(struct world *mzx_world,
+ struct counter_handle *handle, const char *name, int value, int id)
+{
+  struct counter_list *counter_list = &(mzx_world->counter_list);
+  const struct function_counter *fdest;
+  struct counter *cdest;
+  int current_value;
+  int next = 0;
+
+  resolve_counter_handle(mzx_world, handle, name);
+  fdest = handle->fdest;
+
+  if(handle->slot)
+  {
+    *get_counter_slot(mzx_world, handle, id) += value;
+  }
+  else
+
+  if(fdest && fdest->function_read && fdest->function_write)
+  {
+    current_value =
+     fdest->function_read(mzx_world, fdest, name, id);
+    fdest->function_write(mzx_world, fdest, name,
+     current_value + value, id);
+  }
+  else
+  {
+    cdest = find_counter_handle(counter_list, handle, name, &next);
+
+    if(cdest)
+    {
+      value += cdest->value;
+
+      if(cdest->gateway_write && cdest->gateway_write < NUM_GATEWAYS)
+      {
+        gateway_write_function gateway_write = gateways[cdest->gateway_write];
+        value = gateway_write(mzx_world, cdest, name, value, id, false);
+      }
+
+      cdest->value = value;
+    }
+    else
+    {
+      handle->cdest = add_counter(counter_list, name, value, next);
+    }
+  }
+}
+
+void dec_counter_handle(struct world *mzx_world,
+ struct counter_handle *handle, const char *name, int value, int id)
+{
+  struct counter_list *counter_list = &(mzx_world->counter_list);
+  const struct function_counter *fdest;
+  struct counter *cdest;
+  int current_value;
+  int next = 0;
+
+  resolve_counter_handle(mzx_world, handle, name);
+  fdest = handle->fdest;
+
+  if(handle->slot)
+  {
+    *get_counter_slot(mzx_world, handle, id) -= value;
+  }
+  else
+
+  if(fdest && fdest->function_read && fdest->function_write)
+  {
+    current_value =
+     fdest->function_read(mzx_world, fdest, name, id);
+    fdest->function_write(mzx_world, fdest, name,
+     current_value - value, id);
+  }
+  else
+  {
+    cdest = find_counter_handle(counter_list, handle, name, &next);
+
+    if(cdest)
+    {
+      value = cdest->value - value;
+
+      if(cdest->gateway_write && cdest->gateway_write < NUM_GATEWAYS)
+      {
+        gateway_write_function gateway_write = gateways[cdest->gateway_write];
+        value = gateway_write(mzx_world, cdest, name, value, id, true);
+      }
+
+      cdest->value = value;
+    }
+    else
+    {
+      handle->cdest = add_counter(counter_list, name, -value, next);
+    }
+  }
+}
+
 // Create a new counter from loading a save file. This skips find_counter.
 void load_new_counter(struct counter_list *counter_list, int index,
  const char *name, int name_length, int value)
 {
   struct counter *dest = allocate_new_counter(name, name_length, value);
 
+  // This list wasn't necessarily cleared first.
+  counter_handle_generation++;
+
   counter_list->counters[index] = dest;
 
 #ifdef CONFIG_COUNTER_HASH_TABLES
@@ -4061,6 +4043,9 @@ void clear_counter_list(struct counter_list *counter_list)
   counter_list->hash_table = NULL;
 #endif
 
+  // Invalidate all counter handles.
+  counter_handle_generation++;
+
   for(i = 0; i < counter_list->num_counters; i++)
     free(counter_list->counters[i]);
 
@@ -33,7 +33,6 @@ __M_BEGIN_DECLS
 #define SAVE_ROBOT_DISASM_BASE    10
 
 CORE_LIBSPEC void counter_fsg(void);
-CORE_LIBSPEC int match_function_counter(const char *dest, const char *src);
 CORE_LIBSPEC int get_counter(struct world *mzx_world, const char *name, int id);
 CORE_LIBSPEC void set_counter(struct world *mzx_world, const char *name,
  int value, int id);
@@ -56,6 +55,37 @@ void load_new_counter(struct counter_list *counter_list, int index,
 
 void clear_counter_list(struct counter_list *counter_list);
 
+/**
+ * A counter handle caches the lookup of a particular counter name so code
+ * that accesses the same counter repeatedly (i.e. robot bytecode params) can
+ * skip the function counter search and name hashing. Handles must be zeroed
+ * before their first use and must always be used with the same name. They
+ * will re-resolve themselves after the counter list is cleared or the world
+ * version changes.
+ */
+struct function_counter;
+
+struct counter_handle
+{
+  const struct function_counter *fdest;
+  struct counter *cdest;
+  unsigned int generation;
+  int version;
+  // Function counters that are just a field of the robot (local1..local32,
+  // loopcount) are accessed through a direct slot instead of the function.
+  int slot;
+  int slot_index;
+};
+
+int get_counter_handle(struct world *mzx_world, struct counter_handle *handle,
+ const char *name, int id);
+void set_counter_handle(struct world *mzx_world,
+ struct counter_handle *handle, const char *name, int value, int id);
+void inc_counter_handle(struct world *mzx_world,
+ struct counter_handle *handle, const char *name, int value, int id);
+void dec_counter_handle(struct world *mzx_world,
+ struct counter_handle *handle, const char *name, int value, int id);
+
 // Even old games tended to use at least this many.
 #define MIN_COUNTER_ALLOCATE 32
 
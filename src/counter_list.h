@@ -0,0 +1,192 @@
+/* MegaZeux
+ *
+ * Copyright (C) 1996 Greg Janson
+ * Copyright (C) 1999 Charles Goetzman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Builtin function counters, used to generate builtin_counters in counter.c.
+ * Define COUNTER(name, version, read, write) before including this file.
+ * This list must be sorted by name (see match_function_counter). It is also
+ * included by the counter_match unit test.
+ */
+
+COUNTER( "$*",               V262,   string_counter_read,  string_counter_write )
+COUNTER( "abs!",             V268,   abs_read,             NULL )
+COUNTER( "acos!",            V268,   acos_read,            NULL )
+COUNTER( "arctan!,!",        V284,   atan2_read,           NULL )
+COUNTER( "asin!",            V268,   asin_read,            NULL )
+COUNTER( "atan!",            V268,   atan_read,            NULL )
+COUNTER( "bch!,!",           V284,   bch_read,             NULL )
+COUNTER( "bco!,!",           V284,   bco_read,             NULL )
+COUNTER( "bid!,!",           V284,   bid_read,             bid_write )
+COUNTER( "bimesg",           V251s3, NULL,                 bimesg_write ) // s3.2
+COUNTER( "blue_value",       V260,   blue_value_read,      blue_value_write )
+COUNTER( "board_char",       V260,   board_char_read,      NULL )
+COUNTER( "board_color",      V260,   board_color_read,     NULL )
+COUNTER( "board_h",          V265,   board_h_read,         NULL )
+COUNTER( "board_id",         V265,   board_id_read,        board_id_write )
+COUNTER( "board_param",      V265,   board_param_read,     board_param_write )
+COUNTER( "board_w",          V265,   board_w_read,         NULL )
+COUNTER( "bpr!,!",           V284,   bpr_read,             bpr_write )
+COUNTER( "bullettype",       V100,   bullettype_read,      bullettype_write )
+COUNTER( "buttons",          V251s1, buttons_read,         NULL )
+COUNTER( "char_byte",        V260,   char_byte_read,       char_byte_write )
+COUNTER( "commands",         V260,   commands_read,        commands_write )
+COUNTER( "commands_stop",    V290,   commands_stop_read,   commands_stop_write )
+COUNTER( "cos!",             V268,   cos_read,             NULL )
+COUNTER( "c_divisions",      V268,   c_divisions_read,     c_divisions_write )
+COUNTER( "date_day",         V260,   date_day_read,        NULL )
+COUNTER( "date_month",       V260,   date_month_read,      NULL )
+COUNTER( "date_year",        V260,   date_year_read,       NULL )
+COUNTER( "divider",          V268,   divider_read,         divider_write )
+COUNTER( "exit_game",        V290,   NULL,                 exit_game_write )
+COUNTER( "fread",            V260,   fread_read,           NULL )
+COUNTER( "fread_counter",    V265,   fread_counter_read,   NULL )
+COUNTER( "fread_delimiter",  V284,   NULL,                 fread_delim_write )
+COUNTER( "fread_length",     V292,   fread_length_read,    NULL )
+COUNTER( "fread_open",       V260,   fread_open_read,      NULL )
+COUNTER( "fread_pos",        V260,   fread_pos_read,       fread_pos_write )
+COUNTER( "fwrite",           V260,   NULL,                 fwrite_write )
+COUNTER( "fwrite_append",    V260,   fwrite_append_read,   NULL )
+COUNTER( "fwrite_counter",   V265,   NULL,                 fwrite_counter_write )
+COUNTER( "fwrite_delimiter", V284,   NULL,                 fwrite_delim_write )
+COUNTER( "fwrite_length",    V292,   fwrite_length_read,   NULL )
+COUNTER( "fwrite_modify",    V269c,  fwrite_modify_read,   NULL )
+COUNTER( "fwrite_open",      V260,   fwrite_open_read,     NULL )
+COUNTER( "fwrite_pos",       V260,   fwrite_pos_read,      fwrite_pos_write )
+COUNTER( "goop_walk",        V290,   goop_walk_read,       goop_walk_write )
+COUNTER( "green_value",      V260,   green_value_read,     green_value_write )
+COUNTER( "horizpld",         V100,   horizpld_read,        NULL )
+COUNTER( "input",            V100,   input_read,           input_write )
+COUNTER( "inputsize",        V100,   inputsize_read,       inputsize_write )
+COUNTER( "int2bin",          V260,   int2bin_read,         int2bin_write )
+COUNTER( "joy!.*",           V292,   joyn_read,            NULL )
+COUNTER( "joy!active",       V292,   joyn_active_read,     NULL )
+COUNTER( "joy_simulate_keys", V292,   NULL,                 joy_simulate_keys_write )
+COUNTER( "key",              V100,   key_read,             key_write )
+COUNTER( "key!",             V269,   keyn_read,            NULL )
+COUNTER( "key_code",         V269,   key_code_read,        NULL )
+COUNTER( "key_pressed",      V260,   key_pressed_read,     NULL )
+COUNTER( "key_release",      V269,   key_release_read,     NULL )
+COUNTER( "lava_walk",        V260,   lava_walk_read,       lava_walk_write )
+COUNTER( "load_bc?",         V270,   load_bc_read,         NULL )
+COUNTER( "load_counters",    V290,   load_counters_read,   NULL )
+COUNTER( "load_game",        V268,   load_game_read,       NULL )
+COUNTER( "load_robot?",      V270,   load_robot_read,      NULL )
+COUNTER( "local",            V251s1, local_read,           local_write )
+COUNTER( "local!",           V269b,  localn_read,          localn_write )
+COUNTER( "loopcount",        V200,   loopcount_read,       loopcount_write )
+COUNTER( "max!,!",           V284,   maxval_read,          NULL )
+COUNTER( "max_samples",      V291,   max_samples_read,     max_samples_write )
+COUNTER( "mboardx",          V251s1, mboardx_read,         NULL )
+COUNTER( "mboardy",          V251s1, mboardy_read,         NULL )
+COUNTER( "min!,!",           V284,   minval_read,          NULL )
+COUNTER( "mod_frequency",    V281,   mod_freq_read,        mod_freq_write )
+COUNTER( "mod_length",       V291,   mod_length_read,      NULL )
+COUNTER( "mod_loopend",      V292,   mod_loopend_read,     mod_loopend_write )
+COUNTER( "mod_loopstart",    V292,   mod_loopstart_read,   mod_loopstart_write )
+COUNTER( "mod_order",        V262,   mod_order_read,       mod_order_write )
+COUNTER( "mod_position",     V281,   mod_position_read,    mod_position_write )
+COUNTER( "mousepx",          V282,   mousepx_read,         mousepx_write )
+COUNTER( "mousepy",          V282,   mousepy_read,         mousepy_write )
+COUNTER( "mousex",           V251s1, mousex_read,          mousex_write )
+COUNTER( "mousey",           V251s1, mousey_read,          mousey_write )
+COUNTER( "multiplier",       V268,   multiplier_read,      multiplier_write )
+COUNTER( "mzx_speed",        V260,   mzx_speed_read,       mzx_speed_write )
+COUNTER( "och!,!",           V284,   och_read,             NULL )
+COUNTER( "oco!,!",           V284,   oco_read,             NULL )
+COUNTER( "overlay_char",     V260,   overlay_char_read,    NULL )
+COUNTER( "overlay_color",    V260,   overlay_color_read,   NULL )
+COUNTER( "overlay_mode",     V260,   overlay_mode_read,    NULL )
+COUNTER( "pixel",            V260,   pixel_read,           pixel_write )
+COUNTER( "playerdist",       V100,   playerdist_read,      NULL )
+COUNTER( "playerfacedir",    V200,   playerfacedir_read,   playerfacedir_write )
+COUNTER( "playerlastdir",    V200,   playerlastdir_read,   playerlastdir_write )
+COUNTER( "playerx",          V251s1, playerx_read,         NULL )
+COUNTER( "playery",          V251s1, playery_read,         NULL )
+COUNTER( "play_game",        V290,   NULL,                 play_game_write )
+COUNTER( "r!.*",             V265,   r_read,               r_write )
+COUNTER( "random_seed!",     V291,   random_seed_read,     random_seed_write )
+COUNTER( "red_value",        V260,   red_value_read,       red_value_write )
+COUNTER( "rid*",             V269b,  rid_read,             NULL )
+COUNTER( "robot_id",         V260,   robot_id_read,        NULL )
+COUNTER( "robot_id_*",       V265,   robot_id_n_read,      NULL )
+COUNTER( "save_bc?",         V270,   save_bc_read,         NULL )
+COUNTER( "save_counters",    V290,   save_counters_read,   NULL )
+COUNTER( "save_game",        V268,   save_game_read,       NULL )
+COUNTER( "save_robot?",      V270,   save_robot_read,      NULL )
+COUNTER( "scrolledx",        V251s1, scrolledx_read,       NULL )
+COUNTER( "scrolledy",        V251s1, scrolledy_read,       NULL )
+COUNTER( "sin!",             V268,   sin_read,             NULL )
+COUNTER( "smzx_b!",          V269,   smzx_b_read,          smzx_b_write )
+COUNTER( "smzx_g!",          V269,   smzx_g_read,          smzx_g_write )
+COUNTER( "smzx_idx!,!",      V290,   smzx_idx_read,        smzx_idx_write )
+COUNTER( "smzx_indices",     V291,   smzx_indices_read,    NULL )
+COUNTER( "smzx_message",     V291,   smzx_message_read,    smzx_message_write )
+COUNTER( "smzx_mode",        V269,   smzx_mode_read,       smzx_mode_write )
+COUNTER( "smzx_palette",     V269,   smzx_palette_read,    NULL )
+COUNTER( "smzx_r!",          V269,   smzx_r_read,          smzx_r_write )
+COUNTER( "spacelock",        V284,   NULL,                 spacelock_write )
+COUNTER( "spr!_ccheck",      V265,   NULL,                 spr_ccheck_write )
+COUNTER( "spr!_cheight",     V265,   spr_cheight_read,     spr_cheight_write )
+COUNTER( "spr!_clist",       V265,   NULL,                 spr_clist_write )
+COUNTER( "spr!_cwidth",      V265,   spr_cwidth_read,      spr_cwidth_write )
+COUNTER( "spr!_cx",          V265,   spr_cx_read,          spr_cx_write )
+COUNTER( "spr!_cy",          V265,   spr_cy_read,          spr_cy_write )
+COUNTER( "spr!_height",      V265,   spr_height_read,      spr_height_write )
+COUNTER( "spr!_off",         V265,   spr_off_read,         spr_off_write )
+COUNTER( "spr!_offset",      V290,   spr_offset_read,      spr_offset_write )
+COUNTER( "spr!_overlaid",    V265,   NULL,                 spr_overlaid_write )
+COUNTER( "spr!_overlay",     V269c,  NULL,                 spr_overlaid_write )
+COUNTER( "spr!_refx",        V265,   spr_refx_read,        spr_refx_write )
+COUNTER( "spr!_refy",        V265,   spr_refy_read,        spr_refy_write )
+COUNTER( "spr!_setview",     V265,   NULL,                 spr_setview_write )
+COUNTER( "spr!_static",      V265,   NULL,                 spr_static_write )
+COUNTER( "spr!_swap",        V265,   NULL,                 spr_swap_write )
+COUNTER( "spr!_tcol",        V290,   spr_tcol_read,        spr_tcol_write )
+COUNTER( "spr!_unbound",     V290,   spr_unbound_read,     spr_unbound_write )
+COUNTER( "spr!_vlayer",      V269c,  NULL,                 spr_vlayer_write )
+COUNTER( "spr!_width",       V265,   spr_width_read,       spr_width_write )
+COUNTER( "spr!_x",           V265,   spr_x_read,           spr_x_write )
+COUNTER( "spr!_y",           V265,   spr_y_read,           spr_y_write )
+COUNTER( "spr!_z",           V292,   spr_z_read,           spr_z_write )
+COUNTER( "spr_clist!",       V265,   spr_clist_read,       NULL )
+COUNTER( "spr_collisions",   V265,   spr_collisions_read,  NULL )
+COUNTER( "spr_num",          V265,   spr_num_read,         spr_num_write )
+COUNTER( "spr_yorder",       V265,   NULL,                 spr_yorder_write )
+COUNTER( "sqrt!",            V268,   sqrt_read,            NULL )
+COUNTER( "tan!",             V268,   tan_read,             NULL )
+COUNTER( "thisx",            V200,   thisx_read,           NULL )
+COUNTER( "thisy",            V200,   thisy_read,           NULL )
+COUNTER( "this_char",        V260,   this_char_read,       NULL )
+COUNTER( "this_color",       V260,   this_color_read,      NULL )
+COUNTER( "timereset",        V200,   timereset_read,       timereset_write )
+COUNTER( "time_hours",       V260,   time_hours_read,      NULL )
+COUNTER( "time_millis",      V292,   time_millis_read,     NULL )
+COUNTER( "time_minutes",     V260,   time_minutes_read,    NULL )
+COUNTER( "time_seconds",     V260,   time_seconds_read,    NULL )
+COUNTER( "uch!,!",           V284,   uch_read,             NULL )
+COUNTER( "uco!,!",           V284,   uco_read,             NULL )
+COUNTER( "uid!,!",           V284,   uid_read,             uid_write )
+COUNTER( "upr!,!",           V284,   upr_read,             upr_write )
+COUNTER( "vch!,!",           V269c,  vch_read,             vch_write )
+COUNTER( "vco!,!",           V269c,  vco_read,             vco_write )
+COUNTER( "vertpld",          V100,   vertpld_read,         NULL )
+COUNTER( "vlayer_height",    V269c,  vlayer_height_read,   vlayer_height_write )
+COUNTER( "vlayer_size",      V281,   vlayer_size_read,     vlayer_size_write )
+COUNTER( "vlayer_width",     V269c,  vlayer_width_read,    vlayer_width_write )
@@ -0,0 +1,431 @@
+/* MegaZeux
+ *
+ * Copyright (C) 1996 Greg Janson
+ * Copyright (C) 1999 Charles Goetzman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+
+#include "counter_match.h"
+#include "memcasecmp.h"
+
+int match_function_counter(const char *dest, const char *src)
+{
+  int difference;
+  char cur_src, cur_dest;
+
+  while(1)
+  {
+    cur_src = *src;
+    cur_dest = *dest;
+
+    // Skip 1 or more letters
+    switch(cur_src)
+    {
+      // Make sure the first character is a number
+      case '!':
+      {
+        if(((cur_dest < '0') || (cur_dest > '9')) &&
+         (cur_dest != '-'))
+        {
+          // Don't want to accidentally match this char...
+          if(cur_dest == '!')
+            return 1;
+
+          break;
+        }
+
+        dest++;
+        cur_dest = *dest;
+
+        // Fall through, skip remaining numbers
+      }
+
+      /* fallthrough */
+
+      // Skip 0 or more number characters
+      case '?':
+      {
+        src++;
+        cur_src = *src;
+
+        while(((cur_dest >= '0') && (cur_dest <= '9')) ||
+         (cur_dest == '-'))
+        {
+          dest++;
+          cur_dest = *dest;
+        }
+        break;
+      }
+
+      // Match anything, instant winner
+      case '*':
+      {
+        return 0;
+      }
+    }
+
+    if((cur_src | cur_dest) == 0)
+    {
+      // Both hit the null terminator
+      return 0;
+    }
+
+    difference = (int)((cur_dest & 0xDF) - (cur_src & 0xDF));
+
+    if(difference)
+      return difference;
+
+    src++;
+    dest++;
+  }
+
+  return 0;
+}
+
+#define FNV_OFFSET_BASIS  2166136261u
+#define FNV_PRIME         16777619u
+
+// Number characters compare equal under the case-insensitive (& 0xDF)
+// comparison to these, so they all have to hash the same way.
+#define IS_NUMBER_CLASS(c) \
+ ((((c) & 0xDF) >= ('0' & 0xDF) && ((c) & 0xDF) <= ('9' & 0xDF)) || \
+  (((c) & 0xDF) == ('-' & 0xDF)))
+
+#define NUMBER_MARKER '#'
+
+/**
+ * Hash the canonical form of a name: the first character is lowercased
+ * (matching how the function counter list is grouped), the rest are
+ * compared case-insensitively, and each run of number characters becomes a
+ * single marker. Returns false if the canonical form is too long to be a key.
+ */
+static boolean hash_function_counter_name(const char *name, uint32_t *hash)
+{
+  uint32_t h = FNV_OFFSET_BASIS;
+  boolean in_number = false;
+  int length = 1;
+  int c;
+
+  h = (h ^ (uint32_t)memtolower((unsigned char)*name)) * FNV_PRIME;
+  if(*name)
+    name++;
+
+  for(; *name; name++)
+  {
+    c = (unsigned char)*name;
+
+    if(IS_NUMBER_CLASS(c))
+    {
+      if(in_number)
+        continue;
+
+      c = NUMBER_MARKER;
+      in_number = true;
+    }
+    else
+    {
+      c &= 0xDF;
+      in_number = false;
+    }
+
+    if(++length > FUNCTION_COUNTER_MAX_KEY)
+      return false;
+
+    h = (h ^ (uint32_t)c) * FNV_PRIME;
+  }
+
+  *hash = h;
+  return true;
+}
+
+/**
+ * Write a name that hashes the same as anything matching a pattern. If the
+ * pattern contains a '?', with_number selects whether the name has a number
+ * in its place. Returns -1 if the pattern can't be reduced to one name,
+ * 1 if it contains a '?', and 0 otherwise.
+ */
+static int function_counter_key(const char *pattern, boolean with_number,
+ char *buffer)
+{
+  boolean has_optional = false;
+  int pos = 1;
+  int i;
+
+  buffer[0] = pattern[0];
+  if(!pattern[0])
+    return 0;
+
+  for(i = 1; pattern[i]; i++)
+  {
+    switch(pattern[i])
+    {
+      case '*':
+        return -1;
+
+      case '?':
+        if(has_optional)
+          return -1;
+
+        has_optional = true;
+        if(!with_number)
+          continue;
+
+        /* fallthrough */
+
+      case '!':
+        buffer[pos++] = '0';
+        break;
+
+      default:
+        buffer[pos++] = pattern[i];
+        break;
+    }
+
+    if(pos >= FUNCTION_COUNTER_MAX_KEY)
+      return -1;
+  }
+
+  buffer[pos] = 0;
+  return has_optional;
+}
+
+static inline uint32_t function_counter_slot(uint32_t hash,
+ unsigned int displacement)
+{
+  uint32_t h = hash ^ (displacement * 0x9E3779B9u);
+  h ^= h >> 16;
+  h *= 0x85EBCA6Bu;
+  h ^= h >> 13;
+  h *= 0xC2B2AE35u;
+  h ^= h >> 16;
+  return h & (FUNCTION_COUNTER_SLOTS - 1);
+}
+
+static inline const char *function_counter_name(
+ const struct function_counter_index *index, int pos)
+{
+  return *(const char * const *)(index->first_name + pos * index->stride);
+}
+
+static inline boolean function_counter_matches(
+ const struct function_counter_index *index, int pos, const char *name,
+ int first_char)
+{
+  const char *pattern = function_counter_name(index, pos);
+
+  return (first_char == (unsigned char)pattern[0]) &&
+   !match_function_counter(name + 1, pattern + 1);
+}
+
+struct function_counter_key
+{
+  uint32_t hash;
+  int16_t pos;
+};
+
+static boolean add_function_counter_other(
+ struct function_counter_index *index, int pos)
+{
+  int c;
+  int i;
+
+  for(i = 0; i < index->num_other; i++)
+    if(index->other[i] == pos)
+      return true;
+
+  if(index->num_other >= FUNCTION_COUNTER_MAX_OTHER)
+    return false;
+
+  c = (unsigned char)function_counter_name(index, pos)[0];
+  index->other_first_chars[c >> 5] |= (1u << (c & 31));
+  index->other[index->num_other++] = pos;
+  return true;
+}
+
+boolean init_function_counter_index(struct function_counter_index *index,
+ const char * const *first_name, size_t stride, int num_names)
+{
+  struct function_counter_key keys[FUNCTION_COUNTER_SLOTS];
+  int bucket_size[FUNCTION_COUNTER_BUCKETS];
+  int bucket_slots[FUNCTION_COUNTER_SLOTS];
+  char buffer[FUNCTION_COUNTER_MAX_KEY + 1];
+  int num_keys = 0;
+  int largest = 0;
+  int i, j, k;
+
+  memset(index, 0, sizeof(struct function_counter_index));
+  memset(index->slot_index, 0xFF, sizeof(index->slot_index));
+  index->first_name = (const char *)first_name;
+  index->stride = stride;
+  index->num_names = num_names;
+
+  for(i = 0; i < num_names; i++)
+  {
+    int c = (unsigned char)function_counter_name(index, i)[0];
+    index->first_chars[c >> 5] |= (1u << (c & 31));
+  }
+
+  for(i = 0; i < num_names; i++)
+  {
+    const char *pattern = function_counter_name(index, i);
+    int variants = function_counter_key(pattern, false, buffer) + 1;
+
+    if(!variants)
+    {
+      if(!add_function_counter_other(index, i))
+        return false;
+      continue;
+    }
+
+    for(j = 0; j < variants; j++)
+    {
+      uint32_t hash = 0;
+
+      if(j)
+        function_counter_key(pattern, true, buffer);
+
+      if(num_keys >= FUNCTION_COUNTER_SLOTS ||
+       !hash_function_counter_name(buffer, &hash))
+        return false;
+
+      // Two patterns with the same key (or hash) can't share a slot, so
+      // the later one has to be checked separately.
+      for(k = 0; k < num_keys; k++)
+        if(keys[k].hash == hash)
+          break;
+
+      if(k < num_keys)
+      {
+        if(!add_function_counter_other(index, i))
+          return false;
+        continue;
+      }
+
+      keys[num_keys].hash = hash;
+      keys[num_keys].pos = i;
+      num_keys++;
+    }
+  }
+
+  memset(bucket_size, 0, sizeof(bucket_size));
+  for(i = 0; i < num_keys; i++)
+  {
+    int size = ++bucket_size[keys[i].hash & (FUNCTION_COUNTER_BUCKETS - 1)];
+    if(size > largest)
+      largest = size;
+  }
+
+  // Place the largest buckets first, since they're the hardest to fit.
+  for(; largest > 0; largest--)
+  {
+    for(i = 0; i < FUNCTION_COUNTER_BUCKETS; i++)
+    {
+      unsigned int displacement;
+      int num_slots = 0;
+
+      if(bucket_size[i] != largest)
+        continue;
+
+      for(displacement = 0; displacement <= UINT16_MAX; displacement++)
+      {
+        num_slots = 0;
+        for(j = 0; j < num_keys; j++)
+        {
+          uint32_t slot;
+
+          if((keys[j].hash & (FUNCTION_COUNTER_BUCKETS - 1)) != (uint32_t)i)
+            continue;
+
+          slot = function_counter_slot(keys[j].hash, displacement);
+          if(index->slot_index[slot] >= 0)
+            break;
+
+          for(k = 0; k < num_slots; k++)
+            if(bucket_slots[k] == (int)slot)
+              break;
+
+          if(k < num_slots)
+            break;
+
+          bucket_slots[num_slots++] = slot;
+        }
+
+        if(j == num_keys)
+          break;
+      }
+
+      if(displacement > UINT16_MAX)
+        return false;
+
+      index->displacement[i] = displacement;
+      for(j = 0, k = 0; j < num_keys; j++)
+      {
+        if((keys[j].hash & (FUNCTION_COUNTER_BUCKETS - 1)) != (uint32_t)i)
+          continue;
+
+        index->slot_index[bucket_slots[k]] = keys[j].pos;
+        index->slot_hash[bucket_slots[k]] = keys[j].hash;
+        k++;
+      }
+    }
+  }
+
+  index->valid = true;
+  return true;
+}
+
+int find_function_counter_index(const struct function_counter_index *index,
+ const char *name)
+{
+  int c = memtolower((unsigned char)name[0]);
+  uint32_t hash;
+  int i;
+
+  // Most user counters can be rejected from their first character alone.
+  if(!(index->first_chars[c >> 5] & (1u << (c & 31))))
+    return -1;
+
+  if(!index->valid)
+  {
+    for(i = 0; i < index->num_names; i++)
+      if(function_counter_matches(index, i, name, c))
+        return i;
+
+    return -1;
+  }
+
+  if(hash_function_counter_name(name, &hash))
+  {
+    uint32_t slot = function_counter_slot(hash,
+     index->displacement[hash & (FUNCTION_COUNTER_BUCKETS - 1)]);
+
+    i = index->slot_index[slot];
+    if(i >= 0 && index->slot_hash[slot] == hash &&
+     function_counter_matches(index, i, name, c))
+      return i;
+  }
+
+  if(!(index->other_first_chars[c >> 5] & (1u << (c & 31))))
+    return -1;
+
+  for(i = 0; i < index->num_other; i++)
+    if(function_counter_matches(index, index->other[i], name, c))
+      return index->other[i];
+
+  return -1;
+}
@@ -0,0 +1,90 @@
+/* MegaZeux
+ *
+ * Copyright (C) 1996 Greg Janson
+ * Copyright (C) 1999 Charles Goetzman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __COUNTER_MATCH_H
+#define __COUNTER_MATCH_H
+
+#include "compat.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+__M_BEGIN_DECLS
+
+/**
+ * Function counter names are patterns where '!' matches one or more number
+ * characters, '?' matches zero or more number characters, and '*' matches
+ * the rest of the name. Everything else is matched case-insensitively.
+ */
+CORE_LIBSPEC int match_function_counter(const char *dest, const char *src);
+
+#define FUNCTION_COUNTER_MAX_KEY      32
+#define FUNCTION_COUNTER_BUCKETS      64
+#define FUNCTION_COUNTER_SLOTS        512
+#define FUNCTION_COUNTER_MAX_OTHER    16
+
+/**
+ * Perfect hash over a fixed table of function counter patterns. Names are
+ * hashed in a canonical form where each run of number characters becomes a
+ * single marker, so "spr12_x" and "spr!_x" hash the same; a hit is then
+ * confirmed with match_function_counter. Patterns that can't be reduced to a
+ * single key (anything with '*') are kept in a short separate list.
+ */
+struct function_counter_index
+{
+  const char *first_name;
+  size_t stride;
+  int num_names;
+  boolean valid;
+  uint32_t first_chars[256 / 32];
+  uint16_t displacement[FUNCTION_COUNTER_BUCKETS];
+  int16_t slot_index[FUNCTION_COUNTER_SLOTS];
+  uint32_t slot_hash[FUNCTION_COUNTER_SLOTS];
+  uint32_t other_first_chars[256 / 32];
+  int16_t other[FUNCTION_COUNTER_MAX_OTHER];
+  int num_other;
+};
+
+/**
+ * Build an index over num_names patterns. The pattern names are read from
+ * const char * fields stride bytes apart, starting at first_name, which
+ * allows indexing the name field of an array of structs directly.
+ *
+ * The table is built at runtime (counter_fsg does this once at startup)
+ * rather than generated at build time, so counter_list.h stays the only list
+ * of counters. Each bucket searches for a displacement that doesn't collide,
+ * trying up to 65536 of them, but for the builtin counters none needs more
+ * than a few and the whole build takes tens of microseconds. If it fails
+ * anyway, valid is false and lookups fall back to a linear search;
+ * unit/counter_match.cpp checks that this never happens for counter_list.h.
+ */
+boolean init_function_counter_index(struct function_counter_index *index,
+ const char * const *first_name, size_t stride, int num_names);
+
+/**
+ * Find the pattern matching a name. Returns its position in the table or
+ * -1 if no pattern matches.
+ */
+int find_function_counter_index(const struct function_counter_index *index,
+ const char *name);
+
+__M_END_DECLS
+
+#endif /* __COUNTER_MATCH_H */
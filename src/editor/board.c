@@ -294,6 +294,11 @@ struct board *create_blank_board(struct editor_config_info *conf)
   cur_board->num_robots_allocated = 0;
   cur_board->robot_list = cmalloc(sizeof(struct robot *));
   cur_board->robot_list_name_sorted = NULL;
+  cur_board->robot_name_table = NULL;
+  cur_board->label_index = NULL;
+  cur_board->robot_name_list_dirty = false;
+  cur_board->is_lazy = false;
+  cur_board->extram_data = NULL;
   cur_board->num_scrolls = 0;
   cur_board->num_scrolls_allocated = 0;
   cur_board->scroll_list = cmalloc(sizeof(struct scroll *));
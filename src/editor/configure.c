@@ -21,6 +21,7 @@
 #include "robo_ed.h"
 
 #include "../counter.h"
+#include "../counter_match.h"
 #include "../configure.h"
 #include "../const.h"
 #include "../util.h"
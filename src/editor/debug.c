@@ -33,6 +33,7 @@
 #include "../graphics.h"
 #include "../intake.h"
 #include "../memcasecmp.h"
+#include "../robot.h"
 #include "../scrdisp.h"
 #include "../sprite.h"
 #include "../str.h"
@@ -2958,6 +2959,8 @@ void __draw_debug_box(struct world *mzx_world, int x, int y, int d_x, int d_y,
   write_number(mzx_world->current_board_id, DI_DEBUG_NUMBER,
    x + 18, y + 2, 0, 1, 10);
 
+  update_robot_name_list(src_board);
+
   for(i = 0; i < src_board->num_robots_active; i++)
   {
     robot_mem +=
@@ -59,6 +59,7 @@
 #include "pal_ed.h"
 #include "param.h"
 #include "robo_debug.h"
+#include "robo_profile.h"
 #include "robot.h"
 #include "select.h"
 #include "sfx_edit.h"
@@ -210,6 +211,9 @@ static boolean editor_reload_world(struct editor_context *editor,
   if(!reload_world(mzx_world, file, &ignore))
     return false;
 
+  // The editor needs every board, so don't leave any to be loaded later.
+  load_all_boards(mzx_world);
+
   // Part 1: Reset the config file.
   load_editor_config_backup();
 
@@ -3523,6 +3527,9 @@ static void editor_resume(context *ctx)
     editor->reload_after_testing = false;
     chdir(editor->test_reload_dir);
 
+    // Leave the robot profile next to the world so it can be inspected later.
+    dump_robot_profile(ROBOT_PROFILE_FILE);
+
     if(!reload_world(mzx_world, editor->test_reload_file, &ignore))
     {
       if(!editor_reload_world(editor, editor->current_world))
@@ -3535,6 +3542,8 @@ static void editor_resume(context *ctx)
 
     else
     {
+      load_all_boards(mzx_world);
+
       // Set it back to the original version.
       mzx_world->version = editor->test_reload_version;
     }
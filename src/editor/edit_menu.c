@@ -23,6 +23,7 @@
 #include "../event.h"
 #include "../idput.h"
 #include "../graphics.h"
+#include "../robot.h"
 #include "../util.h"
 #include "../window.h"
 #include "../world_struct.h"
@@ -531,6 +532,8 @@ static size_t compute_robot_memory(struct edit_menu_subcontext *edit_menu)
   size_t robot_mem = 0;
   int i;
 
+  update_robot_name_list(cur_board);
+
   for(i = 0; i < cur_board->num_robots_active; i++)
   {
     robot_mem +=
@@ -25,6 +25,7 @@
 #include "debug.h"
 #include "robot.h"
 #include "robo_debug.h"
+#include "robo_profile.h"
 #include "stringsearch.h"
 #include "window.h"
 
@@ -339,6 +340,7 @@ static int debug_config_idle_function(struct world *mzx_world,
  *  1 : add/new
  *  2 : delete
  *  3 : enable/disable debugger
+ *  4 : profiler
  */
 
 void __debug_robot_config(struct world *mzx_world)
@@ -353,7 +355,7 @@ void __debug_robot_config(struct world *mzx_world)
   int i;
 
   int result = 0;
-  struct element *elements[10];
+  struct element *elements[11];
   struct dialog di;
 
   int br_element = 6;
@@ -420,8 +422,8 @@ void __debug_robot_config(struct world *mzx_world)
     br_list[num_breakpoints] = (char *) "(new)";
     wt_list[num_watchpoints] = (char *) "(new)";
 
-    elements[0] = construct_label(3, 23,
-     "~9Alt+N : New   Enter : Edit   Alt+D : Delete");
+    elements[0] = construct_label(2, 23,
+     "~9Alt+N:New  Enter:Edit  Alt+D:Delete");
 
     elements[1] = construct_label(2, 1, "Breakpoint substring");
     elements[2] = construct_label(55, 1, "Line");
@@ -438,10 +440,12 @@ void __debug_robot_config(struct world *mzx_world)
      (const char **)wt_list, num_watchpoints + 1,
      9, 76, 0, &wt_selected, NULL, false);
 
-    elements[8] = construct_button(50, 23,
+    elements[8] = construct_button(40, 23, "Profiler", 4);
+
+    elements[9] = construct_button(51, 23,
      enable_text[robo_debugger_enabled], 3);
 
-    elements[9] = construct_button(70, 23, "Done", -1);
+    elements[10] = construct_button(72, 23, "Done", -1);
 
     construct_dialog_ext(&di, "Configure Robot Debugger", 0, 0, 80, 25,
      elements, ARRAY_SIZE(elements), 0, 0, focus, debug_config_idle_function);
@@ -550,6 +554,13 @@ void __debug_robot_config(struct world *mzx_world)
         robo_debugger_override = 1;
         break;
       }
+
+      // Profiler
+      case 4:
+      {
+        robot_profile_dialog(mzx_world);
+        break;
+      }
     }
 
     destruct_dialog(&di);
@@ -585,6 +596,8 @@ void reset_robot_debugger(void)
     watchpoints[i]->last_value = 0;
 
   step = false;
+
+  reset_robot_profile();
 }
 
 // Called when the editor exits
@@ -614,6 +627,8 @@ void free_breakpoints(void)
   robo_debugger_enabled = 0;
   robo_debugger_override = 0;
   step = false;
+
+  free_robot_profile();
 }
 
 
@@ -965,6 +980,9 @@ static int debug_robot(context *ctx, struct robot *cur_robot, int id,
   cur_robot->commands_total += lines_run;
   cur_robot->commands_cycle = lines_run;
 
+  // Don't charge the time spent in the debugger to this command.
+  robot_profile_pause();
+
   dialog_fadein();
 
   // Prevent previous keys from carrying through.
@@ -1089,6 +1107,7 @@ static int debug_robot(context *ctx, struct robot *cur_robot, int id,
   // Prevent UI keys from carrying through.
   force_release_all_keys();
 
+  robot_profile_resume();
   return ret_val;
 }
 
@@ -0,0 +1,728 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2017 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Instrumenting robot profiler. While enabled, run_robot reports the start
+ * of every command it runs, and the time until the next report is charged
+ * to that command. Time is kept per robot and per bytecode position; the
+ * positions are mapped back to source lines through the command map the
+ * first time each one runs, so the results outlive the robots.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "robo_profile.h"
+#include "robot.h"
+
+#include "../core.h"
+#include "../event.h"
+#include "../robot.h"
+#include "../util.h"
+#include "../window.h"
+#include "../world_struct.h"
+
+#define PROFILE_TEXT_SIZE 48
+#define PROFILE_MAX_LINES 1000
+
+struct profile_line
+{
+  uint64_t time;
+  unsigned int count;
+  int line_number;
+  char *text;
+};
+
+struct profile_robot
+{
+  char robot_name[ROBOT_NAME_SIZE];
+  int board_id;
+  int robot_id;
+  const char *program;
+  int program_length;
+  uint64_t time;
+  uint64_t commands;
+  unsigned int cycles;
+  struct profile_line *lines;
+};
+
+enum profile_view
+{
+  VIEW_ROBOTS,
+  VIEW_LINES,
+  NUM_VIEWS
+};
+
+enum profile_sort
+{
+  SORT_TIME,
+  SORT_COUNT,
+  SORT_NAME,
+  NUM_SORTS
+};
+
+struct profile_line_ref
+{
+  struct profile_robot *robot;
+  struct profile_line *line;
+};
+
+static struct profile_robot **profile_robots = NULL;
+static int num_profile_robots = 0;
+static int num_profile_robots_allocated = 0;
+
+static boolean profiler_enabled = false;
+
+// The command currently being timed.
+static struct profile_robot *current = NULL;
+static struct profile_line *current_line = NULL;
+static uint64_t current_start;
+static boolean current_ran;
+
+static uint64_t pause_start;
+static int pause_depth = 0;
+
+static int profile_view = VIEW_ROBOTS;
+static int profile_sort = SORT_TIME;
+static int profile_selected = 0;
+
+static void map_profile_line(struct profile_line *line,
+ struct robot *cur_robot, int program_pos)
+{
+  struct command_mapping *cmd_map = cur_robot->command_map;
+  const char *src;
+  size_t len;
+  int num;
+
+  if(!program_pos)
+  {
+    src = "(start of cycle)";
+    len = strlen(src);
+  }
+  else
+
+  if(!cmd_map || !cur_robot->program_source)
+  {
+    line->line_number = -program_pos;
+    return;
+  }
+
+  else
+  {
+    num = get_program_command_num(cur_robot, program_pos);
+    line->line_number = cmd_map[num].real_line;
+
+    src = cur_robot->program_source + cmd_map[num].src_pos;
+    for(len = 0; len < PROFILE_TEXT_SIZE - 1; len++)
+      if(!src[len] || src[len] == '\n')
+        break;
+  }
+
+  line->text = cmalloc(len + 1);
+  memcpy(line->text, src, len);
+  line->text[len] = 0;
+}
+
+static struct profile_robot *new_profile_robot(struct world *mzx_world,
+ struct robot *cur_robot, int id)
+{
+  struct profile_robot *prof = ccalloc(1, sizeof(struct profile_robot));
+
+  if(num_profile_robots >= num_profile_robots_allocated)
+  {
+    num_profile_robots_allocated = MAX(num_profile_robots_allocated * 2, 32);
+    profile_robots = crealloc(profile_robots,
+     num_profile_robots_allocated * sizeof(struct profile_robot *));
+  }
+
+  memcpy(prof->robot_name, cur_robot->robot_name, ROBOT_NAME_SIZE);
+  prof->board_id = mzx_world->current_board_id;
+  prof->robot_id = id;
+  prof->program = cur_robot->program_bytecode;
+  prof->program_length = cur_robot->program_bytecode_length;
+  prof->lines = ccalloc(MAX(prof->program_length, 1),
+   sizeof(struct profile_line));
+
+#ifndef CONFIG_DEBYTECODE
+  // Make sure there's a command map to find the line numbers with.
+  prepare_robot_source(cur_robot);
+#endif
+
+  profile_robots[num_profile_robots++] = prof;
+  return prof;
+}
+
+static inline boolean is_profile_robot(struct profile_robot *prof,
+ struct world *mzx_world, struct robot *cur_robot, int id)
+{
+  return prof->program == cur_robot->program_bytecode &&
+   prof->program_length == cur_robot->program_bytecode_length &&
+   prof->robot_id == id && prof->board_id == mzx_world->current_board_id;
+}
+
+static struct profile_robot *get_profile_robot(struct world *mzx_world,
+ struct robot *cur_robot, int id)
+{
+  int index = cur_robot->profile_id - 1;
+  int i;
+
+  if(index >= 0 && index < num_profile_robots &&
+   is_profile_robot(profile_robots[index], mzx_world, cur_robot, id))
+    return profile_robots[index];
+
+  // The robot might have been copied or reallocated since it was last seen.
+  for(i = num_profile_robots - 1; i >= 0; i--)
+  {
+    if(is_profile_robot(profile_robots[i], mzx_world, cur_robot, id) &&
+     !strcmp(profile_robots[i]->robot_name, cur_robot->robot_name))
+      break;
+  }
+
+  if(i < 0)
+  {
+    new_profile_robot(mzx_world, cur_robot, id);
+    i = num_profile_robots - 1;
+  }
+
+  cur_robot->profile_id = i + 1;
+  return profile_robots[i];
+}
+
+static void __debug_robot_profile(struct world *mzx_world,
+ struct robot *cur_robot, int id, int program_pos)
+{
+  uint64_t now = get_time_ns();
+
+  if(current_line)
+  {
+    uint64_t elapsed = now - current_start;
+    current_line->time += elapsed;
+    current->time += elapsed;
+  }
+
+  // End of the cycle.
+  if(!cur_robot)
+  {
+    if(current && current_ran)
+      current->cycles++;
+
+    current = NULL;
+    current_line = NULL;
+    return;
+  }
+
+  if(id < 0)
+    id = -id;
+
+  // A new cycle or the program was replaced mid-cycle.
+  if(!program_pos || !current ||
+   current->program != cur_robot->program_bytecode)
+  {
+    current = get_profile_robot(mzx_world, cur_robot, id);
+    if(!program_pos)
+      current_ran = false;
+  }
+
+  if(program_pos < 0 || program_pos >= current->program_length)
+  {
+    current_line = NULL;
+    current_start = now;
+    return;
+  }
+
+  current_line = &(current->lines[program_pos]);
+  if(!current_line->count && !current_line->line_number &&
+   !current_line->text)
+    map_profile_line(current_line, cur_robot, program_pos);
+
+  if(program_pos)
+  {
+    current_line->count++;
+    current->commands++;
+    current_ran = true;
+  }
+
+  // Don't charge the time spent profiling to the command.
+  current_start = get_time_ns();
+}
+
+/**
+ * Stop charging time to the current command, e.g. while the robot debugger
+ * is waiting for the user.
+ */
+void robot_profile_pause(void)
+{
+  if(!pause_depth++)
+    pause_start = get_time_ns();
+}
+
+void robot_profile_resume(void)
+{
+  if(pause_depth && !--pause_depth)
+    current_start += get_time_ns() - pause_start;
+}
+
+static void enable_robot_profile(boolean enable)
+{
+  profiler_enabled = enable;
+  debug_robot_profile = enable ? __debug_robot_profile : NULL;
+  current = NULL;
+  current_line = NULL;
+}
+
+void reset_robot_profile(void)
+{
+  int i;
+
+  for(i = 0; i < num_profile_robots; i++)
+  {
+    struct profile_robot *prof = profile_robots[i];
+    int j;
+
+    for(j = 0; j < prof->program_length; j++)
+      free(prof->lines[j].text);
+
+    free(prof->lines);
+    free(prof);
+  }
+
+  free(profile_robots);
+  profile_robots = NULL;
+  num_profile_robots = 0;
+  num_profile_robots_allocated = 0;
+
+  current = NULL;
+  current_line = NULL;
+}
+
+// Called when the editor exits
+void free_robot_profile(void)
+{
+  reset_robot_profile();
+  enable_robot_profile(false);
+  profile_selected = 0;
+}
+
+/******************/
+/* Sorted results */
+/******************/
+
+static int cmp_robot_time(const void *a, const void *b)
+{
+  const struct profile_robot *A = *(const struct profile_robot * const *)a;
+  const struct profile_robot *B = *(const struct profile_robot * const *)b;
+  return (A->time < B->time) - (A->time > B->time);
+}
+
+static int cmp_robot_count(const void *a, const void *b)
+{
+  const struct profile_robot *A = *(const struct profile_robot * const *)a;
+  const struct profile_robot *B = *(const struct profile_robot * const *)b;
+  return (A->commands < B->commands) - (A->commands > B->commands);
+}
+
+static int cmp_robot_name(const void *a, const void *b)
+{
+  const struct profile_robot *A = *(const struct profile_robot * const *)a;
+  const struct profile_robot *B = *(const struct profile_robot * const *)b;
+  int res = strcasecmp(A->robot_name, B->robot_name);
+
+  if(!res)
+    res = cmp_robot_time(a, b);
+  return res;
+}
+
+static int cmp_line_time(const void *a, const void *b)
+{
+  const struct profile_line *A = ((const struct profile_line_ref *)a)->line;
+  const struct profile_line *B = ((const struct profile_line_ref *)b)->line;
+  return (A->time < B->time) - (A->time > B->time);
+}
+
+static int cmp_line_count(const void *a, const void *b)
+{
+  const struct profile_line *A = ((const struct profile_line_ref *)a)->line;
+  const struct profile_line *B = ((const struct profile_line_ref *)b)->line;
+  return (A->count < B->count) - (A->count > B->count);
+}
+
+static int cmp_line_name(const void *a, const void *b)
+{
+  const struct profile_line_ref *A = (const struct profile_line_ref *)a;
+  const struct profile_line_ref *B = (const struct profile_line_ref *)b;
+  int res = strcasecmp(A->robot->robot_name, B->robot->robot_name);
+
+  if(!res)
+    res = (A->line->line_number > B->line->line_number) -
+     (A->line->line_number < B->line->line_number);
+  return res;
+}
+
+static struct profile_robot **get_sorted_robots(int sort)
+{
+  struct profile_robot **robots =
+   cmalloc(MAX(num_profile_robots, 1) * sizeof(struct profile_robot *));
+
+  memcpy(robots, profile_robots,
+   num_profile_robots * sizeof(struct profile_robot *));
+
+  qsort(robots, num_profile_robots, sizeof(struct profile_robot *),
+   sort == SORT_NAME ? cmp_robot_name :
+   sort == SORT_COUNT ? cmp_robot_count : cmp_robot_time);
+
+  return robots;
+}
+
+static struct profile_line_ref *get_sorted_lines(int sort, int *_num_lines)
+{
+  struct profile_line_ref *lines = NULL;
+  int num_lines = 0;
+  int num_allocated = 0;
+  int i;
+  int j;
+
+  for(i = 0; i < num_profile_robots; i++)
+  {
+    struct profile_robot *prof = profile_robots[i];
+
+    for(j = 0; j < prof->program_length; j++)
+    {
+      struct profile_line *line = &(prof->lines[j]);
+
+      if(!line->time && !line->count)
+        continue;
+
+      if(num_lines >= num_allocated)
+      {
+        num_allocated = MAX(num_allocated * 2, 256);
+        lines = crealloc(lines, num_allocated * sizeof(struct profile_line_ref));
+      }
+
+      lines[num_lines].robot = prof;
+      lines[num_lines].line = line;
+      num_lines++;
+    }
+  }
+
+  if(num_lines)
+  {
+    qsort(lines, num_lines, sizeof(struct profile_line_ref),
+     sort == SORT_NAME ? cmp_line_name :
+     sort == SORT_COUNT ? cmp_line_count : cmp_line_time);
+  }
+
+  *_num_lines = num_lines;
+  return lines;
+}
+
+static uint64_t get_profile_total_time(void)
+{
+  uint64_t total = 0;
+  int i;
+
+  for(i = 0; i < num_profile_robots; i++)
+    total += profile_robots[i]->time;
+
+  return total;
+}
+
+static void format_line_number(char buffer[12], struct profile_line *line)
+{
+  if(line->line_number > 0)
+    snprintf(buffer, 12, "%d", line->line_number);
+  else
+
+  if(line->line_number < 0)
+    snprintf(buffer, 12, "@%d", -line->line_number);
+
+  else
+    snprintf(buffer, 12, "-");
+}
+
+/**
+ * Write a flat profile for offline analysis. The robots and lines are both
+ * written as tab-separated records sorted by time.
+ */
+boolean dump_robot_profile(const char *filename)
+{
+  struct profile_robot **robots;
+  struct profile_line_ref *lines;
+  char line_number[12];
+  int num_lines;
+  FILE *fp;
+  int i;
+
+  if(!num_profile_robots)
+    return false;
+
+  fp = fopen_unsafe(filename, "wb");
+  if(!fp)
+    return false;
+
+  robots = get_sorted_robots(SORT_TIME);
+  lines = get_sorted_lines(SORT_TIME, &num_lines);
+
+  fprintf(fp, "# MegaZeux robot profile (times in nanoseconds)\n");
+  fprintf(fp, "# total_time\t%" PRIu64 "\n\n", get_profile_total_time());
+
+  fprintf(fp, "# robot\tboard\tid\ttime\tcommands\tcycles\n");
+  for(i = 0; i < num_profile_robots; i++)
+  {
+    fprintf(fp, "%s\t%d\t%d\t%" PRIu64 "\t%" PRIu64 "\t%u\n",
+     robots[i]->robot_name, robots[i]->board_id, robots[i]->robot_id,
+     robots[i]->time, robots[i]->commands, robots[i]->cycles);
+  }
+
+  fprintf(fp, "\n# robot\tboard\tid\tline\ttime\tcount\tsource\n");
+  for(i = 0; i < num_lines; i++)
+  {
+    struct profile_robot *prof = lines[i].robot;
+    struct profile_line *line = lines[i].line;
+
+    format_line_number(line_number, line);
+
+    fprintf(fp, "%s\t%d\t%d\t%s\t%" PRIu64 "\t%u\t%s\n",
+     prof->robot_name, prof->board_id, prof->robot_id, line_number,
+     line->time, line->count, line->text ? line->text : "");
+  }
+
+  fclose(fp);
+  free(robots);
+  free(lines);
+  return true;
+}
+
+/*******************/
+/* Hot list dialog */
+/*******************/
+
+static int profile_idle_function(struct world *mzx_world,
+ struct dialog *di, int key)
+{
+  switch(key)
+  {
+    // Toggle view
+    case IKEY_v:
+    {
+      if(get_alt_status(keycode_internal))
+      {
+        di->return_value = 2;
+        di->done = 1;
+        return 0;
+      }
+      break;
+    }
+    // Change sort
+    case IKEY_s:
+    {
+      if(get_alt_status(keycode_internal))
+      {
+        di->return_value = 3;
+        di->done = 1;
+        return 0;
+      }
+      break;
+    }
+  }
+
+  return key;
+}
+
+static char **build_robot_list(int *num_choices, uint64_t total)
+{
+  struct profile_robot **robots = get_sorted_robots(profile_sort);
+  char **list = ccalloc(num_profile_robots + 1, sizeof(char *));
+  int i;
+
+  for(i = 0; i < num_profile_robots; i++)
+  {
+    struct profile_robot *prof = robots[i];
+
+    list[i] = cmalloc(77);
+    snprintf(list[i], 77, "%-14.14s %5d %4d %11.3f %5.1f%% %11" PRIu64
+     " %7u %9.2f",
+     prof->robot_name, prof->board_id, prof->robot_id,
+     prof->time / 1000000.0, total ? prof->time * 100.0 / total : 0.0,
+     prof->commands, prof->cycles,
+     prof->cycles ? prof->time / 1000.0 / prof->cycles : 0.0);
+  }
+
+  free(robots);
+  *num_choices = num_profile_robots;
+  return list;
+}
+
+static char **build_line_list(int *num_choices, uint64_t total)
+{
+  struct profile_line_ref *lines;
+  char line_number[12];
+  char **list;
+  int num_lines;
+  int i;
+
+  lines = get_sorted_lines(profile_sort, &num_lines);
+  num_lines = MIN(num_lines, PROFILE_MAX_LINES);
+  list = ccalloc(num_lines + 1, sizeof(char *));
+
+  for(i = 0; i < num_lines; i++)
+  {
+    struct profile_robot *prof = lines[i].robot;
+    struct profile_line *line = lines[i].line;
+
+    format_line_number(line_number, line);
+
+    list[i] = cmalloc(77);
+    snprintf(list[i], 77, "%-14.14s %6s %10.3f %5.1f%% %10u  %s",
+     prof->robot_name, line_number, line->time / 1000000.0,
+     total ? line->time * 100.0 / total : 0.0, line->count,
+     line->text ? line->text : "");
+  }
+
+  free(lines);
+  *num_choices = num_lines;
+  return list;
+}
+
+/* Results:
+ * -1 : close
+ *  0 : enable/disable profiler
+ *  1 : reset
+ *  2 : change view
+ *  3 : change sort
+ */
+
+void robot_profile_dialog(struct world *mzx_world)
+{
+  const char *enable_text[] = {
+   "Enable Profiler ",
+   "Disable Profiler",
+  };
+  const char *view_text[] = {
+   "View: Robots",
+   "View: Lines ",
+  };
+  const char *sort_text[] = {
+   "Sort: Time ",
+   "Sort: Count",
+   "Sort: Name ",
+  };
+  const char *header_text[] = {
+   "Robot          Board   ID     Time ms      %    Commands  Cycles  us/cycle",
+   "Robot            Line    Time ms      %      Count  Source",
+  };
+
+  struct element *elements[8];
+  struct dialog di;
+  uint64_t total;
+  char **list;
+  char total_text[77];
+  boolean has_data;
+  int num_choices;
+  int result;
+  int focus = 2;
+  int i;
+
+  robot_profile_pause();
+
+  // Prevent previous keys from carrying through.
+  force_release_all_keys();
+
+  do
+  {
+    total = get_profile_total_time();
+
+    if(profile_view == VIEW_LINES)
+      list = build_line_list(&num_choices, total);
+    else
+      list = build_robot_list(&num_choices, total);
+
+    has_data = (num_choices > 0);
+    if(!has_data)
+    {
+      list[0] = (char *)"(no data)";
+      num_choices = 1;
+    }
+
+    profile_selected = MIN(profile_selected, num_choices - 1);
+
+    snprintf(total_text, 77, "Total robot time: %.3f ms",
+     total / 1000000.0);
+
+    elements[0] = construct_label(2, 1, header_text[profile_view]);
+    elements[1] = construct_label(2, 21, total_text);
+
+    elements[2] = construct_list_box(2, 2,
+     (const char **)list, num_choices, 19, 76, 0, &profile_selected, NULL,
+     false);
+
+    elements[3] = construct_button(2, 23,
+     enable_text[profiler_enabled], 0);
+    elements[4] = construct_button(22, 23, "Reset", 1);
+    elements[5] = construct_button(31, 23, view_text[profile_view], 2);
+    elements[6] = construct_button(47, 23, sort_text[profile_sort], 3);
+    elements[7] = construct_button(70, 23, "Done", -1);
+
+    construct_dialog_ext(&di, "Robot Profiler", 0, 0, 80, 25,
+     elements, ARRAY_SIZE(elements), 0, 0, focus, profile_idle_function);
+
+    result = run_dialog(mzx_world, &di);
+    focus = di.current_element;
+
+    switch(result)
+    {
+      case 0:
+        enable_robot_profile(!profiler_enabled);
+        break;
+
+      case 1:
+        if(!confirm(mzx_world, "Clear the profile data?"))
+        {
+          reset_robot_profile();
+          profile_selected = 0;
+        }
+        break;
+
+      case 2:
+        profile_view = (profile_view + 1) % NUM_VIEWS;
+        profile_selected = 0;
+        break;
+
+      case 3:
+        profile_sort = (profile_sort + 1) % NUM_SORTS;
+        profile_selected = 0;
+        break;
+    }
+
+    destruct_dialog(&di);
+
+    if(has_data)
+      for(i = 0; i < num_choices; i++)
+        free(list[i]);
+
+    free(list);
+  }
+  while(result > -1);
+
+  // Prevent UI keys from carrying through.
+  force_release_all_keys();
+
+  robot_profile_resume();
+}
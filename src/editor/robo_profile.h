@@ -0,0 +1,43 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2017 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __EDITOR_ROBO_PROFILE_H
+#define __EDITOR_ROBO_PROFILE_H
+
+#include "../compat.h"
+
+__M_BEGIN_DECLS
+
+#include "../core.h"
+
+// Written to the world's directory when testing ends with profile data.
+#define ROBOT_PROFILE_FILE "robot_profile.txt"
+
+void robot_profile_dialog(struct world *mzx_world);
+
+void robot_profile_pause(void);
+void robot_profile_resume(void);
+
+boolean dump_robot_profile(const char *filename);
+void reset_robot_profile(void);
+void free_robot_profile(void);
+
+__M_END_DECLS
+
+#endif // __EDITOR_ROBO_PROFILE_H
@@ -125,6 +125,15 @@ void duplicate_robot_direct_source(struct world *mzx_world,
 
   // Bytecode starts as NULL.
   copy_robot->program_bytecode = NULL;
+#ifndef CONFIG_DEBYTECODE
+  copy_robot->expr_cache = NULL;
+  copy_robot->label_board = NULL;
+#endif
+#ifdef CONFIG_PREDECODE
+  copy_robot->instructions = NULL;
+  copy_robot->instruction_index = NULL;
+  copy_robot->num_instructions = 0;
+#endif
 
   // Give the robot a new, fresh stack
   copy_robot->stack = NULL;
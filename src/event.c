@@ -583,7 +583,7 @@ static boolean update_autorepeat(void)
   return rval;
 }
 
-static void start_frame_event_status(void)
+void start_frame_event_status(void)
 {
   struct buffered_status *status = store_status();
 
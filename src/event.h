@@ -203,6 +203,7 @@ CORE_LIBSPEC void init_event(struct config_info *conf);
 
 struct buffered_status *store_status(void);
 
+CORE_LIBSPEC void start_frame_event_status(void);
 CORE_LIBSPEC boolean update_event_status(void);
 CORE_LIBSPEC Uint32 update_event_status_delay(void);
 CORE_LIBSPEC void update_event_status_intake(void);
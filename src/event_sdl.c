@@ -953,6 +953,13 @@ static boolean process_event(SDL_Event *event)
           break;
         }
 
+        case SDL_WINDOWEVENT_EXPOSED:
+        {
+          // The window contents may be gone, so don't skip the next frame.
+          invalidate_screen();
+          break;
+        }
+
         case SDL_WINDOWEVENT_FOCUS_LOST:
         {
           trace("--EVENT_SDL-- SDL_WINDOWEVENT_FOCUS_LOST\n");
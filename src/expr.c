@@ -24,6 +24,7 @@
 
 #include "expr.h"
 
+#include "const.h"
 #include "counter.h"
 #include "memcasecmp.h"
 #include "rasm.h"
@@ -338,6 +339,118 @@ static inline void skip_spaces(char **_expression)
   *_expression = expression;
 }
 
+static inline int apply_operation(int operand_a, enum op operator,
+ int operand_b)
+{
+  switch(operator)
+  {
+    case OP_ADDITION:
+      return operand_a + operand_b;
+
+    case OP_SUBTRACTION:
+      return operand_a - operand_b;
+
+    case OP_MULTIPLICATION:
+      return operand_a * operand_b;
+
+    case OP_DIVISION:
+    {
+      if(operand_b == 0)
+        return 0;
+
+      return operand_a / operand_b;
+    }
+
+    case OP_MODULUS:
+    {
+      int val;
+
+      if(operand_b == 0)
+        return 0;
+
+      val = operand_a % operand_b;
+
+      // Converted C99 regulated truncated modulus to
+      // the more useful (for us) floored modulus
+      // Source:
+      // Division and Modulus for Computer Scientists
+      // DAAN LEIJEN
+      // University of Utrecht
+
+      if((val < 0) ^ (operand_b < 0))
+        val += operand_b;
+
+      return val;
+    }
+
+    case OP_EXPONENTIATION:
+    {
+      int i;
+      int val = 1;
+
+      // a==0 -> result = 0
+      if(operand_a == 0)
+        return 0;
+
+      // a==1 -> result = 1
+      if(operand_a == 1)
+        return 1;
+
+      // a==-1 -> result = 1 if b is even, -1 if b is odd
+      if(operand_a == -1)
+        operand_b &= 1;
+
+      // no floating point support :(
+      if(operand_b < 0)
+        return 0;
+
+      for(i = 0; i < operand_b; i++)
+        val *= operand_a;
+
+      return val;
+    }
+
+    case OP_AND:
+      return operand_a & operand_b;
+
+    case OP_OR:
+      return operand_a | operand_b;
+
+    case OP_XOR:
+      return operand_a ^ operand_b;
+
+    case OP_BITSHIFT_LEFT:
+      return operand_a << operand_b;
+
+    case OP_BITSHIFT_RIGHT:
+      return ((unsigned int)(operand_a) >> operand_b);
+
+    case OP_ARITHMETIC_BITSHIFT_RIGHT:
+      return ((signed int)(operand_a) >> operand_b);
+
+    case OP_EQUAL:
+      return (operand_a == operand_b);
+
+    case OP_LESS_THAN:
+      return (operand_a < operand_b);
+
+    case OP_LESS_THAN_OR_EQUAL:
+      return (operand_a <= operand_b);
+
+    case OP_GREATER_THAN:
+      return (operand_a > operand_b);
+
+    case OP_GREATER_THAN_OR_EQUAL:
+      return (operand_a >= operand_b);
+
+    case OP_NOT_EQUAL:
+      return (operand_a != operand_b);
+
+    default:
+      return operand_a;
+  }
+}
+
 int parse_expression(struct world *mzx_world, char **_expression, int *error,
  int id)
 {
@@ -637,139 +750,7 @@ int parse_expression(struct world *mzx_world, char **_expression, int *error,
 
 
     // Perform operation
-    switch(operator)
-    {
-      case OP_ADDITION:
-        operand_a += operand_b;
-        break;
-
-      case OP_SUBTRACTION:
-        operand_a -= operand_b;
-        break;
-
-      case OP_MULTIPLICATION:
-        operand_a *= operand_b;
-        break;
-
-      case OP_DIVISION:
-      {
-        if(operand_b == 0)
-          operand_a = 0;
-
-        else
-          operand_a /= operand_b;
-
-        break;
-      }
-
-      case OP_MODULUS:
-      {
-        int val;
-
-        if(operand_b == 0)
-        {
-          operand_a = 0;
-          break;
-        }
-
-        val = operand_a % operand_b;
-
-        // Converted C99 regulated truncated modulus to
-        // the more useful (for us) floored modulus
-        // Source:
-        // Division and Modulus for Computer Scientists
-        // DAAN LEIJEN
-        // University of Utrecht
-
-        if((val < 0) ^ (operand_b < 0))
-          val += operand_b;
-
-        operand_a = val;
-        break;
-      }
-
-      case OP_EXPONENTIATION:
-      {
-        int i;
-        int val = 1;
-
-        // a==0 -> result = 0
-        if(operand_a == 0)
-          break;
-
-        // a==1 -> result = 1
-        if(operand_a == 1)
-          break;
-
-        // a==-1 -> result = 1 if b is even, -1 if b is odd
-        if(operand_a == -1)
-          operand_b &= 1;
-
-        // no floating point support :(
-        if(operand_b < 0)
-        {
-          operand_a = 0;
-          break;
-        }
-
-        for(i = 0; i < operand_b; i++)
-          val *= operand_a;
-
-        operand_a = val;
-        break;
-      }
-
-      case OP_AND:
-        operand_a &= operand_b;
-        break;
-
-      case OP_OR:
-        operand_a |= operand_b;
-        break;
-
-      case OP_XOR:
-        operand_a ^= operand_b;
-        break;
-
-      case OP_BITSHIFT_LEFT:
-        operand_a <<= operand_b;
-        break;
-
-      case OP_BITSHIFT_RIGHT:
-        operand_a = ((unsigned int)(operand_a) >> operand_b);
-        break;
-
-      case OP_ARITHMETIC_BITSHIFT_RIGHT:
-        operand_a = ((signed int)(operand_a) >> operand_b);
-        break;
-
-      case OP_EQUAL:
-        operand_a = (operand_a == operand_b);
-        break;
-
-      case OP_LESS_THAN:
-        operand_a = (operand_a < operand_b);
-        break;
-
-      case OP_LESS_THAN_OR_EQUAL:
-        operand_a = (operand_a <= operand_b);
-        break;
-
-      case OP_GREATER_THAN:
-        operand_a = (operand_a > operand_b);
-        break;
-
-      case OP_GREATER_THAN_OR_EQUAL:
-        operand_a = (operand_a >= operand_b);
-        break;
-
-      case OP_NOT_EQUAL:
-        operand_a = (operand_a != operand_b);
-        break;
-
-      default:
-        break;
-    }
+    operand_a = apply_operation(operand_a, operator, operand_b);
 
 
     // Get next operator -- we need to skip any spaces first
@@ -1080,6 +1061,885 @@ err_out:
 }
 
 
+/* Compiled expressions for legacy Robotic.
+ *
+ * parse_expression() re-tokenizes the expression text every time it runs, but
+ * the expression parameters in robot bytecode don't change until the robot is
+ * reassembled. parse_param() compiles each of these parameters once into a
+ * small operator tree, caches it on the robot, and evaluates that instead.
+ *
+ * The compiler only needs to understand well-formed expressions that the
+ * parser above would evaluate completely and without error, in exactly the
+ * same order. Anything else (including anything that would hit the parser's
+ * buffer or stack limits) is marked as uncompilable so parse_param() falls
+ * back to the original behavior.
+ */
+
+// Limits for compiled expressions, kept well under the parser's limits.
+#define EXPR_COMPILE_MAX_DEPTH (EXPR_STACK_SIZE / 2)
+#define EXPR_COMPILE_MAX_NAME (EXPR_BUFFER_SIZE - 16)
+
+enum expr_operand_type
+{
+  EXPR_OPERAND_VALUE,
+  EXPR_OPERAND_COUNTER,
+  EXPR_OPERAND_NAME,
+  EXPR_OPERAND_EXPRESSION
+};
+
+enum expr_part_type
+{
+  EXPR_PART_TEXT,
+  EXPR_PART_EXPRESSION,
+  EXPR_PART_DECIMAL,
+  EXPR_PART_HEX,
+  EXPR_PART_HEX_BYTE
+};
+
+struct expr_level;
+struct expr_name;
+
+struct expr_part
+{
+  enum expr_part_type type;
+  unsigned int length;
+  char *text;
+  struct expr_level *level;
+  struct expr_name *name;
+};
+
+struct expr_name
+{
+  unsigned int num_parts;
+  struct expr_part *parts;
+};
+
+struct expr_term
+{
+  enum op operator;
+  enum expr_operand_type type;
+
+  // Any sequence of unary - and ~ reduces to (value * unary_mul + unary_add).
+  unsigned int unary_mul;
+  unsigned int unary_add;
+
+  int value;
+  char *counter;
+  struct counter_handle handle;
+  struct expr_name *name;
+  struct expr_level *level;
+};
+
+struct expr_level
+{
+  unsigned int num_terms;
+  struct expr_term *terms;
+
+  // If the ternary operator is used, its condition is the value of this level
+  // up to the '?' and the level evaluates to one of these instead.
+  struct expr_level *if_true;
+  struct expr_level *if_false;
+};
+
+struct expr_cache_entry
+{
+  int offset;
+  struct expr_level *level;
+};
+
+struct expr_cache
+{
+  int world_version;
+  unsigned int num_entries;
+  unsigned int num_allocated;
+  struct expr_cache_entry *entries;
+};
+
+struct expr_compile_state
+{
+  struct world *mzx_world;
+  int depth;
+  int num_dynamic;
+};
+
+// Marks a cached parameter that needs to go through parse_expression().
+static struct expr_level expr_uncompilable;
+
+// Marks a cached string parameter that tr_msg would leave unchanged.
+static struct expr_level expr_literal;
+
+static void free_expr_level(struct expr_level *level);
+
+static void free_expr_name(struct expr_name *name)
+{
+  unsigned int i;
+
+  if(!name)
+    return;
+
+  for(i = 0; i < name->num_parts; i++)
+  {
+    free(name->parts[i].text);
+    free_expr_level(name->parts[i].level);
+    free_expr_name(name->parts[i].name);
+  }
+  free(name->parts);
+  free(name);
+}
+
+static void free_expr_level(struct expr_level *level)
+{
+  unsigned int i;
+
+  if(!level || level == &expr_uncompilable || level == &expr_literal)
+    return;
+
+  for(i = 0; i < level->num_terms; i++)
+  {
+    free(level->terms[i].counter);
+    free_expr_name(level->terms[i].name);
+    free_expr_level(level->terms[i].level);
+  }
+  free(level->terms);
+  free_expr_level(level->if_true);
+  free_expr_level(level->if_false);
+  free(level);
+}
+
+static struct expr_part *add_expr_part(struct expr_name *name,
+ enum expr_part_type type)
+{
+  struct expr_part *part;
+
+  name->parts = crealloc(name->parts,
+   (name->num_parts + 1) * sizeof(struct expr_part));
+
+  part = &(name->parts[name->num_parts++]);
+  memset(part, 0, sizeof(struct expr_part));
+  part->type = type;
+  return part;
+}
+
+static void add_expr_text(struct expr_name *name, char chr)
+{
+  struct expr_part *part = NULL;
+
+  if(name->num_parts)
+    part = &(name->parts[name->num_parts - 1]);
+
+  if(!part || part->type != EXPR_PART_TEXT)
+    part = add_expr_part(name, EXPR_PART_TEXT);
+
+  part->text = crealloc(part->text, part->length + 2);
+  part->text[part->length++] = chr;
+  part->text[part->length] = '\0';
+}
+
+static struct expr_level *compile_expr_level(struct expr_compile_state *st,
+ char **_expression, char terminator);
+
+static boolean compile_expr_subexpression(struct expr_compile_state *st,
+ char **_expression, struct expr_level **level)
+{
+  st->depth++;
+  if(st->depth > EXPR_COMPILE_MAX_DEPTH)
+    return false;
+
+  *level = compile_expr_level(st, _expression, ')');
+  st->depth--;
+
+  return (*level != NULL);
+}
+
+/**
+ * Compile a counter name. Names are either 'quoted' or &ampersand& and may
+ * contain nested expressions; quoted names may also contain &interpolation&.
+ * Interpolation can't be nested, so it only contains text and expressions.
+ */
+static struct expr_name *compile_expr_name(struct expr_compile_state *st,
+ char **_expression, boolean is_amp, enum expr_part_type *interpolation)
+{
+  struct expr_name *name = ccalloc(1, sizeof(struct expr_name));
+  struct expr_part *part;
+  char *expression = *_expression;
+  char current_char;
+
+  while(1)
+  {
+    current_char = *expression;
+    expression++;
+
+    if(current_char == '\'')
+    {
+      // The parser accepts this as a terminator for &names& and
+      // interpolation, but the rest of the parser doesn't expect that.
+      if(is_amp)
+        goto err_free;
+
+      break;
+    }
+    else
+
+    if(current_char == '&')
+    {
+      if(is_amp)
+        break;
+
+      if(*expression == '&')
+      {
+        // Two &&s in a counter name -> one & char
+        expression++;
+        add_expr_text(name, '&');
+        continue;
+      }
+
+      st->depth++;
+      if(st->depth > EXPR_COMPILE_MAX_DEPTH)
+        goto err_free;
+
+      part = add_expr_part(name, EXPR_PART_DECIMAL);
+      part->name = compile_expr_name(st, &expression, true, &(part->type));
+      st->depth--;
+      if(!part->name)
+        goto err_free;
+
+      st->num_dynamic++;
+    }
+    else
+
+    if(current_char == '(')
+    {
+      part = add_expr_part(name, EXPR_PART_EXPRESSION);
+      if(!compile_expr_subexpression(st, &expression, &(part->level)))
+        goto err_free;
+
+      st->num_dynamic++;
+    }
+    else
+
+    // The skip functions don't expect either of these in names.
+    if(current_char == ')' || current_char == '\0')
+    {
+      goto err_free;
+    }
+
+    else
+      add_expr_text(name, current_char);
+  }
+
+  // Figure out how to interpolate this name now since that's only affected
+  // by its first char, which can't be changed by a nested expression.
+  if(interpolation)
+  {
+    *interpolation = EXPR_PART_DECIMAL;
+
+    if(name->num_parts && name->parts[0].type == EXPR_PART_TEXT)
+    {
+      part = &(name->parts[0]);
+
+      // &INPUT& and &$string& can be much longer than a number.
+      if(part->text[0] == '$' ||
+       (name->num_parts == 1 && part->length == 5 &&
+       !memcasecmp(part->text, "INPUT", 5)))
+        goto err_free;
+
+      if(part->text[0] == '+' || part->text[0] == '#')
+      {
+        if(part->text[0] == '+')
+          *interpolation = EXPR_PART_HEX;
+
+        else
+          *interpolation = EXPR_PART_HEX_BYTE;
+
+        memmove(part->text, part->text + 1, part->length);
+        part->length--;
+      }
+    }
+  }
+
+  *_expression = expression;
+  return name;
+
+err_free:
+  free_expr_name(name);
+  return NULL;
+}
+
+static boolean compile_expr_operand(struct expr_compile_state *st,
+ char **_expression, struct expr_term *term)
+{
+  char *expression = *_expression;
+  char current_char;
+  unsigned int i;
+
+  term->unary_mul = 1;
+  term->unary_add = 0;
+
+  while(1)
+  {
+    skip_spaces(&expression);
+    current_char = *expression;
+    expression++;
+
+    // Unary operators apply right to left, so compose each new one inside
+    // the existing ones.
+    if(current_char == '~' || current_char == '!')
+    {
+      // ~x == -x - 1
+      term->unary_add -= term->unary_mul;
+      term->unary_mul = -term->unary_mul;
+      continue;
+    }
+    else
+
+    if(current_char == '-')
+    {
+      term->unary_mul = -term->unary_mul;
+      continue;
+    }
+    break;
+  }
+
+  switch(current_char)
+  {
+    case '(':
+    {
+      term->type = EXPR_OPERAND_EXPRESSION;
+      if(!compile_expr_subexpression(st, &expression, &(term->level)))
+        return false;
+
+      break;
+    }
+
+    case '\'':
+    case '&':
+    {
+      struct expr_name *name =
+       compile_expr_name(st, &expression, (current_char == '&'), NULL);
+
+      if(!name)
+        return false;
+
+      for(i = 0; i < name->num_parts; i++)
+        if(name->parts[i].type != EXPR_PART_TEXT)
+          break;
+
+      if(i < name->num_parts)
+      {
+        // Needs to be constructed at runtime.
+        term->type = EXPR_OPERAND_NAME;
+        term->name = name;
+      }
+      else
+      {
+        // Static name, so look it up directly.
+        term->type = EXPR_OPERAND_COUNTER;
+        if(name->num_parts)
+        {
+          term->counter = name->parts[0].text;
+          name->parts[0].text = NULL;
+        }
+        else
+          term->counter = ccalloc(1, 1);
+
+        free_expr_name(name);
+      }
+      break;
+    }
+
+    default:
+    {
+      if((current_char >= '0') && (current_char <= '9'))
+      {
+        char *end_p;
+        term->type = EXPR_OPERAND_VALUE;
+        term->value = (int)strtol(expression - 1, &end_p, 0);
+        expression = end_p;
+        break;
+      }
+      return false;
+    }
+  }
+
+  *_expression = expression;
+  return true;
+}
+
+/**
+ * Compile one level of an expression, up to and including its terminator.
+ * The terminator is ')' for regular levels and ':' for the middle of a
+ * ternary operator.
+ */
+static struct expr_level *compile_expr_level(struct expr_compile_state *st,
+ char **_expression, char terminator)
+{
+  struct expr_level *level = ccalloc(1, sizeof(struct expr_level));
+  struct expr_term *term;
+  char *expression = *_expression;
+  enum op operator = OP_ADDITION;
+  char current_char;
+
+  while(1)
+  {
+    level->terms = crealloc(level->terms,
+     (level->num_terms + 1) * sizeof(struct expr_term));
+
+    term = &(level->terms[level->num_terms]);
+    memset(term, 0, sizeof(struct expr_term));
+    level->num_terms++;
+
+    term->operator = operator;
+    if(!compile_expr_operand(st, &expression, term))
+      goto err_free;
+
+    skip_spaces(&expression);
+    current_char = *expression;
+    expression++;
+
+    switch(current_char)
+    {
+      case '?':
+      {
+        if(st->mzx_world->version < V290)
+          goto err_free;
+
+        st->depth++;
+        if(st->depth > EXPR_COMPILE_MAX_DEPTH)
+          goto err_free;
+
+        level->if_true = compile_expr_level(st, &expression, ':');
+        st->depth--;
+        if(!level->if_true)
+          goto err_free;
+
+        level->if_false = compile_expr_level(st, &expression, terminator);
+        if(!level->if_false)
+          goto err_free;
+
+        *_expression = expression;
+        return level;
+      }
+
+      case ':':
+      case ')':
+      {
+        if(current_char != terminator)
+          goto err_free;
+
+        *_expression = expression;
+        return level;
+      }
+
+      case '+': operator = OP_ADDITION; break;
+      case '-': operator = OP_SUBTRACTION; break;
+      case '*': operator = OP_MULTIPLICATION; break;
+      case '/': operator = OP_DIVISION; break;
+      case '%': operator = OP_MODULUS; break;
+      case '^': operator = OP_EXPONENTIATION; break;
+      case 'a': operator = OP_AND; break;
+      case 'o': operator = OP_OR; break;
+      case 'x': operator = OP_XOR; break;
+      case '=': operator = OP_EQUAL; break;
+
+      case '<':
+      {
+        if(*expression == '<')
+        {
+          expression++;
+          operator = OP_BITSHIFT_LEFT;
+        }
+        else
+
+        if(*expression == '=')
+        {
+          expression++;
+          operator = OP_LESS_THAN_OR_EQUAL;
+        }
+        else
+          operator = OP_LESS_THAN;
+
+        break;
+      }
+
+      case '>':
+      {
+        if(*expression == '>')
+        {
+          expression++;
+          if(*expression == '>')
+          {
+            expression++;
+            operator = OP_ARITHMETIC_BITSHIFT_RIGHT;
+          }
+          else
+            operator = OP_BITSHIFT_RIGHT;
+        }
+        else
+
+        if(*expression == '=')
+        {
+          expression++;
+          operator = OP_GREATER_THAN_OR_EQUAL;
+        }
+        else
+          operator = OP_GREATER_THAN;
+
+        break;
+      }
+
+      case '!':
+      {
+        if(*expression != '=')
+          goto err_free;
+
+        expression++;
+        operator = OP_NOT_EQUAL;
+        break;
+      }
+
+      default:
+        goto err_free;
+    }
+  }
+
+err_free:
+  free_expr_level(level);
+  return NULL;
+}
+
+static struct expr_level *compile_expression(struct world *mzx_world,
+ char *expression)
+{
+  struct expr_compile_state st;
+  struct expr_level *level;
+  size_t length = strlen(expression);
+
+  st.mzx_world = mzx_world;
+  st.depth = 0;
+  st.num_dynamic = 0;
+
+  level = compile_expr_level(&st, &expression, ')');
+  if(!level)
+    return NULL;
+
+  // Must be the entire parameter. Numbers spliced into names can be up to
+  // 11 chars (vs. at least 3 chars of source), so make sure the parser could
+  // never have truncated one of these names either.
+  if(*expression ||
+   (length + (size_t)st.num_dynamic * 8 > EXPR_COMPILE_MAX_NAME))
+  {
+    free_expr_level(level);
+    return NULL;
+  }
+  return level;
+}
+
+static int eval_expr_level(struct world *mzx_world, struct expr_level *level,
+ int id);
+
+static void eval_expr_name(struct world *mzx_world, struct expr_name *name,
+ int id, char *buffer)
+{
+  char number_buffer[16];
+  char name_buffer[EXPR_BUFFER_SIZE];
+  struct expr_part *part = name->parts;
+  struct expr_part *end = part + name->num_parts;
+  size_t len;
+  char *src;
+  int value;
+
+  for(; part < end; part++)
+  {
+    switch(part->type)
+    {
+      case EXPR_PART_TEXT:
+        memcpy(buffer, part->text, part->length);
+        buffer += part->length;
+        continue;
+
+      case EXPR_PART_EXPRESSION:
+        value = eval_expr_level(mzx_world, part->level, id);
+        src = tr_int_to_string(number_buffer, value, &len);
+        break;
+
+      case EXPR_PART_DECIMAL:
+        eval_expr_name(mzx_world, part->name, id, name_buffer);
+        value = get_counter(mzx_world, name_buffer, id);
+        src = tr_int_to_string(number_buffer, value, &len);
+        break;
+
+      case EXPR_PART_HEX:
+        eval_expr_name(mzx_world, part->name, id, name_buffer);
+        value = get_counter(mzx_world, name_buffer, id);
+        src = tr_int_to_hex_string(number_buffer, value, &len);
+        break;
+
+      case EXPR_PART_HEX_BYTE:
+        eval_expr_name(mzx_world, part->name, id, name_buffer);
+        value = get_counter(mzx_world, name_buffer, id);
+        sprintf(number_buffer, "%02x", value);
+        src = number_buffer;
+        len = 2;
+        break;
+
+      default:
+        continue;
+    }
+    memcpy(buffer, src, len);
+    buffer += len;
+  }
+  *buffer = '\0';
+}
+
+static int eval_expr_level(struct world *mzx_world, struct expr_level *level,
+ int id)
+{
+  char name_buffer[EXPR_BUFFER_SIZE];
+  struct expr_term *term = level->terms;
+  struct expr_term *end = term + level->num_terms;
+  int operand_a = 0;
+  int operand_b;
+
+  for(; term < end; term++)
+  {
+    switch(term->type)
+    {
+      case EXPR_OPERAND_VALUE:
+        operand_b = term->value;
+        break;
+
+      case EXPR_OPERAND_COUNTER:
+        operand_b =
+         get_counter_handle(mzx_world, &(term->handle), term->counter, id);
+        break;
+
+      case EXPR_OPERAND_NAME:
+        eval_expr_name(mzx_world, term->name, id, name_buffer);
+        operand_b = get_counter(mzx_world, name_buffer, id);
+        break;
+
+      case EXPR_OPERAND_EXPRESSION:
+        operand_b = eval_expr_level(mzx_world, term->level, id);
+        break;
+
+      default:
+        operand_b = 0;
+        break;
+    }
+
+    operand_b = (int)((unsigned int)operand_b * term->unary_mul +
+     term->unary_add);
+
+    operand_a = apply_operation(operand_a, term->operator, operand_b);
+  }
+
+  if(level->if_true)
+  {
+    if(operand_a)
+      return eval_expr_level(mzx_world, level->if_true, id);
+
+    return eval_expr_level(mzx_world, level->if_false, id);
+  }
+  return operand_a;
+}
+
+#define EXPR_CACHE_MIN_SIZE 16
+
+static struct expr_cache_entry *expr_cache_find(struct expr_cache *cache,
+ int offset)
+{
+  unsigned int mask = cache->num_allocated - 1;
+  unsigned int i = ((unsigned int)offset * 2654435761u) & mask;
+
+  // Linear probing; the table is never allowed to fill up.
+  while(cache->entries[i].level && cache->entries[i].offset != offset)
+    i = (i + 1) & mask;
+
+  return &(cache->entries[i]);
+}
+
+static void expr_cache_resize(struct expr_cache *cache)
+{
+  struct expr_cache_entry *old_entries = cache->entries;
+  unsigned int old_allocated = cache->num_allocated;
+  unsigned int i;
+
+  cache->num_allocated =
+   old_allocated ? old_allocated * 2 : EXPR_CACHE_MIN_SIZE;
+
+  cache->entries =
+   ccalloc(cache->num_allocated, sizeof(struct expr_cache_entry));
+
+  for(i = 0; i < old_allocated; i++)
+    if(old_entries[i].level)
+      *expr_cache_find(cache, old_entries[i].offset) = old_entries[i];
+
+  free(old_entries);
+}
+
+static struct expr_cache *get_expr_cache(struct world *mzx_world,
+ struct robot *cur_robot)
+{
+  struct expr_cache *cache = cur_robot->expr_cache;
+
+  // The world version affects the behavior of some operators.
+  if(cache && cache->world_version != mzx_world->version)
+  {
+    clear_expression_cache(cur_robot);
+    cache = NULL;
+  }
+
+  if(!cache)
+  {
+    cache = ccalloc(1, sizeof(struct expr_cache));
+    cache->world_version = mzx_world->version;
+    expr_cache_resize(cache);
+    cur_robot->expr_cache = cache;
+  }
+  return cache;
+}
+
+static void expr_cache_add(struct expr_cache *cache, int offset,
+ struct expr_level *level)
+{
+  struct expr_cache_entry *entry;
+
+  if((cache->num_entries + 1) * 4 > cache->num_allocated * 3)
+    expr_cache_resize(cache);
+
+  entry = expr_cache_find(cache, offset);
+  entry->offset = offset;
+  entry->level = level;
+  cache->num_entries++;
+}
+
+/**
+ * Evaluate an expression parameter of a legacy robot using its compiled form,
+ * compiling it first if it hasn't been seen yet. The expression pointer is the
+ * same as what would be given to parse_expression, and must point inside the
+ * robot's bytecode. Returns false if the expression couldn't be compiled, in
+ * which case the caller should parse it normally instead.
+ */
+boolean parse_expression_cached(struct world *mzx_world,
+ struct robot *cur_robot, char *expression, int id, int *value)
+{
+  struct expr_cache *cache = get_expr_cache(mzx_world, cur_robot);
+  int offset = expression - cur_robot->program_bytecode;
+  struct expr_level *level = expr_cache_find(cache, offset)->level;
+
+  if(!level)
+  {
+    level = compile_expression(mzx_world, expression);
+    if(!level)
+      level = &expr_uncompilable;
+
+    expr_cache_add(cache, offset, level);
+  }
+
+  if(level == &expr_uncompilable)
+    return false;
+
+  *value = eval_expr_level(mzx_world, level, id);
+  return true;
+}
+
+/**
+ * Get a counter handle for a name parameter of a legacy robot. The name
+ * pointer must point to the parameter text inside the robot's bytecode.
+ * Returns NULL if the name needs to be translated with tr_msg or refers to
+ * a string, in which case the caller should handle the name normally.
+ */
+struct counter_handle *get_param_counter_handle(struct world *mzx_world,
+ struct robot *cur_robot, char *name)
+{
+  struct expr_cache *cache = get_expr_cache(mzx_world, cur_robot);
+  int offset = name - cur_robot->program_bytecode;
+  struct expr_level *level = expr_cache_find(cache, offset)->level;
+
+  if(!level)
+  {
+    size_t length = strlen(name);
+
+    // See tr_msg.
+    if(!strchr(name, '&') && !is_string(name) && length < ROBOT_MAX_TR - 1 &&
+     (mzx_world->version < V268 || !strchr(name, '(')))
+    {
+      level = ccalloc(1, sizeof(struct expr_level));
+      level->terms = ccalloc(1, sizeof(struct expr_term));
+      level->num_terms = 1;
+
+      level->terms[0].operator = OP_ADDITION;
+      level->terms[0].type = EXPR_OPERAND_COUNTER;
+      level->terms[0].unary_mul = 1;
+      level->terms[0].counter = cmalloc(length + 1);
+      memcpy(level->terms[0].counter, name, length + 1);
+    }
+    else
+      level = &expr_uncompilable;
+
+    expr_cache_add(cache, offset, level);
+  }
+
+  if(level == &expr_uncompilable)
+    return NULL;
+
+  return &(level->terms[0].handle);
+}
+
+/**
+ * Check if a string parameter of a legacy robot is a literal, i.e. it would
+ * come out of tr_msg unchanged, so it can be used directly from the bytecode.
+ * The text pointer must point inside the robot's bytecode and length must be
+ * the length of the text according to the bytecode. This is decided once per
+ * parameter; the result is stored under the negated offset of the text so it
+ * doesn't collide with a counter handle for the same parameter.
+ */
+boolean is_param_literal(struct world *mzx_world, struct robot *cur_robot,
+ char *text, size_t length)
+{
+  struct expr_cache *cache = get_expr_cache(mzx_world, cur_robot);
+  int offset = -(int)(text - cur_robot->program_bytecode);
+  struct expr_level *level = expr_cache_find(cache, offset)->level;
+
+  if(!level)
+  {
+    // See tr_msg.
+    if(length < ROBOT_MAX_TR - 1 && strlen(text) == length &&
+     !memchr(text, '&', length) &&
+     (mzx_world->version < V268 || !memchr(text, '(', length)))
+    {
+      level = &expr_literal;
+    }
+    else
+      level = &expr_uncompilable;
+
+    expr_cache_add(cache, offset, level);
+  }
+
+  return (level == &expr_literal);
+}
+
+/**
+ * Free all compiled expressions for a robot. This needs to happen any time
+ * the robot's bytecode is replaced or freed.
+ */
+void clear_expression_cache(struct robot *cur_robot)
+{
+  struct expr_cache *cache = cur_robot->expr_cache;
+  unsigned int i;
+
+  if(cache)
+  {
+    for(i = 0; i < cache->num_allocated; i++)
+      free_expr_level(cache->entries[i].level);
+
+    free(cache->entries);
+    free(cache);
+    cur_robot->expr_cache = NULL;
+  }
+}
+
+
 #else /* CONFIG_DEBYTECODE */
 
 
@@ -30,6 +30,16 @@ __M_BEGIN_DECLS
 int parse_expression(struct world *mzx_world, char **expression, int *error,
  int id);
 
+#ifndef CONFIG_DEBYTECODE
+boolean parse_expression_cached(struct world *mzx_world,
+ struct robot *cur_robot, char *expression, int id, int *value);
+struct counter_handle *get_param_counter_handle(struct world *mzx_world,
+ struct robot *cur_robot, char *name);
+boolean is_param_literal(struct world *mzx_world, struct robot *cur_robot,
+ char *text, size_t length);
+void clear_expression_cache(struct robot *cur_robot);
+#endif
+
 #ifdef CONFIG_DEBYTECODE
 int parse_string_expression(struct world *mzx_world, char **_expression,
  int id, char *output, size_t output_left);
@@ -0,0 +1,331 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Portable extra memory for boards. Every board except the current board is
+ * kept in extra memory. The NDS moves these boards into a RAM expansion (see
+ * arch/nds/extmem.c); everywhere else, if board_compression is set, the board
+ * and overlay planes and robot programs and stacks of each of these boards
+ * are deflated into a single block, which is inflated back into the board
+ * when it's retrieved. Boards that wouldn't get any smaller are left alone.
+ */
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "configure.h"
+#include "error.h"
+#include "extmem.h"
+#include "robot.h"
+#include "util.h"
+
+#if !defined(CONFIG_NDS) || defined(CONFIG_DEBYTECODE)
+
+#define NUM_PLANES 8
+
+struct extram_block
+{
+  uint32_t raw_size;
+  uint32_t size;
+  unsigned char data[1];
+};
+
+struct extram_buffer
+{
+  char **ptr;
+  size_t size;
+};
+
+struct extram_stats
+{
+  uint32_t stored;
+  uint32_t retrieved;
+  uint64_t raw_total;
+  uint64_t compressed_total;
+  uint64_t saved;
+  uint64_t saved_peak;
+  uint64_t retrieve_ns;
+  uint64_t retrieve_max_ns;
+};
+
+static struct extram_stats stats;
+
+/**
+ * Get every buffer of a board that gets compressed, in the order they're
+ * compressed in. The board stays the same while it's in extra memory, so
+ * this is the same list for storing and retrieving it. Empty buffers are
+ * skipped. Returns the number of buffers, which should be freed.
+ */
+static int extram_get_buffers(struct board *board,
+ struct extram_buffer **_buffers, size_t *_raw_size)
+{
+  struct extram_buffer *buffers;
+  size_t size = board->board_width * board->board_height;
+  size_t raw_size = 0;
+  int num_buffers = 0;
+  int num_planes = NUM_PLANES;
+  int i;
+
+  char **planes[NUM_PLANES] =
+  {
+    &board->level_id, &board->level_param, &board->level_color,
+    &board->level_under_id, &board->level_under_param,
+    &board->level_under_color, &board->overlay, &board->overlay_color
+  };
+
+  // Skip the last 2 planes if overlays are disabled.
+  if(!board->overlay_mode)
+    num_planes -= 2;
+
+  buffers = cmalloc((num_planes + board->num_robots * 2) *
+   sizeof(struct extram_buffer));
+
+  for(i = 0; i < num_planes; i++)
+  {
+    buffers[num_buffers].ptr = planes[i];
+    buffers[num_buffers].size = size;
+    num_buffers++;
+  }
+
+#ifndef CONFIG_DEBYTECODE
+  // Robot 0 is the global robot, which is shared by every board.
+  if(board->robot_list)
+  {
+    for(i = 1; i <= board->num_robots; i++)
+    {
+      struct robot *cur_robot = board->robot_list[i];
+      if(!cur_robot)
+        continue;
+
+      if(cur_robot->stack_size)
+      {
+        buffers[num_buffers].ptr = (char **)&(cur_robot->stack);
+        buffers[num_buffers].size = cur_robot->stack_size * sizeof(int);
+        num_buffers++;
+      }
+
+      if(cur_robot->program_bytecode_length)
+      {
+        buffers[num_buffers].ptr = &(cur_robot->program_bytecode);
+        buffers[num_buffers].size = cur_robot->program_bytecode_length;
+        num_buffers++;
+      }
+    }
+  }
+#endif
+
+  for(i = 0; i < num_buffers; i++)
+    raw_size += buffers[i].size;
+
+  *_buffers = buffers;
+  *_raw_size = raw_size;
+  return num_buffers;
+}
+
+static void extram_compress_board(struct board *board, int level)
+{
+  struct extram_buffer *buffers;
+  struct extram_block *block = NULL;
+  size_t raw_size;
+  int num_buffers;
+  int result = Z_OK;
+  z_stream z;
+  int i;
+
+  num_buffers = extram_get_buffers(board, &buffers, &raw_size);
+
+  // Make sure every buffer is actually there before freeing any of them.
+  for(i = 0; i < num_buffers; i++)
+    if(!*(buffers[i].ptr))
+      goto err_free;
+
+  if(!raw_size || raw_size > UINT32_MAX)
+    goto err_free;
+
+  memset(&z, 0, sizeof(z_stream));
+  if(deflateInit(&z, level) != Z_OK)
+    goto err_free;
+
+  // Only keep the compressed block if it's smaller than the board.
+  block = cmalloc(offsetof(struct extram_block, data) + raw_size);
+  z.next_out = block->data;
+  z.avail_out = raw_size;
+
+  for(i = 0; i < num_buffers; i++)
+  {
+    z.next_in = (Bytef *)*(buffers[i].ptr);
+    z.avail_in = buffers[i].size;
+
+    result = deflate(&z, (i == num_buffers - 1) ? Z_FINISH : Z_NO_FLUSH);
+    if(z.avail_in)
+      break;
+  }
+  deflateEnd(&z);
+
+  if(result != Z_STREAM_END)
+    goto err_free;
+
+  block->raw_size = raw_size;
+  block->size = z.total_out;
+  block = crealloc(block, offsetof(struct extram_block, data) + block->size);
+
+#ifndef CONFIG_DEBYTECODE
+  // Labels and other caches point into the programs being freed.
+  if(board->robot_list)
+    for(i = 1; i <= board->num_robots; i++)
+      if(board->robot_list[i])
+        clear_label_cache(board->robot_list[i]);
+#endif
+
+  for(i = 0; i < num_buffers; i++)
+  {
+    free(*(buffers[i].ptr));
+    *(buffers[i].ptr) = NULL;
+  }
+  free(buffers);
+
+  board->extram_data = block;
+
+  stats.stored++;
+  stats.raw_total += block->raw_size;
+  stats.compressed_total += block->size;
+  stats.saved += block->raw_size - block->size;
+  stats.saved_peak = MAX(stats.saved_peak, stats.saved);
+  return;
+
+err_free:
+  free(block);
+  free(buffers);
+}
+
+static void extram_decompress_board(struct board *board)
+{
+  struct extram_block *block = (struct extram_block *)board->extram_data;
+  struct extram_buffer *buffers;
+  uint64_t start = get_time_ns();
+  uint64_t ns;
+  uint32_t saved;
+  size_t raw_size;
+  int num_buffers;
+  int result = Z_OK;
+  z_stream z;
+  int i;
+
+  num_buffers = extram_get_buffers(board, &buffers, &raw_size);
+  if(raw_size != block->raw_size)
+    goto err;
+
+  memset(&z, 0, sizeof(z_stream));
+  if(inflateInit(&z) != Z_OK)
+    goto err;
+
+  z.next_in = block->data;
+  z.avail_in = block->size;
+
+  for(i = 0; i < num_buffers; i++)
+  {
+    *(buffers[i].ptr) = cmalloc(buffers[i].size);
+    z.next_out = (Bytef *)*(buffers[i].ptr);
+    z.avail_out = buffers[i].size;
+
+    result = inflate(&z, Z_NO_FLUSH);
+    if(z.avail_out)
+      break;
+  }
+  inflateEnd(&z);
+
+  if(result != Z_STREAM_END)
+    goto err;
+
+  saved = block->raw_size - block->size;
+  free(buffers);
+  free(block);
+  board->extram_data = NULL;
+
+#ifndef CONFIG_DEBYTECODE
+  if(board->robot_list)
+    for(i = 1; i <= board->num_robots; i++)
+      if(board->robot_list[i] && board->robot_list[i]->program_bytecode)
+        cache_robot_labels(board->robot_list[i]);
+#endif
+
+  ns = get_time_ns() - start;
+  stats.retrieved++;
+  stats.retrieve_ns += ns;
+  stats.retrieve_max_ns = MAX(stats.retrieve_max_ns, ns);
+  stats.saved -= MIN(stats.saved, saved);
+  return;
+
+err:
+  // The board is gone if this happens, so there's no way to recover.
+  error("Failed to decompress board", ERROR_T_FATAL,
+   ERROR_OPT_EXIT|ERROR_OPT_NO_HELP, 0);
+}
+
+void real_store_board_to_extram(struct board *board, const char *file,
+ int line)
+{
+  int level = get_config()->board_compression;
+
+#ifdef DEBUG
+  if(!board->is_extram)
+    board->is_extram = true;
+  else
+    warn("board %p is already in extram! (%s:%d)\n", (void *)board, file, line);
+#endif
+
+  // Boards that haven't been loaded yet don't have anything to compress.
+  if(level && !board->is_lazy && !board->extram_data)
+    extram_compress_board(board, level);
+}
+
+void real_retrieve_board_from_extram(struct board *board, const char *file,
+ int line)
+{
+#ifdef DEBUG
+  if(board->is_extram)
+    board->is_extram = false;
+  else
+    warn("board %p isn't in extram! (%s:%d)\n", (void *)board, file, line);
+#endif
+
+  if(board->extram_data)
+    extram_decompress_board(board);
+}
+
+void extram_print_stats(void)
+{
+  if(!stats.stored)
+    return;
+
+  info("Compressed %" PRIu32 " boards from %" PRIu64 " to %" PRIu64
+   " bytes (%" PRIu64 " bytes saved at most).\n", stats.stored,
+   stats.raw_total, stats.compressed_total, stats.saved_peak);
+
+  if(stats.retrieved)
+    info("Decompressed %" PRIu32 " boards in %.3fms on average "
+     "(%.3fms at most).\n", stats.retrieved,
+     stats.retrieve_ns / 1000000.0 / stats.retrieved,
+     stats.retrieve_max_ns / 1000000.0);
+}
+
+#endif /* !CONFIG_NDS || CONFIG_DEBYTECODE */
@@ -28,6 +28,10 @@ __M_BEGIN_DECLS
 #include "board_struct.h"
 #include "world_struct.h"
 
+// Load the rest of a board that only had its board info loaded (world.c).
+CORE_LIBSPEC void load_board_lazy(struct world *mzx_world,
+ struct board *cur_board);
+
 #if defined(CONFIG_NDS) && !defined(CONFIG_DEBYTECODE)
 
 // Move the board's memory from normal RAM to extra RAM.
@@ -42,42 +46,32 @@ void set_current_board(struct world *mzx_world, struct board *cur_board);
 // Set the current board to cur_board, in extra memory.
 void set_current_board_ext(struct world *mzx_world, struct board *cur_board);
 
+// Boards aren't compressed here, so there's nothing to print.
+static inline void extram_print_stats(void) {}
+
 #else // !CONFIG_NDS || CONFIG_DEBYTECODE
 
-/* If we're not on NDS, these inline functions should get optimised
- * away. The implementations are obvious enough.
+/* Elsewhere, boards in extra memory are compressed in normal memory if
+ * board_compression is set; otherwise, these only check that boards are
+ * stored and retrieved in pairs (in debug builds). See extmem.c.
  */
 
-#ifdef DEBUG
-#include "util.h"
-#endif
-
 #define store_board_to_extram(b) \
  real_store_board_to_extram(b, __FILE__, __LINE__)
 #define retrieve_board_from_extram(b) \
  real_retrieve_board_from_extram(b, __FILE__, __LINE__)
 
-static inline void real_store_board_to_extram(struct board *board,
- const char *file, int line)
-{
-#ifdef DEBUG
-  if(!board->is_extram)
-    board->is_extram = true;
-  else
-    warn("board %p is already in extram! (%s:%d)\n", (void *)board, file, line);
-#endif
-}
+// Compress the board's memory if board_compression is set.
+CORE_LIBSPEC void real_store_board_to_extram(struct board *board,
+ const char *file, int line);
 
-static inline void real_retrieve_board_from_extram(struct board *board,
- const char *file, int line)
-{
-#ifdef DEBUG
-  if(board->is_extram)
-    board->is_extram = false;
-  else
-    warn("board %p isn't in extram! (%s:%d)\n", (void *)board, file, line);
-#endif
-}
+// Decompress the board's memory if it was compressed.
+CORE_LIBSPEC void real_retrieve_board_from_extram(struct board *board,
+ const char *file, int line);
+
+// Print how much memory compressing boards saved and how long it took to
+// decompress them, if any boards were compressed.
+CORE_LIBSPEC void extram_print_stats(void);
 
 static inline void set_current_board(struct world *mzx_world,
  struct board *cur_board)
@@ -92,6 +86,9 @@ static inline void set_current_board_ext(struct world *mzx_world,
 {
   set_current_board(mzx_world, cur_board);
   retrieve_board_from_extram(cur_board);
+
+  if(cur_board->is_lazy)
+    load_board_lazy(mzx_world, cur_board);
 }
 
 #endif // CONFIG_NDS && !CONFIG_DEBYTECODE
@@ -41,6 +41,7 @@
 #include "game_player.h"
 #include "game_update.h"
 #include "graphics.h"
+#include "pacing.h"
 #include "platform.h"
 #include "robot.h"
 #include "util.h"
@@ -420,6 +421,8 @@ static boolean game_draw(context *ctx)
   struct game_context *game = (struct game_context *)ctx;
   struct config_info *conf = get_config();
   struct world *mzx_world = ctx->world;
+  enum pacing_phase prev_phase;
+  int updates;
 
   // No game state change has happened (yet)
   mzx_world->change_game_state = CHANGE_STATE_NONE;
@@ -454,7 +457,23 @@ static boolean game_draw(context *ctx)
   }
 
   set_context_framerate_mode(ctx, FRAMERATE_MZX_SPEED);
+
+  // The world is updated here rather than in game_update; time it separately.
+  // If the game fell behind, run extra updates to catch up before drawing.
+  // The input for this frame is only seen by the first update, so the extra
+  // updates only get the keys that are still held.
+  prev_phase = pacing_set_phase(PACING_UPDATE);
+  updates = pacing_get_updates();
   update_world(ctx, game->is_title);
+
+  while(--updates > 0 && !has_context_changed(ctx) &&
+   mzx_world->change_game_state == CHANGE_STATE_NONE)
+  {
+    start_frame_event_status();
+    update_world(ctx, game->is_title);
+  }
+  pacing_set_phase(prev_phase);
+
   return draw_world(ctx, game->is_title);
 }
 
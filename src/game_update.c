@@ -48,6 +48,8 @@
 // Length of cooldown between player shots, including current frame.
 #define MAX_PLAYER_SHOT_COOLDOWN 2
 
+struct update_timers *update_timers = NULL;
+
 // Updates game variables
 // Slowed = 1 to not update lazwall or time
 // due to slowtime or freezetime
@@ -712,8 +714,14 @@ void update_world(context *ctx, boolean is_title)
 
   // Global robot
   if(mzx_world->current_board->robot_list[0])
+  {
     if(mzx_world->current_board->robot_list[0]->used)
+    {
+      uint64_t start = update_timer_start();
       run_robot(ctx, 0, -1, -1);
+      update_timer_stop(UPDATE_TIMER_ROBOTS, start);
+    }
+  }
 
   if(!mzx_world->current_cycle_frozen)
   {
@@ -835,6 +843,7 @@ boolean draw_world(context *ctx, boolean is_title)
   struct world *mzx_world = ctx->world;
   struct board *cur_board = mzx_world->current_board;
   struct config_info *conf = get_config();
+  uint64_t sprites_start;
   int time_remaining;
   int top_x;
   int top_y;
@@ -883,7 +892,9 @@ boolean draw_world(context *ctx, boolean is_title)
 
   // Add sprites
   select_layer(OVERLAY_LAYER);
+  sprites_start = update_timer_start();
   draw_sprites(mzx_world);
+  update_timer_stop(UPDATE_TIMER_SPRITES, sprites_start);
 
   // Add time limit
   time_remaining = get_counter(mzx_world, "TIME", 0);
@@ -24,8 +24,42 @@
 
 __M_BEGIN_DECLS
 
+#include <stdint.h>
+
 #include "core.h"
 
+/**
+ * Optional subsystem timing used by the benchmark runner. When update_timers
+ * is set, the time spent in each subsystem during update_world and
+ * draw_world is added to it using the provided clock.
+ */
+enum update_timer_type
+{
+  UPDATE_TIMER_ROBOTS,
+  UPDATE_TIMER_SPRITES,
+  NUM_UPDATE_TIMERS
+};
+
+struct update_timers
+{
+  uint64_t (*get_time)(void);
+  uint64_t time[NUM_UPDATE_TIMERS];
+};
+
+extern struct update_timers *update_timers;
+
+static inline uint64_t update_timer_start(void)
+{
+  return update_timers ? update_timers->get_time() : 0;
+}
+
+static inline void update_timer_stop(enum update_timer_type type,
+ uint64_t start)
+{
+  if(update_timers)
+    update_timers->time[type] += update_timers->get_time() - start;
+}
+
 void update_world(context *ctx, boolean is_title);
 void update_board(context *ctx);
 
@@ -103,10 +103,11 @@ void update_board(context *ctx)
   slow_down = mzx_world->current_cycle_odd;
 
   // Clear the status code of all robots
-  for(i = 0; i < src_board->num_robots_active; i++)
+  for(i = 1; i <= src_board->num_robots; i++)
   {
-    cur_robot = src_board->robot_list_name_sorted[i];
-    cur_robot->status = 0;
+    cur_robot = src_board->robot_list[i];
+    if(cur_robot)
+      cur_robot->status = 0;
   }
 
   memset(update_done, 0, board_width * board_height);
@@ -135,7 +136,9 @@ void update_board(context *ctx)
         case ROBOT:
         case ROBOT_PUSHABLE:
         {
+          uint64_t start = update_timer_start();
           run_robot(ctx, current_param, x, y);
+          update_timer_stop(UPDATE_TIMER_ROBOTS, start);
 
           // On a game state change, we need to return to the main game loop.
           if(mzx_world->change_game_state)
@@ -1698,10 +1701,12 @@ void update_board(context *ctx)
       current_id = (enum thing)level_id[level_offset];
       if(is_robot(current_id))
       {
+        uint64_t start = update_timer_start();
         current_param = level_param[level_offset];
 
         // May change the source board (with swap world or load game)
         run_robot(ctx, -current_param, x, y);
+        update_timer_stop(UPDATE_TIMER_ROBOTS, start);
 
         // On a game state change, we need to return to the main game loop.
         if(mzx_world->change_game_state)
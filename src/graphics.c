@@ -95,6 +95,9 @@ static const struct renderer_data renderers[] =
   { "gx", render_gx_register },
 #endif
   { "xfb", render_xfb_register },
+#endif
+#if defined(CONFIG_RENDER_HEADLESS)
+  { "headless", render_headless_register },
 #endif
   { NULL, NULL }
 };
@@ -138,12 +141,16 @@ static const struct rgb_color default_pal[16] =
 static void remap_charbyte(struct graphics_data *graphics, Uint16 chr,
  Uint8 byte)
 {
+  graphics->char_version[chr]++;
+  graphics->full_redraw = true;
   if(graphics->renderer.remap_charbyte)
     graphics->renderer.remap_charbyte(graphics, chr, byte);
 }
 
 static void remap_char(struct graphics_data *graphics, Uint16 chr)
 {
+  graphics->char_version[chr]++;
+  graphics->full_redraw = true;
   if(graphics->renderer.remap_char)
     graphics->renderer.remap_char(graphics, chr);
 }
@@ -151,6 +158,12 @@ static void remap_char(struct graphics_data *graphics, Uint16 chr)
 static void remap_char_range(struct graphics_data *graphics, Uint16 first,
  Uint16 len)
 {
+  Uint32 i;
+
+  for(i = first; i < (Uint32)first + len && i < FULL_CHARSET_SIZE; i++)
+    graphics->char_version[i]++;
+
+  graphics->full_redraw = true;
   if(graphics->renderer.remap_char_range)
     graphics->renderer.remap_char_range(graphics, first, len);
 }
@@ -336,48 +349,67 @@ __editor_maybe_static void ec_load_mzx(void)
   ec_mem_load_set(graphics.default_charset, CHAR_SIZE * CHARSET_SIZE);
 }
 
-static void update_colors(struct rgb_color *palette, Uint32 count)
+/**
+ * Send colors [first, first + count) of the output palette to the renderer.
+ */
+static void update_colors(Uint32 first, Uint32 count)
 {
-  graphics.renderer.update_colors(&graphics, palette, count);
+  // SMZX index changes also get here, since they mark the palette dirty.
+  graphics.palette_version++;
+
+  if(graphics.renderer.update_colors_range)
+  {
+    graphics.renderer.update_colors_range(&graphics, graphics.output_palette,
+     first, count);
+  }
+  else
+    graphics.renderer.update_colors(&graphics, graphics.output_palette,
+     graphics.output_palette_size);
 }
 
-static Uint32 make_palette(struct rgb_color *palette)
+/**
+ * Make colors [first, end) of a palette from the intensity palette, not
+ * including the protected palette.
+ */
+static void make_palette_colors(struct rgb_color *palette,
+ Uint32 first, Uint32 end)
 {
   Uint32 i;
-  Uint32 paletteSize;
 
-  // Is SMZX mode set?
-  if(graphics.screen_mode)
+  // SMZX mode 1: set all colors to diagonals
+  if(graphics.screen_mode == 1)
   {
-    // SMZX mode 1: set all colors to diagonals
-    if(graphics.screen_mode == 1)
+    for(i = first; i < end; i++)
     {
-      for(i = 0; i < SMZX_PAL_SIZE; i++)
-      {
-        palette[i].r =
-         ((graphics.intensity_palette[i & 15].r << 1) +
-          graphics.intensity_palette[i >> 4].r) / 3;
-        palette[i].g =
-         ((graphics.intensity_palette[i & 15].g << 1) +
-          graphics.intensity_palette[i >> 4].g) / 3;
-        palette[i].b =
-         ((graphics.intensity_palette[i & 15].b << 1) +
-          graphics.intensity_palette[i >> 4].b) / 3;
-      }
+      palette[i].r =
+       ((graphics.intensity_palette[i & 15].r << 1) +
+        graphics.intensity_palette[i >> 4].r) / 3;
+      palette[i].g =
+       ((graphics.intensity_palette[i & 15].g << 1) +
+        graphics.intensity_palette[i >> 4].g) / 3;
+      palette[i].b =
+       ((graphics.intensity_palette[i & 15].b << 1) +
+        graphics.intensity_palette[i >> 4].b) / 3;
     }
-    else
-    {
-      memcpy(palette, graphics.intensity_palette,
-       sizeof(struct rgb_color) * SMZX_PAL_SIZE);
-    }
-    paletteSize = SMZX_PAL_SIZE;
   }
   else
   {
-    memcpy(palette, graphics.intensity_palette,
-     sizeof(struct rgb_color) * PAL_SIZE);
-    paletteSize = PAL_SIZE;
+    memcpy(palette + first, graphics.intensity_palette + first,
+     sizeof(struct rgb_color) * (end - first));
   }
+}
+
+static Uint32 make_palette(struct rgb_color *palette)
+{
+  Uint32 paletteSize;
+
+  // Is SMZX mode set?
+  if(graphics.screen_mode)
+    paletteSize = SMZX_PAL_SIZE;
+  else
+    paletteSize = PAL_SIZE;
+
+  make_palette_colors(palette, 0, paletteSize);
   memcpy(palette + paletteSize, graphics.protected_palette,
    sizeof(struct rgb_color) * PROTECTED_PAL_SIZE);
   graphics.protected_pal_position = paletteSize;
@@ -394,8 +426,81 @@ static Uint32 make_palette(struct rgb_color *palette)
 
 void update_palette(void)
 {
-  struct rgb_color new_palette[FULL_PAL_SIZE];
-  update_colors(new_palette, make_palette(new_palette));
+  graphics.output_palette_size = make_palette(graphics.output_palette);
+  graphics.palette_dirty_first = SMZX_PAL_SIZE;
+  graphics.palette_dirty_end = 0;
+
+  update_colors(0, graphics.output_palette_size);
+  graphics.full_redraw = true;
+}
+
+/**
+ * Remake and send only the colors of the output palette that were affected by
+ * changes to the intensity palette since it was last sent.
+ */
+static void update_palette_range(void)
+{
+  Uint32 first = graphics.palette_dirty_first;
+  Uint32 end = graphics.palette_dirty_end;
+
+  graphics.palette_dirty_first = SMZX_PAL_SIZE;
+  graphics.palette_dirty_end = 0;
+
+  switch(graphics.screen_mode)
+  {
+    case 0:
+      // Only the first 16 colors are used.
+      end = MIN(end, PAL_SIZE);
+      break;
+
+    case 1:
+      // Every color mixes two of the first 16 colors, one in each nibble.
+      if(first >= PAL_SIZE)
+        return;
+
+      end = MIN(end, PAL_SIZE);
+      end = MAX(end << 4, 0xF0 + end);
+      break;
+  }
+
+  end = MIN(end, graphics.output_palette_size);
+  if(first >= end)
+    return;
+
+  make_palette_colors(graphics.output_palette, first, end);
+  update_colors(first, end - first);
+  graphics.full_redraw = true;
+}
+
+/**
+ * Mark a color of the intensity palette as changed.
+ */
+static void dirty_color(Uint32 color)
+{
+  graphics.palette_dirty_first = MIN(graphics.palette_dirty_first, color);
+  graphics.palette_dirty_end = MAX(graphics.palette_dirty_end, color + 1);
+}
+
+/**
+ * Component values for each intensity from 0% to 100%, so fades and other
+ * intensity changes don't need a multiply and divide for every component.
+ */
+static Uint8 intensity_table[101][256];
+static boolean intensity_table_init;
+
+static void init_intensity_table(void)
+{
+  int percent;
+  int i;
+
+  if(intensity_table_init)
+    return;
+
+  for(percent = 0; percent <= 100; percent++)
+    for(i = 0; i < 256; i++)
+      intensity_table[percent][i] = i * percent / 100;
+
+  intensity_table_init = true;
 }
 
 static void init_palette(void)
@@ -416,10 +521,14 @@ static void init_palette(void)
 
   graphics.fade_status = 1;
   graphics.palette_dirty = true;
+  init_intensity_table();
 }
 
-static int intensity(int component, int percent)
+static int intensity(Uint32 component, Uint32 percent)
 {
+  if(percent <= 100 && component <= 255 && intensity_table_init)
+    return intensity_table[percent][component];
+
   component = (component * percent) / 100;
 
   if(component > 255)
@@ -445,7 +554,7 @@ void set_color_intensity(Uint32 color, Uint32 percent)
     graphics.intensity_palette[color].b = b;
 
     graphics.current_intensity[color] = percent;
-    graphics.palette_dirty = true;
+    dirty_color(color);
   }
 }
 
@@ -480,7 +589,7 @@ void set_rgb(Uint32 color, Uint32 r, Uint32 g, Uint32 b)
 
   graphics.palette[color].b = b;
   graphics.intensity_palette[color].b = intensity(b, percent);
-  graphics.palette_dirty = true;
+  dirty_color(color);
 }
 
 void set_protected_rgb(Uint32 color, Uint32 r, Uint32 g, Uint32 b)
@@ -501,7 +610,7 @@ void set_red_component(Uint32 color, Uint32 r)
 
   graphics.palette[color].r = r;
   graphics.intensity_palette[color].r = intensity(r, percent);
-  graphics.palette_dirty = true;
+  dirty_color(color);
 }
 
 void set_green_component(Uint32 color, Uint32 g)
@@ -511,7 +620,7 @@ void set_green_component(Uint32 color, Uint32 g)
 
   graphics.palette[color].g = g;
   graphics.intensity_palette[color].g = intensity(g, percent);
-  graphics.palette_dirty = true;
+  dirty_color(color);
 }
 
 void set_blue_component(Uint32 color, Uint32 b)
@@ -521,7 +630,7 @@ void set_blue_component(Uint32 color, Uint32 b)
 
   graphics.palette[color].b = b;
   graphics.intensity_palette[color].b = intensity(b, percent);
-  graphics.palette_dirty = true;
+  dirty_color(color);
 }
 
 static Uint32 get_smzx_index_offset(Uint32 color, Uint32 index)
@@ -1043,97 +1152,438 @@ static int compare_layers(const void *a, const void *b)
     (*(struct video_layer * const *)b)->draw_order;
 }
 
-void update_screen(void)
+/**
+ * Dirty tracking. draw_world blanks and redraws every layer each frame, so
+ * marking cells as they're written would mark nearly everything. Instead,
+ * each frame is compared against a snapshot of the last frame that was
+ * rendered. Frames where nothing changed aren't rendered at all, and for the
+ * rest the changed areas are given to the renderer in dirty_rects.
+ */
+
+struct layer_snapshot
 {
-  Uint32 ticks = get_ticks();
-  Uint32 layer;
+  struct video_layer layer;
+  struct char_element *data;
+  size_t data_size;
+  boolean visible;
+};
 
-  if((ticks - graphics.cursor_timestamp) > CURSOR_BLINK_RATE)
+struct cursor_state
+{
+  boolean visible;
+  Uint32 x;
+  Uint32 y;
+  Uint16 color;
+  Uint8 lines;
+  Uint8 offset;
+};
+
+struct mouse_state
+{
+  boolean visible;
+  int x;
+  int y;
+  int w;
+  int h;
+};
+
+static struct char_element last_text_video[SCREEN_W * SCREEN_H];
+static struct layer_snapshot last_layers[TEXTVIDEO_LAYERS];
+static Uint32 last_layer_count;
+static boolean last_extended;
+static struct cursor_state last_cursor;
+static struct mouse_state last_mouse;
+
+/**
+ * Force the next frame to be redrawn completely, e.g. if the window contents
+ * were lost.
+ */
+void invalidate_screen(void)
+{
+  graphics.full_redraw = true;
+}
+
+#ifdef CONFIG_FPS
+/**
+ * Get the percentage of chars the layer renderer found in its glyph cache
+ * since the last call, or -1 if it didn't look anything up.
+ */
+double get_glyph_cache_hit_rate(void)
+{
+  Uint64 total = graphics.glyph_cache_hits + graphics.glyph_cache_misses;
+  double rate = -1.0;
+
+  if(total)
+    rate = 100.0 * graphics.glyph_cache_hits / total;
+
+  graphics.glyph_cache_hits = 0;
+  graphics.glyph_cache_misses = 0;
+  return rate;
+}
+#endif
+
+static void add_dirty_rect(int x, int y, int w, int h)
+{
+  struct video_rect *rect;
+
+  if(x < 0)
   {
-    graphics.cursor_flipflop ^= 1;
-    graphics.cursor_timestamp = ticks;
+    w += x;
+    x = 0;
   }
 
-  if(graphics.palette_dirty)
+  if(y < 0)
   {
-    update_palette();
-    graphics.palette_dirty = false;
+    h += y;
+    y = 0;
   }
 
-  if(graphics.requires_extended && graphics.renderer.render_layer)
+  w = MIN(w, SCREEN_PIX_W - x);
+  h = MIN(h, SCREEN_PIX_H - y);
+
+  if(w <= 0 || h <= 0 || graphics.full_redraw)
+    return;
+
+  // Past this many rects it's easier to just draw everything.
+  if(graphics.num_dirty_rects >= MAX_DIRTY_RECTS)
   {
-    for(layer = 0; layer < graphics.layer_count; layer++)
+    graphics.full_redraw = true;
+    return;
+  }
+
+  rect = &(graphics.dirty_rects[graphics.num_dirty_rects++]);
+  rect->x = x;
+  rect->y = y;
+  rect->w = w;
+  rect->h = h;
+}
+
+static void add_dirty_layer(struct video_layer *layer)
+{
+  add_dirty_rect(layer->x, layer->y, layer->w * CHAR_W, layer->h * CHAR_H);
+}
+
+/**
+ * Compare the contents of a layer to its previous contents. Consecutive rows
+ * with changes are combined into one rect spanning their changed columns.
+ */
+static void find_dirty_cells(const struct char_element *prev,
+ const struct char_element *cur, Uint32 w, Uint32 h, int x, int y)
+{
+  size_t row_size = w * sizeof(struct char_element);
+  Uint32 block_start = 0;
+  Uint32 block_min = 0;
+  Uint32 block_max = 0;
+  boolean in_block = false;
+  Uint32 min, max;
+  Uint32 i;
+
+  for(i = 0; i < h; i++, prev += w, cur += w)
+  {
+    if(!memcmp(prev, cur, row_size))
     {
-      graphics.sorted_video_layers[layer] = &graphics.video_layers[layer];
+      if(in_block)
+      {
+        add_dirty_rect(x + block_min * CHAR_W, y + block_start * CHAR_H,
+         (block_max - block_min + 1) * CHAR_W, (i - block_start) * CHAR_H);
+        in_block = false;
+      }
+      continue;
     }
 
-    qsort(graphics.sorted_video_layers, graphics.layer_count,
-     sizeof(struct video_layer *), compare_layers);
+    for(min = 0; !memcmp(prev + min, cur + min, sizeof(struct char_element));
+     min++);
 
-    for(layer = 0; layer < graphics.layer_count; layer++)
+    for(max = w - 1; !memcmp(prev + max, cur + max, sizeof(struct char_element));
+     max--);
+
+    if(!in_block)
     {
-      if(graphics.sorted_video_layers[layer]->data &&
-       !graphics.sorted_video_layers[layer]->empty)
-        graphics.renderer.render_layer(&graphics,
-         graphics.sorted_video_layers[layer]);
+      block_start = i;
+      block_min = min;
+      block_max = max;
+      in_block = true;
+    }
+    else
+    {
+      block_min = MIN(block_min, min);
+      block_max = MAX(block_max, max);
     }
   }
-  else
 
-  if(graphics.renderer.render_graph)
+  if(in_block)
   {
-    // Fallback if the layer renderer is unavailable or unnecessary
-    graphics.renderer.render_graph(&graphics);
+    add_dirty_rect(x + block_min * CHAR_W, y + block_start * CHAR_H,
+     (block_max - block_min + 1) * CHAR_W, (h - block_start) * CHAR_H);
   }
-  else
+}
+
+static boolean layer_is_visible(struct video_layer *layer)
+{
+  return layer->data && !layer->empty;
+}
+
+static boolean layer_is_moved(struct video_layer *a, struct video_layer *b)
+{
+  return a->x != b->x || a->y != b->y || a->w != b->w || a->h != b->h ||
+   a->mode != b->mode || a->draw_order != b->draw_order ||
+   a->transparent_col != b->transparent_col || a->offset != b->offset;
+}
+
+static void find_dirty_layers(void)
+{
+  Uint32 count = MAX(graphics.layer_count, last_layer_count);
+  struct layer_snapshot *last;
+  struct video_layer *layer;
+  boolean visible;
+  Uint32 i;
+
+  for(i = 0; i < count && !graphics.full_redraw; i++)
+  {
+    last = (i < last_layer_count) ? &(last_layers[i]) : NULL;
+    layer = (i < graphics.layer_count) ? &(graphics.video_layers[i]) : NULL;
+    visible = layer && layer_is_visible(layer);
+
+    if(visible && last && last->visible && !layer_is_moved(layer, &last->layer))
+    {
+      find_dirty_cells(last->data, layer->data, layer->w, layer->h,
+       layer->x, layer->y);
+      continue;
+    }
+
+    if(last && last->visible)
+      add_dirty_layer(&(last->layer));
+
+    if(visible)
+      add_dirty_layer(layer);
+  }
+}
+
+static void save_layer_snapshots(void)
+{
+  struct layer_snapshot *last;
+  struct video_layer *layer;
+  size_t size;
+  Uint32 i;
+
+  for(i = 0; i < graphics.layer_count; i++)
+  {
+    last = &(last_layers[i]);
+    layer = &(graphics.video_layers[i]);
+    last->layer = *layer;
+    last->visible = layer_is_visible(layer);
+
+    if(last->visible)
+    {
+      size = layer->w * layer->h * sizeof(struct char_element);
+      if(size > last->data_size)
+      {
+        last->data = crealloc(last->data, size);
+        last->data_size = size;
+      }
+      memcpy(last->data, layer->data, size);
+    }
+  }
+  last_layer_count = graphics.layer_count;
+}
 
-  if(graphics.renderer.render_layer)
+static void find_dirty_cursor(struct cursor_state *cursor)
+{
+  if(cursor->visible == last_cursor.visible && cursor->x == last_cursor.x &&
+   cursor->y == last_cursor.y && cursor->color == last_cursor.color &&
+   cursor->lines == last_cursor.lines && cursor->offset == last_cursor.offset)
+    return;
+
+  if(last_cursor.visible)
   {
-    // Fallback using the layer renderer
-    graphics.text_video_layer.mode = graphics.screen_mode;
-    graphics.text_video_layer.data = graphics.text_video;
+    add_dirty_rect(last_cursor.x * CHAR_W, last_cursor.y * CHAR_H,
+     CHAR_W, CHAR_H);
+  }
+
+  if(cursor->visible)
+    add_dirty_rect(cursor->x * CHAR_W, cursor->y * CHAR_H, CHAR_W, CHAR_H);
+}
+
+static void find_dirty_mouse(struct mouse_state *mouse)
+{
+  if(mouse->visible == last_mouse.visible && mouse->x == last_mouse.x &&
+   mouse->y == last_mouse.y && mouse->w == last_mouse.w &&
+   mouse->h == last_mouse.h)
+    return;
+
+  if(last_mouse.visible)
+    add_dirty_rect(last_mouse.x, last_mouse.y, last_mouse.w, last_mouse.h);
 
-    graphics.renderer.render_layer(&graphics, &(graphics.text_video_layer));
+  if(mouse->visible)
+    add_dirty_rect(mouse->x, mouse->y, mouse->w, mouse->h);
+}
+
+void update_screen(void)
+{
+  Uint32 ticks = get_ticks();
+  struct cursor_state cursor;
+  struct mouse_state mouse;
+  boolean extended;
+  Uint32 layer;
+
+  if((ticks - graphics.cursor_timestamp) > CURSOR_BLINK_RATE)
+  {
+    graphics.cursor_flipflop ^= 1;
+    graphics.cursor_timestamp = ticks;
   }
 
+  if(graphics.palette_dirty)
+  {
+    update_palette();
+    graphics.palette_dirty = false;
+  }
+  else
+
+  if(graphics.palette_dirty_first < graphics.palette_dirty_end)
+    update_palette_range();
+
+  // Work out what the cursor and mouse will look like first, since they may
+  // have changed even if the layers didn't.
+  memset(&cursor, 0, sizeof(struct cursor_state));
   if(graphics.cursor_flipflop &&
    (graphics.cursor_mode != cursor_mode_invisible))
   {
-    Uint16 cursor_color = get_cursor_color();
-    Uint32 lines = 0;
-    Uint32 offset = 0;
+    cursor.visible = true;
+    cursor.x = graphics.cursor_x;
+    cursor.y = graphics.cursor_y;
+    cursor.color = get_cursor_color();
 
     switch(graphics.cursor_mode)
     {
       case cursor_mode_underline:
-        lines = 2;
-        offset = 12;
+        cursor.lines = 2;
+        cursor.offset = 12;
         break;
       case cursor_mode_solid:
-        lines = 14;
-        offset = 0;
+        cursor.lines = 14;
+        cursor.offset = 0;
         break;
       case cursor_mode_invisible:
         break;
     }
-
-    graphics.renderer.render_cursor(&graphics,
-     graphics.cursor_x, graphics.cursor_y, cursor_color, lines, offset);
   }
 
+  memset(&mouse, 0, sizeof(struct mouse_state));
   if(graphics.mouse_status)
   {
-    int mouse_x, mouse_y;
-    get_real_mouse_position(&mouse_x, &mouse_y);
+    get_real_mouse_position(&mouse.x, &mouse.y);
+
+    mouse.visible = true;
+    mouse.x = (mouse.x / graphics.mouse_width_mul) * graphics.mouse_width_mul;
+    mouse.y = (mouse.y / graphics.mouse_height_mul) * graphics.mouse_height_mul;
+    mouse.w = graphics.mouse_width_mul;
+    mouse.h = graphics.mouse_height_mul;
+  }
+
+  extended = graphics.requires_extended && graphics.renderer.render_layer;
+
+  if(extended != last_extended)
+    graphics.full_redraw = true;
 
-    mouse_x = (mouse_x / graphics.mouse_width_mul) * graphics.mouse_width_mul;
-    mouse_y = (mouse_y / graphics.mouse_height_mul) * graphics.mouse_height_mul;
+  if(!graphics.full_redraw)
+  {
+    if(extended)
+      find_dirty_layers();
+    else
+      find_dirty_cells(last_text_video, graphics.text_video,
+       SCREEN_W, SCREEN_H, 0, 0);
+
+    find_dirty_cursor(&cursor);
+    find_dirty_mouse(&mouse);
+
+    // Nothing changed, so the last frame is still correct. Present it again
+    // anyway, since the frame should still take as long as usual (e.g. the
+    // game loop relies on waiting for vsync at mzx_speed 1).
+    if(!graphics.full_redraw && !graphics.num_dirty_rects)
+    {
+      graphics.renderer.sync_screen(&graphics);
+      return;
+    }
+  }
+
+  if(extended)
+  {
+    for(layer = 0; layer < graphics.layer_count; layer++)
+    {
+      graphics.sorted_video_layers[layer] = &graphics.video_layers[layer];
+    }
+
+    qsort(graphics.sorted_video_layers, graphics.layer_count,
+     sizeof(struct video_layer *), compare_layers);
+
+    if(graphics.renderer.render_layers)
+    {
+      // Give the renderer every visible layer at once.
+      Uint32 count = 0;
+
+      for(layer = 0; layer < graphics.layer_count; layer++)
+      {
+        struct video_layer *vlayer = graphics.sorted_video_layers[layer];
+        if(vlayer->data && !vlayer->empty)
+          graphics.sorted_video_layers[count++] = vlayer;
+      }
+
+      graphics.renderer.render_layers(&graphics,
+       graphics.sorted_video_layers, count);
+    }
+    else
+    {
+      for(layer = 0; layer < graphics.layer_count; layer++)
+      {
+        if(graphics.sorted_video_layers[layer]->data &&
+         !graphics.sorted_video_layers[layer]->empty)
+          graphics.renderer.render_layer(&graphics,
+           graphics.sorted_video_layers[layer]);
+      }
+    }
+
+    save_layer_snapshots();
+  }
+  else
+  {
+    if(graphics.renderer.render_graph)
+    {
+      // Fallback if the layer renderer is unavailable or unnecessary
+      graphics.renderer.render_graph(&graphics);
+    }
+    else
+
+    if(graphics.renderer.render_layer)
+    {
+      // Fallback using the layer renderer
+      graphics.text_video_layer.mode = graphics.screen_mode;
+      graphics.text_video_layer.data = graphics.text_video;
+
+      graphics.renderer.render_layer(&graphics, &(graphics.text_video_layer));
+    }
+
+    memcpy(last_text_video, graphics.text_video, sizeof(last_text_video));
+  }
+
+  if(cursor.visible)
+  {
+    graphics.renderer.render_cursor(&graphics,
+     cursor.x, cursor.y, cursor.color, cursor.lines, cursor.offset);
+  }
 
-    graphics.renderer.render_mouse(&graphics, mouse_x, mouse_y,
-     graphics.mouse_width_mul, graphics.mouse_height_mul);
+  if(mouse.visible)
+  {
+    graphics.renderer.render_mouse(&graphics, mouse.x, mouse.y,
+     mouse.w, mouse.h);
   }
 
   graphics.renderer.sync_screen(&graphics);
+
+  last_extended = extended;
+  last_cursor = cursor;
+  last_mouse = mouse;
+  graphics.full_redraw = false;
+  graphics.num_dirty_rects = 0;
 }
 
 // Very quick fade out. Saves intensity table for fade in. Be sure
@@ -1281,6 +1731,19 @@ void default_protected_palette(void)
   graphics.palette_dirty = true;
 }
 
+static void (*renderer_override)(struct renderer *renderer);
+
+/**
+ * Use a renderer that isn't in the renderer list regardless of the config,
+ * e.g. for tools that need the video state but not a display. This needs to
+ * be set before init_video is called. Since there's nobody to answer them,
+ * has_video_initialized will report false so dialogs are skipped.
+ */
+void set_renderer_override(void (*reg)(struct renderer *renderer))
+{
+  renderer_override = reg;
+}
+
 static boolean set_graphics_output(struct config_info *conf)
 {
   char video_output[sizeof(conf->video_output)];
@@ -1288,6 +1751,19 @@ static boolean set_graphics_output(struct config_info *conf)
   const struct renderer_alias *alias = renderer_aliases;
   int i = 0;
 
+  // Only the GL renderers apply vsync, and they set this in init_video.
+  // Clear it so a software renderer (or a fallback from a GL renderer that
+  // failed to start) doesn't report the configured setting.
+  graphics.gl_vsync = 0;
+
+  if(renderer_override)
+  {
+    memset(&graphics.renderer, 0, sizeof(struct renderer));
+    renderer_override(&graphics.renderer);
+    graphics.renderer_num = 0;
+    return true;
+  }
+
   // The first renderer was NULL, this shouldn't happen
   if(!renderer->name)
   {
@@ -1442,6 +1918,12 @@ static void new_empty_layer(struct video_layer *layer, int x, int y, Uint32 w,
   if(!layer->data || layer->w != w || layer->h != h)
     layer->data = crealloc(layer->data, sizeof(struct char_element) * w * h);
 
+  // Zero is never used, so it can stand for "no layer".
+  if(!++graphics.layer_serial)
+    graphics.layer_serial++;
+
+  layer->serial = graphics.layer_serial;
+
   layer->w = w;
   layer->h = h;
   layer->x = x;
@@ -1471,6 +1953,42 @@ Uint32 create_layer(int x, int y, Uint32 w, Uint32 h, int draw_order, int t_col,
   return layer_idx;
 }
 
+/**
+ * Same as create_layer, except if *serial is the serial of the layer this
+ * would create and it's still the same size, the layer keeps the chars it
+ * had instead of being cleared. This lets something that was drawn to a layer
+ * last frame skip drawing it again if nothing changed. The layer's serial is
+ * stored to *serial. Returns true if the chars were kept.
+ */
+boolean create_layer_cached(Uint32 *layer_idx, Uint32 *serial,
+ int x, int y, Uint32 w, Uint32 h, int draw_order, int t_col, int offset,
+ boolean unbound)
+{
+  struct video_layer *layer = &graphics.video_layers[graphics.layer_count];
+
+  if(!*serial || layer->serial != *serial || !layer->data ||
+   layer->w != w || layer->h != h)
+  {
+    *layer_idx = create_layer(x, y, w, h, draw_order, t_col, offset, unbound);
+    *serial = graphics.video_layers[*layer_idx].serial;
+    return false;
+  }
+
+  // Everything but the chars and whether the layer is empty.
+  layer->x = x;
+  layer->y = y;
+  layer->mode = graphics.screen_mode;
+  layer->draw_order = draw_order;
+  layer->transparent_col = t_col;
+  layer->offset = offset;
+  *layer_idx = graphics.layer_count++;
+
+  if(!graphics.requires_extended && unbound)
+    graphics.requires_extended = true;
+
+  return true;
+}
+
 void set_layer_offset(Uint32 layer, int offset)
 {
   graphics.video_layers[layer].offset = offset;
@@ -1620,6 +2138,7 @@ boolean init_video(struct config_info *conf, const char *caption)
   graphics.cursor_flipflop = 1;
   graphics.system_mouse = conf->system_mouse;
   graphics.grab_mouse = conf->grab_mouse;
+  graphics.render_threads = conf->render_threads;
 
   memset(&(graphics.text_video_layer), 0, sizeof(struct video_layer));
   graphics.text_video_layer.w = SCREEN_W;
@@ -1723,6 +2242,9 @@ boolean has_video_initialized(void)
   if(sdl_driver && !strcmp(sdl_driver, "dummy")) return false;
 #endif /* CONFIG_SDL */
 
+  if(renderer_override || graphics.headless)
+    return false;
+
   return graphics_was_initialized;
 }
 
@@ -1775,6 +2297,7 @@ boolean set_video_mode(void)
 
   ret = graphics.renderer.set_video_mode(&graphics,
    target_width, target_height, target_depth, fullscreen, resize);
+  graphics.full_redraw = true;
 
   if(ret)
   {
@@ -1874,6 +2397,14 @@ boolean is_fullscreen(void)
   return graphics.fullscreen;
 }
 
+/**
+ * Whether the active renderer waits for the display when presenting a frame.
+ */
+boolean is_vsync_enabled(void)
+{
+  return graphics.gl_vsync > 0;
+}
+
 void toggle_fullscreen(void)
 {
   graphics.fullscreen = !graphics.fullscreen;
@@ -1898,6 +2429,7 @@ void resize_screen(Uint32 w, Uint32 h)
       exit(1);
     }
     graphics.renderer.resize_screen(&graphics, w, h);
+    graphics.full_redraw = true;
   }
 }
 
@@ -2354,6 +2886,30 @@ void draw_char_ext(Uint8 chr, Uint8 color, Uint32 x,
   dirty_current();
 }
 
+/**
+ * Same as calling draw_char_ext with no offsets for count chars starting at
+ * (x, y). The chars must all be on the same line.
+ */
+void draw_char_run(const Uint8 *chr, const Uint8 *color, Uint32 count,
+ Uint32 x, Uint32 y)
+{
+  int scr_off = (y * SCREEN_W) + x;
+  struct char_element *dest = graphics.current_video + offset_adjust(scr_off);
+  struct char_element *dest_copy = graphics.text_video + scr_off;
+  Uint32 i;
+
+  for(i = 0; i < count; i++)
+  {
+    dest[i].char_value = chr[i];
+    dest[i].bg_color = color[i] >> 4;
+    dest[i].fg_color = color[i] & 0x0F;
+    dest_copy[i] = dest[i];
+  }
+
+  dirty_ui();
+  dirty_current();
+}
+
 void draw_char_linear_ext(Uint8 color, Uint8 chr,
  Uint32 offset, Uint32 offset_b, Uint32 c_offset)
 {
@@ -2379,6 +2935,54 @@ void draw_char_to_layer(Uint8 color, Uint8 chr,
   dirty_current();
 }
 
+/**
+ * Copy a row of chars to the current layer at (x, y), relative to the layer.
+ * Chars that are INVISIBLE_CHAR are copied too, so cells that shouldn't be
+ * drawn need to be INVISIBLE_CHAR with both colors 0xFF, like a new layer.
+ * If to_screen is true, the other chars are also copied to the screen copy
+ * read by get_color_linear etc., the same as draw_char_linear_ext.
+ */
+void draw_layer_row(const struct char_element *src, Uint32 count,
+ Uint32 x, Uint32 y, boolean to_screen)
+{
+  struct video_layer *layer = &graphics.video_layers[graphics.current_layer];
+  struct char_element *dest = graphics.current_video + (y * layer->w) + x;
+  struct char_element *dest_copy;
+  boolean drawn = false;
+  Uint32 i;
+
+  memcpy(dest, src, count * sizeof(struct char_element));
+
+  if(to_screen)
+  {
+    dest_copy = graphics.text_video +
+     (layer->y / CHAR_H + y) * SCREEN_W + layer->x / CHAR_W + x;
+
+    for(i = 0; i < count; i++)
+    {
+      if(src[i].char_value != INVISIBLE_CHAR)
+      {
+        dest_copy[i] = src[i];
+        drawn = true;
+      }
+    }
+  }
+  else
+  {
+    for(i = 0; i < count; i++)
+    {
+      if(src[i].char_value != INVISIBLE_CHAR)
+      {
+        drawn = true;
+        break;
+      }
+    }
+  }
+
+  if(drawn)
+    dirty_current();
+}
+
 void color_string(const char *string, Uint32 x, Uint32 y, Uint8 color)
 {
   color_string_ext(string, x, y, color, PRO_CH, 16, false);
@@ -2687,6 +3291,7 @@ void dump_screen(void)
   // to back this up, fill it, render the layer to memory, then copy the old
   // palette back.
   memcpy(backup_palette, graphics.flat_intensity_palette, palette_size_bytes);
+  graphics.palette_version++;
 
   palette_size = make_palette(palette);
   for(i = 0; i < palette_size; i++)
@@ -2713,6 +3318,7 @@ void dump_screen(void)
   }
 
   memcpy(graphics.flat_intensity_palette, backup_palette, palette_size_bytes);
+  graphics.palette_version++;
 
   //dump_screen_real(ss, palette, make_palette(palette), name);
   dump_screen_real_32bpp(ss, name);
@@ -2802,6 +3408,8 @@ boolean switch_shader(const char *name)
   if(graphics.renderer.switch_shader)
     graphics.renderer.switch_shader(&graphics, name);
 
+  graphics.full_redraw = true;
+
   if(graphics.gl_scaling_shader[0])
     return true;
 
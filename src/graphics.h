@@ -105,6 +105,13 @@ enum default_video_layers
 struct graphics_data;
 struct video_layer;
 
+struct video_rect
+{
+  int x, y, w, h;
+};
+
+#define MAX_DIRTY_RECTS 64
+
 struct renderer
 {
   boolean (*init_video)       (struct graphics_data *, struct config_info *);
@@ -115,6 +122,9 @@ struct renderer
                                 int depth, boolean fullscreen, boolean resize);
   void    (*update_colors)    (struct graphics_data *, struct rgb_color *palette,
                                 Uint32 count);
+  void    (*update_colors_range)(struct graphics_data *,
+                                struct rgb_color *palette, Uint32 first,
+                                Uint32 count);
   void    (*resize_screen)    (struct graphics_data *, int width, int height);
   void    (*remap_char_range) (struct graphics_data *, Uint16 first, Uint16 count);
   void    (*remap_char)       (struct graphics_data *, Uint16 chr);
@@ -127,6 +137,8 @@ struct renderer
   void    (*switch_shader)    (struct graphics_data *, const char *name);
   void    (*render_graph)     (struct graphics_data *);
   void    (*render_layer)     (struct graphics_data *, struct video_layer *);
+  void    (*render_layers)    (struct graphics_data *, struct video_layer **,
+                                Uint32 count);
   void    (*render_cursor)    (struct graphics_data *, Uint32 x, Uint32 y,
                                 Uint16 color, Uint8 lines, Uint8 offset);
   void    (*render_mouse)     (struct graphics_data *, Uint32 x, Uint32 y,
@@ -147,6 +159,7 @@ struct video_layer
   int transparent_col;
   int offset;
   boolean empty;
+  Uint32 serial; // Changes whenever this layer is (re)created.
 };
 
 struct graphics_data
@@ -165,8 +178,18 @@ struct graphics_data
   Uint32 backup_intensity[SMZX_PAL_SIZE];
   boolean palette_dirty;
 
+  // Colors of intensity_palette changed since the palette was last sent to
+  // the renderer, if only some of them did (palette_dirty isn't set).
+  Uint32 palette_dirty_first;
+  Uint32 palette_dirty_end;
+
+  // The palette last sent to the renderer.
+  struct rgb_color output_palette[FULL_PAL_SIZE];
+  Uint32 output_palette_size;
+
   Uint32 layer_count;
   Uint32 layer_count_prev;
+  Uint32 layer_serial;
   struct video_layer text_video_layer;
   struct video_layer video_layers[TEXTVIDEO_LAYERS];
   Uint32 current_layer;
@@ -174,6 +197,15 @@ struct graphics_data
   struct video_layer *sorted_video_layers[TEXTVIDEO_LAYERS];
   boolean requires_extended;
 
+  // Areas of the screen (in pixels) that changed since the last frame was
+  // rendered, including the cursor and mouse. If full_redraw is set, the
+  // entire screen needs to be redrawn and the rects should be ignored.
+  // Only the software renderer uses these right now; the other renderers
+  // still redraw every layer whenever anything has changed.
+  boolean full_redraw;
+  Uint32 num_dirty_rects;
+  struct video_rect dirty_rects[MAX_DIRTY_RECTS];
+
   enum cursor_mode_types cursor_mode;
   boolean fade_status;
   boolean dialog_fade_status;
@@ -199,11 +231,22 @@ struct graphics_data
   enum gl_filter_type gl_filter_method;
   char *gl_scaling_shader;
   int gl_vsync;
+  int render_threads;
+  boolean headless; // No display, so nothing can answer a dialog.
 
   Uint8 default_charset[CHAR_SIZE * CHARSET_SIZE];
 
   Uint32 flat_intensity_palette[FULL_PAL_SIZE];
   Uint32 protected_pal_position;
+
+  // Bumped whenever a char or the colors given to the renderer change, so
+  // anything that keeps expanded chars around knows they need to be redone.
+  Uint32 char_version[FULL_CHARSET_SIZE];
+  Uint32 palette_version;
+#ifdef CONFIG_FPS
+  Uint64 glyph_cache_hits;
+  Uint64 glyph_cache_misses;
+#endif
   struct renderer renderer;
   void *render_data;
   Uint32 renderer_num;
@@ -228,10 +271,14 @@ CORE_LIBSPEC void draw_char_mixed_pal_ext(Uint8 chr, Uint8 bg_color,
  Uint8 fg_color, Uint32 x, Uint32 y, Uint32 offset);
 CORE_LIBSPEC void draw_char_ext(Uint8 chr, Uint8 color, Uint32 x,
  Uint32 y, Uint32 offset, Uint32 c_offset);
+CORE_LIBSPEC void draw_char_run(const Uint8 *chr, const Uint8 *color,
+ Uint32 count, Uint32 x, Uint32 y);
 CORE_LIBSPEC void draw_char_linear_ext(Uint8 color, Uint8 chr,
  Uint32 offset, Uint32 offset_b, Uint32 c_offset);
 CORE_LIBSPEC void draw_char_to_layer(Uint8 color, Uint8 chr,
  Uint32 x, Uint32 y, Uint32 offset_b, Uint32 c_offset);
+CORE_LIBSPEC void draw_layer_row(const struct char_element *src,
+ Uint32 count, Uint32 x, Uint32 y, boolean to_screen);
 CORE_LIBSPEC void write_string_mask(const char *str, Uint32 x, Uint32 y,
  Uint8 color, Uint32 tab_allowed);
 
@@ -242,11 +289,15 @@ CORE_LIBSPEC void cursor_off(void);
 CORE_LIBSPEC void move_cursor(Uint32 x, Uint32 y);
 
 CORE_LIBSPEC boolean init_video(struct config_info *conf, const char *caption);
+void set_renderer_override(void (*reg)(struct renderer *renderer));
 CORE_LIBSPEC void quit_video(void);
 CORE_LIBSPEC void destruct_layers(void);
 CORE_LIBSPEC void destruct_extra_layers(Uint32 first);
 CORE_LIBSPEC Uint32 create_layer(int x, int y, Uint32 w, Uint32 h,
  int draw_order, int t_col, int offset, boolean unbound);
+CORE_LIBSPEC boolean create_layer_cached(Uint32 *layer_idx, Uint32 *serial,
+ int x, int y, Uint32 w, Uint32 h, int draw_order, int t_col, int offset,
+ boolean unbound);
 CORE_LIBSPEC void set_layer_offset(Uint32 layer, int offset);
 CORE_LIBSPEC void set_layer_mode(Uint32 layer, int mode);
 CORE_LIBSPEC void move_layer(Uint32 layer, int x, int y);
@@ -254,6 +305,10 @@ CORE_LIBSPEC void select_layer(Uint32 layer);
 CORE_LIBSPEC void blank_layers(void);
 CORE_LIBSPEC boolean has_video_initialized(void);
 CORE_LIBSPEC void update_screen(void);
+void invalidate_screen(void);
+#ifdef CONFIG_FPS
+double get_glyph_cache_hit_rate(void);
+#endif
 CORE_LIBSPEC void set_window_caption(const char *caption);
 
 CORE_LIBSPEC void ec_read_char(Uint16 chr, char *matrix);
@@ -322,6 +377,7 @@ int get_current_video_output(void);
 
 boolean set_video_mode(void);
 boolean is_fullscreen(void);
+boolean is_vsync_enabled(void);
 void toggle_fullscreen(void);
 void resize_screen(Uint32 w, Uint32 h);
 void set_screen(struct char_element *src);
@@ -18,6 +18,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "board.h"
 #include "const.h"
@@ -453,42 +454,43 @@ unsigned char get_id_under_color(struct board *src_board, int id_offset)
   );
 }
 
-void id_put(struct board *src_board, unsigned char x_pos, unsigned char y_pos,
- int array_x, int array_y, int ovr_x, int ovr_y)
+static boolean overlay_visible(struct board *src_board)
 {
-  int array_offset, overlay_offset;
   int overlay_mode = src_board->overlay_mode;
-  int board_width = src_board->board_width;
 
-  unsigned char c, color;
+  return !(overlay_mode & 128) && (overlay_mode & 3) &&
+   ((overlay_mode & 3) != 3);
+}
 
-  array_offset = (array_y * board_width) + array_x;
+/**
+ * Work out the char and color id_put should draw for a board position and
+ * which layer it goes on. overlay_offset is only used if the overlay is
+ * visible.
+ */
+static int id_get(struct board *src_board, int array_offset,
+ int overlay_offset, unsigned char *_c, unsigned char *_color)
+{
+  int overlay_mode = src_board->overlay_mode;
+  unsigned char c, color;
+  int layer = BOARD_LAYER;
 
-  if(!(overlay_mode & 128) && (overlay_mode & 3) &&
-   ((overlay_mode & 3) != 3))
+  if(overlay_visible(src_board))
   {
-    if(overlay_mode & 2)
-    {
-      overlay_offset = (ovr_y * board_width) + ovr_x;
-    }
-    else
-    {
-      overlay_offset = array_offset;
-    }
-    select_layer(OVERLAY_LAYER);
+    layer = OVERLAY_LAYER;
     c = src_board->overlay[overlay_offset];
     color = src_board->overlay_color[overlay_offset];
     if(overlay_mode & 64)
     {
-      draw_char_ext(c, color, x_pos, y_pos, 0, 0);
-      return;
+      *_c = c;
+      *_color = color;
+      return layer;
     }
 
     if(overlay_mode == 4)
     {
       if(c == 32)
       {
-        select_layer(BOARD_LAYER);
+        layer = BOARD_LAYER;
         c = get_id_char(src_board, array_offset);
         color = get_id_color(src_board, array_offset);
       }
@@ -496,7 +498,7 @@ void id_put(struct board *src_board, unsigned char x_pos, unsigned char y_pos,
       {
         if(!(color & 0xF0) && !(overlay_mode & 64))
         {
-          select_layer(BOARD_LAYER);
+          layer = BOARD_LAYER;
           c = get_id_char(src_board, array_offset);
           color = (color & 0x0F) |
            (get_id_color(src_board, array_offset) & 0xF0);
@@ -507,7 +509,7 @@ void id_put(struct board *src_board, unsigned char x_pos, unsigned char y_pos,
     {
       if(c == 32)
       {
-        select_layer(BOARD_LAYER);
+        layer = BOARD_LAYER;
         c = get_id_char(src_board, array_offset);
         color = get_id_color(src_board, array_offset);
       }
@@ -523,32 +525,211 @@ void id_put(struct board *src_board, unsigned char x_pos, unsigned char y_pos,
   }
   else
   {
-    select_layer(BOARD_LAYER);
     c = get_id_char(src_board, array_offset);
     color = get_id_color(src_board, array_offset);
   }
 
+  *_c = c;
+  *_color = color;
+  return layer;
+}
+
+void id_put(struct board *src_board, unsigned char x_pos, unsigned char y_pos,
+ int array_x, int array_y, int ovr_x, int ovr_y)
+{
+  int board_width = src_board->board_width;
+  int array_offset = (array_y * board_width) + array_x;
+  int overlay_offset = array_offset;
+  unsigned char c, color;
+
+  if(src_board->overlay_mode & 2)
+    overlay_offset = (ovr_y * board_width) + ovr_x;
+
+  select_layer(id_get(src_board, array_offset, overlay_offset, &c, &color));
   draw_char_ext(c, color, x_pos, y_pos, 0, 0);
 }
 
+/**
+ * What each row of the game window looked like the last time it was drawn,
+ * along with every board and overlay value it was drawn from. Nearly every
+ * row of a typical board is the same from one frame to the next, so if a
+ * row's values haven't changed, its chars can be copied from here instead of
+ * working out every one of them again. The board arrays are written directly
+ * all over the place, so comparing them is much safer than expecting every
+ * writer to report its changes.
+ *
+ * Rows are stored by their board row, so rows that are still visible after
+ * the viewport scrolls vertically are kept. Rows containing anything that
+ * depends on more than its own values (lines and webs, which depend on their
+ * neighbors, robots, sensors, scrolls, and the player) are always redrawn.
+ */
+struct id_cache_row
+{
+  boolean valid;
+  boolean redraw;
+  int array_y;
+  unsigned char id[SCREEN_W];
+  unsigned char param[SCREEN_W];
+  unsigned char color[SCREEN_W];
+  unsigned char under_color[SCREEN_W];
+  unsigned char overlay[SCREEN_W];
+  unsigned char overlay_color[SCREEN_W];
+  unsigned char out_char[SCREEN_W];
+  unsigned char out_color[SCREEN_W];
+  unsigned char out_layer[SCREEN_W];
+};
+
+static struct id_cache_row id_cache[SCREEN_H];
+static unsigned char id_cache_chars[ID_CHARS_SIZE];
+static int id_cache_array_x = -1;
+static int id_cache_viewport_x;
+static int id_cache_viewport_width;
+static int id_cache_board_width;
+static int id_cache_overlay_mode;
+
+static boolean id_cache_redraw(enum thing id)
+{
+  return (id >= SENSOR) || (id == LINE) || (id == WEB) || (id == THICK_WEB);
+}
+
+/**
+ * Everything in a row needs to be redrawn if any of the things that affect
+ * the whole window changed since the last frame.
+ */
+static void id_cache_check(struct board *src_board, int array_x)
+{
+  int i;
+
+  if(id_cache_array_x != array_x ||
+   id_cache_viewport_x != src_board->viewport_x ||
+   id_cache_viewport_width != src_board->viewport_width ||
+   id_cache_board_width != src_board->board_width ||
+   id_cache_overlay_mode != src_board->overlay_mode ||
+   memcmp(id_cache_chars, id_chars, ID_CHARS_SIZE))
+  {
+    for(i = 0; i < SCREEN_H; i++)
+      id_cache[i].valid = false;
+
+    memcpy(id_cache_chars, id_chars, ID_CHARS_SIZE);
+    id_cache_array_x = array_x;
+    id_cache_viewport_x = src_board->viewport_x;
+    id_cache_viewport_width = src_board->viewport_width;
+    id_cache_board_width = src_board->board_width;
+    id_cache_overlay_mode = src_board->overlay_mode;
+  }
+}
+
+static void id_cache_draw_row(struct board *src_board, int y,
+ int array_x, int array_y, int ovr_y)
+{
+  struct id_cache_row *row = &(id_cache[array_y % SCREEN_H]);
+  int board_width = src_board->board_width;
+  int width = src_board->viewport_width;
+  int viewport_x = src_board->viewport_x;
+  int array_offset = (array_y * board_width) + array_x;
+  int overlay_offset = array_offset;
+  boolean use_overlay = overlay_visible(src_board);
+  int layer;
+  int end;
+  int i;
+
+  char *level_id = src_board->level_id + array_offset;
+  char *level_param = src_board->level_param + array_offset;
+  char *level_color = src_board->level_color + array_offset;
+  char *level_under_color = src_board->level_under_color + array_offset;
+  char *overlay = NULL;
+  char *overlay_color = NULL;
+
+  if(use_overlay)
+  {
+    if(src_board->overlay_mode & 2)
+      overlay_offset = ovr_y * board_width;
+
+    overlay = src_board->overlay + overlay_offset;
+    overlay_color = src_board->overlay_color + overlay_offset;
+  }
+
+  if(!row->valid || row->redraw || row->array_y != array_y ||
+   memcmp(row->id, level_id, width) ||
+   memcmp(row->param, level_param, width) ||
+   memcmp(row->color, level_color, width) ||
+   memcmp(row->under_color, level_under_color, width) ||
+   (use_overlay &&
+    (memcmp(row->overlay, overlay, width) ||
+     memcmp(row->overlay_color, overlay_color, width))))
+  {
+    row->valid = true;
+    row->redraw = false;
+    row->array_y = array_y;
+    memcpy(row->id, level_id, width);
+    memcpy(row->param, level_param, width);
+    memcpy(row->color, level_color, width);
+    memcpy(row->under_color, level_under_color, width);
+
+    if(use_overlay)
+    {
+      memcpy(row->overlay, overlay, width);
+      memcpy(row->overlay_color, overlay_color, width);
+    }
+
+    for(i = 0; i < width; i++)
+    {
+      row->out_layer[i] = id_get(src_board, array_offset + i,
+       overlay_offset + i, row->out_char + i, row->out_color + i);
+
+      if(id_cache_redraw((enum thing)row->id[i]))
+        row->redraw = true;
+    }
+  }
+
+  // Draw each run of chars on the same layer at once.
+  for(i = 0; i < width; i = end)
+  {
+    layer = row->out_layer[i];
+    for(end = i + 1; end < width; end++)
+      if(row->out_layer[end] != layer)
+        break;
+
+    select_layer(layer);
+    draw_char_run(row->out_char + i, row->out_color + i, end - i,
+     viewport_x + i, y);
+  }
+}
+
 void draw_game_window(struct board *src_board, int array_x, int array_y)
 {
-  int x_limit, y_limit;
-  int x, y;
-  int a_x, a_y;
-  int o_x, o_y;
+  int y_limit;
+  int y, a_y, o_y;
 
-  x_limit = src_board->viewport_width;
   y_limit = src_board->viewport_height;
 
-  for(y = src_board->viewport_y, a_y = array_y, o_y = 0; o_y < y_limit;
-   y++, a_y++, o_y++)
+  // The viewport can be bigger than the board, in which case this draws
+  // whatever is past the edges of the board like it always has.
+  if(array_x < 0 || array_y < 0 ||
+   array_x + src_board->viewport_width > src_board->board_width ||
+   array_y + y_limit > src_board->board_height)
   {
-    for(x = src_board->viewport_x, a_x = array_x, o_x = 0;
-     o_x < x_limit; x++, a_x++, o_x++)
+    int x_limit = src_board->viewport_width;
+    int x, a_x, o_x;
+
+    for(y = src_board->viewport_y, a_y = array_y, o_y = 0; o_y < y_limit;
+     y++, a_y++, o_y++)
     {
-      id_put(src_board, x, y, a_x, a_y, o_x, o_y);
+      for(x = src_board->viewport_x, a_x = array_x, o_x = 0;
+       o_x < x_limit; x++, a_x++, o_x++)
+      {
+        id_put(src_board, x, y, a_x, a_y, o_x, o_y);
+      }
     }
+    return;
+  }
+
+  id_cache_check(src_board, array_x);
+
+  for(y = src_board->viewport_y, a_y = array_y, o_y = 0; o_y < y_limit;
+   y++, a_y++, o_y++)
+  {
+    id_cache_draw_row(src_board, y, array_x, a_y, o_y);
   }
 }
 
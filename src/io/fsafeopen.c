@@ -22,12 +22,14 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <time.h>
 #include <sys/stat.h>
 
 #include "fsafeopen.h"
 #include "dir.h"
 #include "path.h"
 
+#include "../hashtable.h"
 #include "../util.h"
 
 #ifndef __WIN32__
@@ -283,34 +285,98 @@ static void case4(char *string)
     string[i] = toupper((int)string[i]);
 }
 
-// brute force method; returns -1 if no permutation can be found to work
-
-static int case5(char *path, size_t buffer_len, char *string, boolean check_sfn)
+/**
+ * Check a directory entry against a truncated SFN (e.g. NAME~1.EXT). If the
+ * SFN generated for the entry matches, the entry replaces the token. There's
+ * no way to tell which of several matching entries the SFN meant, so any
+ * match after the first one is an error.
+ *
+ * @param  string         Token to replace with the matching entry.
+ * @param  string_sfn     Copy of the original token.
+ * @param  name           Name of the directory entry.
+ * @param  max_len        Maximum length of an entry the token can expand to.
+ * @param  has_sfn_match  Set if this entry matches; should start false.
+ * @param  ret            Set to the result if this entry matches.
+ * @return                true if the search should stop, otherwise false.
+ */
+static boolean match_sfn_entry(char *string, const char *string_sfn,
+ const char *name, size_t max_len, boolean *has_sfn_match, int *ret)
 {
-  int ret = -FSAFE_BRUTE_FORCE_FAILED;
-  int dirlen = string - path;
-  struct mzx_dir wd;
-  char *newpath;
+  char name_sfn[SFN_BUFFER_LEN];
+  const char *name_cmp = get_sfn(name_sfn, SFN_BUFFER_LEN, name);
+  size_t name_len;
 
-  newpath = cmalloc(PATH_BUF_LEN);
+  if(!name_cmp || strcasecmp(string_sfn, name_cmp))
+    return false;
+
+  name_len = strlen(name);
+
+  // If there are duplicate SFN matches, there is no unambiguous
+  // result and thus it is not possible to guarantee a correct match.
+  if(*has_sfn_match)
+  {
+    trace("%s:%d: ambiguous match for SFN '%s' to '%s', aborting.\n",
+     __FILE__, __LINE__, string_sfn, name);
+    memcpy(string, string_sfn, strlen(string_sfn) + 1);
+    *ret = -FSAFE_BRUTE_FORCE_SFN_AMBIGUOUS;
+    return true;
+  }
+  else
+
+  // Make sure the SFN expansion won't overflow the buffer.
+  if(name_len > max_len)
+  {
+    trace("%s:%d: expansion for SFN '%s' to '%s' would overflow buffer,"
+     " aborting.\n", __FILE__, __LINE__, string_sfn, name);
+    *ret = -FSAFE_BRUTE_FORCE_SFN_OVERFLOW;
+    return true;
+  }
+  else
+  {
+    // Overwrite the old path with the expanded match, then continue
+    // searching the directory for duplicate matches or an exact match.
+    memcpy(string, name, name_len + 1);
+    trace("%s:%d: expanded SFN '%s' to '%s'\n",
+     __FILE__, __LINE__, string_sfn, name);
+    *has_sfn_match = true;
+    *ret = FSAFE_SUCCESS;
+  }
+  return false;
+}
 
+// get the directory containing the last token of a path
+
+static void get_token_dir(char *dest, const char *path, int dirlen)
+{
   // prepend the working directory
-  snprintf(newpath, PATH_BUF_LEN, "./");
+  snprintf(dest, PATH_BUF_LEN, "./");
 
   // copy everything sans last token
   if(dirlen > 0)
   {
     if(dirlen + 2 >= PATH_BUF_LEN)
       dirlen = PATH_BUF_LEN - 2;
-    strncpy(newpath + 2, path, dirlen - 1);
-    newpath[dirlen + 2 - 1] = 0;
+    strncpy(dest + 2, path, dirlen - 1);
+    dest[dirlen + 2 - 1] = 0;
   }
+}
+
+// brute force method; returns -1 if no permutation can be found to work
+
+static int case5(char *path, size_t buffer_len, char *string, boolean check_sfn)
+{
+  int ret = -FSAFE_BRUTE_FORCE_FAILED;
+  int dirlen = string - path;
+  struct mzx_dir wd;
+  char *newpath;
+
+  newpath = cmalloc(PATH_BUF_LEN);
+  get_token_dir(newpath, path, dirlen);
 
   if(dir_open(&wd, newpath))
   {
     const char *string_cmp = string;
     char string_sfn[SFN_BUFFER_LEN];
-    char newpath_sfn[SFN_BUFFER_LEN];
     boolean string_is_wildcard_sfn = false;
     boolean has_sfn_match = false;
 
@@ -336,42 +402,9 @@ static int case5(char *path, size_t buffer_len, char *string, boolean check_sfn)
 
       if(string_is_wildcard_sfn)
       {
-        const char *newpath_cmp = get_sfn(newpath_sfn, SFN_BUFFER_LEN, newpath);
-        if(!strcasecmp(string_cmp, newpath_cmp))
-        {
-          size_t newpath_len = strlen(newpath);
-
-          // If there are duplicate SFN matches, there is no unambiguous
-          // result and thus it is not possible to guarantee a correct match.
-          if(has_sfn_match)
-          {
-            trace("%s:%d: ambiguous match for SFN '%s' to '%s', aborting.\n",
-             __FILE__, __LINE__, string_sfn, newpath);
-            memcpy(string, string_sfn, strlen(string_sfn) + 1);
-            ret = -FSAFE_BRUTE_FORCE_SFN_AMBIGUOUS;
-            break;
-          }
-          else
-
-          // Make sure the SFN expansion won't overflow the buffer.
-          if(newpath_len + dirlen + 1 > buffer_len)
-          {
-            trace("%s:%d: expansion for SFN '%s' to '%s' would overflow buffer,"
-             " aborting.\n", __FILE__, __LINE__, string_sfn, newpath);
-            ret = -FSAFE_BRUTE_FORCE_SFN_OVERFLOW;
-            break;
-          }
-          else
-          {
-            // Overwrite the old path with the expanded match, then continue
-            // searching the directory for duplicate matches or an exact match.
-            memcpy(string, newpath, newpath_len + 1);
-            trace("%s:%d: expanded SFN '%s' to '%s'\n",
-             __FILE__, __LINE__, string_sfn, newpath);
-            has_sfn_match = true;
-            ret = FSAFE_SUCCESS;
-          }
-        }
+        if(match_sfn_entry(string, string_sfn, newpath,
+         buffer_len - dirlen - 1, &has_sfn_match, &ret))
+          break;
       }
     }
 
@@ -382,22 +415,319 @@ static int case5(char *path, size_t buffer_len, char *string, boolean check_sfn)
   return ret;
 }
 
-static int match(char *path, size_t buffer_len)
+/**
+ * Case-insensitive index of the names in a directory. Without it, every use
+ * of a path that isn't cased correctly stats a few permutations of each
+ * wrong token and then reads the whole directory. Instead, the first lookup
+ * in a directory reads it into a hash table, and later lookups in it only
+ * need to stat the directory and probe the table.
+ *
+ * An index is rebuilt if the directory's device, inode, or modification time
+ * change. Directories modified in the last few seconds aren't kept, since
+ * their modification time might not change if they're modified again within
+ * the same second (or two, on FAT). Some filesystems don't update directory
+ * modification times at all, so fsafeopen also drops the index of any
+ * directory it opens a file in for writing.
+ */
+
+#define FSAFE_INDEX_DIRS 16
+#define FSAFE_INDEX_MTIME_SLACK 2
+
+struct fsafe_index_entry
 {
-  char *oldtoken = NULL, *token = NULL;
+  uint32_t hash;
+  uint32_t name_length;
+  // Next entry with the same name ignoring case, in directory order.
+  struct fsafe_index_entry *next;
+  char name[1];
+};
+
+HASH_SET_INIT(FSAFE_INDEX, struct fsafe_index_entry *, name, name_length)
+
+struct fsafe_index
+{
+  char path[PATH_BUF_LEN];
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  unsigned int last_used;
+  boolean is_valid;
+  void *hash_table;
+  // Every entry, in directory order.
+  struct fsafe_index_entry **entries;
+  int num_entries;
+  int num_entries_allocated;
+};
+
+static struct fsafe_index fsafe_indexes[FSAFE_INDEX_DIRS];
+static unsigned int fsafe_index_uses;
+
+static void clear_index(struct fsafe_index *idx)
+{
+  int i;
+
+  for(i = 0; i < idx->num_entries; i++)
+    free(idx->entries[i]);
+
+  HASH_CLEAR(FSAFE_INDEX, idx->hash_table);
+  free(idx->entries);
+  idx->entries = NULL;
+  idx->num_entries = 0;
+  idx->num_entries_allocated = 0;
+  idx->is_valid = false;
+}
+
+static void add_index_entry(struct fsafe_index *idx, const char *name)
+{
+  struct fsafe_index_entry *first;
+  struct fsafe_index_entry *entry;
+  size_t name_length = strlen(name);
+
+  entry = cmalloc(sizeof(struct fsafe_index_entry) + name_length);
+  memcpy(entry->name, name, name_length + 1);
+  entry->name_length = name_length;
+  entry->next = NULL;
+
+  HASH_FIND(FSAFE_INDEX, idx->hash_table, name, name_length, first);
+  if(first)
+  {
+    while(first->next)
+      first = first->next;
+
+    first->next = entry;
+  }
+  else
+    HASH_ADD(FSAFE_INDEX, idx->hash_table, entry);
+
+  if(idx->num_entries == idx->num_entries_allocated)
+  {
+    idx->num_entries_allocated = MAX(32, idx->num_entries_allocated * 2);
+    idx->entries = crealloc(idx->entries,
+     idx->num_entries_allocated * sizeof(struct fsafe_index_entry *));
+  }
+  idx->entries[idx->num_entries++] = entry;
+}
+
+static boolean build_index(struct fsafe_index *idx, const char *dir_path,
+ struct stat *dir_info)
+{
+  struct mzx_dir wd;
+  char *name;
+
+  if(!dir_open(&wd, dir_path))
+    return false;
+
+  name = cmalloc(PATH_BUF_LEN);
+  while(dir_get_next_entry(&wd, name, NULL))
+    add_index_entry(idx, name);
+
+  free(name);
+  dir_close(&wd);
+
+  snprintf(idx->path, PATH_BUF_LEN, "%s", dir_path);
+  idx->dev = dir_info->st_dev;
+  idx->ino = dir_info->st_ino;
+  idx->mtime = dir_info->st_mtime;
+
+  // This index can still be used for the current lookup either way.
+  idx->is_valid = (dir_info->st_mtime + FSAFE_INDEX_MTIME_SLACK < time(NULL));
+  return true;
+}
+
+static struct fsafe_index *get_index(const char *dir_path)
+{
+  struct fsafe_index *oldest = NULL;
+  struct fsafe_index *idx;
+  struct stat dir_info;
+  int i;
+
+  if(stat(dir_path, &dir_info) || !S_ISDIR(dir_info.st_mode))
+    return NULL;
+
+  for(i = 0; i < FSAFE_INDEX_DIRS; i++)
+  {
+    idx = &(fsafe_indexes[i]);
+
+    if(idx->is_valid && !strcmp(idx->path, dir_path))
+    {
+      if(idx->dev == dir_info.st_dev && idx->ino == dir_info.st_ino &&
+       idx->mtime == dir_info.st_mtime)
+      {
+        idx->last_used = ++fsafe_index_uses;
+        return idx;
+      }
+
+      // The directory changed, so rebuild its index in place.
+      oldest = idx;
+      break;
+    }
+
+    if(!oldest || (oldest->is_valid &&
+     (!idx->is_valid || idx->last_used < oldest->last_used)))
+      oldest = idx;
+  }
+
+  idx = oldest;
+  clear_index(idx);
+
+  if(!build_index(idx, dir_path, &dir_info))
+    return NULL;
+
+  idx->last_used = ++fsafe_index_uses;
+  return idx;
+}
+
+// Drop the index of the directory containing a file (if there is one).
+
+static void invalidate_index(const char *path)
+{
+  const char *last_slash = strrchr(path, '/');
+  char *dir_path = cmalloc(PATH_BUF_LEN);
+  int i;
+
+  get_token_dir(dir_path, path, last_slash ? last_slash - path + 1 : 0);
+
+  for(i = 0; i < FSAFE_INDEX_DIRS; i++)
+    if(fsafe_indexes[i].is_valid && !strcmp(fsafe_indexes[i].path, dir_path))
+      clear_index(&(fsafe_indexes[i]));
+
+  free(dir_path);
+}
+
+/**
+ * Pick which of the entries matching a token (ignoring case) to use when
+ * there's more than one, the same way match_token would: the first of these
+ * cases with an exact match, otherwise the first match in directory order.
+ */
+static struct fsafe_index_entry *choose_index_entry(
+ struct fsafe_index_entry *first, const char *token, boolean is_file)
+{
+  static void (* const cases[])(char *) = { NULL, case1, case2, case3, case4 };
+  int num_cases = is_file ? 5 : 3;
+  struct fsafe_index_entry *entry;
+  size_t len = strlen(token);
+  char *buffer;
+  int i;
+
+  if(!first->next)
+    return first;
+
+  buffer = cmalloc(len + 1);
+  for(i = 0; i < num_cases; i++)
+  {
+    memcpy(buffer, token, len + 1);
+    if(cases[i])
+      cases[i](buffer);
+
+    for(entry = first; entry; entry = entry->next)
+    {
+      if(!strcmp(entry->name, buffer))
+      {
+        free(buffer);
+        return entry;
+      }
+    }
+  }
+
+  free(buffer);
+  return first;
+}
+
+/**
+ * Find the last token of a path in the index of its directory, replacing the
+ * token with the name of the entry it matches.
+ *
+ * @return  false if the directory couldn't be indexed, otherwise true (and
+ *          ret is set to the same result as the brute force method).
+ */
+static boolean match_indexed(char *path, size_t buffer_len, char *token,
+ boolean is_file, int *ret)
+{
+  struct fsafe_index_entry *entry;
+  struct fsafe_index *idx;
+  int dirlen = token - path;
+  char *dir_path;
+  size_t len;
+  int i;
+
+  dir_path = cmalloc(PATH_BUF_LEN);
+  get_token_dir(dir_path, path, dirlen);
+  idx = get_index(dir_path);
+  free(dir_path);
+
+  if(!idx)
+    return false;
+
+  len = strlen(token);
+  HASH_FIND(FSAFE_INDEX, idx->hash_table, token, len, entry);
+  if(entry)
+  {
+    entry = choose_index_entry(entry, token, is_file);
+    memcpy(token, entry->name, len + 1);
+    *ret = FSAFE_SUCCESS;
+    return true;
+  }
+
+  *ret = -FSAFE_BRUTE_FORCE_FAILED;
+
+  // If the token is a truncated SFN, check it against generated SFNs from
+  // files in the directory.
+  if(is_file && is_sfn(token, len) == SFN_TRUNCATED)
+  {
+    char token_sfn[SFN_BUFFER_LEN];
+    boolean has_sfn_match = false;
+
+    memcpy(token_sfn, token, len + 1);
+
+    for(i = 0; i < idx->num_entries; i++)
+      if(match_sfn_entry(token, token_sfn, idx->entries[i]->name,
+       buffer_len - dirlen - 1, &has_sfn_match, ret))
+        break;
+  }
+  return true;
+}
+
+/* FOUR likely permutations on files, and two likely permutations on
+ * directories before we start having to do anything fancy:
+ *
+ * filename.ext FILENAME.EXT filename.EXT FILENAME.ext
+ * directory    DIRECTORY
+ */
+
+static int match_token(char *path, size_t buffer_len, char *token,
+ boolean is_file)
+{
+  static void (* const cases[])(char *) = { case1, case2, case3, case4 };
+  int num_cases = is_file ? 4 : 2;
   struct stat inode;
+  int ret;
   int i;
 
+  // check the token as-is
+  if(stat(path, &inode) == 0)
+    return FSAFE_SUCCESS;
+
+  // try the directory's index, then normal cases, then brute force
+  if(match_indexed(path, buffer_len, token, is_file, &ret))
+    return ret;
+
+  for(i = 0; i < num_cases; i++)
+  {
+    cases[i](token);
+    if(stat(path, &inode) == 0)
+      return FSAFE_SUCCESS;
+  }
+
+  return case5(path, buffer_len, token, is_file);
+}
+
+static int match(char *path, size_t buffer_len)
+{
+  char *oldtoken = NULL, *token = NULL;
+
   if(path == NULL)
     return -FSAFE_MATCH_FAILED;
 
-  /* FOUR likely permutations on files, and two likely permutations on
-   * directories before we start having to do anything fancy:
-   *
-   * filename.ext FILENAME.EXT filename.EXT FILENAME.ext
-   * directory    DIRECTORY
-   */
-
   while(1)
   {
     if(token == NULL)
@@ -413,70 +743,20 @@ static int match(char *path, size_t buffer_len)
       // this token is the file
       if(token == NULL)
       {
-        for(i = 0; i < 5; i++)
+        if(match_token(path, buffer_len, oldtoken, true) < 0)
         {
-          // check file
-          if(stat(path, &inode) == 0)
-            break;
-
-          // try normal cases, then try brute force
-          switch(i)
-          {
-            case 0:
-              case1(oldtoken);
-              break;
-
-            case 1:
-              case2(oldtoken);
-              break;
-
-            case 2:
-              case3(oldtoken);
-              break;
-
-            case 3:
-              case4(oldtoken);
-              break;
-
-            default:
-              // try brute force
-              if(case5(path, buffer_len, oldtoken, true) < 0)
-              {
-                trace("%s:%d: file matches for %s failed.\n",
-                 __FILE__, __LINE__, path);
-                return -FSAFE_MATCH_FAILED;
-              }
-          }
+          trace("%s:%d: file matches for %s failed.\n",
+           __FILE__, __LINE__, path);
+          return -FSAFE_MATCH_FAILED;
         }
         break;
       }
 
-      for(i = 0; i < 3; i++)
+      if(match_token(path, buffer_len, oldtoken, false) < 0)
       {
-        // check directory
-        if(stat(path, &inode) == 0)
-          break;
-
-        // try normal cases, then try brute force
-        switch(i)
-        {
-          case 0:
-            case1(oldtoken);
-            break;
-
-          case 1:
-            case2(oldtoken);
-            break;
-
-          default:
-            // try brute force
-            if(case5(path, buffer_len, oldtoken, false) < 0)
-            {
-              trace("%s:%d: directory matches for %s failed.\n",
-               __FILE__, __LINE__, path);
-              return -FSAFE_MATCH_FAILED;
-            }
-        }
+        trace("%s:%d: directory matches for %s failed.\n",
+         __FILE__, __LINE__, path);
+        return -FSAFE_MATCH_FAILED;
       }
 
       /* this "hack" overwrites the token's \0 to re-formulate
@@ -648,6 +928,13 @@ FILE *fsafeopen(const char *path, const char *mode)
 
   // _TRY_ opening the file
   f = fopen_unsafe(newpath, mode);
+
+#ifdef ENABLE_DOS_COMPAT_TRANSLATIONS
+  // this may have created the file, so its directory needs to be reindexed
+  if(f && strpbrk(mode, "wa+"))
+    invalidate_index(newpath);
+#endif
+
   free(newpath);
   return f;
 }
@@ -212,6 +212,37 @@ struct memfile *vfile_get_memfile(vfile *vf)
   return &(vf->mf);
 }
 
+/**
+ * Map the entire contents of a file opened for reading into memory. The file
+ * can be closed afterward. Returns NULL if the file is empty or the platform
+ * can't map files; otherwise, unmap the file with vfunmap when done with it.
+ */
+void *vfmap(FILE *fp, size_t *len)
+{
+  struct stat st;
+  void *ptr;
+
+  assert(fp && len);
+
+  if(fstat(fileno(fp), &st) || st.st_size <= 0)
+    return NULL;
+
+  ptr = platform_map_file(fp, st.st_size);
+  if(ptr)
+    *len = st.st_size;
+
+  return ptr;
+}
+
+/**
+ * Unmap a file mapped with vfmap.
+ */
+void vfunmap(void *ptr, size_t len)
+{
+  assert(ptr);
+  platform_unmap_file(ptr, len);
+}
+
 /**
  * Change the current working directory to path.
  */
@@ -40,6 +40,9 @@ int vfclose(vfile *vf);
 
 struct memfile *vfile_get_memfile(vfile *vf);
 
+void *vfmap(FILE *fp, size_t *len);
+void vfunmap(void *ptr, size_t len);
+
 int vchdir(const char *path);
 char *vgetcwd(char *buf, size_t size);
 int vmkdir(const char *path, int mode);
@@ -73,6 +73,35 @@ static inline int platform_stat(const char *path, struct stat *buf)
   return stat(path, buf);
 }
 
+/**
+ * Memory-mapped files, where available.
+ */
+
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#include <sys/mman.h>
+
+static inline void *platform_map_file(FILE *fp, size_t len)
+{
+  void *ptr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+  return (ptr != MAP_FAILED) ? ptr : NULL;
+}
+
+static inline void platform_unmap_file(void *ptr, size_t len)
+{
+  munmap(ptr, len);
+}
+
+#else /* !_POSIX_MAPPED_FILES */
+
+static inline void *platform_map_file(FILE *fp, size_t len)
+{
+  return NULL;
+}
+
+static inline void platform_unmap_file(void *ptr, size_t len) {}
+
+#endif /* !_POSIX_MAPPED_FILES */
+
 __M_END_DECLS
 
 #endif /* __IO_VFILE_WIN32_H */
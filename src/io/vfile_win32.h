@@ -36,6 +36,8 @@ __M_BEGIN_DECLS
 #include <unistd.h>
 #endif
 
+#include <io.h>
+
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #include <wchar.h>
@@ -203,6 +205,33 @@ static inline int platform_stat(const char *path, struct stat *buf)
   return stat(path, buf);
 }
 
+/**
+ * Memory-mapped files. The view keeps the mapping open after its handle is
+ * closed, and the mapping keeps the file open after fp is closed.
+ */
+static inline void *platform_map_file(FILE *fp, size_t len)
+{
+  HANDLE file = (HANDLE)_get_osfhandle(_fileno(fp));
+  HANDLE mapping;
+  void *ptr;
+
+  if(file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(!mapping)
+    return NULL;
+
+  ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, len);
+  CloseHandle(mapping);
+  return ptr;
+}
+
+static inline void platform_unmap_file(void *ptr, size_t len)
+{
+  UnmapViewOfFile(ptr);
+}
+
 __M_END_DECLS
 
 #endif /* __IO_VFILE_WIN32_H */
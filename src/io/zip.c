@@ -410,6 +410,225 @@ static void zip_free_file_header(struct zip_file_header *fh)
   free(fh);
 }
 
+/**
+ * Allocate and set up the header for a file about to be written.
+ */
+static struct zip_file_header *zip_new_write_file_header(const char *name,
+ int method)
+{
+  uint16_t file_name_len = strlen(name);
+  struct zip_file_header *fh = zip_allocate_file_header(file_name_len);
+
+#ifdef ZIP_WRITE_DATA_DESCRIPTOR
+  fh->flags = ZIP_F_DATA_DESCRIPTOR;
+#else
+  fh->flags = 0;
+#endif
+  fh->method = method;
+  fh->crc32 = 0;
+  fh->compressed_size = 0;
+  fh->uncompressed_size = 0;
+  fh->offset = 0;
+  fh->file_name_length = file_name_len;
+  memcpy(fh->file_name, name, file_name_len + 1);
+  return fh;
+}
+
+/**
+ * Add the header of a file that has been fully written to the archive.
+ */
+static void zip_add_file_header(struct zip_archive *zp,
+ struct zip_file_header *fh)
+{
+  if(zp->pos == zp->files_alloc)
+  {
+    int count = zp->files_alloc * 2;
+    zp->files = crealloc(zp->files, count * sizeof(struct zip_file_header *));
+    zp->files_alloc = count;
+  }
+  zp->running_file_name_length += fh->file_name_length;
+  zp->files[zp->pos] = fh;
+  zp->num_files++;
+  zp->pos++;
+}
+
+/********/
+/* Jobs */
+/********/
+
+struct zip_job_stream
+{
+  struct zip_stream_data data;
+  uint8_t padding[ZIP_STREAM_DATA_PADDING];
+};
+
+/**
+ * Compress a job's file. This makes the same calls to the compressor as
+ * zip_write_file does, so the output is the same as if it had been written
+ * directly.
+ */
+static enum zip_error zip_compress_job(struct zip_method_handler *handler,
+ struct zip_job *job)
+{
+  struct zip_job_stream stream;
+  struct zip_stream_data *stream_data = &(stream.data);
+  size_t alloc = job->src_len + (job->src_len >> 3) + 64;
+  boolean finish = false;
+  enum zip_error result;
+
+  job->dest = cmalloc(alloc);
+
+  handler->compress_open(stream_data, job->fh->method, 0);
+  handler->input(stream_data, job->src, job->src_len);
+  handler->output(stream_data, job->dest, alloc);
+
+  while(true)
+  {
+    result = handler->compress_block(stream_data, finish);
+
+    if(result == ZIP_OUTPUT_FULL)
+    {
+      job->dest = crealloc(job->dest, alloc * 2);
+      handler->output(stream_data, (uint8_t *)job->dest + alloc, alloc);
+      alloc *= 2;
+      continue;
+    }
+
+    if(result == ZIP_INPUT_EMPTY && !finish)
+    {
+      finish = true;
+      continue;
+    }
+    break;
+  }
+
+  handler->close(stream_data, NULL, NULL);
+
+  if(result != ZIP_STREAM_FINISHED)
+    return ZIP_COMPRESS_FAILED;
+
+  job->dest_len = stream_data->final_output_length;
+  return ZIP_SUCCESS;
+}
+
+/**
+ * Decompress a job's file and check its CRC-32.
+ */
+static enum zip_error zip_decompress_job(struct zip_method_handler *handler,
+ struct zip_job *job)
+{
+  struct zip_job_stream stream;
+  struct zip_stream_data *stream_data = &(stream.data);
+  struct zip_file_header *fh = job->fh;
+  enum zip_error result;
+
+  job->dest_len = fh->uncompressed_size;
+  job->dest = cmalloc(MAX(job->dest_len, 1));
+
+  handler->decompress_open(stream_data, fh->method, fh->flags);
+  handler->input(stream_data, job->src, job->src_len);
+  handler->output(stream_data, job->dest, job->dest_len);
+
+  if(handler->decompress_block)
+    result = handler->decompress_block(stream_data);
+  else
+    result = handler->decompress_file(stream_data);
+
+  handler->close(stream_data, NULL, NULL);
+
+  // Like zread, running out of input isn't an error by itself; if the file
+  // is incomplete, the CRC-32 will catch it.
+  if(result && result != ZIP_OUTPUT_FULL && result != ZIP_STREAM_FINISHED &&
+   result != ZIP_INPUT_EMPTY)
+    return result;
+
+  job->crc32 = crc32(0, job->dest, job->dest_len);
+  if(job->crc32 != fh->crc32)
+    return ZIP_CRC32_MISMATCH;
+
+  return ZIP_SUCCESS;
+}
+
+/**
+ * Compress or decompress the file for a job. This doesn't touch the archive
+ * the job belongs to, so it can be called from any thread.
+ */
+void zip_run_job(struct zip_job *job)
+{
+  struct zip_method_handler *handler = NULL;
+
+  if(job->fh->method != ZIP_M_NONE)
+    handler = zip_method_handlers[job->fh->method];
+
+  if(job->is_compression)
+  {
+    job->crc32 = crc32(0, job->src, job->src_len);
+
+    if(handler)
+    {
+      job->result = zip_compress_job(handler, job);
+    }
+    else
+    {
+      job->dest = job->src;
+      job->dest_len = job->src_len;
+      job->result = ZIP_SUCCESS;
+    }
+  }
+  else
+    job->result = zip_decompress_job(handler, job);
+}
+
+static void zip_free_job(struct zip_job *job)
+{
+  // Compression jobs own their header until it's added to the archive.
+  if(job->is_compression)
+    zip_free_file_header(job->fh);
+
+  if(job->dest != job->src)
+    free(job->dest);
+
+  free(job->src);
+  free(job);
+}
+
+/**
+ * Start a job and add it to the end of the archive's job queue.
+ */
+static void zip_start_job(struct zip_archive *zp, struct zip_job *job)
+{
+  uint32_t next = (zp->jobs_first + zp->jobs_count) % zp->worker->max_jobs;
+
+  zp->jobs[next] = job;
+  zp->jobs_count++;
+  zp->worker->start(zp->worker, job);
+}
+
+/**
+ * Get the first job in the archive's queue without waiting for it.
+ */
+static struct zip_job *zip_peek_job(struct zip_archive *zp)
+{
+  if(zp->jobs_count)
+    return zp->jobs[zp->jobs_first];
+
+  return NULL;
+}
+
+/**
+ * Remove the first job from the archive's queue and wait for it to finish.
+ */
+static struct zip_job *zip_finish_job(struct zip_archive *zp)
+{
+  struct zip_job *job = zp->jobs[zp->jobs_first];
+
+  zp->jobs_first = (zp->jobs_first + 1) % zp->worker->max_jobs;
+  zp->jobs_count--;
+
+  zp->worker->wait(zp->worker, job);
+  return job;
+}
+
 static char file_sig_local[] =
 {
   0x50,
@@ -947,6 +1166,15 @@ enum zip_error zread(void *destBuf, size_t readLen, struct zip_archive *zp)
 
   fh = zp->streaming_file;
 
+  // Already decompressed by a read ahead job
+  if(zp->stream_job)
+  {
+    struct zip_job *job = zp->stream_job;
+    memcpy(destBuf,
+     (uint8_t *)job->dest + job->dest_len - zp->stream_u_left, readLen);
+  }
+  else
+
   // No compression
   if(fh->method == ZIP_M_NONE)
   {
@@ -1113,6 +1341,64 @@ err_out:
   return result;
 }
 
+/**
+ * Wait for and free any read ahead jobs for files before the given position.
+ */
+static void zip_drop_read_jobs(struct zip_archive *zp, uint32_t pos)
+{
+  struct zip_job *job;
+
+  while((job = zip_peek_job(zp)) && job->index < pos)
+    zip_free_job(zip_finish_job(zp));
+}
+
+/**
+ * Read compressed files after the current file ahead of time and start
+ * decompressing them through the worker, up to the worker's job limit.
+ * Stored files are quicker to read directly, so they're left alone. Anything
+ * that goes wrong here is left for the regular read functions to report.
+ */
+static void zip_read_ahead(struct zip_archive *zp)
+{
+  uint32_t max_jobs = zp->worker->max_jobs;
+
+  zp->prefetch_pos = MAX(zp->prefetch_pos, zp->pos);
+
+  while(zp->jobs_count < max_jobs && zp->prefetch_pos < zp->num_files)
+  {
+    uint32_t index = zp->prefetch_pos++;
+    struct zip_file_header *fh = zp->files[index];
+    struct zip_method_handler *handler;
+    struct zip_job *job;
+    void *src;
+
+    if(fh->method == ZIP_M_NONE || !zip_method_is_supported(fh->method))
+      continue;
+
+    handler = zip_method_handlers[fh->method];
+    if(!handler->decompress_open || !fh->compressed_size)
+      continue;
+
+    if(vfseek(zp->vf, fh->offset, SEEK_SET) ||
+     zip_verify_local_file_header(zp, fh))
+      continue;
+
+    src = cmalloc(fh->compressed_size);
+    if(!vfread(src, fh->compressed_size, 1, zp->vf))
+    {
+      free(src);
+      continue;
+    }
+
+    job = ccalloc(1, sizeof(struct zip_job));
+    job->fh = fh;
+    job->index = index;
+    job->src = src;
+    job->src_len = fh->compressed_size;
+    zip_start_job(zp, job);
+  }
+}
+
 /**
  * Common function for zip stream opening.
  * mode should be either ZIP_S_READ_STREAM or ZIP_S_READ_MEMSTREAM.
@@ -1186,6 +1472,43 @@ static enum zip_error zip_read_stream_open(struct zip_archive *zp, uint8_t mode)
   return ZIP_SUCCESS;
 }
 
+/**
+ * If the current file was read ahead, stream it out of the finished job
+ * instead of decompressing it again. Returns ZIP_IGNORE_FILE if the file
+ * needs to be streamed normally instead (including if the job failed, so the
+ * regular stream can report the error).
+ */
+static enum zip_error zip_read_stream_job(struct zip_archive *zp)
+{
+  struct zip_job *job;
+
+  if(zp->read_file_error || zp->pos >= zp->num_files)
+    return ZIP_IGNORE_FILE;
+
+  zip_drop_read_jobs(zp, zp->pos);
+  job = zip_peek_job(zp);
+
+  if(!job || job->index != zp->pos)
+    return ZIP_IGNORE_FILE;
+
+  job = zip_finish_job(zp);
+  if(job->result || job->dest_len != job->fh->uncompressed_size)
+  {
+    zip_free_job(job);
+    return ZIP_IGNORE_FILE;
+  }
+
+  zp->mode = ZIP_S_READ_STREAM;
+  zp->streaming_file = job->fh;
+  zp->stream_job = job;
+  zp->stream_u_left = job->dest_len;
+  zp->stream_left = 0;
+  zp->stream_crc32 = 0;
+
+  precalculate_read_errors(zp);
+  return ZIP_SUCCESS;
+}
+
 /**
  * Open a stream to read the next file from a zip archive. If provided, destLen
  * will be the uncompressed size of the file on return (or 0 upon error).
@@ -1193,7 +1516,14 @@ static enum zip_error zip_read_stream_open(struct zip_archive *zp, uint8_t mode)
 enum zip_error zip_read_open_file_stream(struct zip_archive *zp,
  size_t *destLen)
 {
-  enum zip_error result = zip_read_stream_open(zp, ZIP_S_READ_STREAM);
+  enum zip_error result = ZIP_IGNORE_FILE;
+
+  if(zp && zp->worker)
+    result = zip_read_stream_job(zp);
+
+  if(result == ZIP_IGNORE_FILE)
+    result = zip_read_stream_open(zp, ZIP_S_READ_STREAM);
+
   if(result)
     goto err_out;
 
@@ -1281,6 +1611,12 @@ enum zip_error zip_read_close_stream(struct zip_archive *zp)
   expected_crc32 = zp->streaming_file->crc32;
   stream_crc32 = zp->stream_crc32;
 
+  if(zp->stream_job)
+  {
+    zip_free_job(zp->stream_job);
+    zp->stream_job = NULL;
+  }
+
   // Increment the position and clear the streaming vars
   zp->mode = ZIP_S_READ_FILES;
   zp->streaming_file = NULL;
@@ -1292,6 +1628,9 @@ enum zip_error zip_read_close_stream(struct zip_archive *zp)
 
   precalculate_read_errors(zp);
 
+  if(zp->worker)
+    zip_read_ahead(zp);
+
   // Check for an error from zread...
   if(result)
     goto err_out;
@@ -1312,6 +1651,46 @@ err_out:
   return result;
 }
 
+/**
+ * Read the current file from its read ahead job, if it has one. Returns
+ * ZIP_IGNORE_FILE if the file needs to be read normally instead.
+ */
+static enum zip_error zip_read_file_job(struct zip_archive *zp,
+ void *destBuf, size_t destLen, size_t *readLen)
+{
+  struct zip_job *job;
+  enum zip_error result;
+
+  if(zp->read_file_error || zp->pos >= zp->num_files)
+    return ZIP_IGNORE_FILE;
+
+  zip_drop_read_jobs(zp, zp->pos);
+  job = zip_peek_job(zp);
+
+  if(!job || job->index != zp->pos)
+  {
+    zip_read_ahead(zp);
+    return ZIP_IGNORE_FILE;
+  }
+
+  job = zip_finish_job(zp);
+  result = job->result;
+  *readLen = MIN(destLen, job->dest_len);
+
+  if(!result)
+    memcpy(destBuf, job->dest, *readLen);
+
+  if(result == ZIP_CRC32_MISMATCH)
+    warn("crc check: expected %"PRIx32", got %"PRIx32"\n",
+     job->fh->crc32, job->crc32);
+
+  zip_free_job(job);
+  zp->pos++;
+
+  zip_read_ahead(zp);
+  return result;
+}
+
 /**
  * Rewind to the start of the zip archive.
  */
@@ -1330,6 +1709,13 @@ enum zip_error zip_rewind(struct zip_archive *zp)
 
   zp->pos = 0;
 
+  if(zp->worker)
+  {
+    zip_drop_read_jobs(zp, zp->num_files);
+    zp->prefetch_pos = 0;
+    zip_read_ahead(zp);
+  }
+
   return ZIP_SUCCESS;
 
 err_out:
@@ -1337,6 +1723,40 @@ err_out:
   return result;
 }
 
+/**
+ * Move to a file in the zip archive by its position in the central directory,
+ * i.e. the value zp->pos had when it was the next file.
+ */
+enum zip_error zip_set_position(struct zip_archive *zp, uint32_t pos)
+{
+  enum zip_error result;
+
+  result = zp->read_file_error;
+  if(result)
+    goto err_out;
+
+  if(pos >= zp->num_files)
+  {
+    result = ZIP_EOF;
+    goto err_out;
+  }
+
+  zp->pos = pos;
+
+  if(zp->worker)
+  {
+    zip_drop_read_jobs(zp, zp->num_files);
+    zp->prefetch_pos = pos;
+    zip_read_ahead(zp);
+  }
+
+  return ZIP_SUCCESS;
+
+err_out:
+  zip_error("zip_set_position", result);
+  return result;
+}
+
 /**
  * Skip the current file in the zip archive.
  */
@@ -1381,6 +1801,21 @@ enum zip_error zip_read_file(struct zip_archive *zp,
     goto err_out;
   }
 
+  if(zp && zp->worker)
+  {
+    result = zip_read_file_job(zp, destBuf, destLen, &u_size);
+    if(result != ZIP_IGNORE_FILE)
+    {
+      if(result)
+        goto err_out;
+
+      if(readLen)
+        *readLen = u_size;
+
+      return ZIP_SUCCESS;
+    }
+  }
+
   result = zip_read_open_file_stream(zp, &u_size);
   if(result)
     goto err_out;
@@ -1688,6 +2123,107 @@ static inline enum zip_error zip_write_data_descriptor(struct zip_archive *zp,
   return ZIP_SUCCESS;
 }
 
+/**
+ * Write a file compressed by a job to the archive. This writes exactly what
+ * zip_write_file would have for the same file.
+ */
+static enum zip_error zip_write_job(struct zip_archive *zp, struct zip_job *job)
+{
+  struct zip_file_header *fh = job->fh;
+  enum zip_error result = job->result;
+
+  if(result)
+    return result;
+
+  if(zp->is_memory && zip_ensure_capacity(fh->file_name_length + 30, zp))
+    return ZIP_EOF;
+
+  fh->offset = vftell(zp->vf);
+  result = zip_write_file_header(zp, fh, 0);
+  if(result)
+    return result;
+
+  if(job->dest_len)
+  {
+    result = zwrite_out(job->dest, job->dest_len, zp);
+    if(result)
+      return result;
+  }
+
+  fh->crc32 = job->crc32;
+  fh->compressed_size = job->dest_len;
+  fh->uncompressed_size = job->src_len;
+
+  result = zip_write_data_descriptor(zp, fh);
+  if(result)
+    return result;
+
+  // The archive owns the header now.
+  zip_add_file_header(zp, fh);
+  job->fh = NULL;
+
+  zp->mode = ZIP_S_WRITE_FILES;
+  precalculate_write_errors(zp);
+  return ZIP_SUCCESS;
+}
+
+/**
+ * Wait for queued files and write them to the archive in order. Unless all is
+ * true, this only writes enough files to make room for another job. After an
+ * error, the remaining files are still waited for, but not written.
+ */
+static enum zip_error zip_write_jobs(struct zip_archive *zp, boolean all)
+{
+  uint32_t max_jobs = all ? 1 : zp->worker->max_jobs;
+  enum zip_error result = ZIP_SUCCESS;
+  struct zip_job *job;
+
+  while(zp->jobs_count >= max_jobs)
+  {
+    job = zip_finish_job(zp);
+
+    if(!result)
+      result = zip_write_job(zp, job);
+
+    zip_free_job(job);
+  }
+  return result;
+}
+
+/**
+ * Copy a file and queue it to be compressed by the worker. The file will be
+ * written once it and every file queued before it are finished.
+ */
+static enum zip_error zip_queue_write_file(struct zip_archive *zp,
+ const char *name, const void *src, size_t srcLen, int method)
+{
+  struct zip_job *job;
+  enum zip_error result;
+
+  result = zp->write_file_error;
+  if(result)
+    return result;
+
+  result = zip_get_stream(zp, method, ZIP_S_WRITE_STREAM);
+  zp->stream = NULL;
+  if(result)
+    return result;
+
+  result = zip_write_jobs(zp, false);
+  if(result)
+    return result;
+
+  job = ccalloc(1, sizeof(struct zip_job));
+  job->fh = zip_new_write_file_header(name, method);
+  job->is_compression = true;
+  job->src = cmalloc(MAX(srcLen, 1));
+  job->src_len = srcLen;
+  memcpy(job->src, src, srcLen);
+
+  zip_start_job(zp, job);
+  return ZIP_SUCCESS;
+}
+
 /**
  * Common function for zip write stream opening.
  * mode should be either ZIP_S_WRITE_STREAM or ZIP_S_WRITE_MEMSTREAM.
@@ -1696,8 +2232,6 @@ static enum zip_error zip_write_open_stream(struct zip_archive *zp,
  const char *name, int method, uint8_t mode)
 {
   struct zip_file_header *fh;
-  uint16_t file_name_len;
-
   enum zip_error result;
 
   result = (zp ? zp->write_file_error : ZIP_NULL);
@@ -1715,6 +2249,14 @@ static enum zip_error zip_write_open_stream(struct zip_archive *zp,
       return ZIP_UNSUPPORTED_METHOD_MEMORY_STREAM;
   }
 
+  // Anything waiting on the worker needs to be written before this file.
+  if(zp->worker)
+  {
+    result = zip_write_jobs(zp, true);
+    if(result)
+      return result;
+  }
+
   // memfiles: make sure there's enough space for the header
   if(zp->is_memory && zip_ensure_capacity(strlen(name) + 30, zp))
     return ZIP_EOF;
@@ -1725,22 +2267,9 @@ static enum zip_error zip_write_open_stream(struct zip_archive *zp,
   if(result)
     return result;
 
-  file_name_len = strlen(name);
-  fh = zip_allocate_file_header(file_name_len);
-
   // Set up the header
-#ifdef ZIP_WRITE_DATA_DESCRIPTOR
-  fh->flags = ZIP_F_DATA_DESCRIPTOR;
-#else
-  fh->flags = 0;
-#endif
-  fh->method = method;
-  fh->crc32 = 0;
-  fh->compressed_size = 0;
-  fh->uncompressed_size = 0;
+  fh = zip_new_write_file_header(name, method);
   fh->offset = vftell(zp->vf);
-  fh->file_name_length = file_name_len;
-  memcpy(fh->file_name, name, file_name_len + 1);
 
   // Write the header
   result = zip_write_file_header(zp, fh, 0);
@@ -1868,16 +2397,7 @@ enum zip_error zip_write_close_stream(struct zip_archive *zp)
     goto err_out;
 
   // Put the file header into the zip archive
-  if(zp->pos == zp->files_alloc)
-  {
-    int count = zp->files_alloc * 2;
-    zp->files = crealloc(zp->files, count * sizeof(struct zip_file_header *));
-    zp->files_alloc = count;
-  }
-  zp->running_file_name_length += fh->file_name_length;
-  zp->files[zp->pos] = fh;
-  zp->num_files++;
-  zp->pos++;
+  zip_add_file_header(zp, fh);
 
   // Clean up the stream
   zp->mode = ZIP_S_WRITE_FILES;
@@ -1942,6 +2462,15 @@ enum zip_error zip_write_file(struct zip_archive *zp, const char *name,
 
   // No need to check mode; the functions used here will
 
+  if(zp && zp->worker)
+  {
+    result = zip_queue_write_file(zp, name, src, srcLen, method);
+    if(result)
+      goto err_out;
+
+    return ZIP_SUCCESS;
+  }
+
   result = zip_write_open_file_stream(zp, name, method);
   if(result)
     goto err_out;
@@ -2220,6 +2749,48 @@ static enum zip_error zip_write_eocd_record(struct zip_archive *zp)
   return ZIP_SUCCESS;
 }
 
+/**
+ * Attach a worker to an archive to (de)compress its files, or detach the
+ * current worker with NULL. Detaching the worker from an archive being written
+ * writes all files still waiting on it. A worker must stay valid until it's
+ * detached or the archive is closed.
+ */
+enum zip_error zip_set_worker(struct zip_archive *zp, struct zip_worker *worker)
+{
+  enum zip_error result = ZIP_SUCCESS;
+
+  if(!zp)
+    return ZIP_NULL;
+
+  if(zp->worker)
+  {
+    if(zp->mode == ZIP_S_WRITE_UNINITIALIZED || zp->mode == ZIP_S_WRITE_FILES)
+      result = zip_write_jobs(zp, true);
+    else
+      zip_drop_read_jobs(zp, zp->num_files);
+
+    free(zp->jobs);
+    zp->jobs = NULL;
+    zp->jobs_first = 0;
+    zp->worker = NULL;
+  }
+
+  if(worker && worker->max_jobs > 0)
+  {
+    zp->worker = worker;
+    zp->jobs = cmalloc(worker->max_jobs * sizeof(struct zip_job *));
+    zp->prefetch_pos = zp->pos;
+
+    if(zp->mode == ZIP_S_READ_FILES)
+      zip_read_ahead(zp);
+  }
+
+  if(result)
+    zip_error("zip_set_worker", result);
+
+  return result;
+}
+
 /**
  * Attempts to close the zip archive, and when writing, constructs the central
  * directory and EOCD record. Upon returning ZIP_SUCCESS, *final_length will be
@@ -2227,6 +2798,7 @@ static enum zip_error zip_write_eocd_record(struct zip_archive *zp)
  */
 enum zip_error zip_close(struct zip_archive *zp, size_t *final_length)
 {
+  enum zip_error jobs_result = ZIP_SUCCESS;
   int result = ZIP_SUCCESS;
   int mode;
   int i;
@@ -2236,6 +2808,16 @@ enum zip_error zip_close(struct zip_archive *zp, size_t *final_length)
     return ZIP_NULL;
   }
 
+  // Finish any files still waiting on a worker.
+  if(zp->worker)
+    jobs_result = zip_set_worker(zp, NULL);
+
+  if(zp->stream_job)
+  {
+    zip_free_job(zp->stream_job);
+    zp->stream_job = NULL;
+  }
+
   mode = zp->mode;
 
   // Before initiating the close, make sure there wasn't an open write stream!
@@ -2319,6 +2901,9 @@ enum zip_error zip_close(struct zip_archive *zp, size_t *final_length)
   free(zp->files);
   free(zp);
 
+  if(result == ZIP_SUCCESS)
+    result = jobs_result;
+
   if(result != ZIP_SUCCESS)
     zip_error("zip_close", result);
 
@@ -2372,6 +2957,13 @@ static struct zip_archive *zip_new_archive(void)
   zp->external_buffer = NULL;
   zp->external_buffer_size = NULL;
 
+  zp->worker = NULL;
+  zp->jobs = NULL;
+  zp->jobs_first = 0;
+  zp->jobs_count = 0;
+  zp->prefetch_pos = 0;
+  zp->stream_job = NULL;
+
   zp->mode = ZIP_S_READ_UNINITIALIZED;
 
   return zp;
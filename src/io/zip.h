@@ -194,6 +194,49 @@ struct zip_stream_data
 
 struct zip_method_handler;
 
+/**
+ * A file to be compressed or decompressed on behalf of an archive by a
+ * zip_worker. These are created and freed by the archive; workers only need
+ * to call zip_run_job for them (from any thread) and track when they finish.
+ */
+struct zip_job
+{
+  struct zip_file_header *fh;
+  uint32_t index;
+  boolean is_compression;
+
+  void *src;
+  size_t src_len;
+  void *dest;
+  size_t dest_len;
+  uint32_t crc32;
+  enum zip_error result;
+
+  // For the worker's use.
+  struct zip_job *next;
+  boolean done;
+};
+
+/**
+ * Runs zip_jobs, possibly on other threads. While a worker is attached to an
+ * archive, files written with zip_write_file are compressed through it and
+ * written in order as they finish, and compressed files are read ahead and
+ * decompressed through it for zip_read_file and zip_read_open_file_stream.
+ * Either way, the archive and the data read from it are exactly the same as
+ * without a worker.
+ */
+struct zip_worker
+{
+  // Start running a job.
+  void (*start)(struct zip_worker *, struct zip_job *);
+
+  // Wait for a started job to finish.
+  void (*wait)(struct zip_worker *, struct zip_job *);
+
+  // Maximum number of jobs an archive should have started at once.
+  int max_jobs;
+};
+
 struct zip_archive
 {
   uint8_t mode;
@@ -234,6 +277,13 @@ struct zip_archive
   void **external_buffer;
   size_t *external_buffer_size;
 
+  struct zip_worker *worker;
+  struct zip_job **jobs;
+  uint32_t jobs_first;
+  uint32_t jobs_count;
+  uint32_t prefetch_pos;
+  struct zip_job *stream_job;
+
   struct zip_method_handler *stream;
   struct zip_stream_data stream_data;
   uint8_t padding[ZIP_STREAM_DATA_PADDING];
@@ -267,6 +317,9 @@ UTILS_LIBSPEC enum zip_error zip_read_open_mem_stream(struct zip_archive *zp,
 
 UTILS_LIBSPEC enum zip_error zip_rewind(struct zip_archive *zp);
 
+UTILS_LIBSPEC enum zip_error zip_set_position(struct zip_archive *zp,
+ uint32_t pos);
+
 UTILS_LIBSPEC enum zip_error zip_skip_file(struct zip_archive *zp);
 
 UTILS_LIBSPEC enum zip_error zip_read_file(struct zip_archive *zp,
@@ -289,6 +342,11 @@ UTILS_LIBSPEC enum zip_error zip_write_close_mem_stream(struct zip_archive *zp,
 UTILS_LIBSPEC enum zip_error zip_write_file(struct zip_archive *zp,
  const char *name, const void *src, size_t srcLen, int method);
 
+UTILS_LIBSPEC void zip_run_job(struct zip_job *job);
+
+UTILS_LIBSPEC enum zip_error zip_set_worker(struct zip_archive *zp,
+ struct zip_worker *worker);
+
 UTILS_LIBSPEC enum zip_error zip_close(struct zip_archive *zp,
  size_t *final_length);
 
@@ -0,0 +1,222 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Thread pool zip_worker. Jobs are run in the order they were started by
+ * whichever thread takes them first, including the thread waiting on them,
+ * which runs queued jobs itself instead of sleeping. The archive writes the
+ * results in its own order, so the number of threads doesn't change them.
+ */
+
+#include <stdlib.h>
+
+#include "../util.h"
+#include "zip.h"
+#include "zip_threads.h"
+
+// Threads are available even when platform.h doesn't include them (i.e. if
+// audio and networking are disabled).
+#ifdef CONFIG_PTHREAD
+#include "../thread_pthread.h"
+#define ZIP_THREADS
+#elif defined(CONFIG_SDL)
+#include "../thread_sdl.h"
+#define ZIP_THREADS
+#endif
+
+#ifdef ZIP_THREADS
+
+#define MAX_ZIP_THREADS 16
+
+// Most world files are small, so allow a few jobs per thread to keep every
+// thread busy while the archive waits on the oldest one.
+#define ZIP_JOBS_PER_THREAD 4
+
+struct zip_thread_pool
+{
+  struct zip_worker worker;
+  platform_mutex lock;
+  platform_cond start_cond;
+  platform_cond done_cond;
+  platform_thread threads[MAX_ZIP_THREADS];
+  int num_threads;
+  boolean quit;
+
+  struct zip_job *first;
+  struct zip_job *last;
+};
+
+/**
+ * Take the oldest job nobody has started running yet, if any.
+ * Must be called with the pool locked.
+ */
+static struct zip_job *zip_threads_take(struct zip_thread_pool *pool)
+{
+  struct zip_job *job = pool->first;
+
+  if(job)
+  {
+    pool->first = job->next;
+    if(!pool->first)
+      pool->last = NULL;
+  }
+  return job;
+}
+
+/**
+ * Run a job taken from the pool. Must be called with the pool locked.
+ */
+static void zip_threads_run(struct zip_thread_pool *pool, struct zip_job *job)
+{
+  platform_mutex_unlock(&(pool->lock));
+  zip_run_job(job);
+  platform_mutex_lock(&(pool->lock));
+
+  job->done = true;
+  platform_cond_broadcast(&(pool->done_cond));
+}
+
+static THREAD_RES zip_thread_main(void *data)
+{
+  struct zip_thread_pool *pool = (struct zip_thread_pool *)data;
+  struct zip_job *job;
+
+  platform_mutex_lock(&(pool->lock));
+  while(true)
+  {
+    while(!pool->quit && !pool->first)
+      platform_cond_wait(&(pool->start_cond), &(pool->lock));
+
+    if(pool->quit)
+      break;
+
+    job = zip_threads_take(pool);
+    zip_threads_run(pool, job);
+  }
+  platform_mutex_unlock(&(pool->lock));
+  THREAD_RETURN;
+}
+
+static void zip_threads_start(struct zip_worker *worker, struct zip_job *job)
+{
+  struct zip_thread_pool *pool = (struct zip_thread_pool *)worker;
+
+  job->next = NULL;
+  job->done = false;
+
+  platform_mutex_lock(&(pool->lock));
+  if(pool->last)
+    pool->last->next = job;
+  else
+    pool->first = job;
+
+  pool->last = job;
+  platform_cond_signal(&(pool->start_cond));
+  platform_mutex_unlock(&(pool->lock));
+}
+
+static void zip_threads_wait(struct zip_worker *worker, struct zip_job *job)
+{
+  struct zip_thread_pool *pool = (struct zip_thread_pool *)worker;
+  struct zip_job *next;
+
+  platform_mutex_lock(&(pool->lock));
+  while(!job->done)
+  {
+    next = zip_threads_take(pool);
+    if(next)
+      zip_threads_run(pool, next);
+    else
+      platform_cond_wait(&(pool->done_cond), &(pool->lock));
+  }
+  platform_mutex_unlock(&(pool->lock));
+}
+
+void zip_threads_free(struct zip_worker *worker)
+{
+  struct zip_thread_pool *pool = (struct zip_thread_pool *)worker;
+  int i;
+
+  if(!pool)
+    return;
+
+  platform_mutex_lock(&(pool->lock));
+  pool->quit = true;
+  platform_cond_broadcast(&(pool->start_cond));
+  platform_mutex_unlock(&(pool->lock));
+
+  for(i = 0; i < pool->num_threads; i++)
+    platform_thread_join(&(pool->threads[i]));
+
+  platform_cond_destroy(&(pool->done_cond));
+  platform_cond_destroy(&(pool->start_cond));
+  platform_mutex_destroy(&(pool->lock));
+  free(pool);
+}
+
+struct zip_worker *zip_threads_init(int num_threads)
+{
+  struct zip_thread_pool *pool;
+  int i;
+
+  if(num_threads <= 0)
+    num_threads = platform_get_cpu_count();
+
+  // The thread using the archive runs jobs while it waits, so start one fewer.
+  num_threads = MIN(num_threads - 1, MAX_ZIP_THREADS);
+  if(num_threads <= 0)
+    return NULL;
+
+  pool = (struct zip_thread_pool *)ccalloc(1, sizeof(struct zip_thread_pool));
+  pool->worker.start = zip_threads_start;
+  pool->worker.wait = zip_threads_wait;
+
+  platform_mutex_init(&(pool->lock));
+  platform_cond_init(&(pool->start_cond));
+  platform_cond_init(&(pool->done_cond));
+
+  for(i = 0; i < num_threads; i++)
+  {
+    if(platform_thread_create(&(pool->threads[i]),
+     (platform_thread_fn)zip_thread_main, pool))
+      break;
+
+    pool->num_threads++;
+  }
+
+  if(!pool->num_threads)
+  {
+    zip_threads_free(&(pool->worker));
+    return NULL;
+  }
+
+  pool->worker.max_jobs = (pool->num_threads + 1) * ZIP_JOBS_PER_THREAD;
+  return &(pool->worker);
+}
+
+#else /* !ZIP_THREADS */
+
+struct zip_worker *zip_threads_init(int num_threads)
+{
+  return NULL;
+}
+
+void zip_threads_free(struct zip_worker *worker) {}
+
+#endif /* !ZIP_THREADS */
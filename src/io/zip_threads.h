@@ -0,0 +1,52 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __ZIP_THREADS_H
+#define __ZIP_THREADS_H
+
+#include "../compat.h"
+
+__M_BEGIN_DECLS
+
+#include "zip.h"
+
+/**
+ * Start a pool of threads to (de)compress the files of a zip archive. Attach
+ * it to an archive with zip_set_worker.
+ *
+ * @param num_threads   Number of threads to use, or 0 for one per CPU. This
+ *                      includes the thread using the archive.
+ * @return              A zip_worker, or NULL if only one thread would be used
+ *                      or threads aren't available.
+ */
+
+CORE_LIBSPEC struct zip_worker *zip_threads_init(int num_threads);
+
+/**
+ * Stop and free a pool of threads started with zip_threads_init. The archive
+ * it was attached to must be closed (or the pool detached from it) first.
+ *
+ * @param worker        The zip_worker returned by zip_threads_init, or NULL.
+ */
+
+CORE_LIBSPEC void zip_threads_free(struct zip_worker *worker);
+
+__M_END_DECLS
+
+#endif // __ZIP_THREADS_H
@@ -112,6 +112,11 @@ int legacy_load_board_direct(struct world *mzx_world, struct board *cur_board,
   cur_board->num_sensors_allocated = 0;
   cur_board->robot_list = NULL;
   cur_board->robot_list_name_sorted = NULL;
+  cur_board->robot_name_table = NULL;
+  cur_board->label_index = NULL;
+  cur_board->robot_name_list_dirty = false;
+  cur_board->is_lazy = false;
+  cur_board->extram_data = NULL;
   cur_board->sensor_list = NULL;
   cur_board->scroll_list = NULL;
 
@@ -44,6 +44,14 @@ struct robot *legacy_load_robot_allocate(struct world *mzx_world, FILE *fp,
   cur_robot->program_bytecode = NULL;
   cur_robot->program_source = NULL;
   cur_robot->num_labels = 0;
+#ifndef CONFIG_DEBYTECODE
+  cur_robot->label_board = NULL;
+#endif
+#ifdef CONFIG_PREDECODE
+  cur_robot->instructions = NULL;
+  cur_robot->instruction_index = NULL;
+  cur_robot->num_instructions = 0;
+#endif
 
   if(!legacy_load_robot(mzx_world, cur_robot, fp, savegame, file_version))
     *truncated = true;
@@ -80,6 +88,7 @@ void legacy_load_robot_from_memory(struct world *mzx_world,
   cur_robot->commands_total = 0;
   cur_robot->commands_cycle = 0;
   cur_robot->commands_caught = 0;
+  cur_robot->profile_id = 0;
 #endif
 
   mfread(cur_robot->robot_name, LEGACY_ROBOT_NAME_SIZE, 1, mf);
@@ -19,14 +19,19 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <assert.h>
+#include <sys/stat.h>
 
 #include "mzm.h"
 
+#include "configure.h"
 #include "data.h"
 #include "error.h"
+#include "hashtable.h"
 #include "idput.h"
 #include "legacy_robot.h"
 #include "legacy_world.h"
@@ -37,6 +42,7 @@
 #include "world_format.h"
 #include "world_struct.h"
 #include "io/memfile.h"
+#include "io/vfile.h"
 #include "io/zip.h"
 
 
@@ -51,6 +57,283 @@ enum mzm_storage_mode
   MZM_STORAGE_MODE_LAYER = 1,
 };
 
+struct mzm_header
+{
+  int width;
+  int height;
+  enum mzm_storage_mode storage_mode;
+  int savegame_mode;
+  int num_robots;
+  int robots_location;
+  int mzm_world_version;
+  int data_start;
+};
+
+/**
+ * MZM cache. PUT "@file.mzm" usually stamps the same few files over and over,
+ * so valid MZM files are kept in memory (most recently used first) along with
+ * their parsed headers, keyed by their path and validated against their
+ * device, inode, size and modification time before each use. Overlay and
+ * vlayer loads also keep the chars and colors of the MZM decoded so they can
+ * be copied a row at a time. The least recently used files are freed when the
+ * cache goes over mzm_cache_size.
+ */
+
+// Files modified this recently aren't cached, since another change within the
+// same mtime tick wouldn't be noticed.
+#define MZM_CACHE_MTIME_SLACK 2
+
+struct mzm_cache_entry
+{
+  uint32_t hash;
+  uint32_t name_length;
+  struct mzm_cache_entry *prev;
+  struct mzm_cache_entry *next;
+  struct mzm_header header;
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  size_t file_length;
+  size_t mem_size;
+  unsigned char *buffer;
+  char *layer;
+  char name[1];
+};
+
+struct mzm_cache_stats
+{
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+  size_t mem_peak;
+};
+
+HASH_SET_INIT(MZM_CACHE, struct mzm_cache_entry *, name, name_length)
+
+static hash_t(MZM_CACHE) *mzm_cache_table;
+static struct mzm_cache_entry *mzm_cache_first;
+static struct mzm_cache_entry *mzm_cache_last;
+static size_t mzm_cache_mem;
+static struct mzm_cache_stats mzm_cache_stats;
+
+static size_t mzm_cache_budget(void)
+{
+  return (size_t)get_config()->mzm_cache_size * 1024;
+}
+
+static void mzm_cache_unlink(struct mzm_cache_entry *entry)
+{
+  if(entry->prev)
+    entry->prev->next = entry->next;
+  else
+    mzm_cache_first = entry->next;
+
+  if(entry->next)
+    entry->next->prev = entry->prev;
+  else
+    mzm_cache_last = entry->prev;
+
+  entry->prev = NULL;
+  entry->next = NULL;
+}
+
+static void mzm_cache_link_first(struct mzm_cache_entry *entry)
+{
+  entry->prev = NULL;
+  entry->next = mzm_cache_first;
+
+  if(mzm_cache_first)
+    mzm_cache_first->prev = entry;
+  else
+    mzm_cache_last = entry;
+
+  mzm_cache_first = entry;
+}
+
+static void mzm_cache_remove(struct mzm_cache_entry *entry)
+{
+  HASH_DELETE(MZM_CACHE, mzm_cache_table, entry);
+  mzm_cache_unlink(entry);
+  mzm_cache_mem -= entry->mem_size;
+
+  free(entry->buffer);
+  free(entry->layer);
+  free(entry);
+}
+
+/**
+ * Free the least recently used entries until the cache fits in its budget.
+ * The entry being used (if any) is kept regardless.
+ */
+static void mzm_cache_evict(struct mzm_cache_entry *keep)
+{
+  size_t budget = mzm_cache_budget();
+  struct mzm_cache_entry *entry = mzm_cache_last;
+  struct mzm_cache_entry *prev;
+
+  while(entry && mzm_cache_mem > budget)
+  {
+    prev = entry->prev;
+    if(entry != keep)
+    {
+      mzm_cache_remove(entry);
+      mzm_cache_stats.evictions++;
+    }
+    entry = prev;
+  }
+}
+
+/**
+ * Find the cache entry for a file. Entries for files that have changed since
+ * they were cached are freed.
+ */
+static struct mzm_cache_entry *mzm_cache_find(const char *name,
+ const struct stat *stat_info)
+{
+  struct mzm_cache_entry *entry;
+  size_t name_length = strlen(name);
+
+  HASH_FIND(MZM_CACHE, mzm_cache_table, name, name_length, entry);
+  if(!entry)
+    return NULL;
+
+  // The table ignores case, but files that only differ by case may not.
+  // The name is relative to the current directory, so also make sure it's
+  // still the same file.
+  if(strcmp(entry->name, name) || entry->dev != stat_info->st_dev ||
+   entry->ino != stat_info->st_ino || entry->mtime != stat_info->st_mtime ||
+   entry->file_length != (size_t)stat_info->st_size)
+  {
+    mzm_cache_remove(entry);
+    return NULL;
+  }
+
+  mzm_cache_unlink(entry);
+  mzm_cache_link_first(entry);
+  return entry;
+}
+
+/**
+ * Add a validated MZM to the cache. On success, the cache takes ownership of
+ * the buffer. Returns NULL if the MZM can't be cached.
+ */
+static struct mzm_cache_entry *mzm_cache_add(const char *name,
+ const struct stat *stat_info, unsigned char *buffer, size_t file_length,
+ const struct mzm_header *header)
+{
+  struct mzm_cache_entry *entry;
+  size_t name_length = strlen(name);
+  size_t mem_size = sizeof(struct mzm_cache_entry) + name_length + file_length;
+
+  if(mem_size > mzm_cache_budget() ||
+   time(NULL) - stat_info->st_mtime < MZM_CACHE_MTIME_SLACK)
+    return NULL;
+
+  entry = cmalloc(sizeof(struct mzm_cache_entry) + name_length);
+  memcpy(entry->name, name, name_length + 1);
+  entry->name_length = name_length;
+  entry->header = *header;
+  entry->dev = stat_info->st_dev;
+  entry->ino = stat_info->st_ino;
+  entry->mtime = stat_info->st_mtime;
+  entry->file_length = file_length;
+  entry->mem_size = mem_size;
+  entry->buffer = buffer;
+  entry->layer = NULL;
+
+  HASH_ADD(MZM_CACHE, mzm_cache_table, entry);
+  mzm_cache_link_first(entry);
+  mzm_cache_mem += mem_size;
+
+  mzm_cache_evict(entry);
+  mzm_cache_stats.mem_peak = MAX(mzm_cache_stats.mem_peak, mzm_cache_mem);
+  return entry;
+}
+
+/**
+ * Get the chars and colors of a cached MZM, decoding them first if needed.
+ * Returns NULL if they don't fit in the cache.
+ */
+static const char *mzm_cache_get_layer(struct mzm_cache_entry *entry)
+{
+  const struct mzm_header *header = &(entry->header);
+  size_t layer_size = (size_t)header->width * header->height;
+  size_t tile_size = header->storage_mode ? 2 : 6;
+  const unsigned char *src = entry->buffer + header->data_start;
+  char *chars;
+  char *colors;
+  size_t i;
+
+  if(entry->layer)
+    return entry->layer;
+
+  if(layer_size * tile_size > entry->file_length - header->data_start ||
+   entry->mem_size + layer_size * 2 > mzm_cache_budget())
+    return NULL;
+
+  entry->layer = cmalloc(layer_size * 2);
+  chars = entry->layer;
+  colors = entry->layer + layer_size;
+
+  if(header->storage_mode == MZM_STORAGE_MODE_BOARD)
+  {
+    // Use param as char, like loading the MZM directly would.
+    for(i = 0; i < layer_size; i++, src += tile_size)
+    {
+      chars[i] = src[1];
+      colors[i] = src[2];
+    }
+  }
+  else
+  {
+    for(i = 0; i < layer_size; i++, src += tile_size)
+    {
+      chars[i] = src[0];
+      colors[i] = src[1];
+    }
+  }
+
+  entry->mem_size += layer_size * 2;
+  mzm_cache_mem += layer_size * 2;
+
+  mzm_cache_evict(entry);
+  mzm_cache_stats.mem_peak = MAX(mzm_cache_stats.mem_peak, mzm_cache_mem);
+  return entry->layer;
+}
+
+/**
+ * Free a cached MZM, if any. This should be used when MZX writes an MZM.
+ */
+static void mzm_cache_invalidate(const char *name)
+{
+  struct mzm_cache_entry *entry;
+
+  HASH_FIND(MZM_CACHE, mzm_cache_table, name, strlen(name), entry);
+  if(entry)
+    mzm_cache_remove(entry);
+}
+
+void mzm_cache_clear(void)
+{
+  while(mzm_cache_first)
+    mzm_cache_remove(mzm_cache_first);
+
+  HASH_CLEAR(MZM_CACHE, mzm_cache_table);
+}
+
+void mzm_cache_print_stats(void)
+{
+  uint32_t total = mzm_cache_stats.hits + mzm_cache_stats.misses;
+
+  if(!total)
+    return;
+
+  info("MZM cache: %" PRIu32 " hits, %" PRIu32 " misses (%.1f%% hits), %"
+   PRIu32 " evictions, %zu bytes at most.\n", mzm_cache_stats.hits,
+   mzm_cache_stats.misses, mzm_cache_stats.hits * 100.0 / total,
+   mzm_cache_stats.evictions, mzm_cache_stats.mem_peak);
+}
+
 // This is assumed to not go over the edges.
 
 /**
@@ -78,6 +361,8 @@ static size_t save_mzm_calculate_size(struct world *mzx_world, int start_x,
     int num_robots_alloc = 0;
     int i;
 
+    update_robot_name_list(src_board);
+
     for(i = 0; i < num_robots_active; i++)
     {
       struct robot *cur_robot = robot_list[i];
@@ -329,6 +614,7 @@ void save_mzm(struct world *mzx_world, char *name, int start_x, int start_y,
     fwrite(buffer, mzm_size, 1, output_file);
     free(buffer);
     fclose(output_file);
+    mzm_cache_invalidate(name);
   }
 }
 
@@ -419,39 +705,53 @@ static boolean load_mzm_header(struct memfile *mf, size_t file_length,
   return true;
 }
 
-// This will clip.
-
-static int load_mzm_common(struct world *mzx_world, struct memfile *mf,
- int file_length, int start_x, int start_y, int mode, int savegame, char *name)
+/**
+ * Read and validate the header of an MZM. If this succeeds, the memfile will
+ * be positioned at the start of the MZM data.
+ */
+static boolean load_mzm_validate(struct memfile *mf, int file_length,
+ struct mzm_header *header)
 {
-  enum mzm_storage_mode storage_mode;
-  int width;
-  int height;
-  int savegame_mode;
-  int num_robots;
-  int robots_location;
-  int mzm_world_version;
-
-  int data_start;
   int expected_data_size;
 
-  if(!load_mzm_header(mf, file_length, &width, &height, &storage_mode,
-   &savegame_mode, &num_robots, &robots_location, &mzm_world_version))
-    goto err_invalid;
+  if(!load_mzm_header(mf, file_length, &header->width, &header->height,
+   &header->storage_mode, &header->savegame_mode, &header->num_robots,
+   &header->robots_location, &header->mzm_world_version))
+    return false;
 
-  data_start = mftell(mf);
-  expected_data_size = (width * height) * (storage_mode ? 2 : 6);
+  header->data_start = mftell(mf);
+  expected_data_size = (header->width * header->height) *
+   (header->storage_mode ? 2 : 6);
 
   // Validate
   if(
-   (savegame_mode > 1) || (savegame_mode < 0) // Invalid save mode
-   || (storage_mode != MZM_STORAGE_MODE_BOARD
-     && storage_mode != MZM_STORAGE_MODE_LAYER) // Invalid storage mode
-   || (file_length - data_start < expected_data_size) // not enough space
-   || (file_length < robots_location) // The end of file is before the robots
-   || (robots_location && (expected_data_size + data_start > robots_location))
+   (header->savegame_mode > 1) || (header->savegame_mode < 0) // Invalid save mode
+   || (header->storage_mode != MZM_STORAGE_MODE_BOARD
+     && header->storage_mode != MZM_STORAGE_MODE_LAYER) // Invalid storage mode
+   || (file_length - header->data_start < expected_data_size) // not enough space
+   || (file_length < header->robots_location) // The end of file is before the robots
+   || (header->robots_location &&
+     (expected_data_size + header->data_start > header->robots_location))
     )
-    goto err_invalid;
+    return false;
+
+  return true;
+}
+
+// This will clip. If layer isn't NULL, overlay and vlayer loads copy its
+// chars and colors (width * height each) instead of reading the MZM data.
+
+static int load_mzm_data(struct world *mzx_world, struct memfile *mf,
+ int file_length, const struct mzm_header *header, const char *layer,
+ int start_x, int start_y, int mode, int savegame, char *name)
+{
+  enum mzm_storage_mode storage_mode = header->storage_mode;
+  int width = header->width;
+  int height = header->height;
+  int savegame_mode = header->savegame_mode;
+  int num_robots = header->num_robots;
+  int robots_location = header->robots_location;
+  int mzm_world_version = header->mzm_world_version;
 
   // If the mzm version is newer than the MZX version, notify
   if(mzm_world_version > MZX_VERSION)
@@ -902,6 +1202,24 @@ static int load_mzm_common(struct world *mzx_world, struct memfile *mf,
 
       line_skip = dest_width - effective_width;
 
+      if(layer)
+      {
+        // Already decoded by the MZM cache; copy it a row at a time.
+        const char *layer_colors = layer + (width * height);
+
+        if(effective_width > 0)
+        {
+          for(y = 0; y < effective_height; y++)
+          {
+            memcpy(dest_chars + offset, layer + (y * width), effective_width);
+            memcpy(dest_colors + offset, layer_colors + (y * width),
+             effective_width);
+            offset += dest_width;
+          }
+        }
+        break;
+      }
+
       switch(storage_mode)
       {
         case MZM_STORAGE_MODE_BOARD:
@@ -962,24 +1280,57 @@ err_robots:
   // The main file loaded fine, but there was a problem handling robots
   error_message(E_MZM_ROBOT_CORRUPT, 0, name);
   return 0;
+}
+
+static int load_mzm_common(struct world *mzx_world, struct memfile *mf,
+ int file_length, int start_x, int start_y, int mode, int savegame, char *name)
+{
+  struct mzm_header header;
 
-err_invalid:
-  error_message(E_MZM_FILE_INVALID, 0, name);
-  return -1;
+  if(!load_mzm_validate(mf, file_length, &header))
+  {
+    error_message(E_MZM_FILE_INVALID, 0, name);
+    return -1;
+  }
+
+  return load_mzm_data(mzx_world, mf, file_length, &header, NULL,
+   start_x, start_y, mode, savegame, name);
 }
 
 int load_mzm(struct world *mzx_world, char *name, int start_x, int start_y,
  int mode, int savegame)
 {
+  struct mzm_cache_entry *entry = NULL;
+  struct mzm_header header;
+  struct stat stat_info;
+  boolean cacheable = false;
+  const char *layer = NULL;
   FILE *input_file;
   size_t file_size;
-  void *buffer;
+  unsigned char *buffer;
   int success;
   int count;
   struct memfile mf;
-  input_file = fopen_unsafe(name, "rb");
-  if(input_file)
+
+  if(mzm_cache_budget() && !vstat(name, &stat_info))
+  {
+    cacheable = true;
+    entry = mzm_cache_find(name, &stat_info);
+  }
+
+  if(entry)
   {
+    mzm_cache_stats.hits++;
+  }
+  else
+  {
+    input_file = fopen_unsafe(name, "rb");
+    if(!input_file)
+    {
+      error_message(E_MZM_DOES_NOT_EXIST, 0, name);
+      return -1;
+    }
+
     fseek(input_file, 0, SEEK_END);
     file_size = ftell(input_file);
     buffer = cmalloc(file_size);
@@ -994,16 +1345,36 @@ int load_mzm(struct world *mzx_world, char *name, int start_x, int start_y,
     }
 
     mfopen(buffer, file_size, &mf);
-    success = load_mzm_common(mzx_world, &mf, (int)file_size, start_x,
-     start_y, mode, savegame, name);
-    free(buffer);
-    return success;
-  }
-  else
-  {
-    error_message(E_MZM_DOES_NOT_EXIST, 0, name);
-    return -1;
+    if(!load_mzm_validate(&mf, (int)file_size, &header))
+    {
+      error_message(E_MZM_FILE_INVALID, 0, name);
+      free(buffer);
+      return -1;
+    }
+
+    if(cacheable)
+    {
+      mzm_cache_stats.misses++;
+      entry = mzm_cache_add(name, &stat_info, buffer, file_size, &header);
+    }
+
+    if(!entry)
+    {
+      success = load_mzm_data(mzx_world, &mf, (int)file_size, &header, NULL,
+       start_x, start_y, mode, savegame, name);
+      free(buffer);
+      return success;
+    }
   }
+
+  if(mode != MZM_LOAD_TO_BOARD)
+    layer = mzm_cache_get_layer(entry);
+
+  mfopen(entry->buffer, entry->file_length, &mf);
+  mfseek(&mf, entry->header.data_start, SEEK_SET);
+
+  return load_mzm_data(mzx_world, &mf, (int)entry->file_length,
+   &(entry->header), layer, start_x, start_y, mode, savegame, name);
 }
 
 int load_mzm_memory(struct world *mzx_world, char *name, int start_x,
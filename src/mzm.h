@@ -50,6 +50,8 @@ CORE_LIBSPEC int load_mzm(struct world *mzx_world, char *name,
 CORE_LIBSPEC int load_mzm_memory(struct world *mzx_world, char *name, int start_x,
  int start_y, int mode, int savegame, const void *buffer, size_t length);
 CORE_LIBSPEC void load_mzm_size(char *name, int *width, int *height);
+CORE_LIBSPEC void mzm_cache_clear(void);
+CORE_LIBSPEC void mzm_cache_print_stats(void);
 
 __M_END_DECLS
 
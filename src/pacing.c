@@ -0,0 +1,315 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Frame pacing for the main loop. Frames are timed with get_time_ns instead
+ * of get_ticks, and each paced frame ends a fixed period after the previous
+ * frame was supposed to end, so a frame that ran long is made up for by
+ * shortening the next ones. If that isn't enough, the game catches up with a
+ * fixed timestep: when max_frame_updates is set, a frame that starts one or
+ * more periods late runs that many extra world updates (up to the cap) before
+ * it's drawn. If frame_skip is set, frames that are already late can also
+ * skip updating the screen until the game catches up.
+ *
+ * The time spent in each part of every frame is sorted into histograms,
+ * which can be printed on exit with frame_histogram.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "configure.h"
+#include "graphics.h"
+#include "pacing.h"
+#include "platform.h"
+#include "util.h"
+
+// The first bucket is for times under 0.25ms; each bucket after it is twice
+// as long as the previous one, and the last is for everything else (64ms+).
+#define PACING_BUCKETS 10
+#define PACING_BUCKET_MIN_NS 250000
+
+// How long before a deadline to stop sleeping with delay() and yield until
+// it passes instead. This adjusts to how late delay() tends to wake up.
+#define PACING_SLACK_DEFAULT_NS 2000000
+#define PACING_SLACK_MIN_NS 500000
+#define PACING_SLACK_MAX_NS 4000000
+
+// Weight of each new frame in the averages shown in the FPS display.
+#define PACING_AVERAGE_FRAMES 16
+
+struct pacing_histogram
+{
+  Uint32 buckets[PACING_BUCKETS];
+  Uint32 count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  double average_ms;
+};
+
+struct pacing_data
+{
+  int frame_skip;
+  int max_updates;
+  boolean print_histogram;
+
+  enum pacing_phase phase;
+  uint64_t phase_start;
+  uint64_t phase_ns[NUM_PACING_PHASES];
+  uint64_t frame_start;
+
+  uint64_t period;
+  uint64_t deadline;
+  uint64_t slack;
+  boolean paced;
+  boolean presented;
+  int skipped;
+
+  struct pacing_histogram phases[NUM_PACING_PHASES];
+  struct pacing_histogram frames;
+};
+
+static struct pacing_data pacing;
+
+static const char * const phase_names[NUM_PACING_PHASES] =
+{
+  "idle",
+  "update",
+  "draw",
+  "present",
+};
+
+void pacing_init(struct config_info *conf)
+{
+  memset(&pacing, 0, sizeof(struct pacing_data));
+  pacing.frame_skip = conf->frame_skip;
+  pacing.max_updates = MAX(1, conf->max_frame_updates);
+  pacing.print_histogram = conf->frame_histogram;
+  pacing.slack = PACING_SLACK_DEFAULT_NS;
+  pacing.phase = PACING_IDLE;
+  pacing.phase_start = get_time_ns();
+}
+
+enum pacing_phase pacing_set_phase(enum pacing_phase phase)
+{
+  enum pacing_phase prev = pacing.phase;
+  uint64_t now = get_time_ns();
+
+  pacing.phase_ns[prev] += now - pacing.phase_start;
+  pacing.phase_start = now;
+  pacing.phase = phase;
+
+  if(phase == PACING_PRESENT)
+    pacing.presented = true;
+
+  return prev;
+}
+
+static void pacing_record(struct pacing_histogram *hist, uint64_t ns)
+{
+  uint64_t limit = PACING_BUCKET_MIN_NS;
+  int bucket = 0;
+
+  while(bucket < PACING_BUCKETS - 1 && ns >= limit)
+  {
+    limit <<= 1;
+    bucket++;
+  }
+
+  hist->buckets[bucket]++;
+  hist->count++;
+  hist->total_ns += ns;
+  hist->max_ns = MAX(hist->max_ns, ns);
+
+  hist->average_ms += (ns / 1000000.0 - hist->average_ms) /
+   PACING_AVERAGE_FRAMES;
+}
+
+void pacing_end_frame(void)
+{
+  uint64_t now;
+  int i;
+
+  pacing_set_phase(pacing.phase);
+  now = pacing.phase_start;
+
+  if(pacing.frame_start)
+  {
+    for(i = 0; i < NUM_PACING_PHASES; i++)
+      pacing_record(&(pacing.phases[i]), pacing.phase_ns[i]);
+
+    pacing_record(&(pacing.frames), now - pacing.frame_start);
+  }
+
+  memset(pacing.phase_ns, 0, sizeof(pacing.phase_ns));
+  pacing.frame_start = now;
+
+  // A frame that wasn't paced (e.g. a UI frame) breaks the chain of
+  // deadlines, so the next paced frame starts counting from scratch.
+  if(!pacing.paced)
+    pacing.deadline = 0;
+
+  pacing.paced = false;
+  pacing.presented = false;
+}
+
+/**
+ * Sleep until the given time. delay() only has millisecond precision and
+ * often wakes up late, so stop using it a little early and yield the rest of
+ * the way. When vsync is on and this frame was presented, presenting the next
+ * one will wait for the display anyway, so don't bother getting any closer
+ * than delay() can. A frame that skipped its present has nothing to wait on,
+ * so it always sleeps all the way to the deadline.
+ */
+static void pacing_sleep_until(uint64_t deadline)
+{
+  boolean vsync = is_vsync_enabled() && pacing.presented;
+  uint64_t now;
+  uint64_t late;
+  Uint32 ms;
+
+  while((now = get_time_ns()) < deadline)
+  {
+    ms = 0;
+    if(deadline - now > pacing.slack)
+      ms = (deadline - now - pacing.slack) / 1000000;
+
+    if(ms)
+    {
+      delay(ms);
+
+      late = get_time_ns() - now;
+      late = late > ms * 1000000ULL ? late - ms * 1000000ULL : 0;
+
+      pacing.slack -= pacing.slack / 8;
+      pacing.slack = MAX(pacing.slack, late + PACING_SLACK_MIN_NS);
+      pacing.slack = MIN(pacing.slack, PACING_SLACK_MAX_NS);
+      continue;
+    }
+
+    if(vsync)
+      break;
+
+    delay(0);
+  }
+}
+
+void pacing_wait(uint64_t period_ns)
+{
+  uint64_t now = get_time_ns();
+
+  if(!pacing.deadline || pacing.period != period_ns)
+  {
+    pacing.deadline = pacing.frame_start + period_ns;
+  }
+  else
+  {
+    pacing.deadline += period_ns;
+
+    // Only try to catch up on a limited number of frames; past that, the lost
+    // time is gone and it's better to start over from here.
+    if(now > pacing.deadline +
+     period_ns * (pacing.frame_skip + pacing.max_updates))
+      pacing.deadline = now;
+  }
+
+  pacing.period = period_ns;
+  pacing.paced = true;
+
+  pacing_sleep_until(pacing.deadline);
+}
+
+int pacing_get_updates(void)
+{
+  uint64_t now;
+  uint64_t behind;
+  int updates = 1;
+
+  // The current frame should have started when the last paced frame ended.
+  // Each whole period since then is an update that's owed; run as many of
+  // them as allowed now, and count them as if they'd happened on time.
+  if(pacing.max_updates > 1 && pacing.deadline)
+  {
+    now = get_time_ns();
+    if(now >= pacing.deadline + pacing.period)
+    {
+      behind = (now - pacing.deadline) / pacing.period;
+      updates += MIN(behind, (uint64_t)(pacing.max_updates - 1));
+      pacing.deadline += (updates - 1) * pacing.period;
+    }
+  }
+  return updates;
+}
+
+boolean pacing_should_present(void)
+{
+  // The current frame should end one period after the last paced frame.
+  if(pacing.frame_skip && pacing.deadline &&
+   get_time_ns() > pacing.deadline + pacing.period &&
+   pacing.skipped < pacing.frame_skip)
+  {
+    pacing.skipped++;
+    return false;
+  }
+
+  pacing.skipped = 0;
+  return true;
+}
+
+double pacing_get_average_ms(enum pacing_phase phase)
+{
+  return pacing.phases[phase].average_ms;
+}
+
+static void pacing_print_line(const char *name, struct pacing_histogram *hist)
+{
+  char buffer[128];
+  size_t len = 0;
+  int i;
+
+  len += snprintf(buffer, sizeof(buffer), "%-8s", name);
+
+  for(i = 0; i < PACING_BUCKETS; i++)
+    len += snprintf(buffer + len, sizeof(buffer) - len, "%7" PRIu32,
+     hist->buckets[i]);
+
+  info("%s %8.3f %8.3f\n", buffer,
+   hist->count ? hist->total_ns / 1000000.0 / hist->count : 0.0,
+   hist->max_ns / 1000000.0);
+}
+
+void pacing_print_histogram(void)
+{
+  int i;
+
+  if(!pacing.print_histogram || !pacing.frames.count)
+    return;
+
+  info("Frame times (ms) for %" PRIu32 " frames:\n", pacing.frames.count);
+  info("%-8s%7s%7s%7s%7s%7s%7s%7s%7s%7s%7s %8s %8s\n", "",
+   "<0.25", "<0.5", "<1", "<2", "<4", "<8", "<16", "<32", "<64", "64+",
+   "avg", "max");
+
+  for(i = PACING_UPDATE; i < NUM_PACING_PHASES; i++)
+    pacing_print_line(phase_names[i], &(pacing.phases[i]));
+
+  pacing_print_line(phase_names[PACING_IDLE], &(pacing.phases[PACING_IDLE]));
+  pacing_print_line("frame", &(pacing.frames));
+}
@@ -0,0 +1,118 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __PACING_H
+#define __PACING_H
+
+#include "compat.h"
+
+__M_BEGIN_DECLS
+
+#include <inttypes.h>
+
+#include "configure.h"
+
+/**
+ * What the main loop is currently spending its time on. PACING_IDLE covers
+ * delays and event handling.
+ */
+enum pacing_phase
+{
+  PACING_IDLE,
+  PACING_UPDATE,
+  PACING_DRAW,
+  PACING_PRESENT,
+  NUM_PACING_PHASES
+};
+
+/**
+ * Reset the pacer and set it up from the config.
+ *
+ * @param conf        The current config.
+ */
+
+CORE_LIBSPEC void pacing_init(struct config_info *conf);
+
+/**
+ * Switch the phase the current time is counted towards. This can be used to
+ * time part of another phase, e.g. the world update inside of a draw.
+ *
+ * @param phase       The phase to switch to.
+ * @return            The phase that was active before, to switch back to.
+ */
+
+CORE_LIBSPEC enum pacing_phase pacing_set_phase(enum pacing_phase phase);
+
+/**
+ * Mark the end of a frame: record the time spent in each phase since the last
+ * call to the histograms. Call this right before starting the next update.
+ */
+
+CORE_LIBSPEC void pacing_end_frame(void);
+
+/**
+ * Wait until the frame that was started at the last pacing_end_frame should
+ * end, given the length of a frame. If the previous frame was paced with the
+ * same length, this is relative to when that frame should have ended rather
+ * than when it actually did, so short delays are made up on later frames.
+ * If vsync is on and the frame was presented, this may return slightly early,
+ * since the next present waits for the display.
+ *
+ * @param period_ns   Length of a frame in nanoseconds.
+ */
+
+CORE_LIBSPEC void pacing_wait(uint64_t period_ns);
+
+/**
+ * Get the number of world updates the current frame should run. This is
+ * more than one only when max_frame_updates is set and the frame started one
+ * or more periods late; the extra updates are counted as on time.
+ *
+ * @return            The number of updates to run, from 1 to max_frame_updates.
+ */
+
+CORE_LIBSPEC int pacing_get_updates(void);
+
+/**
+ * Check if the current frame should be presented. This only returns false
+ * when frame_skip is enabled and the current frame is already late.
+ *
+ * @return            True if the screen should be updated for this frame.
+ */
+
+CORE_LIBSPEC boolean pacing_should_present(void);
+
+/**
+ * Get the average number of milliseconds recently spent in a phase per frame.
+ *
+ * @param phase       The phase to get the average time of.
+ * @return            The average time in milliseconds.
+ */
+
+CORE_LIBSPEC double pacing_get_average_ms(enum pacing_phase phase);
+
+/**
+ * Print the frame time histograms, if frame_histogram is enabled.
+ */
+
+CORE_LIBSPEC void pacing_print_histogram(void);
+
+__M_END_DECLS
+
+#endif // __PACING_H
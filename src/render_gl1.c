@@ -255,6 +255,8 @@ static void gl1_free_video(struct graphics_data *graphics)
 {
   struct gl1_render_data *render_data = graphics->render_data;
 
+  render_layers_free();
+
   if(render_data)
   {
     gl1.glDeleteTextures(1, &render_data->texture_number);
@@ -266,11 +268,11 @@ static void gl1_free_video(struct graphics_data *graphics)
   }
 }
 
-static void gl1_update_colors(struct graphics_data *graphics,
- struct rgb_color *palette, Uint32 count)
+static void gl1_update_colors_range(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 first, Uint32 count)
 {
   Uint32 i;
-  for(i = 0; i < count; i++)
+  for(i = first; i < first + count; i++)
   {
 #if PLATFORM_BYTE_ORDER == PLATFORM_BIG_ENDIAN
     graphics->flat_intensity_palette[i] = (palette[i].r << 24) |
@@ -307,6 +309,15 @@ static void gl1_render_layer(struct graphics_data *graphics,
   render_layer(render_data->pixels, 32, render_data->w * 4, graphics, layer);
 }
 
+static void gl1_render_layers(struct graphics_data *graphics,
+ struct video_layer **layers, Uint32 count)
+{
+  struct gl1_render_data *render_data = graphics->render_data;
+
+  render_layers(render_data->pixels, 32, render_data->w * 4, graphics,
+   layers, count);
+}
+
 static void gl1_render_cursor(struct graphics_data *graphics,
  Uint32 x, Uint32 y, Uint16 color, Uint8 lines, Uint8 offset)
 {
@@ -365,12 +376,13 @@ void render_gl1_register(struct renderer *renderer)
   renderer->free_video = gl1_free_video;
   renderer->check_video_mode = gl_check_video_mode;
   renderer->set_video_mode = gl1_set_video_mode;
-  renderer->update_colors = gl1_update_colors;
+  renderer->update_colors_range = gl1_update_colors_range;
   renderer->resize_screen = gl1_resize_screen;
   renderer->get_screen_coords = get_screen_coords_scaled;
   renderer->set_screen_coords = set_screen_coords_scaled;
   renderer->render_graph = gl1_render_graph;
   renderer->render_layer = gl1_render_layer;
+  renderer->render_layers = gl1_render_layers;
   renderer->render_cursor = gl1_render_cursor;
   renderer->render_mouse = gl1_render_mouse;
   renderer->sync_screen = gl1_sync_screen;
@@ -398,12 +398,12 @@ static boolean gl2_set_video_mode(struct graphics_data *graphics,
   return true;
 }
 
-static void gl2_update_colors(struct graphics_data *graphics,
- struct rgb_color *palette, Uint32 count)
+static void gl2_update_colors_range(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 first, Uint32 count)
 {
   struct gl2_render_data *render_data = graphics->render_data;
   Uint32 i;
-  for(i = 0; i < count; i++)
+  for(i = first; i < first + count; i++)
   {
     graphics->flat_intensity_palette[i] = gl_pack_u32((0xFF << 24) |
      (palette[i].b << 16) | (palette[i].g << 8) | palette[i].r);
@@ -1020,7 +1020,7 @@ void render_gl2_register(struct renderer *renderer)
   renderer->free_video = gl2_free_video;
   renderer->check_video_mode = gl_check_video_mode;
   renderer->set_video_mode = gl2_set_video_mode;
-  renderer->update_colors = gl2_update_colors;
+  renderer->update_colors_range = gl2_update_colors_range;
   renderer->resize_screen = resize_screen_standard;
   renderer->remap_char_range = gl2_remap_char_range;
   renderer->remap_char = gl2_remap_char;
@@ -90,9 +90,11 @@ static const struct gl_version gl_required_version = { 2, 0 };
 #define TEX_DATA_IDX_X 0
 #define TEX_DATA_IDX_Y 897
 
-// Layer: 81 x 26 (max)
+// Layers: TEX_DATA_WIDTH x 123
+// Every layer drawn in a batch is packed into this area at once.
 #define TEX_DATA_LAYER_X 0
 #define TEX_DATA_LAYER_Y 901
+#define TEX_DATA_LAYER_H (TEX_DATA_HEIGHT - TEX_DATA_LAYER_Y)
 
 // NOTE: Layer data packing scheme
 // (highest two bits currently unused but included as part of the char)
@@ -121,6 +123,17 @@ enum
   ATTRIB_POSITION,
   ATTRIB_TEXCOORD,
   ATTRIB_COLOR,
+  ATTRIB_LAYER,
+};
+
+// Two triangles per layer, so layers can be drawn together.
+#define LAYER_VERTICES 6
+
+struct glsl_layer_vertex
+{
+  float position[2];
+  float texcoord[2];
+  float layer[3]; // Layer data X, layer data Y, transparent color.
 };
 
 /**
@@ -290,6 +303,8 @@ struct glsl_render_data
   Uint32 *pixels;
   Uint32 charset_texture[CHAR_H * FULL_CHARSET_SIZE * CHAR_W];
   Uint32 background_texture[BG_WIDTH * BG_HEIGHT];
+  Uint32 layer_texture[TEX_DATA_WIDTH * TEX_DATA_LAYER_H];
+  struct glsl_layer_vertex layer_vertices[TEXTVIDEO_LAYERS * LAYER_VERTICES];
   GLuint textures[NUM_TEXTURES];
   GLuint fbos[NUM_FBOS];
   GLubyte palette[3 * FULL_PAL_SIZE];
@@ -297,7 +312,6 @@ struct glsl_render_data
   Uint8 remap_char[FULL_CHARSET_SIZE];
   boolean dirty_palette;
   boolean dirty_indices;
-  int last_tcol;
   GLuint scaler_program;
   GLuint tilemap_program;
   GLuint tilemap_smzx_program;
@@ -585,6 +599,8 @@ static void glsl_load_shaders(struct graphics_data *graphics)
      ATTRIB_POSITION, "Position");
     glsl.glBindAttribLocation(render_data->tilemap_program,
      ATTRIB_TEXCOORD, "Texcoord");
+    glsl.glBindAttribLocation(render_data->tilemap_program,
+     ATTRIB_LAYER, "Layer");
     glsl.glLinkProgram(render_data->tilemap_program);
     glsl_verify_link(render_data, render_data->tilemap_program);
     glsl_delete_shaders(render_data->tilemap_program);
@@ -598,6 +614,8 @@ static void glsl_load_shaders(struct graphics_data *graphics)
      ATTRIB_POSITION, "Position");
     glsl.glBindAttribLocation(render_data->tilemap_smzx_program,
      ATTRIB_TEXCOORD, "Texcoord");
+    glsl.glBindAttribLocation(render_data->tilemap_smzx_program,
+     ATTRIB_LAYER, "Layer");
     glsl.glLinkProgram(render_data->tilemap_smzx_program);
     glsl_verify_link(render_data, render_data->tilemap_smzx_program);
     glsl_delete_shaders(render_data->tilemap_smzx_program);
@@ -985,12 +1003,12 @@ static inline void glsl_do_remap_char(struct graphics_data *graphics,
   gl_check_error();
 }
 
-static void glsl_update_colors(struct graphics_data *graphics,
- struct rgb_color *palette, Uint32 count)
+static void glsl_update_colors_range(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 first, Uint32 count)
 {
   struct glsl_render_data *render_data = graphics->render_data;
   Uint32 i;
-  for(i = 0; i < count; i++)
+  for(i = first; i < first + count; i++)
   {
     graphics->flat_intensity_palette[i] = gl_pack_u32((0xFF << 24) |
      (palette[i].b << 16) | (palette[i].g << 8) | palette[i].r);
@@ -1000,15 +1018,63 @@ static void glsl_update_colors(struct graphics_data *graphics,
   }
 }
 
-static void glsl_render_layer(struct graphics_data *graphics,
- struct video_layer *layer)
+/**
+ * Convert a layer's chars and colors to the packed format the tilemap shaders
+ * read (see LAYER_FG_POS etc.) and write them to dest.
+ */
+static void glsl_pack_layer(struct graphics_data *graphics,
+ struct video_layer *layer, Uint32 *dest, Uint32 stride)
 {
-  struct glsl_render_data *render_data = graphics->render_data;
   struct char_element *src = layer->data;
-  Uint32 *colorptr, *dest, i, j;
-  int width, height;
   Uint32 char_value, fg_color, bg_color;
+  Uint32 x, y;
+
+  for(y = 0; y < layer->h; y++, dest += stride - layer->w)
+  {
+    for(x = 0; x < layer->w; x++, dest++, src++)
+    {
+      char_value = src->char_value;
+      bg_color = src->bg_color;
+      fg_color = src->fg_color;
+
+      if(char_value != INVISIBLE_CHAR)
+      {
+        if(char_value < PROTECTED_CHARSET_POSITION)
+          char_value = (char_value + layer->offset) % PROTECTED_CHARSET_POSITION;
+
+        if(bg_color >= 16)
+          bg_color = (bg_color & 0xF) + graphics->protected_pal_position;
+
+        if(fg_color >= 16)
+          fg_color = (fg_color & 0xF) + graphics->protected_pal_position;
+      }
+      else
+      {
+        bg_color = FULL_PAL_SIZE;
+        fg_color = FULL_PAL_SIZE;
+      }
+
+      *dest = gl_pack_u32(
+       (char_value << LAYER_CHAR_POS) |
+       (bg_color << LAYER_BG_POS) |
+       (fg_color << LAYER_FG_POS));
+    }
+  }
+}
 
+/**
+ * Set up the two triangles that draw a layer. The texture coordinates are in
+ * chars relative to the layer; the layer attribute says where the layer's
+ * data was packed and which color is transparent.
+ */
+static void glsl_layer_vertices(struct glsl_layer_vertex *v,
+ struct video_layer *layer, int data_x, int data_y)
+{
+  static const int corners[LAYER_VERTICES][2] =
+  {
+    { 0, 0 }, { 0, 1 }, { 1, 0 },
+    { 1, 0 }, { 0, 1 }, { 1, 1 },
+  };
   int x1 = layer->x;
   int x2 = layer->x + layer->w * CHAR_W;
   int y1 = layer->y;
@@ -1018,22 +1084,90 @@ static void glsl_render_layer(struct graphics_data *graphics,
   float v_right =  1.0f * x2 / SCREEN_PIX_W_F * 2.0f - 1.0f;
   float v_top =    1.0f * y1 / SCREEN_PIX_H_F * 2.0f - 1.0f;
   float v_bottom = 1.0f * y2 / SCREEN_PIX_H_F * 2.0f - 1.0f;
+  int i;
 
-  float vertex_array_single[2 * 4] =
+  for(i = 0; i < LAYER_VERTICES; i++, v++)
   {
-    v_left, -v_top,
-    v_left, -v_bottom,
-    v_right, -v_top,
-    v_right, -v_bottom,
-  };
+    boolean right = corners[i][0];
+    boolean bottom = corners[i][1];
+
+    v->position[0] = right ? v_right : v_left;
+    v->position[1] = bottom ? -v_bottom : -v_top;
+    v->texcoord[0] = right ? layer->w : 0.0f;
+    v->texcoord[1] = bottom ? layer->h : 0.0f;
+    v->layer[0] = data_x;
+    v->layer[1] = data_y;
+    v->layer[2] = layer->transparent_col;
+  }
+}
+
+/**
+ * Pack as many of the given layers as will fit into the layer area of the
+ * data texture, starting with the first. Layers are placed left to right in
+ * rows as tall as the tallest layer in them. Returns the number of layers
+ * packed and the size of the area they used.
+ */
+static Uint32 glsl_pack_layers(struct graphics_data *graphics,
+ struct video_layer **layers, Uint32 count, int *_width, int *_height)
+{
+  struct glsl_render_data *render_data = graphics->render_data;
+  struct glsl_layer_vertex *v = render_data->layer_vertices;
+  int pos_x[TEXTVIDEO_LAYERS];
+  int pos_y[TEXTVIDEO_LAYERS];
+  int width = 0;
+  int x = 0;
+  int y = 0;
+  int row_height = 0;
+  Uint32 i;
 
-  float tex_coord_array_single[2 * 4] =
+  for(i = 0; i < count; i++)
   {
-    0.0f,     0.0f,
-    0.0f,     layer->h,
-    layer->w, 0.0f,
-    layer->w, layer->h,
-  };
+    int w = layers[i]->w;
+    int h = layers[i]->h;
+
+    if(x + w > TEX_DATA_WIDTH)
+    {
+      x = 0;
+      y += row_height;
+      row_height = 0;
+    }
+
+    // Out of room; the rest will be drawn in the next batch.
+    if(y + h > TEX_DATA_LAYER_H)
+      break;
+
+    pos_x[i] = x;
+    pos_y[i] = y;
+    x += w;
+    width = MAX(width, x);
+    row_height = MAX(row_height, h);
+
+    glsl_layer_vertices(v, layers[i], TEX_DATA_LAYER_X + pos_x[i],
+     TEX_DATA_LAYER_Y + pos_y[i]);
+    v += LAYER_VERTICES;
+  }
+  count = i;
+
+  // Now that the width is known, the data can be packed at that pitch.
+  for(i = 0; i < count; i++)
+  {
+    glsl_pack_layer(graphics, layers[i],
+     render_data->layer_texture + pos_y[i] * width + pos_x[i], width);
+  }
+
+  *_width = width;
+  *_height = y + row_height;
+  return count;
+}
+
+static void glsl_render_layers(struct graphics_data *graphics,
+ struct video_layer **layers, Uint32 count)
+{
+  struct glsl_render_data *render_data = graphics->render_data;
+  struct glsl_layer_vertex *vertices = render_data->layer_vertices;
+  boolean smzx = false;
+  Uint32 *colorptr, *dest, i, j;
+  int width, height;
 
   // Clamp draw area to size of screen texture.
   get_context_width_height(graphics, &width, &height);
@@ -1054,12 +1188,6 @@ static void glsl_render_layer(struct graphics_data *graphics,
   glsl.glViewport(0, 0, width, height);
   gl_check_error();
 
-  if(layer->mode == 0)
-    glsl.glUseProgram(render_data->tilemap_program);
-  else
-    glsl.glUseProgram(render_data->tilemap_smzx_program);
-  gl_check_error();
-
   glsl.glBindTexture(GL_TEXTURE_2D, render_data->textures[TEX_DATA_ID]);
   gl_check_error();
 
@@ -1081,52 +1209,10 @@ static void glsl_render_layer(struct graphics_data *graphics,
     }
   }
 
-  // Layer data
-  dest = render_data->background_texture;
-
-  for(i = 0; i < layer->w * layer->h; i++, dest++, src++)
-  {
-    char_value = src->char_value;
-    bg_color = src->bg_color;
-    fg_color = src->fg_color;
-
-    if(char_value != INVISIBLE_CHAR)
-    {
-      if(char_value < PROTECTED_CHARSET_POSITION)
-        char_value = (char_value + layer->offset) % PROTECTED_CHARSET_POSITION;
-
-      if(bg_color >= 16)
-        bg_color = (bg_color & 0xF) + graphics->protected_pal_position;
-
-      if(fg_color >= 16)
-        fg_color = (fg_color & 0xF) + graphics->protected_pal_position;
-    }
-    else
-    {
-      bg_color = FULL_PAL_SIZE;
-      fg_color = FULL_PAL_SIZE;
-    }
-
-    *dest = gl_pack_u32(
-     (char_value << LAYER_CHAR_POS) |
-     (bg_color << LAYER_BG_POS) |
-     (fg_color << LAYER_FG_POS));
-  }
-
-  glsl.glBindTexture(GL_TEXTURE_2D, render_data->textures[TEX_DATA_ID]);
-  gl_check_error();
-
-  glsl.glTexSubImage2D(GL_TEXTURE_2D, 0,
-   TEX_DATA_LAYER_X, TEX_DATA_LAYER_Y, layer->w, layer->h,
-   GL_RGBA, GL_UNSIGNED_BYTE, render_data->background_texture);
-  gl_check_error();
-
   // Palette
-  if(render_data->dirty_palette ||
-   render_data->last_tcol != layer->transparent_col)
+  if(render_data->dirty_palette)
   {
     render_data->dirty_palette = false;
-    render_data->last_tcol = layer->transparent_col;
 
     colorptr = graphics->flat_intensity_palette;
     dest = render_data->background_texture;
@@ -1134,8 +1220,6 @@ static void glsl_render_layer(struct graphics_data *graphics,
     for(i = 0; i < graphics->protected_pal_position + 16; i++, dest++, colorptr++)
       *dest = *colorptr;
 
-    if(layer->transparent_col != -1)
-      render_data->background_texture[layer->transparent_col] = 0x00000000;
     render_data->background_texture[FULL_PAL_SIZE] = 0x00000000;
 
     glsl.glTexSubImage2D(GL_TEXTURE_2D, 0,
@@ -1145,7 +1229,11 @@ static void glsl_render_layer(struct graphics_data *graphics,
   }
 
   // Indices
-  if(render_data->dirty_indices && layer->mode)
+  for(i = 0; i < count; i++)
+    if(layers[i]->mode)
+      smzx = true;
+
+  if(render_data->dirty_indices && smzx)
   {
     render_data->dirty_indices = false;
     dest = render_data->background_texture;
@@ -1161,26 +1249,76 @@ static void glsl_render_layer(struct graphics_data *graphics,
 
   glsl.glEnableVertexAttribArray(ATTRIB_POSITION);
   glsl.glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+  glsl.glEnableVertexAttribArray(ATTRIB_LAYER);
 
   glsl.glEnable(GL_BLEND);
   glsl.glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-  glsl.glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0,
-   vertex_array_single);
+  glsl.glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE,
+   sizeof(struct glsl_layer_vertex), vertices->position);
   gl_check_error();
 
-  glsl.glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 0,
-   tex_coord_array_single);
+  glsl.glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE,
+   sizeof(struct glsl_layer_vertex), vertices->texcoord);
   gl_check_error();
 
-  glsl.glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glsl.glVertexAttribPointer(ATTRIB_LAYER, 3, GL_FLOAT, GL_FALSE,
+   sizeof(struct glsl_layer_vertex), vertices->layer);
   gl_check_error();
 
+  // Upload the data for as many layers as fit at once, then draw each run of
+  // layers that use the same program with one call. Primitives are blended in
+  // the order they're given, so this is the same as drawing them one by one.
+  while(count)
+  {
+    Uint32 packed;
+    Uint32 start;
+    Uint32 end;
+    int data_w;
+    int data_h;
+
+    packed = glsl_pack_layers(graphics, layers, count, &data_w, &data_h);
+
+    glsl.glTexSubImage2D(GL_TEXTURE_2D, 0,
+     TEX_DATA_LAYER_X, TEX_DATA_LAYER_Y, data_w, data_h,
+     GL_RGBA, GL_UNSIGNED_BYTE, render_data->layer_texture);
+    gl_check_error();
+
+    for(start = 0; start < packed; start = end)
+    {
+      Uint32 mode = layers[start]->mode;
+
+      for(end = start + 1; end < packed; end++)
+        if(!layers[end]->mode != !mode)
+          break;
+
+      if(mode == 0)
+        glsl.glUseProgram(render_data->tilemap_program);
+      else
+        glsl.glUseProgram(render_data->tilemap_smzx_program);
+      gl_check_error();
+
+      glsl.glDrawArrays(GL_TRIANGLES, start * LAYER_VERTICES,
+       (end - start) * LAYER_VERTICES);
+      gl_check_error();
+    }
+
+    layers += packed;
+    count -= packed;
+  }
+
   glsl.glDisableVertexAttribArray(ATTRIB_POSITION);
   glsl.glDisableVertexAttribArray(ATTRIB_TEXCOORD);
+  glsl.glDisableVertexAttribArray(ATTRIB_LAYER);
   glsl.glDisable(GL_BLEND);
 }
 
+static void glsl_render_layer(struct graphics_data *graphics,
+ struct video_layer *layer)
+{
+  glsl_render_layers(graphics, &layer, 1);
+}
+
 static void glsl_render_cursor(struct graphics_data *graphics,
  Uint32 x, Uint32 y, Uint16 color, Uint8 lines, Uint8 offset)
 {
@@ -1402,7 +1540,7 @@ void render_glsl_register(struct renderer *renderer)
   renderer->free_video = glsl_free_video;
   renderer->check_video_mode = gl_check_video_mode;
   renderer->set_video_mode = glsl_set_video_mode;
-  renderer->update_colors = glsl_update_colors;
+  renderer->update_colors_range = glsl_update_colors_range;
   renderer->resize_screen = resize_screen_standard;
   renderer->remap_char_range = glsl_remap_char_range;
   renderer->remap_char = glsl_remap_char;
@@ -1410,6 +1548,7 @@ void render_glsl_register(struct renderer *renderer)
   renderer->get_screen_coords = get_screen_coords_scaled;
   renderer->set_screen_coords = set_screen_coords_scaled;
   renderer->render_layer = glsl_render_layer;
+  renderer->render_layers = glsl_render_layers;
   renderer->render_cursor = glsl_render_cursor;
   renderer->render_mouse = glsl_render_mouse;
   renderer->sync_screen = glsl_sync_screen;
@@ -0,0 +1,263 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Renderer that draws to a 640x350 32bpp buffer in memory instead of a
+ * display, using the same layer and graph renderers as the software
+ * renderer. This lets the test worlds and benchmarks exercise the whole
+ * drawing path on machines with no display.
+ *
+ * If headless_dump_interval is set, every Nth frame that gets rendered is
+ * written to <headless_dump_prefix><frame>.png. The time taken to render
+ * each frame is reported when the renderer is shut down.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "configure.h"
+#include "graphics.h"
+#include "platform_endian.h"
+#include "render.h"
+#include "render_layer.h"
+#include "renderers.h"
+#include "util.h"
+
+#ifdef CONFIG_PNG
+#include "pngops.h"
+#endif
+
+#define HEADLESS_PITCH (SCREEN_PIX_W * sizeof(Uint32))
+
+struct headless_render_data
+{
+  Uint32 pixels[SCREEN_PIX_W * SCREEN_PIX_H];
+  int dump_interval;
+  char dump_prefix[256];
+
+  boolean in_frame;
+  uint64_t frame_start;
+  Uint32 frames;
+  uint64_t total_ns;
+  uint64_t min_ns;
+  uint64_t max_ns;
+};
+
+static boolean headless_set_video_mode(struct graphics_data *graphics,
+ int width, int height, int depth, boolean fullscreen, boolean resize)
+{
+  return true;
+}
+
+static boolean headless_init_video(struct graphics_data *graphics,
+ struct config_info *conf)
+{
+  struct headless_render_data *render_data =
+   ccalloc(1, sizeof(struct headless_render_data));
+
+  if(!render_data)
+    return false;
+
+  render_data->dump_interval = conf->headless_dump_interval;
+  snprintf(render_data->dump_prefix, sizeof(render_data->dump_prefix), "%s",
+   conf->headless_dump_prefix);
+
+#ifndef CONFIG_PNG
+  if(render_data->dump_interval)
+  {
+    warn("Headless: this build can't write PNGs; frames won't be dumped.\n");
+    render_data->dump_interval = 0;
+  }
+#endif
+
+  graphics->render_data = render_data;
+  graphics->allow_resize = 0;
+  graphics->bits_per_pixel = 32;
+  graphics->headless = true;
+
+  graphics->resolution_width = SCREEN_PIX_W;
+  graphics->resolution_height = SCREEN_PIX_H;
+  graphics->window_width = SCREEN_PIX_W;
+  graphics->window_height = SCREEN_PIX_H;
+
+  return set_video_mode();
+}
+
+static void headless_free_video(struct graphics_data *graphics)
+{
+  struct headless_render_data *render_data = graphics->render_data;
+
+  if(render_data->frames)
+  {
+    info("Headless: %" PRIu32 " frames, %.3f ms/frame "
+     "(min %.3f ms, max %.3f ms)\n", render_data->frames,
+     render_data->total_ns / 1000000.0 / render_data->frames,
+     render_data->min_ns / 1000000.0, render_data->max_ns / 1000000.0);
+  }
+
+  render_layers_free();
+  free(render_data);
+
+  graphics->render_data = NULL;
+  graphics->headless = false;
+}
+
+static void headless_update_colors_range(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 first, Uint32 count)
+{
+  Uint32 i;
+
+  // Same layout dump_screen uses, which is what the PNG writer expects.
+  for(i = first; i < first + count; i++)
+  {
+#if PLATFORM_BYTE_ORDER == PLATFORM_BIG_ENDIAN
+    graphics->flat_intensity_palette[i] =
+     (palette[i].r << 8) | (palette[i].g << 16) | (palette[i].b << 24);
+#else
+    graphics->flat_intensity_palette[i] =
+     (palette[i].r << 16) | (palette[i].g << 8) | (palette[i].b << 0);
+#endif /* PLATFORM_BYTE_ORDER == PLATFORM_BIG_ENDIAN */
+  }
+}
+
+/**
+ * The first draw after a sync starts the timer for the frame.
+ */
+static void headless_begin_frame(struct headless_render_data *render_data)
+{
+  if(!render_data->in_frame)
+  {
+    render_data->in_frame = true;
+    render_data->frame_start = get_time_ns();
+  }
+}
+
+static void headless_render_graph(struct graphics_data *graphics)
+{
+  struct headless_render_data *render_data = graphics->render_data;
+  Uint32 mode = graphics->screen_mode;
+
+  headless_begin_frame(render_data);
+
+  if(!mode)
+  {
+    render_graph32(render_data->pixels, HEADLESS_PITCH, graphics,
+     set_colors32[mode]);
+  }
+  else
+  {
+    render_graph32s(render_data->pixels, HEADLESS_PITCH, graphics,
+     set_colors32[mode]);
+  }
+}
+
+static void headless_render_layer(struct graphics_data *graphics,
+ struct video_layer *layer)
+{
+  struct headless_render_data *render_data = graphics->render_data;
+
+  headless_begin_frame(render_data);
+  render_layer(render_data->pixels, 32, HEADLESS_PITCH, graphics, layer);
+}
+
+static void headless_render_layers(struct graphics_data *graphics,
+ struct video_layer **layers, Uint32 count)
+{
+  struct headless_render_data *render_data = graphics->render_data;
+
+  headless_begin_frame(render_data);
+  render_layers(render_data->pixels, 32, HEADLESS_PITCH, graphics, layers,
+   count);
+}
+
+static void headless_render_cursor(struct graphics_data *graphics,
+ Uint32 x, Uint32 y, Uint16 color, Uint8 lines, Uint8 offset)
+{
+  struct headless_render_data *render_data = graphics->render_data;
+
+  headless_begin_frame(render_data);
+  render_cursor(render_data->pixels, HEADLESS_PITCH, 32, x, y,
+   graphics->flat_intensity_palette[color], lines, offset);
+}
+
+static void headless_render_mouse(struct graphics_data *graphics,
+ Uint32 x, Uint32 y, Uint8 w, Uint8 h)
+{
+  struct headless_render_data *render_data = graphics->render_data;
+
+  headless_begin_frame(render_data);
+  render_mouse(render_data->pixels, HEADLESS_PITCH, 32, x, y, 0x00FFFFFF, 0,
+   w, h);
+}
+
+static void headless_sync_screen(struct graphics_data *graphics)
+{
+  struct headless_render_data *render_data = graphics->render_data;
+  uint64_t elapsed;
+
+  if(!render_data->in_frame)
+    return;
+
+  elapsed = get_time_ns() - render_data->frame_start;
+  render_data->in_frame = false;
+
+  if(!render_data->frames || elapsed < render_data->min_ns)
+    render_data->min_ns = elapsed;
+  if(elapsed > render_data->max_ns)
+    render_data->max_ns = elapsed;
+
+  render_data->total_ns += elapsed;
+  render_data->frames++;
+
+#ifdef CONFIG_PNG
+  // Frames are numbered from 1, so an interval of N dumps frame N first.
+  if(render_data->dump_interval &&
+   !(render_data->frames % render_data->dump_interval))
+  {
+    char name[MAX_PATH];
+
+    snprintf(name, MAX_PATH, "%s%06" PRIu32 ".png", render_data->dump_prefix,
+     render_data->frames);
+
+    if(!png_write_screen_32bpp(render_data->pixels, name))
+      warn("Headless: failed to write '%s'.\n", name);
+  }
+#endif
+}
+
+void render_headless_register(struct renderer *renderer)
+{
+  memset(renderer, 0, sizeof(struct renderer));
+  renderer->init_video = headless_init_video;
+  renderer->free_video = headless_free_video;
+  renderer->check_video_mode = headless_set_video_mode;
+  renderer->set_video_mode = headless_set_video_mode;
+  renderer->update_colors_range = headless_update_colors_range;
+  renderer->resize_screen = resize_screen_standard;
+  renderer->get_screen_coords = get_screen_coords_centered;
+  renderer->set_screen_coords = set_screen_coords_centered;
+  renderer->render_graph = headless_render_graph;
+  renderer->render_layer = headless_render_layer;
+  renderer->render_layers = headless_render_layers;
+  renderer->render_cursor = headless_render_cursor;
+  renderer->render_mouse = headless_render_mouse;
+  renderer->sync_screen = headless_sync_screen;
+}
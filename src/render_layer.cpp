@@ -18,11 +18,23 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "platform.h"
 #include "graphics.h"
 #include "render_layer.h"
+#include "util.h"
+
+// Threads are available even when platform.h doesn't include them (i.e. if
+// audio and networking are disabled).
+#ifdef CONFIG_PTHREAD
+#include "thread_pthread.h"
+#define RENDER_LAYER_THREADS
+#elif defined(CONFIG_SDL)
+#include "thread_sdl.h"
+#define RENDER_LAYER_THREADS
+#endif
 
 // Skip unused variants to reduce compile time on these platforms.
 #if defined(CONFIG_WII) || defined(ANDROID) || defined(__EMSCRIPTEN__)
@@ -37,10 +49,42 @@
 #endif
 
 #include "render_layer_code.hpp"
+#include "render_layer_simd.hpp"
+#include "render_layer_cache.hpp"
+
+// Used by everything drawn from the main thread; render_layers threads each
+// get their own cache.
+static struct glyph_cache layer_glyph_cache;
+
+#ifdef HAS_LAYER_SIMD
+// Selected from the main thread before anything is drawn, since the
+// render_layers threads all read it.
+static int layer_simd_selected = -1;
+#endif
+
+static void render_layer_init(void)
+{
+#ifdef HAS_LAYER_SIMD
+  if(layer_simd_selected < 0)
+    layer_simd_selected = layer_simd_best();
+#endif
+}
 
-#if 0
+#ifdef CONFIG_FPS
+static void glyph_cache_stats(struct graphics_data *graphics,
+ struct glyph_cache *cache)
+{
+  graphics->glyph_cache_hits += cache->hits;
+  graphics->glyph_cache_misses += cache->misses;
+  cache->hits = 0;
+  cache->misses = 0;
+}
+#endif
+
+#ifdef RENDER_LAYER_REFERENCE
 // This layer renderer is very slow, but it should work properly.
 // The renderers in render_layer_code.h should generally be used instead.
+// It's only built for the unit tests, which check the others against it.
 
 static inline void reference_renderer(Uint32 *pixels, Uint32 pitch,
  struct graphics_data *graphics, struct video_layer *layer)
@@ -185,8 +229,9 @@ void render_layer_8bpp(void *pixels, Uint32 pitch,
   render_layer(pixels, 8, pitch, graphics, layer);
 }
 
-void render_layer(void *pixels, int force_bpp, Uint32 pitch,
- struct graphics_data *graphics, struct video_layer *layer)
+static void render_layer_ext(void *pixels, int force_bpp, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer,
+ struct glyph_cache *cache)
 {
   //reference_renderer(pixels, pitch, graphics, layer); return;
 
@@ -205,6 +250,27 @@ void render_layer(void *pixels, int force_bpp, Uint32 pitch,
   if(force_bpp == -1)
     force_bpp = graphics->bits_per_pixel;
 
+  if(!clip)
+  {
+#ifdef HAS_LAYER_SIMD
+    // The vector renderers expand a whole char row at once, which is faster
+    // than any of the alignments below, but they don't handle clipping.
+    // Copying from the glyph cache is faster still, but not while the palette
+    // is changing every frame (e.g. fading) and nothing in it gets reused.
+    if(force_bpp == 32 && cache->palette_version != graphics->palette_version)
+    {
+      cache->palette_version = graphics->palette_version;
+      if(render_layer_simd(pixels, pitch, graphics, layer,
+       layer_simd_selected, smzx, trans))
+        return;
+    }
+#endif
+
+    if(render_layer_cached(pixels, force_bpp, pitch, graphics, layer,
+     cache, smzx, trans))
+      return;
+  }
+
   drawStart =
    (size_t)((char *)pixels + layer->y * pitch + (layer->x * force_bpp / 8));
 
@@ -236,3 +302,339 @@ void render_layer(void *pixels, int force_bpp, Uint32 pitch,
   render_layer_func(pixels, pitch, graphics, layer,
    force_bpp, align, smzx, ppal, trans, clip);
 }
+
+void render_layer(void *pixels, int force_bpp, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer)
+{
+  render_layer_init();
+  render_layer_ext(pixels, force_bpp, pitch, graphics, layer,
+   &layer_glyph_cache);
+
+#ifdef CONFIG_FPS
+  glyph_cache_stats(graphics, &layer_glyph_cache);
+#endif
+}
+
+/**
+ * Draw the part of a layer that falls in the pixel rows [y_start, y_end).
+ * Char rows that fit in the range entirely are drawn straight to the screen.
+ * A char row that crosses either edge is drawn to a scratch buffer instead
+ * (with the screen rows in the range copied in first, so transparent pixels
+ * blend the same way) and only the rows in the range are copied back.
+ * The scratch buffer must hold CHAR_H rows of SCREEN_PIX_W 32bpp pixels.
+ */
+static void render_layer_rows(void *pixels, int bpp, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer,
+ int y_start, int y_end, Uint8 *scratch, struct glyph_cache *cache)
+{
+  struct video_layer part = *layer;
+  Uint32 scratch_pitch = SCREEN_PIX_W * bpp / 8;
+  int layer_end = layer->y + (int)layer->h * CHAR_H;
+  int first;
+  int last;
+  int full_first;
+  int full_last;
+  int row;
+  int y;
+
+  if(layer->y >= y_end || layer_end <= y_start)
+    return;
+
+  // Char rows touching the range, and the char rows entirely inside of it.
+  first = (y_start > layer->y) ? (y_start - layer->y) / CHAR_H : 0;
+  last = MIN((int)layer->h, (y_end - layer->y + CHAR_H - 1) / CHAR_H);
+  full_first = (y_start > layer->y) ?
+   (y_start - layer->y + CHAR_H - 1) / CHAR_H : 0;
+  full_last = MIN((int)layer->h, (y_end - layer->y) / CHAR_H);
+
+  if(full_first < full_last)
+  {
+    part.y = layer->y + full_first * CHAR_H;
+    part.h = full_last - full_first;
+    part.data = layer->data + full_first * layer->w;
+    render_layer_ext(pixels, bpp, pitch, graphics, &part, cache);
+  }
+  else
+    full_last = full_first;
+
+  for(row = first; row < last; row++)
+  {
+    int row_y = layer->y + row * CHAR_H;
+    int copy_start = MAX(row_y, y_start);
+    int copy_end = MIN(row_y + CHAR_H, y_end);
+
+    if(row >= full_first && row < full_last)
+      continue;
+
+    for(y = copy_start; y < copy_end; y++)
+    {
+      memcpy(scratch + (y - row_y) * scratch_pitch,
+       (Uint8 *)pixels + y * pitch, scratch_pitch);
+    }
+
+    part.y = 0;
+    part.h = 1;
+    part.data = layer->data + row * layer->w;
+    render_layer_ext(scratch, bpp, scratch_pitch, graphics, &part, cache);
+
+    for(y = copy_start; y < copy_end; y++)
+    {
+      memcpy((Uint8 *)pixels + y * pitch,
+       scratch + (y - row_y) * scratch_pitch, scratch_pitch);
+    }
+  }
+}
+
+#ifdef RENDER_LAYER_THREADS
+
+#define MAX_LAYER_THREADS 16
+
+/**
+ * Worker pool for render_layers. The screen is split into bands of whole
+ * char rows and each band is composited through every layer by whichever
+ * thread takes it first. No two threads ever touch the same pixel, and
+ * every pixel is drawn by the same layers in the same order as a serial
+ * render, so the output doesn't depend on the number of threads.
+ */
+struct layer_thread_pool
+{
+  platform_mutex lock;
+  platform_cond start_cond;
+  platform_cond done_cond;
+  platform_thread threads[MAX_LAYER_THREADS];
+  Uint8 *scratch[MAX_LAYER_THREADS + 1];
+  struct glyph_cache *caches[MAX_LAYER_THREADS + 1];
+  int num_threads;
+  boolean quit;
+
+  // Current job.
+  Uint32 generation;
+  void *pixels;
+  int bpp;
+  Uint32 pitch;
+  struct graphics_data *graphics;
+  struct video_layer **layers;
+  Uint32 num_layers;
+  int band_height;
+  int num_bands;
+  int next_band;
+  int bands_done;
+};
+
+static struct layer_thread_pool *layer_threads;
+static int layer_threads_requested = -1;
+
+struct layer_thread_data
+{
+  struct layer_thread_pool *pool;
+  int id;
+};
+
+static struct layer_thread_data layer_thread_data[MAX_LAYER_THREADS];
+
+/**
+ * Take and draw bands of the current job until there are none left.
+ * Must be called with the pool locked.
+ */
+static void layer_threads_run(struct layer_thread_pool *pool, int id)
+{
+  Uint32 i;
+  int band;
+
+  while(pool->next_band < pool->num_bands)
+  {
+    int y_start;
+    int y_end;
+
+    band = pool->next_band++;
+    platform_mutex_unlock(&(pool->lock));
+
+    y_start = band * pool->band_height;
+    y_end = MIN(y_start + pool->band_height, SCREEN_PIX_H);
+
+    for(i = 0; i < pool->num_layers; i++)
+    {
+      render_layer_rows(pool->pixels, pool->bpp, pool->pitch, pool->graphics,
+       pool->layers[i], y_start, y_end, pool->scratch[id], pool->caches[id]);
+    }
+
+    platform_mutex_lock(&(pool->lock));
+    pool->bands_done++;
+    if(pool->bands_done == pool->num_bands)
+      platform_cond_signal(&(pool->done_cond));
+  }
+}
+
+static THREAD_RES layer_thread_main(void *_data)
+{
+  struct layer_thread_data *data = (struct layer_thread_data *)_data;
+  struct layer_thread_pool *pool = data->pool;
+  Uint32 generation = 0;
+
+  platform_mutex_lock(&(pool->lock));
+  while(true)
+  {
+    while(!pool->quit && generation == pool->generation)
+      platform_cond_wait(&(pool->start_cond), &(pool->lock));
+
+    if(pool->quit)
+      break;
+
+    generation = pool->generation;
+    layer_threads_run(pool, data->id);
+  }
+  platform_mutex_unlock(&(pool->lock));
+  THREAD_RETURN;
+}
+
+void render_layers_free(void)
+{
+  struct layer_thread_pool *pool = layer_threads;
+  int i;
+
+  if(!pool)
+    return;
+
+  platform_mutex_lock(&(pool->lock));
+  pool->quit = true;
+  platform_cond_broadcast(&(pool->start_cond));
+  platform_mutex_unlock(&(pool->lock));
+
+  for(i = 0; i < pool->num_threads; i++)
+    platform_thread_join(&(pool->threads[i]));
+
+  for(i = 0; i <= pool->num_threads; i++)
+    free(pool->scratch[i]);
+
+  for(i = 1; i <= pool->num_threads; i++)
+    free(pool->caches[i]);
+
+  platform_cond_destroy(&(pool->done_cond));
+  platform_cond_destroy(&(pool->start_cond));
+  platform_mutex_destroy(&(pool->lock));
+  free(pool);
+  layer_threads = NULL;
+  layer_threads_requested = -1;
+}
+
+/**
+ * Start the pool for the configured number of threads (0 for one per CPU).
+ * The calling thread also draws bands, so this starts one fewer thread.
+ */
+static struct layer_thread_pool *layer_threads_init(int num_threads)
+{
+  struct layer_thread_pool *pool;
+  int i;
+
+  int requested = num_threads;
+
+  if(requested == layer_threads_requested)
+    return layer_threads;
+
+  render_layers_free();
+  layer_threads_requested = requested;
+
+  if(num_threads <= 0)
+    num_threads = platform_get_cpu_count();
+
+  num_threads = MIN(num_threads - 1, MAX_LAYER_THREADS);
+  if(num_threads <= 0)
+    return NULL;
+
+  pool = (struct layer_thread_pool *)ccalloc(1,
+   sizeof(struct layer_thread_pool));
+
+  platform_mutex_init(&(pool->lock));
+  platform_cond_init(&(pool->start_cond));
+  platform_cond_init(&(pool->done_cond));
+
+  pool->scratch[0] = (Uint8 *)cmalloc(SCREEN_PIX_W * CHAR_H * sizeof(Uint32));
+  pool->caches[0] = &layer_glyph_cache;
+
+  for(i = 0; i < num_threads; i++)
+  {
+    layer_thread_data[i].pool = pool;
+    layer_thread_data[i].id = i + 1;
+
+    if(platform_thread_create(&(pool->threads[i]),
+     (platform_thread_fn)layer_thread_main, &(layer_thread_data[i])))
+      break;
+
+    pool->scratch[i + 1] =
+     (Uint8 *)cmalloc(SCREEN_PIX_W * CHAR_H * sizeof(Uint32));
+    pool->caches[i + 1] =
+     (struct glyph_cache *)ccalloc(1, sizeof(struct glyph_cache));
+    pool->num_threads++;
+  }
+
+  layer_threads = pool;
+  if(!pool->num_threads)
+  {
+    render_layers_free();
+    layer_threads_requested = requested;
+  }
+  return layer_threads;
+}
+
+#else /* !RENDER_LAYER_THREADS */
+
+void render_layers_free(void) {}
+
+#endif /* !RENDER_LAYER_THREADS */
+
+void render_layers(void *pixels, int force_bpp, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer **layers,
+ Uint32 num_layers)
+{
+  Uint32 i;
+
+  if(force_bpp == -1)
+    force_bpp = graphics->bits_per_pixel;
+
+  render_layer_init();
+
+#ifdef RENDER_LAYER_THREADS
+  if(graphics->render_threads != 1)
+  {
+    struct layer_thread_pool *pool =
+     layer_threads_init(graphics->render_threads);
+
+    if(pool)
+    {
+      // Aim for two bands per thread so uneven bands can be balanced out.
+      int threads = pool->num_threads + 1;
+      int band_rows = MAX(1, SCREEN_H / (threads * 2));
+
+      platform_mutex_lock(&(pool->lock));
+      pool->pixels = pixels;
+      pool->bpp = force_bpp;
+      pool->pitch = pitch;
+      pool->graphics = graphics;
+      pool->layers = layers;
+      pool->num_layers = num_layers;
+      pool->band_height = band_rows * CHAR_H;
+      pool->num_bands = (SCREEN_H + band_rows - 1) / band_rows;
+      pool->next_band = 0;
+      pool->bands_done = 0;
+      pool->generation++;
+      platform_cond_broadcast(&(pool->start_cond));
+
+      layer_threads_run(pool, 0);
+
+      while(pool->bands_done < pool->num_bands)
+        platform_cond_wait(&(pool->done_cond), &(pool->lock));
+
+#ifdef CONFIG_FPS
+      for(i = 0; i <= (Uint32)pool->num_threads; i++)
+        glyph_cache_stats(graphics, pool->caches[i]);
+#endif
+
+      platform_mutex_unlock(&(pool->lock));
+      return;
+    }
+  }
+#endif
+
+  for(i = 0; i < num_layers; i++)
+    render_layer(pixels, force_bpp, pitch, graphics, layers[i]);
+}
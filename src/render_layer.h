@@ -36,6 +36,16 @@ void render_layer_16bpp(void *pixels, Uint32 pitch,
 void render_layer_8bpp(void *pixels, Uint32 pitch,
  struct graphics_data *graphics, struct video_layer *layer);
 
+/**
+ * Draw a list of layers in order. With more than one thread available this
+ * splits the screen into bands and composites them in parallel.
+ */
+void render_layers(void *pixels, int force_bpp, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer **layers,
+ Uint32 num_layers);
+
+void render_layers_free(void);
+
 __M_END_DECLS
 
 #endif // __RENDER_LAYER_H
@@ -0,0 +1,303 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+// Glyph cache for the 16bpp and 32bpp layer renderers. Most games only draw
+// a few hundred different char/color combinations, so instead of expanding
+// each char from the charset every time it's drawn, keep the expanded pixels
+// (and which of them are transparent) for recently drawn chars. Drawing a
+// cached char is then a copy of each row, or a masked copy if the char has
+// transparent pixels.
+//
+// The cache is two-way set associative, since a direct mapped cache this
+// size still has plenty of collisions on a busy board. Entries are checked
+// against graphics->char_version and palette_version, which graphics.c bumps
+// whenever a char or the palette changes, so nothing needs to be flushed
+// explicitly. This only handles layers that don't need to be clipped;
+// everything else goes through render_layer_code.hpp.
+
+#define GLYPH_CACHE_SET_BITS 9
+#define GLYPH_CACHE_SETS (1 << GLYPH_CACHE_SET_BITS)
+#define GLYPH_CACHE_SIZE (GLYPH_CACHE_SETS * 2)
+#define GLYPH_CACHE_EMPTY (~(Uint64)0)
+
+struct glyph_cache_entry
+{
+  Uint64 key;
+  Uint32 char_version;
+  Uint32 palette_version;
+
+  // A set bit keeps the existing pixel (MSB is the leftmost pixel).
+  Uint8 trans[CHAR_H];
+  boolean all_trans;
+
+  // 16bpp chars only use the first half of this.
+  Uint32 pixels[CHAR_W * CHAR_H];
+};
+
+struct glyph_cache
+{
+  struct graphics_data *graphics;
+  Uint32 palette_version; // When this cache was last used (render_layer.cpp).
+  Uint32 hits;
+  Uint32 misses;
+  struct glyph_cache_entry entries[GLYPH_CACHE_SIZE];
+
+  // Which entry of each set to replace next (the least recently used).
+  Uint8 replace[GLYPH_CACHE_SETS];
+};
+
+/**
+ * Empty the cache if it was last used with a different graphics_data; its
+ * versions have nothing to do with the ones the entries were made with.
+ */
+static inline void glyph_cache_check(struct glyph_cache *cache,
+ struct graphics_data *graphics)
+{
+  int i;
+
+  if(cache->graphics == graphics)
+    return;
+
+  for(i = 0; i < GLYPH_CACHE_SIZE; i++)
+    cache->entries[i].key = GLYPH_CACHE_EMPTY;
+
+  memset(cache->replace, 0, sizeof(cache->replace));
+
+  cache->graphics = graphics;
+}
+
+/**
+ * Everything that affects the pixels of a char other than the charset and
+ * palette, which are covered by the versions.
+ */
+static inline Uint64 glyph_cache_key(Uint16 c, struct char_element *src,
+ Uint32 mode, int tcol, int bpp)
+{
+  return (Uint64)c |
+   ((Uint64)src->bg_color << 12) |
+   ((Uint64)src->fg_color << 20) |
+   ((Uint64)(mode & 3) << 28) |
+   ((Uint64)(Uint16)(tcol + 1) << 30) |
+   ((Uint64)(bpp == 32) << 46);
+}
+
+static inline Uint32 glyph_cache_set(Uint64 key)
+{
+  return (Uint32)((key * 0x9E3779B97F4A7C15ULL) >> (64 - GLYPH_CACHE_SET_BITS));
+}
+
+static inline boolean glyph_cache_valid(struct glyph_cache_entry *entry,
+ struct graphics_data *graphics, Uint64 key, Uint16 c)
+{
+  return entry->key == key &&
+   entry->char_version == graphics->char_version[c] &&
+   entry->palette_version == graphics->palette_version;
+}
+
+template<typename PIXTYPE, int SMZX, int TR>
+static void glyph_cache_fill(struct glyph_cache_entry *entry,
+ struct graphics_data *graphics, struct char_element *src, Uint16 c,
+ int tcol)
+{
+  struct layer_char_colors colors;
+  PIXTYPE *out = (PIXTYPE *)entry->pixels;
+  Uint8 *char_ptr = graphics->charset + (c * CHAR_H);
+  int row;
+  int x;
+
+  layer_get_char_colors<SMZX, TR>(&colors, graphics, src, tcol,
+   graphics->protected_pal_position);
+
+  entry->char_version = graphics->char_version[c];
+  entry->palette_version = graphics->palette_version;
+  entry->all_trans = colors.all_tcol;
+
+  for(row = 0; row < CHAR_H; row++, out += CHAR_W)
+  {
+    Uint8 char_byte = char_ptr[row];
+    Uint8 trans = 0;
+
+    for(x = 0; x < CHAR_W; x++)
+    {
+      int idx;
+
+      if(SMZX)
+        idx = (char_byte >> (6 - (x & ~1))) & 3;
+      else
+        idx = (char_byte >> (7 - x)) & 1;
+
+      out[x] = colors.color[idx];
+      if(colors.trans[idx])
+        trans |= 0x80 >> x;
+    }
+    entry->trans[row] = trans;
+  }
+}
+
+/**
+ * Draw an unclipped layer to a 16bpp or 32bpp buffer through the cache.
+ */
+template<typename PIXTYPE, int SMZX, int TR>
+static void render_layer_cached(void *pixels, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer,
+ struct glyph_cache *cache)
+{
+  struct char_element *src = layer->data;
+  Uint32 align_pitch = pitch / sizeof(PIXTYPE);
+  PIXTYPE *outPtr = (PIXTYPE *)pixels + layer->y * align_pitch + layer->x;
+  Uint32 advance_char_row = align_pitch * CHAR_H - CHAR_W * layer->w;
+  int tcol = TR ? layer->transparent_col : -1;
+  Uint32 ch_x, ch_y;
+  Uint16 c;
+
+  glyph_cache_check(cache, graphics);
+
+  for(ch_y = 0; ch_y < layer->h; ch_y++, outPtr += advance_char_row)
+  {
+    for(ch_x = 0; ch_x < layer->w; ch_x++, src++, outPtr += CHAR_W)
+    {
+      struct glyph_cache_entry *entry;
+      const PIXTYPE *tile;
+      PIXTYPE *dest;
+      Uint64 key;
+      Uint32 set;
+      int row;
+      int x;
+
+      c = src->char_value;
+      if(c == INVISIBLE_CHAR)
+        continue;
+
+      // Char values of 256+, prior to offsetting, are from the protected set
+      if(c > 0xFF)
+      {
+        c = (c & 0xFF) + PROTECTED_CHARSET_POSITION;
+      }
+      else
+      {
+        c += layer->offset;
+        c %= PROTECTED_CHARSET_POSITION;
+      }
+
+      key = glyph_cache_key(c, src, layer->mode, tcol, sizeof(PIXTYPE) * 8);
+      set = glyph_cache_set(key);
+      entry = &(cache->entries[set * 2]);
+
+      if(glyph_cache_valid(entry, graphics, key, c))
+      {
+        cache->replace[set] = 1;
+        cache->hits++;
+      }
+      else
+
+      if(glyph_cache_valid(entry + 1, graphics, key, c))
+      {
+        cache->replace[set] = 0;
+        cache->hits++;
+        entry++;
+      }
+      else
+      {
+        // A stale copy of this char would never be used again.
+        if(entry[1].key == key)
+          cache->replace[set] = 1;
+        else
+
+        if(entry[0].key == key)
+          cache->replace[set] = 0;
+
+        entry += cache->replace[set];
+        cache->replace[set] ^= 1;
+
+        glyph_cache_fill<PIXTYPE, SMZX, TR>(entry, graphics, src, c, tcol);
+        entry->key = key;
+        cache->misses++;
+      }
+
+      // Don't bother drawing chars that are completely transparent.
+      if(TR && entry->all_trans)
+        continue;
+
+      tile = (const PIXTYPE *)entry->pixels;
+      dest = outPtr;
+
+      for(row = 0; row < CHAR_H; row++, tile += CHAR_W, dest += align_pitch)
+      {
+        Uint8 trans = TR ? entry->trans[row] : 0;
+
+        if(!trans)
+        {
+          memcpy(dest, tile, CHAR_W * sizeof(PIXTYPE));
+        }
+        else
+
+        if(trans != 0xFF)
+        {
+          for(x = 0; x < CHAR_W; x++)
+            if(!(trans & (0x80 >> x)))
+              dest[x] = tile[x];
+        }
+      }
+    }
+  }
+}
+
+template<typename PIXTYPE>
+static void render_layer_cached(void *pixels, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer,
+ struct glyph_cache *cache, int smzx, int trans)
+{
+  if(smzx)
+  {
+    if(trans)
+      render_layer_cached<PIXTYPE, 1, 1>(pixels, pitch, graphics, layer, cache);
+    else
+      render_layer_cached<PIXTYPE, 1, 0>(pixels, pitch, graphics, layer, cache);
+  }
+  else
+  {
+    if(trans)
+      render_layer_cached<PIXTYPE, 0, 1>(pixels, pitch, graphics, layer, cache);
+    else
+      render_layer_cached<PIXTYPE, 0, 0>(pixels, pitch, graphics, layer, cache);
+  }
+}
+
+/**
+ * Returns false if the cache doesn't support this BPP.
+ */
+static inline boolean render_layer_cached(void *pixels, int bpp, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer,
+ struct glyph_cache *cache, int smzx, int trans)
+{
+  switch(bpp)
+  {
+#ifndef SKIP_16BPP
+    case 16:
+      render_layer_cached<Uint16>(pixels, pitch, graphics, layer, cache,
+       smzx, trans);
+      return true;
+#endif
+    case 32:
+      render_layer_cached<Uint32>(pixels, pitch, graphics, layer, cache,
+       smzx, trans);
+      return true;
+  }
+  return false;
+}
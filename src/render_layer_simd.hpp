@@ -0,0 +1,549 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2017 Dr Lancer-X <drlancer@megazeux.org>
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+// Vector versions of the 32bpp layer renderer. Each char row is expanded
+// from its charset byte to 8 pixels at once: the byte is broadcast to every
+// lane, each lane tests the bit (or SMZX bit pair) for its pixel, and the
+// resulting masks select the pixel colors and, for transparent colors,
+// whether to keep the existing pixel. This only handles layers that don't
+// need to be clipped; everything else goes through render_layer_code.hpp.
+
+#include "platform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+ (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LAYER_SIMD_SSE2
+#include <emmintrin.h>
+
+// AVX2 needs to be enabled per-function so the rest of the binary still runs
+// on CPUs without it. MSVC doesn't need this, but it also lacks a simple way
+// to check for AVX2 at runtime, so it's GCC/clang only for now.
+#if (defined(__GNUC__) && (__GNUC__ > 4 || \
+ (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))) || defined(__clang__)
+#define LAYER_SIMD_AVX2
+#include <immintrin.h>
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LAYER_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(LAYER_SIMD_SSE2) || defined(LAYER_SIMD_NEON)
+#define HAS_LAYER_SIMD
+#endif
+
+/**
+ * Colors for a char, one per MZX color or SMZX index. For each, trans is all
+ * ones if that color is the layer's transparent color.
+ */
+struct layer_char_colors
+{
+  Uint32 color[4];
+  Uint32 trans[4];
+  Uint32 byte_tcol;
+  boolean has_tcol;
+  boolean all_tcol;
+};
+
+/**
+ * Same color selection as render_layer_func for BPP=16 and BPP=32. This is
+ * also used to fill the glyph cache (see render_layer_cache.hpp).
+ */
+template<int SMZX, int TR>
+static inline void layer_get_char_colors(struct layer_char_colors *dest,
+ struct graphics_data *graphics, struct char_element *src, int tcol, int ppal)
+{
+  int char_idx[4];
+  int num_colors = SMZX ? 4 : 2;
+  int i;
+
+  if(SMZX)
+  {
+    Uint16 pal = ((src->bg_color & 0xF) << 4) | (src->fg_color & 0xF);
+    for(i = 0; i < 4; i++)
+      char_idx[i] = graphics->smzx_indices[pal * 4 + i];
+  }
+  else
+  {
+    char_idx[0] = (src->bg_color >= 16) ?
+     (src->bg_color - 16) % 16 + ppal : src->bg_color & 0x0F;
+    char_idx[1] = (src->fg_color >= 16) ?
+     (src->fg_color - 16) % 16 + ppal : src->fg_color & 0x0F;
+  }
+
+  dest->has_tcol = false;
+  dest->all_tcol = true;
+  dest->byte_tcol = 0xFFFF;
+
+  for(i = 0; i < num_colors; i++)
+  {
+    dest->color[i] = graphics->flat_intensity_palette[char_idx[i]];
+    dest->trans[i] = (TR && char_idx[i] == tcol) ? 0xFFFFFFFF : 0;
+
+    if(TR)
+    {
+      // Charset byte for a row drawn entirely in this color.
+      if(!dest->has_tcol)
+      {
+        static const Uint8 tcol_bytes_mzx[] = { 0x00, 0xFF };
+        static const Uint8 tcol_bytes_smzx[] = { 0x00, 0x55, 0xAA, 0xFF };
+        dest->byte_tcol = SMZX ? tcol_bytes_smzx[i] : tcol_bytes_mzx[i];
+      }
+      dest->has_tcol |= (char_idx[i] == tcol);
+      dest->all_tcol &= (char_idx[i] == tcol);
+    }
+  }
+
+  for(; i < 4; i++)
+  {
+    dest->color[i] = 0;
+    dest->trans[i] = 0;
+  }
+
+  if(!TR)
+    dest->all_tcol = false;
+}
+
+#ifdef HAS_LAYER_SIMD
+
+enum layer_simd
+{
+  LAYER_SIMD_NONE,
+  LAYER_SIMD_SSE2_KERNEL,
+  LAYER_SIMD_AVX2_KERNEL,
+  LAYER_SIMD_NEON_KERNEL,
+  NUM_LAYER_SIMD
+};
+
+template<int KERNEL>
+struct layer_simd_kernel;
+
+#ifdef LAYER_SIMD_SSE2
+
+template<>
+struct layer_simd_kernel<LAYER_SIMD_SSE2_KERNEL>
+{
+  static inline __m128i select(__m128i mask, __m128i a, __m128i b)
+  {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+  }
+
+  static inline __m128i test(__m128i v, __m128i bits)
+  {
+    return _mm_cmpeq_epi32(_mm_and_si128(v, bits), bits);
+  }
+
+  template<int SMZX, int TR>
+  static void draw_char(Uint32 *dest, Uint32 pitch, const Uint8 *char_ptr,
+   const struct layer_char_colors *colors)
+  {
+    // Pixels 0-3 and 4-7 of the row. SMZX uses the bits for the high (a)
+    // and low (b) bit of each pixel's pair.
+    const __m128i mzx_lo = _mm_setr_epi32(0x80, 0x40, 0x20, 0x10);
+    const __m128i mzx_hi = _mm_setr_epi32(0x08, 0x04, 0x02, 0x01);
+    const __m128i smzx_lo_a = _mm_setr_epi32(0x80, 0x80, 0x20, 0x20);
+    const __m128i smzx_lo_b = _mm_setr_epi32(0x40, 0x40, 0x10, 0x10);
+    const __m128i smzx_hi_a = _mm_setr_epi32(0x08, 0x08, 0x02, 0x02);
+    const __m128i smzx_hi_b = _mm_setr_epi32(0x04, 0x04, 0x01, 0x01);
+    __m128i c0 = _mm_set1_epi32(colors->color[0]);
+    __m128i c1 = _mm_set1_epi32(colors->color[1]);
+    __m128i c2 = _mm_set1_epi32(colors->color[2]);
+    __m128i c3 = _mm_set1_epi32(colors->color[3]);
+    __m128i t0 = _mm_set1_epi32(colors->trans[0]);
+    __m128i t1 = _mm_set1_epi32(colors->trans[1]);
+    __m128i t2 = _mm_set1_epi32(colors->trans[2]);
+    __m128i t3 = _mm_set1_epi32(colors->trans[3]);
+    boolean blend = TR && colors->has_tcol;
+    int row;
+
+    for(row = 0; row < CHAR_H; row++, dest += pitch)
+    {
+      Uint32 char_byte = char_ptr[row];
+      __m128i *out = (__m128i *)dest;
+      __m128i v = _mm_set1_epi32(char_byte);
+      __m128i lo;
+      __m128i hi;
+
+      if(blend && char_byte == colors->byte_tcol)
+        continue;
+
+      if(!SMZX)
+      {
+        __m128i m_lo = test(v, mzx_lo);
+        __m128i m_hi = test(v, mzx_hi);
+
+        lo = select(m_lo, c1, c0);
+        hi = select(m_hi, c1, c0);
+
+        if(blend)
+        {
+          lo = select(select(m_lo, t1, t0), _mm_loadu_si128(out), lo);
+          hi = select(select(m_hi, t1, t0), _mm_loadu_si128(out + 1), hi);
+        }
+      }
+      else
+      {
+        __m128i a_lo = test(v, smzx_lo_a);
+        __m128i b_lo = test(v, smzx_lo_b);
+        __m128i a_hi = test(v, smzx_hi_a);
+        __m128i b_hi = test(v, smzx_hi_b);
+
+        lo = select(a_lo, select(b_lo, c3, c2), select(b_lo, c1, c0));
+        hi = select(a_hi, select(b_hi, c3, c2), select(b_hi, c1, c0));
+
+        if(blend)
+        {
+          __m128i k_lo =
+           select(a_lo, select(b_lo, t3, t2), select(b_lo, t1, t0));
+          __m128i k_hi =
+           select(a_hi, select(b_hi, t3, t2), select(b_hi, t1, t0));
+
+          lo = select(k_lo, _mm_loadu_si128(out), lo);
+          hi = select(k_hi, _mm_loadu_si128(out + 1), hi);
+        }
+      }
+
+      _mm_storeu_si128(out, lo);
+      _mm_storeu_si128(out + 1, hi);
+    }
+  }
+};
+
+#endif /* LAYER_SIMD_SSE2 */
+
+#ifdef LAYER_SIMD_AVX2
+
+template<>
+struct layer_simd_kernel<LAYER_SIMD_AVX2_KERNEL>
+{
+  // Not _mm256_blendv_epi8: some GCC versions fold its mask test as if the
+  // mask bytes were unsigned when building with -funsigned-char.
+  static TARGET_AVX2 inline __m256i select(__m256i mask, __m256i a, __m256i b)
+  {
+    return _mm256_or_si256(_mm256_and_si256(mask, a),
+     _mm256_andnot_si256(mask, b));
+  }
+
+  static TARGET_AVX2 inline __m256i test(__m256i v, __m256i bits)
+  {
+    return _mm256_cmpeq_epi32(_mm256_and_si256(v, bits), bits);
+  }
+
+  // A whole char row fits in one register, so no lo/hi halves here.
+  template<int SMZX, int TR>
+  static TARGET_AVX2 void draw_char(Uint32 *dest, Uint32 pitch,
+   const Uint8 *char_ptr, const struct layer_char_colors *colors)
+  {
+    const __m256i mzx_bits =
+     _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    const __m256i smzx_a =
+     _mm256_setr_epi32(0x80, 0x80, 0x20, 0x20, 0x08, 0x08, 0x02, 0x02);
+    const __m256i smzx_b =
+     _mm256_setr_epi32(0x40, 0x40, 0x10, 0x10, 0x04, 0x04, 0x01, 0x01);
+    __m256i c0 = _mm256_set1_epi32(colors->color[0]);
+    __m256i c1 = _mm256_set1_epi32(colors->color[1]);
+    __m256i c2 = _mm256_set1_epi32(colors->color[2]);
+    __m256i c3 = _mm256_set1_epi32(colors->color[3]);
+    __m256i t0 = _mm256_set1_epi32(colors->trans[0]);
+    __m256i t1 = _mm256_set1_epi32(colors->trans[1]);
+    __m256i t2 = _mm256_set1_epi32(colors->trans[2]);
+    __m256i t3 = _mm256_set1_epi32(colors->trans[3]);
+    boolean blend = TR && colors->has_tcol;
+    int row;
+
+    for(row = 0; row < CHAR_H; row++, dest += pitch)
+    {
+      Uint32 char_byte = char_ptr[row];
+      __m256i *out = (__m256i *)dest;
+      __m256i v = _mm256_set1_epi32(char_byte);
+      __m256i pix;
+
+      if(blend && char_byte == colors->byte_tcol)
+        continue;
+
+      if(!SMZX)
+      {
+        __m256i m = test(v, mzx_bits);
+
+        pix = select(m, c1, c0);
+
+        if(blend)
+          pix = select(select(m, t1, t0), _mm256_loadu_si256(out), pix);
+      }
+      else
+      {
+        __m256i a = test(v, smzx_a);
+        __m256i b = test(v, smzx_b);
+
+        pix = select(a, select(b, c3, c2), select(b, c1, c0));
+
+        if(blend)
+        {
+          __m256i keep = select(a, select(b, t3, t2), select(b, t1, t0));
+          pix = select(keep, _mm256_loadu_si256(out), pix);
+        }
+      }
+
+      _mm256_storeu_si256(out, pix);
+    }
+  }
+};
+
+#endif /* LAYER_SIMD_AVX2 */
+
+#ifdef LAYER_SIMD_NEON
+
+template<>
+struct layer_simd_kernel<LAYER_SIMD_NEON_KERNEL>
+{
+  template<int SMZX, int TR>
+  static void draw_char(Uint32 *dest, Uint32 pitch, const Uint8 *char_ptr,
+   const struct layer_char_colors *colors)
+  {
+    static const Uint32 mzx_bits[8] =
+     { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    static const Uint32 smzx_a[8] =
+     { 0x80, 0x80, 0x20, 0x20, 0x08, 0x08, 0x02, 0x02 };
+    static const Uint32 smzx_b[8] =
+     { 0x40, 0x40, 0x10, 0x10, 0x04, 0x04, 0x01, 0x01 };
+    uint32x4_t mzx_lo = vld1q_u32(mzx_bits);
+    uint32x4_t mzx_hi = vld1q_u32(mzx_bits + 4);
+    uint32x4_t a_lo_bits = vld1q_u32(smzx_a);
+    uint32x4_t a_hi_bits = vld1q_u32(smzx_a + 4);
+    uint32x4_t b_lo_bits = vld1q_u32(smzx_b);
+    uint32x4_t b_hi_bits = vld1q_u32(smzx_b + 4);
+    uint32x4_t c0 = vdupq_n_u32(colors->color[0]);
+    uint32x4_t c1 = vdupq_n_u32(colors->color[1]);
+    uint32x4_t c2 = vdupq_n_u32(colors->color[2]);
+    uint32x4_t c3 = vdupq_n_u32(colors->color[3]);
+    uint32x4_t t0 = vdupq_n_u32(colors->trans[0]);
+    uint32x4_t t1 = vdupq_n_u32(colors->trans[1]);
+    uint32x4_t t2 = vdupq_n_u32(colors->trans[2]);
+    uint32x4_t t3 = vdupq_n_u32(colors->trans[3]);
+    boolean blend = TR && colors->has_tcol;
+    int row;
+
+    for(row = 0; row < CHAR_H; row++, dest += pitch)
+    {
+      Uint32 char_byte = char_ptr[row];
+      uint32x4_t v = vdupq_n_u32(char_byte);
+      uint32x4_t lo;
+      uint32x4_t hi;
+
+      if(blend && char_byte == colors->byte_tcol)
+        continue;
+
+      if(!SMZX)
+      {
+        uint32x4_t m_lo = vtstq_u32(v, mzx_lo);
+        uint32x4_t m_hi = vtstq_u32(v, mzx_hi);
+
+        lo = vbslq_u32(m_lo, c1, c0);
+        hi = vbslq_u32(m_hi, c1, c0);
+
+        if(blend)
+        {
+          lo = vbslq_u32(vbslq_u32(m_lo, t1, t0), vld1q_u32(dest), lo);
+          hi = vbslq_u32(vbslq_u32(m_hi, t1, t0), vld1q_u32(dest + 4), hi);
+        }
+      }
+      else
+      {
+        uint32x4_t a_lo = vtstq_u32(v, a_lo_bits);
+        uint32x4_t b_lo = vtstq_u32(v, b_lo_bits);
+        uint32x4_t a_hi = vtstq_u32(v, a_hi_bits);
+        uint32x4_t b_hi = vtstq_u32(v, b_hi_bits);
+
+        lo = vbslq_u32(a_lo, vbslq_u32(b_lo, c3, c2), vbslq_u32(b_lo, c1, c0));
+        hi = vbslq_u32(a_hi, vbslq_u32(b_hi, c3, c2), vbslq_u32(b_hi, c1, c0));
+
+        if(blend)
+        {
+          uint32x4_t k_lo =
+           vbslq_u32(a_lo, vbslq_u32(b_lo, t3, t2), vbslq_u32(b_lo, t1, t0));
+          uint32x4_t k_hi =
+           vbslq_u32(a_hi, vbslq_u32(b_hi, t3, t2), vbslq_u32(b_hi, t1, t0));
+
+          lo = vbslq_u32(k_lo, vld1q_u32(dest), lo);
+          hi = vbslq_u32(k_hi, vld1q_u32(dest + 4), hi);
+        }
+      }
+
+      vst1q_u32(dest, lo);
+      vst1q_u32(dest + 4, hi);
+    }
+  }
+};
+
+#endif /* LAYER_SIMD_NEON */
+
+/**
+ * Draw an unclipped layer to a 32bpp buffer with a vector kernel.
+ */
+template<int KERNEL, int SMZX, int TR>
+static void render_layer_simd(void *pixels, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer)
+{
+  struct layer_char_colors colors;
+  struct char_element *src = layer->data;
+  Uint32 align_pitch = pitch / sizeof(Uint32);
+  Uint32 *outPtr = (Uint32 *)pixels + layer->y * align_pitch + layer->x;
+  Uint32 advance_char_row = align_pitch * CHAR_H - CHAR_W * layer->w;
+  int tcol = layer->transparent_col;
+  int ppal = graphics->protected_pal_position;
+  Uint16 last_fg = 0xFFFF;
+  Uint16 last_bg = 0xFFFF;
+  Uint32 ch_x, ch_y;
+  Uint16 c;
+
+  for(ch_y = 0; ch_y < layer->h; ch_y++, outPtr += advance_char_row)
+  {
+    for(ch_x = 0; ch_x < layer->w; ch_x++, src++, outPtr += CHAR_W)
+    {
+      c = src->char_value;
+      if(c == INVISIBLE_CHAR)
+        continue;
+
+      // Char values of 256+, prior to offsetting, are from the protected set
+      if(c > 0xFF)
+      {
+        c = (c & 0xFF) + PROTECTED_CHARSET_POSITION;
+      }
+      else
+      {
+        c += layer->offset;
+        c %= PROTECTED_CHARSET_POSITION;
+      }
+
+      if(src->bg_color != last_bg || src->fg_color != last_fg)
+      {
+        layer_get_char_colors<SMZX, TR>(&colors, graphics, src, tcol, ppal);
+        last_bg = src->bg_color;
+        last_fg = src->fg_color;
+      }
+
+      // Don't bother drawing chars that are completely transparent.
+      if(TR && colors.all_tcol)
+        continue;
+
+      layer_simd_kernel<KERNEL>::template draw_char<SMZX, TR>(outPtr,
+       align_pitch, graphics->charset + (c * CHAR_H), &colors);
+    }
+  }
+}
+
+/**
+ * Transparency enabled (1) or disabled (0), and SMZX (1) or MZX (0).
+ */
+template<int KERNEL>
+static void render_layer_simd(void *pixels, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer,
+ int smzx, int trans)
+{
+  if(smzx)
+  {
+    if(trans)
+      render_layer_simd<KERNEL, 1, 1>(pixels, pitch, graphics, layer);
+    else
+      render_layer_simd<KERNEL, 1, 0>(pixels, pitch, graphics, layer);
+  }
+  else
+  {
+    if(trans)
+      render_layer_simd<KERNEL, 0, 1>(pixels, pitch, graphics, layer);
+    else
+      render_layer_simd<KERNEL, 0, 0>(pixels, pitch, graphics, layer);
+  }
+}
+
+/**
+ * Draw a layer with the given kernel (see layer_simd_best).
+ * Returns false if the selected kernel isn't available.
+ */
+static inline boolean render_layer_simd(void *pixels, Uint32 pitch,
+ struct graphics_data *graphics, struct video_layer *layer,
+ int kernel, int smzx, int trans)
+{
+  switch(kernel)
+  {
+#ifdef LAYER_SIMD_SSE2
+    case LAYER_SIMD_SSE2_KERNEL:
+      render_layer_simd<LAYER_SIMD_SSE2_KERNEL>(pixels, pitch, graphics, layer,
+       smzx, trans);
+      return true;
+#endif
+#ifdef LAYER_SIMD_AVX2
+    case LAYER_SIMD_AVX2_KERNEL:
+      render_layer_simd<LAYER_SIMD_AVX2_KERNEL>(pixels, pitch, graphics, layer,
+       smzx, trans);
+      return true;
+#endif
+#ifdef LAYER_SIMD_NEON
+    case LAYER_SIMD_NEON_KERNEL:
+      render_layer_simd<LAYER_SIMD_NEON_KERNEL>(pixels, pitch, graphics, layer,
+       smzx, trans);
+      return true;
+#endif
+  }
+  return false;
+}
+
+/**
+ * Whether a kernel was compiled in and is supported by this CPU.
+ */
+static inline boolean layer_simd_supported(int kernel)
+{
+  switch(kernel)
+  {
+#ifdef LAYER_SIMD_SSE2
+    case LAYER_SIMD_SSE2_KERNEL:
+      return true;
+#endif
+#ifdef LAYER_SIMD_AVX2
+    case LAYER_SIMD_AVX2_KERNEL:
+      return __builtin_cpu_supports("avx2") != 0;
+#endif
+#ifdef LAYER_SIMD_NEON
+    case LAYER_SIMD_NEON_KERNEL:
+      return true;
+#endif
+  }
+  return false;
+}
+
+/**
+ * Find the widest kernel supported by this CPU.
+ */
+static inline int layer_simd_best(void)
+{
+  int best = LAYER_SIMD_NONE;
+  int i;
+
+  for(i = 0; i < NUM_LAYER_SIMD; i++)
+    if(layer_simd_supported(i))
+      best = i;
+
+  return best;
+}
+
+#endif /* HAS_LAYER_SIMD */
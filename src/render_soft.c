@@ -65,14 +65,15 @@ static boolean soft_init_video(struct graphics_data *graphics,
 
 static void soft_free_video(struct graphics_data *graphics)
 {
+  render_layers_free();
   sdl_destruct_window(graphics);
 
   // Don't free render_data, it's static!
   graphics->render_data = NULL;
 }
 
-static void soft_update_colors(struct graphics_data *graphics,
- struct rgb_color *palette, Uint32 count)
+static void soft_update_colors_range(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 first, Uint32 count)
 {
   struct sdl_render_data *render_data = graphics->render_data;
   SDL_Surface *screen = soft_get_screen_surface(render_data);
@@ -81,7 +82,7 @@ static void soft_update_colors(struct graphics_data *graphics,
 
   if(graphics->bits_per_pixel != 8)
   {
-    for(i = 0; i < count; i++)
+    for(i = first; i < first + count; i++)
     {
       graphics->flat_intensity_palette[i] =
        SDL_MapRGBA(screen->format, palette[i].r, palette[i].g, palette[i].b,
@@ -90,8 +91,11 @@ static void soft_update_colors(struct graphics_data *graphics,
   }
   else
   {
-    if (count > 256) count = 256;
-    for(i = 0; i < count; i++)
+    if(first >= 256)
+      return;
+
+    count = MIN(count, 256 - first);
+    for(i = first; i < first + count; i++)
     {
       sdlpal[i].r = palette[i].r;
       sdlpal[i].g = palette[i].g;
@@ -99,9 +103,9 @@ static void soft_update_colors(struct graphics_data *graphics,
     }
 
 #if SDL_VERSION_ATLEAST(2,0,0)
-    SDL_SetPaletteColors(render_data->palette, sdlpal, 0, count);
+    SDL_SetPaletteColors(render_data->palette, sdlpal + first, first, count);
 #else
-    SDL_SetColors(render_data->screen, sdlpal, 0, count);
+    SDL_SetColors(render_data->screen, sdlpal + first, first, count);
 #endif
   }
 }
@@ -207,10 +211,52 @@ static void soft_render_mouse(struct graphics_data *graphics,
   SDL_UnlockSurface(screen);
 }
 
+#if SDL_VERSION_ATLEAST(2,0,0)
+// Only copy the parts of the screen that changed to the window.
+static void soft_sync_dirty_rects(struct graphics_data *graphics)
+{
+  struct sdl_render_data *render_data = graphics->render_data;
+  SDL_Surface *screen = soft_get_screen_surface(render_data);
+  SDL_Rect rects[MAX_DIRTY_RECTS];
+  Uint32 bpp = screen->format->BitsPerPixel;
+  Uint32 i;
+
+  // Same offsets as the rendering functions.
+  int x_offset = ((screen->w - 640) * bpp / 64) * 32 / bpp;
+  int y_offset = ((screen->h - 350) / 8) * 4;
+
+  for(i = 0; i < graphics->num_dirty_rects; i++)
+  {
+    rects[i].x = graphics->dirty_rects[i].x + x_offset;
+    rects[i].y = graphics->dirty_rects[i].y + y_offset;
+    rects[i].w = graphics->dirty_rects[i].w;
+    rects[i].h = graphics->dirty_rects[i].h;
+
+    if(render_data->shadow)
+    {
+      SDL_Rect dest = rects[i];
+      SDL_BlitSurface(render_data->shadow, &rects[i], render_data->screen,
+       &dest);
+    }
+  }
+
+  SDL_UpdateWindowSurfaceRects(render_data->window, rects,
+   graphics->num_dirty_rects);
+}
+#endif
+
 static void soft_sync_screen(struct graphics_data *graphics)
 {
   struct sdl_render_data *render_data = graphics->render_data;
 
+#if SDL_VERSION_ATLEAST(2,0,0)
+  if(!graphics->full_redraw && graphics->num_dirty_rects)
+  {
+    soft_sync_dirty_rects(graphics);
+    return;
+  }
+#endif
+
   if(render_data->shadow)
   {
     SDL_BlitSurface(render_data->shadow,
@@ -244,6 +290,24 @@ static void soft_render_layer(struct graphics_data *graphics,
   SDL_UnlockSurface(screen);
 }
 
+static void soft_render_layers(struct graphics_data *graphics,
+ struct video_layer **layers, Uint32 count)
+{
+  struct sdl_render_data *render_data = graphics->render_data;
+  SDL_Surface *screen = soft_get_screen_surface(render_data);
+
+  Uint32 *pixels = (Uint32 *)screen->pixels;
+  Uint32 pitch = screen->pitch;
+  Uint32 bpp = screen->format->BitsPerPixel;
+
+  pixels += pitch * ((screen->h - 350) / 8);
+  pixels += (screen->w - 640) * bpp / 64;
+
+  SDL_LockSurface(screen);
+  render_layers(pixels, bpp, pitch, graphics, layers, count);
+  SDL_UnlockSurface(screen);
+}
+
 void render_soft_register(struct renderer *renderer)
 {
   memset(renderer, 0, sizeof(struct renderer));
@@ -251,12 +315,13 @@ void render_soft_register(struct renderer *renderer)
   renderer->free_video = soft_free_video;
   renderer->check_video_mode = sdl_check_video_mode;
   renderer->set_video_mode = sdl_set_video_mode;
-  renderer->update_colors = soft_update_colors;
+  renderer->update_colors_range = soft_update_colors_range;
   renderer->resize_screen = resize_screen_standard;
   renderer->get_screen_coords = get_screen_coords_centered;
   renderer->set_screen_coords = set_screen_coords_centered;
   renderer->render_graph = soft_render_graph;
   renderer->render_layer = soft_render_layer;
+  renderer->render_layers = soft_render_layers;
   renderer->render_cursor = soft_render_cursor;
   renderer->render_mouse = soft_render_mouse;
   renderer->sync_screen = soft_sync_screen;
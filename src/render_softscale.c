@@ -67,6 +67,8 @@ static void softscale_free_video(struct graphics_data *graphics)
 {
   struct softscale_render_data *render_data = graphics->render_data;
 
+  render_layers_free();
+
   if(render_data)
   {
     if(render_data->sdl_format)
@@ -389,8 +391,8 @@ err_free:
   return false;
 }
 
-static void softscale_update_colors(struct graphics_data *graphics,
- struct rgb_color *palette, Uint32 count)
+static void softscale_update_colors_range(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 first, Uint32 count)
 {
   struct softscale_render_data *render_data = graphics->render_data;
 
@@ -398,7 +400,7 @@ static void softscale_update_colors(struct graphics_data *graphics,
 
   if(!render_data->rgb_to_yuv)
   {
-    for(i = 0; i < count; i++)
+    for(i = first; i < first + count; i++)
     {
       graphics->flat_intensity_palette[i] = SDL_MapRGBA(render_data->sdl_format,
        palette[i].r, palette[i].g, palette[i].b, SDL_ALPHA_OPAQUE);
@@ -406,7 +408,7 @@ static void softscale_update_colors(struct graphics_data *graphics,
   }
   else
   {
-    for(i = 0; i < count; i++)
+    for(i = first; i < first + count; i++)
     {
       graphics->flat_intensity_palette[i] =
        render_data->rgb_to_yuv(palette[i].r, palette[i].g, palette[i].b);
@@ -511,6 +513,18 @@ static void softscale_render_layer(struct graphics_data *graphics,
   render_layer(pixels, bpp, pitch, graphics, layer);
 }
 
+static void softscale_render_layers(struct graphics_data *graphics,
+ struct video_layer **layers, Uint32 count)
+{
+  struct softscale_render_data *render_data = graphics->render_data;
+  Uint32 *pixels;
+  Uint32 pitch;
+  Uint32 bpp;
+
+  softscale_lock_texture(render_data, false, &pixels, &pitch, &bpp);
+  render_layers(pixels, bpp, pitch, graphics, layers, count);
+}
+
 static void softscale_render_cursor(struct graphics_data *graphics,
  Uint32 x, Uint32 y, Uint16 color, Uint8 lines, Uint8 offset)
 {
@@ -581,12 +595,13 @@ void render_softscale_register(struct renderer *renderer)
   renderer->free_video = softscale_free_video;
   renderer->check_video_mode = sdl_check_video_mode;
   renderer->set_video_mode = softscale_set_video_mode;
-  renderer->update_colors = softscale_update_colors;
+  renderer->update_colors_range = softscale_update_colors_range;
   renderer->resize_screen = resize_screen_standard;
   renderer->get_screen_coords = get_screen_coords_scaled;
   renderer->set_screen_coords = set_screen_coords_scaled;
   renderer->render_graph = softscale_render_graph;
   renderer->render_layer = softscale_render_layer;
+  renderer->render_layers = softscale_render_layers;
   renderer->render_cursor = softscale_render_cursor;
   renderer->render_mouse = softscale_render_mouse;
   renderer->sync_screen = softscale_sync_screen;
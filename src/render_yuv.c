@@ -156,13 +156,13 @@ static boolean yuv_check_video_mode(struct graphics_data *graphics,
    sdl_flags(depth, fullscreen, false, resize) | SDL_ANYFORMAT);
 }
 
-static void yuv_update_colors(struct graphics_data *graphics,
- struct rgb_color *palette, Uint32 count)
+static void yuv_update_colors_range(struct graphics_data *graphics,
+ struct rgb_color *palette, Uint32 first, Uint32 count)
 {
   struct yuv_render_data *render_data = graphics->render_data;
   Uint32 i;
 
-  for(i = 0; i < count; i++)
+  for(i = first; i < first + count; i++)
   {
     graphics->flat_intensity_palette[i] =
      render_data->rgb_to_yuv(palette[i].r, palette[i].g, palette[i].b);
@@ -284,7 +284,7 @@ void render_yuv1_register(struct renderer *renderer)
   renderer->free_video = yuv_free_video;
   renderer->check_video_mode = yuv_check_video_mode;
   renderer->set_video_mode = yuv1_set_video_mode;
-  renderer->update_colors = yuv_update_colors;
+  renderer->update_colors_range = yuv_update_colors_range;
   renderer->resize_screen = resize_screen_standard;
   renderer->get_screen_coords = get_screen_coords_scaled;
   renderer->set_screen_coords = set_screen_coords_scaled;
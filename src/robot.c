@@ -49,6 +49,10 @@
 #include "io/memfile.h"
 #include "io/zip.h"
 
+#ifdef CONFIG_COUNTER_HASH_TABLES
+#include "hashtable.h"
+#endif
+
 void create_blank_robot(struct robot *cur_robot)
 {
   int i;
@@ -64,6 +68,17 @@ void create_blank_robot(struct robot *cur_robot)
   cur_robot->label_list = NULL;
   cur_robot->num_labels = 0;
 
+#ifndef CONFIG_DEBYTECODE
+  cur_robot->expr_cache = NULL;
+  cur_robot->label_board = NULL;
+#endif
+
+#ifdef CONFIG_PREDECODE
+  cur_robot->instructions = NULL;
+  cur_robot->instruction_index = NULL;
+  cur_robot->num_instructions = 0;
+#endif
+
   cur_robot->program_bytecode_length = 0;
   cur_robot->program_bytecode = NULL;
   cur_robot->program_source_length = 0;
@@ -98,6 +113,7 @@ void create_blank_robot(struct robot *cur_robot)
 
   cur_robot->commands_total = 0;
   cur_robot->commands_cycle = 0;
+  cur_robot->profile_id = 0;
 #endif
 }
 
@@ -828,6 +844,293 @@ static int cmp_labels(const void *dest, const void *src)
   }
 }
 
+#if !defined(CONFIG_DEBYTECODE) && defined(CONFIG_COUNTER_HASH_TABLES)
+#define CONFIG_LABEL_INDEX
+
+/**
+ * Each board can have an inverted index from label name to the robots on it
+ * that define that label, used by send_robot_all so a broadcast only visits
+ * its receivers instead of searching every robot's label list. A message sent
+ * to one robot never affects another, so skipping robots without the label is
+ * safe, and so is visiting the receivers in a different order than the name
+ * list.
+ *
+ * The index is built from the label caches of the board's robots the first
+ * time something is broadcast on it, and each of those robots remembers the
+ * board in label_board. After that, placing a robot on the board and caching,
+ * clearing, zapping, or restoring a robot's labels only update that robot's
+ * entries. Removing a robot from a board always clears its labels first.
+ */
+struct label_receiver
+{
+  struct robot *robot;
+  int num_live;
+};
+
+struct label_index_entry
+{
+  uint32_t hash;
+  uint32_t name_length;
+  int num_receivers;
+  int num_receivers_allocated;
+  struct label_receiver *receivers;
+  char name[1];
+};
+
+HASH_SET_INIT(LABEL, struct label_index_entry *, name, name_length)
+
+static struct label_index_entry *find_label_index_entry(
+ struct board *src_board, const char *name)
+{
+  struct label_index_entry *entry;
+  HASH_FIND(LABEL, src_board->label_index, name, strlen(name), entry);
+  return entry;
+}
+
+static void add_label_index_entry(struct board *src_board,
+ struct robot *cur_robot, struct label *cur_label)
+{
+  struct label_index_entry *entry =
+   find_label_index_entry(src_board, cur_label->name);
+  struct label_receiver *receiver = NULL;
+
+  if(!entry)
+  {
+    size_t name_length = strlen(cur_label->name);
+
+    entry = cmalloc(sizeof(struct label_index_entry) + name_length);
+    memcpy(entry->name, cur_label->name, name_length + 1);
+    entry->name_length = name_length;
+    entry->num_receivers = 0;
+    entry->num_receivers_allocated = 0;
+    entry->receivers = NULL;
+
+    HASH_ADD(LABEL, src_board->label_index, entry);
+  }
+
+  // All of a robot's labels are added at once, so if this robot already
+  // receives this label it's the last receiver.
+  if(entry->num_receivers)
+  {
+    receiver = entry->receivers + entry->num_receivers - 1;
+    if(receiver->robot != cur_robot)
+      receiver = NULL;
+  }
+
+  if(!receiver)
+  {
+    if(entry->num_receivers == entry->num_receivers_allocated)
+    {
+      entry->num_receivers_allocated =
+       MAX(4, entry->num_receivers_allocated * 2);
+
+      entry->receivers = crealloc(entry->receivers,
+       entry->num_receivers_allocated * sizeof(struct label_receiver));
+    }
+
+    receiver = entry->receivers + entry->num_receivers;
+    receiver->robot = cur_robot;
+    receiver->num_live = 0;
+    entry->num_receivers++;
+  }
+
+  if(!cur_label->zapped)
+    receiver->num_live++;
+}
+
+static void add_label_index_robot(struct board *src_board,
+ struct robot *cur_robot)
+{
+  int i;
+
+  cur_robot->label_board = src_board;
+
+  for(i = 0; i < cur_robot->num_labels; i++)
+    add_label_index_entry(src_board, cur_robot, cur_robot->label_list[i]);
+}
+
+static void remove_label_index_robot(struct board *src_board,
+ struct robot *cur_robot)
+{
+  struct label_index_entry *entry;
+  int i;
+  int j;
+
+  for(i = 0; i < cur_robot->num_labels; i++)
+  {
+    entry = find_label_index_entry(src_board, cur_robot->label_list[i]->name);
+    if(!entry)
+      continue;
+
+    // Duplicate labels share one receiver, which is gone after the first.
+    for(j = 0; j < entry->num_receivers; j++)
+    {
+      if(entry->receivers[j].robot == cur_robot)
+      {
+        entry->num_receivers--;
+        memmove(entry->receivers + j, entry->receivers + j + 1,
+         (entry->num_receivers - j) * sizeof(struct label_receiver));
+        break;
+      }
+    }
+
+    if(!entry->num_receivers)
+    {
+      HASH_DELETE(LABEL, src_board->label_index, entry);
+      free(entry->receivers);
+      free(entry);
+    }
+  }
+}
+
+/**
+ * Get the board's label index, building it first if it doesn't exist. A
+ * board without any labels has no table, so this also leaves it NULL; that
+ * just means it's checked again on the next broadcast.
+ */
+static void *get_label_index(struct board *src_board)
+{
+  int i;
+
+  if(!src_board->label_index)
+  {
+    update_robot_name_list(src_board);
+
+    for(i = 0; i < src_board->num_robots_active; i++)
+      add_label_index_robot(src_board, src_board->robot_list_name_sorted[i]);
+  }
+  return src_board->label_index;
+}
+
+/**
+ * Index the labels of a robot that was just placed on a board. Robots that
+ * are placed before the index is built are picked up when it's built.
+ */
+static void place_label_index_robot(struct board *src_board,
+ struct robot *cur_robot)
+{
+  if(src_board->label_index && cur_robot->label_board != src_board)
+    add_label_index_robot(src_board, cur_robot);
+}
+
+/**
+ * Adjust the live count of a label that was just zapped or restored.
+ */
+static void update_label_index_live(struct robot *cur_robot,
+ const char *name, int delta)
+{
+  struct board *src_board = cur_robot->label_board;
+  struct label_index_entry *entry;
+  int i;
+
+  if(!src_board || !src_board->label_index)
+    return;
+
+  entry = find_label_index_entry(src_board, name);
+  if(entry)
+  {
+    for(i = 0; i < entry->num_receivers; i++)
+    {
+      if(entry->receivers[i].robot == cur_robot)
+      {
+        entry->receivers[i].num_live += delta;
+        break;
+      }
+    }
+  }
+}
+
+void clear_label_index(struct board *src_board)
+{
+  struct label_index_entry *entry;
+
+  HASH_ITER(LABEL, src_board->label_index, entry,
+  {
+    free(entry->receivers);
+    free(entry);
+  });
+  HASH_CLEAR(LABEL, src_board->label_index);
+}
+
+#else /* CONFIG_DEBYTECODE || !CONFIG_COUNTER_HASH_TABLES */
+
+void clear_label_index(struct board *src_board)
+{
+}
+
+#endif /* CONFIG_DEBYTECODE || !CONFIG_COUNTER_HASH_TABLES */
+
+#ifdef CONFIG_PREDECODE
+
+/**
+ * Decode every command of a robot into a fixed-size record for the dispatch
+ * table in run_robot.c. Only the first ROBOT_INSTRUCTION_PARAMS params of each
+ * command are decoded; commands that need more are run from the bytecode.
+ */
+static void predecode_robot(struct robot *cur_robot)
+{
+  char *program = cur_robot->program_bytecode;
+  int length = cur_robot->program_bytecode_length;
+  struct robot_instruction *instructions;
+  struct robot_instruction *inst;
+  int num_instructions = 0;
+  int *index;
+  int i;
+  int n;
+
+  // Each command is its length, the command byte, its params, and the length
+  // again. A length of zero ends the program.
+  for(i = 1; (i < length - 1) && program[i]; i += program[i] + 2)
+    num_instructions++;
+
+  if(!num_instructions)
+    return;
+
+  instructions = ccalloc(num_instructions, sizeof(struct robot_instruction));
+  index = cmalloc(length * sizeof(int));
+
+  for(i = 0; i < length; i++)
+    index[i] = -1;
+
+  for(i = 1, n = 0; n < num_instructions; i += program[i] + 2, n++)
+  {
+    char *cmd_ptr = program + i + 1;
+    char *end = cmd_ptr + program[i];
+    char *param = cmd_ptr + 1;
+    int num_params = 0;
+
+    inst = instructions + n;
+    inst->cmd = cmd_ptr[0];
+
+    while(param < end)
+    {
+      if(num_params < ROBOT_INSTRUCTION_PARAMS)
+      {
+        inst->params[num_params] = param - cmd_ptr;
+
+        // Numeric; see parse_param.
+        if(param[0] == 0)
+        {
+          inst->immediate |= 1 << num_params;
+          inst->value[num_params] =
+           (signed short)((int)param[1] | (int)(param[2] << 8));
+        }
+      }
+      param = next_param_pos(param);
+      num_params++;
+    }
+
+    inst->num_params = MIN(num_params, 255);
+    index[i] = n;
+  }
+
+  cur_robot->instructions = instructions;
+  cur_robot->instruction_index = index;
+  cur_robot->num_instructions = num_instructions;
+}
+
+#endif /* CONFIG_PREDECODE */
+
 // TODO: If bytecode isn't valid then this is done at a bad time. It should
 // really be done when robots are assembled, rather than when they're loaded.
 // So it's bundled with the function for that.
@@ -847,9 +1150,19 @@ void cache_robot_labels(struct robot *cur_robot)
   cur_robot->label_list = NULL;
   cur_robot->num_labels = 0;
 
+#ifdef CONFIG_PREDECODE
+  cur_robot->instructions = NULL;
+  cur_robot->instruction_index = NULL;
+  cur_robot->num_instructions = 0;
+#endif
+
   if(!robot_program)
     return;
 
+#ifdef CONFIG_PREDECODE
+  predecode_robot(cur_robot);
+#endif
+
   label_list = ccalloc(16, sizeof(struct label *));
 
   for(i = 1; i < (cur_robot->program_bytecode_length - 1); i++)
@@ -913,6 +1226,11 @@ void cache_robot_labels(struct robot *cur_robot)
 
   cur_robot->label_list = label_list;
   cur_robot->num_labels = labels_found;
+
+#ifdef CONFIG_LABEL_INDEX
+  if(cur_robot->label_board && cur_robot->label_board->label_index)
+    add_label_index_robot(cur_robot->label_board, cur_robot);
+#endif
   return;
 }
 
@@ -925,6 +1243,11 @@ void clear_label_cache(struct robot *cur_robot)
 
   if(cur_robot->label_list)
   {
+#ifdef CONFIG_LABEL_INDEX
+    if(cur_robot->label_board && cur_robot->label_board->label_index)
+      remove_label_index_robot(cur_robot->label_board, cur_robot);
+#endif
+
     for(i = 0; i < cur_robot->num_labels; i++)
     {
       free(cur_robot->label_list[i]);
@@ -935,6 +1258,19 @@ void clear_label_cache(struct robot *cur_robot)
 
   cur_robot->label_list = NULL;
   cur_robot->num_labels = 0;
+
+#ifdef CONFIG_PREDECODE
+  free(cur_robot->instructions);
+  free(cur_robot->instruction_index);
+  cur_robot->instructions = NULL;
+  cur_robot->instruction_index = NULL;
+  cur_robot->num_instructions = 0;
+#endif
+
+#ifndef CONFIG_DEBYTECODE
+  // Compiled expressions point into the bytecode too.
+  clear_expression_cache(cur_robot);
+#endif
 }
 
 void clear_robot_contents(struct robot *cur_robot)
@@ -976,6 +1312,221 @@ void clear_scroll(struct scroll *cur_scroll)
   free(cur_scroll);
 }
 
+#ifdef CONFIG_COUNTER_HASH_TABLES
+
+/**
+ * Each board can have a case-insensitive table from robot name to the robots
+ * with that name, in the same order they have in robot_list_name_sorted. It's
+ * built from the name list the first time a robot on the board is looked up
+ * by name. After that, adding, removing, and renaming robots only updates the
+ * table, and the name list is rebuilt from the table when it's needed again
+ * (see update_robot_name_list).
+ */
+struct robot_name_entry
+{
+  uint32_t hash;
+  uint32_t name_length;
+  int num_robots;
+  int num_robots_allocated;
+  struct robot **robots;
+  char name[1];
+};
+
+HASH_SET_INIT(ROBOT_NAME, struct robot_name_entry *, name, name_length)
+
+static struct robot_name_entry *add_robot_name_table_entry(
+ struct board *src_board, const char *name)
+{
+  size_t name_length = strlen(name);
+  struct robot_name_entry *entry =
+   cmalloc(sizeof(struct robot_name_entry) + name_length);
+
+  memcpy(entry->name, name, name_length + 1);
+  entry->name_length = name_length;
+  entry->num_robots = 0;
+  entry->num_robots_allocated = 0;
+  entry->robots = NULL;
+
+  HASH_ADD(ROBOT_NAME, src_board->robot_name_table, entry);
+  return entry;
+}
+
+static void insert_robot_name_table_entry(struct robot_name_entry *entry,
+ struct robot *cur_robot, int position)
+{
+  if(entry->num_robots == entry->num_robots_allocated)
+  {
+    entry->num_robots_allocated = MAX(2, entry->num_robots_allocated * 2);
+    entry->robots = crealloc(entry->robots,
+     entry->num_robots_allocated * sizeof(struct robot *));
+  }
+
+  if(position < entry->num_robots)
+  {
+    memmove(entry->robots + position + 1, entry->robots + position,
+     (entry->num_robots - position) * sizeof(struct robot *));
+  }
+  entry->robots[position] = cur_robot;
+  entry->num_robots++;
+}
+
+static void *get_robot_name_table(struct board *src_board)
+{
+  struct robot **name_list = src_board->robot_list_name_sorted;
+  struct robot_name_entry *entry = NULL;
+  int active = src_board->num_robots_active;
+  int i;
+
+  if(!src_board->robot_name_table && active)
+  {
+    for(i = 0; i < active; i++)
+    {
+      if(!entry || strcasecmp(entry->name, name_list[i]->robot_name))
+        entry = add_robot_name_table_entry(src_board, name_list[i]->robot_name);
+
+      insert_robot_name_table_entry(entry, name_list[i], entry->num_robots);
+    }
+  }
+  return src_board->robot_name_table;
+}
+
+static struct robot_name_entry *find_robot_name_table_entry(
+ struct board *src_board, const char *name)
+{
+  struct robot_name_entry *entry;
+  HASH_FIND(ROBOT_NAME, get_robot_name_table(src_board), name, strlen(name),
+   entry);
+  return entry;
+}
+
+/**
+ * Add a robot to the table. Like the name list, new robots go before any
+ * other robots with the same name. Returns false if there's no table.
+ */
+static boolean insert_robot_name_table(struct board *src_board,
+ struct robot *cur_robot, const char *name)
+{
+  struct robot_name_entry *entry;
+
+  if(!get_robot_name_table(src_board))
+    return false;
+
+  entry = find_robot_name_table_entry(src_board, name);
+  if(!entry)
+    entry = add_robot_name_table_entry(src_board, name);
+
+  insert_robot_name_table_entry(entry, cur_robot, 0);
+  src_board->num_robots_active++;
+  src_board->robot_name_list_dirty = true;
+  return true;
+}
+
+/**
+ * Remove a robot from the table. Returns false if there's no table.
+ */
+static boolean remove_robot_name_table(struct board *src_board,
+ struct robot *cur_robot, const char *name)
+{
+  struct robot_name_entry *entry;
+  int i;
+
+  if(!get_robot_name_table(src_board))
+    return false;
+
+  entry = find_robot_name_table_entry(src_board, name);
+  if(entry)
+  {
+    for(i = 0; i < entry->num_robots; i++)
+    {
+      if(entry->robots[i] == cur_robot)
+      {
+        entry->num_robots--;
+        memmove(entry->robots + i, entry->robots + i + 1,
+         (entry->num_robots - i) * sizeof(struct robot *));
+
+        src_board->num_robots_active--;
+        src_board->robot_name_list_dirty = true;
+        break;
+      }
+    }
+
+    if(!entry->num_robots)
+    {
+      HASH_DELETE(ROBOT_NAME, src_board->robot_name_table, entry);
+      free(entry->robots);
+      free(entry);
+    }
+  }
+  return true;
+}
+
+static int cmp_robot_name_entries(const void *a, const void *b)
+{
+  const struct robot_name_entry *entry_a = *(const struct robot_name_entry **)a;
+  const struct robot_name_entry *entry_b = *(const struct robot_name_entry **)b;
+  return strcasecmp(entry_a->name, entry_b->name);
+}
+
+void update_robot_name_list(struct board *src_board)
+{
+  struct robot **name_list = src_board->robot_list_name_sorted;
+  struct robot_name_entry **entries;
+  struct robot_name_entry *entry;
+  int num_entries = 0;
+  int pos = 0;
+  int i;
+
+  if(!src_board->robot_name_list_dirty)
+    return;
+
+  entries = cmalloc(MAX(1, src_board->num_robots_active) *
+   sizeof(struct robot_name_entry *));
+
+  HASH_ITER(ROBOT_NAME, src_board->robot_name_table, entry,
+  {
+    entries[num_entries++] = entry;
+  });
+
+  qsort(entries, num_entries, sizeof(struct robot_name_entry *),
+   cmp_robot_name_entries);
+
+  for(i = 0; i < num_entries; i++)
+  {
+    memcpy(name_list + pos, entries[i]->robots,
+     entries[i]->num_robots * sizeof(struct robot *));
+    pos += entries[i]->num_robots;
+  }
+
+  free(entries);
+  src_board->robot_name_list_dirty = false;
+}
+
+void clear_robot_name_table(struct board *src_board)
+{
+  struct robot_name_entry *entry;
+
+  update_robot_name_list(src_board);
+
+  HASH_ITER(ROBOT_NAME, src_board->robot_name_table, entry,
+  {
+    free(entry->robots);
+    free(entry);
+  });
+  HASH_CLEAR(ROBOT_NAME, src_board->robot_name_table);
+}
+
+#else /* !CONFIG_COUNTER_HASH_TABLES */
+
+void update_robot_name_list(struct board *src_board)
+{
+}
+
+void clear_robot_name_table(struct board *src_board)
+{
+}
+
+#endif /* !CONFIG_COUNTER_HASH_TABLES */
+
 // Does not remove entry from the normal list
 static void remove_robot_name_entry(struct board *src_board,
  struct robot *cur_robot, char *name)
@@ -985,6 +1536,11 @@ static void remove_robot_name_entry(struct board *src_board,
   int active = src_board->num_robots_active;
   struct robot **name_list = src_board->robot_list_name_sorted;
 
+#ifdef CONFIG_COUNTER_HASH_TABLES
+  if(remove_robot_name_table(src_board, cur_robot, name))
+    return;
+#endif
+
   find_robot(src_board, name, &first, &last);
 
   // Find the one that matches the robot
@@ -1077,11 +1633,13 @@ void get_robot_position(struct robot *cur_robot, int *xpos, int *ypos)
 
 int get_robot_id(struct board *src_board, const char *name)
 {
-  int first, last;
+  struct robot **robots;
+  int count;
 
-  if(find_robot(src_board, name, &first, &last))
+  robots = find_robots(src_board, name, &count);
+  if(robots)
   {
-    struct robot *cur_robot = src_board->robot_list_name_sorted[first];
+    struct robot *cur_robot = robots[0];
     // This is a cheap trick for now since robots don't have
     // a back-reference for IDs
     enum thing d_id;
@@ -1341,6 +1899,37 @@ int find_robot(struct board *src_board, const char *name,
   return 0;
 }
 
+/**
+ * Get the robots on a board with a given name, in name list order. Returns
+ * NULL if there aren't any. The list is only valid until a robot is added to
+ * the board, removed from it, or renamed.
+ */
+struct robot **find_robots(struct board *src_board, const char *name,
+ int *count)
+{
+#ifdef CONFIG_COUNTER_HASH_TABLES
+  struct robot_name_entry *entry =
+   find_robot_name_table_entry(src_board, name);
+
+  if(entry)
+  {
+    *count = entry->num_robots;
+    return entry->robots;
+  }
+#else
+  int first, last;
+
+  if(find_robot(src_board, name, &first, &last))
+  {
+    *count = last - first + 1;
+    return src_board->robot_list_name_sorted + first;
+  }
+#endif
+
+  *count = 0;
+  return NULL;
+}
+
 /* Built-in label only wrappers for send_robot_id and send_robot_all */
 int send_robot_id_def(struct world *mzx_world, int robot_id, const char *mesg,
  int ignore_lock)
@@ -1881,7 +2470,9 @@ void send_robot(struct world *mzx_world, char *name, const char *mesg,
  int ignore_lock)
 {
   struct board *src_board = mzx_world->current_board;
-  int first, last;
+  struct robot **robots;
+  int count;
+  int i;
 
   if(!strcasecmp(name, "all"))
   {
@@ -1897,15 +2488,9 @@ void send_robot(struct world *mzx_world, char *name, const char *mesg,
        ignore_lock, 0);
     }
 
-    if(find_robot(src_board, name, &first, &last))
-    {
-      while(first <= last)
-      {
-        send_robot_direct(mzx_world, src_board->robot_list_name_sorted[first],
-         mesg, ignore_lock, 0);
-        first++;
-      }
-    }
+    robots = find_robots(src_board, name, &count);
+    for(i = 0; i < count; i++)
+      send_robot_direct(mzx_world, robots[i], mesg, ignore_lock, 0);
   }
 
   send_sensors(mzx_world, name, mesg);
@@ -1935,6 +2520,32 @@ void send_robot_all(struct world *mzx_world, const char *mesg, int ignore_lock)
      mesg, ignore_lock, 0);
   }
 
+#ifdef CONFIG_LABEL_INDEX
+  // #return and #top don't need a label, so they still go to every robot.
+  if(strcasecmp(mesg, "#return") && strcasecmp(mesg, "#top"))
+  {
+    struct label_index_entry *entry = NULL;
+
+    if(get_label_index(src_board))
+      entry = find_label_index_entry(src_board, mesg);
+
+    if(entry)
+    {
+      for(i = 0; i < entry->num_receivers; i++)
+      {
+        if(entry->receivers[i].num_live)
+        {
+          send_robot_direct(mzx_world, entry->receivers[i].robot,
+           mesg, ignore_lock, 0);
+        }
+      }
+    }
+    return;
+  }
+#endif
+
+  update_robot_name_list(src_board);
+
   for(i = 0; i < src_board->num_robots_active; i++)
   {
     send_robot_direct(mzx_world, src_board->robot_list_name_sorted[i],
@@ -2347,6 +2958,10 @@ int restore_label(struct robot *cur_robot, char *label)
   {
     cur_robot->program_bytecode[dest_label->cmd_position] = ROBOTIC_CMD_LABEL;
     dest_label->zapped = false;
+
+#ifdef CONFIG_LABEL_INDEX
+    update_label_index_live(cur_robot, dest_label->name, 1);
+#endif
     return 1;
   }
 
@@ -2361,6 +2976,10 @@ int zap_label(struct robot *cur_robot, char *label)
   {
     cur_robot->program_bytecode[dest_label->cmd_position] = ROBOTIC_CMD_ZAPPED_LABEL;
     dest_label->zapped = true;
+
+#ifdef CONFIG_LABEL_INDEX
+    update_label_index_live(cur_robot, dest_label->name, -1);
+#endif
     return 1;
   }
 
@@ -2945,10 +3564,26 @@ char *tr_msg_ext(struct world *mzx_world, char *mesg, int id, char *buffer,
   return src_ptr + 1;
 }
 
+char *tr_msg_length(struct world *mzx_world, char *mesg, int id,
+ char *buffer, size_t *length)
+{
+  tr_msg_ext(mzx_world, mesg, id, buffer, 0);
+  *length = strlen(buffer);
+  return buffer;
+}
+
 #else /* !CONFIG_DEBYTECODE */
 
 char *tr_msg_ext(struct world *mzx_world, char *mesg, int id, char *buffer,
  char terminating_char)
+{
+  size_t length;
+  return tr_msg_length(mzx_world, mesg, id, buffer, &length);
+}
+
+// Same as tr_msg, but also returns the length of the translated message.
+char *tr_msg_length(struct world *mzx_world, char *mesg, int id,
+ char *buffer, size_t *length)
 {
   struct board *src_board = mzx_world->current_board;
   char name_buffer[256];
@@ -2959,6 +3594,7 @@ char *tr_msg_ext(struct world *mzx_world, char *mesg, int id, char *buffer,
   char *old_ptr;
 
   size_t dest_pos = 0;
+  size_t null_pos = ROBOT_MAX_TR;
   size_t name_length;
   int error;
   int val;
@@ -3065,6 +3701,14 @@ char *tr_msg_ext(struct world *mzx_world, char *mesg, int id, char *buffer,
             name_length = ROBOT_MAX_TR - dest_pos - 1;
 
           memcpy(buffer + dest_pos, str_src.value, name_length);
+
+          // Strings can contain nulls, which end the message early.
+          if(null_pos == ROBOT_MAX_TR)
+          {
+            char *null_char = memchr(str_src.value, 0, name_length);
+            if(null_char)
+              null_pos = dest_pos + (null_char - str_src.value);
+          }
           dest_pos += name_length;
         }
         else
@@ -3110,6 +3754,9 @@ char *tr_msg_ext(struct world *mzx_world, char *mesg, int id, char *buffer,
     }
     else
     {
+      if(!current_char)
+        break;
+
       buffer[dest_pos] = current_char;
       src_ptr++;
       dest_pos++;
@@ -3117,6 +3764,7 @@ char *tr_msg_ext(struct world *mzx_world, char *mesg, int id, char *buffer,
   } while(current_char && (dest_pos < ROBOT_MAX_TR - 1));
 
   buffer[dest_pos] = 0;
+  *length = MIN(dest_pos, null_pos);
   return buffer;
 }
 
@@ -3131,7 +3779,17 @@ void add_robot_name_entry(struct board *src_board, struct robot *cur_robot,
   int active = src_board->num_robots_active;
   struct robot **name_list = src_board->robot_list_name_sorted;
 
+#ifdef CONFIG_LABEL_INDEX
+  place_label_index_robot(src_board, cur_robot);
+#endif
+
+#ifdef CONFIG_COUNTER_HASH_TABLES
+  if(insert_robot_name_table(src_board, cur_robot, name))
+    return;
+#endif
+
   find_robot(src_board, name, &first, &last);
+
   // Insert into name list, if it's not at the end
   if(first != active)
   {
@@ -3303,6 +3961,13 @@ void duplicate_robot_direct(struct world *mzx_world, struct robot *cur_robot,
   // We need unique copies of the program and the label cache.
   copy_robot->program_bytecode = cmalloc(program_length);
 
+#ifndef CONFIG_DEBYTECODE
+  // Expressions are recompiled for the copy as they're used, and its labels
+  // are indexed once it's placed on a board.
+  copy_robot->expr_cache = NULL;
+  copy_robot->label_board = NULL;
+#endif
+
   src_program_location = cur_robot->program_bytecode;
   dest_program_location = copy_robot->program_bytecode;
 
@@ -3328,6 +3993,22 @@ void duplicate_robot_direct(struct world *mzx_world, struct robot *cur_robot,
     dest_label->name += program_offset;
   }
 
+#ifdef CONFIG_PREDECODE
+  // The records only hold offsets, so they can be copied as-is.
+  if(cur_robot->instructions)
+  {
+    size_t inst_size = cur_robot->num_instructions *
+     sizeof(struct robot_instruction);
+
+    copy_robot->instructions = cmalloc(inst_size);
+    memcpy(copy_robot->instructions, cur_robot->instructions, inst_size);
+
+    copy_robot->instruction_index = cmalloc(program_length * sizeof(int));
+    memcpy(copy_robot->instruction_index, cur_robot->instruction_index,
+     program_length * sizeof(int));
+  }
+#endif
+
   copy_robot->program_source = NULL;
   copy_robot->program_source_length = 0;
 
@@ -3345,6 +4026,7 @@ void duplicate_robot_direct(struct world *mzx_world, struct robot *cur_robot,
 #ifdef CONFIG_EDITOR
   copy_robot->command_map = NULL;
   copy_robot->command_map_length = 0;
+  copy_robot->profile_id = 0;
 
 #ifdef CONFIG_DEBYTECODE
   if(mzx_world->editing && cur_robot->command_map)
@@ -142,9 +142,16 @@ CORE_LIBSPEC int send_robot_id(struct world *mzx_world, int id,
  const char *mesg, int ignore_lock);
 CORE_LIBSPEC char *tr_msg_ext(struct world *mzx_world, char *mesg, int id,
  char *buffer, char terminating_char);
+char *tr_msg_length(struct world *mzx_world, char *mesg, int id,
+ char *buffer, size_t *length);
 
+CORE_LIBSPEC void update_robot_name_list(struct board *src_board);
+void clear_robot_name_table(struct board *src_board);
+void clear_label_index(struct board *src_board);
 int find_robot(struct board *src_board, const char *name,
  int *first, int *last);
+struct robot **find_robots(struct board *src_board, const char *name,
+ int *count);
 void send_robot_all(struct world *mzx_world, const char *mesg, int ignore_lock);
 int send_robot_self(struct world *mzx_world, struct robot *src_robot,
  const char *mesg, int ignore_lock);
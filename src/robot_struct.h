@@ -58,6 +58,26 @@ struct sensor
   char used;
 };
 
+#ifdef CONFIG_PREDECODE
+#define ROBOT_INSTRUCTION_PARAMS 4
+
+// A command of a legacy robot program, decoded when its labels are cached.
+// Params are offsets from the command byte to each param's length byte, so
+// records stay valid when the program is copied. Numeric params are decoded
+// into value; bit N of immediate is set if param N is numeric.
+struct robot_instruction
+{
+  unsigned char cmd;
+  unsigned char num_params;
+  unsigned char immediate;
+  unsigned char params[ROBOT_INSTRUCTION_PARAMS];
+  short value[ROBOT_INSTRUCTION_PARAMS];
+};
+#endif
+
+struct board;
+struct expr_cache;
+
 struct robot
 {
   int world_version;
@@ -108,6 +128,22 @@ struct robot
   int num_labels;
   struct label **label_list;
 
+#ifndef CONFIG_DEBYTECODE
+  // Compiled expression parameters, built as they're used (see expr.c).
+  struct expr_cache *expr_cache;
+
+  // Board whose label index this robot's labels are kept in (see robot.c).
+  struct board *label_board;
+#endif
+
+#ifdef CONFIG_PREDECODE
+  // Pre-decoded commands (see robot.c). The index maps each bytecode position
+  // that starts a command to its record and is -1 everywhere else.
+  struct robot_instruction *instructions;
+  int *instruction_index;
+  int num_instructions;
+#endif
+
   int stack_size;
   int stack_pointer;
   int *stack;
@@ -124,6 +160,9 @@ struct robot
   int commands_total;
   int commands_cycle;
   int commands_caught;
+
+  // Robot profiler entry for this robot (0 for none)
+  int profile_id;
 #endif
 };
 
@@ -317,6 +317,55 @@ int place_player_xy(struct world *mzx_world, int x, int y)
   return 0;
 }
 
+#ifndef CONFIG_DEBYTECODE
+// Get the robot that owns a param in its bytecode, if any. Only these params
+// can use the robot's cached expressions and counter handles.
+static struct robot *get_param_robot(struct world *mzx_world, char *program,
+ int id)
+{
+  struct board *src_board = mzx_world->current_board;
+  struct robot *cur_robot;
+
+  if(!src_board || id < 0 || id > src_board->num_robots)
+    return NULL;
+
+  cur_robot = src_board->robot_list[id];
+
+  if(cur_robot && cur_robot->program_bytecode &&
+   program > cur_robot->program_bytecode &&
+   program < cur_robot->program_bytecode + cur_robot->program_bytecode_length)
+    return cur_robot;
+
+  return NULL;
+}
+#endif
+
+// Translates a string param (the ptr is at the text following the length)
+// with tr_msg, unless the param doesn't need translation, in which case the
+// text in the bytecode is returned instead of copying it. The result must not
+// be modified.
+static char *tr_param(struct world *mzx_world, char *param, int id,
+ char *buffer, size_t *length)
+{
+#ifndef CONFIG_DEBYTECODE
+  struct robot *cur_robot = get_param_robot(mzx_world, param, id);
+
+  if(cur_robot)
+  {
+    size_t param_length = (unsigned char)param[-1];
+
+    if(param_length &&
+     is_param_literal(mzx_world, cur_robot, param, param_length - 1))
+    {
+      *length = param_length - 1;
+      return param;
+    }
+  }
+#endif
+
+  return tr_msg_length(mzx_world, param, id, buffer, length);
+}
+
 static void send_at_xy(struct world *mzx_world, int id, int x, int y,
  char *label)
 {
@@ -328,18 +377,18 @@ static void send_at_xy(struct world *mzx_world, int id, int x, int y,
   {
     char label_buffer[ROBOT_MAX_TR];
     int d_param = src_board->level_param[offset];
+    size_t label_length;
 
-    tr_msg(mzx_world, label, id, label_buffer);
+    label = tr_param(mzx_world, label, id, label_buffer, &label_length);
 
     if(d_param == id)
     {
       send_robot_self(mzx_world,
-       mzx_world->current_board->robot_list[id], label_buffer, 0);
+       mzx_world->current_board->robot_list[id], label, 0);
     }
     else
     {
-      send_robot_id(mzx_world, src_board->level_param[offset],
-       label_buffer, 0);
+      send_robot_id(mzx_world, src_board->level_param[offset], label, 0);
     }
   }
 }
@@ -374,10 +423,11 @@ static int get_random_range(int min_value, int max_value)
 static int send_self_label_tr(struct world *mzx_world, char *param, int id)
 {
   char label_buffer[ROBOT_MAX_TR];
-  tr_msg(mzx_world, param, id, label_buffer);
+  size_t label_length;
+  char *label = tr_param(mzx_world, param, id, label_buffer, &label_length);
 
   if(send_robot_self(mzx_world,
-   mzx_world->current_board->robot_list[id], label_buffer, 1))
+   mzx_world->current_board->robot_list[id], label, 1))
   {
     return 0;
   }
@@ -994,6 +1044,10 @@ void replace_player(struct world *mzx_world)
 int parse_param(struct world *mzx_world, char *program, int id)
 {
   char ibuff[ROBOT_MAX_TR];
+#ifndef CONFIG_DEBYTECODE
+  struct counter_handle *handle;
+  struct robot *cur_robot;
+#endif
 
   if(program[0] == 0)
   {
@@ -1001,17 +1055,38 @@ int parse_param(struct world *mzx_world, char *program, int id)
     return (signed short)((int)program[1] | (int)(program[2] << 8));
   }
 
+#ifndef CONFIG_DEBYTECODE
+  cur_robot = get_param_robot(mzx_world, program, id);
+#endif
+
   // Expressions - Exo
   if((program[1] == '(') && mzx_world->version >= V268)
   {
     char *e_ptr = program + 2;
     int val, error;
 
+#ifndef CONFIG_DEBYTECODE
+    // Use the robot's compiled copy of this expression, if possible.
+    if(cur_robot &&
+     parse_expression_cached(mzx_world, cur_robot, e_ptr, id, &val))
+      return val;
+#endif
+
     val = parse_expression(mzx_world, &e_ptr, &error, id);
     if(!error && !(*e_ptr))
       return val;
   }
 
+#ifndef CONFIG_DEBYTECODE
+  // Names that don't need translation can use a counter handle instead.
+  if(cur_robot)
+  {
+    handle = get_param_counter_handle(mzx_world, cur_robot, program + 1);
+    if(handle)
+      return get_counter_handle(mzx_world, handle, program + 1, id);
+  }
+#endif
+
   tr_msg(mzx_world, program + 1, id, ibuff);
 
   return get_counter(mzx_world, ibuff, id);
@@ -1026,6 +1101,72 @@ static boolean is_name_param(struct world *mzx_world, char *program)
   ((program[1] != '(') || mzx_world->version < V268);
 }
 
+// Compare two values for IF c?n.
+static boolean compare_if_values(struct world *mzx_world,
+ enum equality comparison, int dest_value, int src_value)
+{
+  if(mzx_world->version < V290)
+  {
+    // In port releases prior to 2.90b there was a horrible
+    // bug stopping comparisons between numbers with a
+    // difference greater than 2^31-1.
+    // To our great regret we must support this functionality
+    // for older worlds.
+    dest_value = dest_value - src_value;
+    src_value = 0;
+  }
+
+  switch(comparison)
+  {
+    case EQUAL:
+    case EXACTLY_EQUAL:
+    case WILD_EQUAL:
+    case WILD_EXACTLY_EQUAL:
+    {
+      if(dest_value == src_value)
+        return true;
+      break;
+    }
+
+    case LESS_THAN:
+    {
+      if(dest_value < src_value)
+        return true;
+      break;
+    }
+
+    case GREATER_THAN:
+    {
+      if(dest_value > src_value)
+        return true;
+      break;
+    }
+
+    case GREATER_THAN_OR_EQUAL:
+    {
+      if(dest_value >= src_value)
+        return true;
+      break;
+    }
+
+    case LESS_THAN_OR_EQUAL:
+    {
+      if(dest_value <= src_value)
+        return true;
+      break;
+    }
+
+    case NOT_EQUAL:
+    {
+      if(dest_value != src_value)
+        return true;
+      break;
+    }
+  }
+
+  return false;
+}
+
 // These will always return numeric values
 enum thing parse_param_thing(struct world *mzx_world, char *program)
 {
@@ -1105,6 +1246,307 @@ static void end_program(struct robot *cur_robot)
   cur_robot->pos_within_line = 0;
 }
 
+#ifdef CONFIG_PREDECODE
+
+enum predecode_result
+{
+  PREDECODE_NEXT,
+  PREDECODE_END_CYCLE,
+  PREDECODE_RETURN,
+  PREDECODE_FALLBACK
+};
+
+// What a pre-decoded command can see of and change in __run_robot.
+struct predecode_state
+{
+  struct world *mzx_world;
+  struct robot *cur_robot;
+  const struct robot_instruction *inst;
+  char *program;
+  char *cmd_ptr;
+  char *level_color;
+  int board_width;
+  int id;
+  int x;
+  int y;
+  boolean first_cmd;
+
+  int gotoed;
+  boolean done;
+  boolean clear_last_label;
+};
+
+typedef enum predecode_result (*predecode_handler)(struct predecode_state *s);
+
+static char *predecode_param_pos(struct predecode_state *s, int num)
+{
+  return s->cmd_ptr + s->inst->params[num];
+}
+
+static boolean predecode_param_is_numeric(struct predecode_state *s, int num)
+{
+  return (s->inst->immediate & (1 << num)) != 0;
+}
+
+static int predecode_param(struct predecode_state *s, int num)
+{
+  if(predecode_param_is_numeric(s, num))
+    return s->inst->value[num];
+
+  return parse_param(s->mzx_world, predecode_param_pos(s, num), s->id);
+}
+
+/* Handlers for commonly used commands. These behave exactly like their cases
+ * in __run_robot and return PREDECODE_FALLBACK, before doing anything that
+ * the switch wouldn't also do, for any form of the command they don't cover.
+ */
+
+static enum predecode_result predecode_wait(struct predecode_state *s)
+{
+  struct robot *cur_robot = s->cur_robot;
+  int wait_time = predecode_param(s, 0) & 0xFF;
+
+  if(wait_time <= cur_robot->pos_within_line)
+    return PREDECODE_NEXT;
+
+  cur_robot->pos_within_line++;
+  if(s->first_cmd)
+    cur_robot->status = 1;
+
+  return PREDECODE_END_CYCLE;
+}
+
+static enum predecode_result predecode_cycle(struct predecode_state *s)
+{
+  s->cur_robot->robot_cycle = predecode_param(s, 0);
+  s->done = true;
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_char(struct predecode_state *s)
+{
+  s->cur_robot->robot_char = predecode_param(s, 0);
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_color(struct predecode_state *s)
+{
+  if(s->id)
+  {
+    int offset = s->x + (s->y * s->board_width);
+    s->level_color[offset] =
+     fix_color(predecode_param(s, 0), s->level_color[offset]);
+  }
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_set(struct predecode_state *s)
+{
+  struct world *mzx_world = s->mzx_world;
+  struct robot *cur_robot = s->cur_robot;
+  char *dest_string = predecode_param_pos(s, 0) + 1;
+  struct counter_handle *dest_handle;
+  int value;
+
+  dest_handle = get_param_counter_handle(mzx_world, cur_robot, dest_string);
+  if(!dest_handle)
+    return PREDECODE_FALLBACK;
+
+  mzx_world->special_counter_return = FOPEN_NONE;
+  value = predecode_param(s, 1);
+
+  if(mzx_world->special_counter_return != FOPEN_NONE)
+  {
+    char dest_buffer[ROBOT_MAX_TR];
+    strcpy(dest_buffer, dest_string);
+
+    s->gotoed = set_counter_special(mzx_world, dest_buffer, value, s->id);
+
+    // On a game state change, we need to return to the main game loop.
+    if(mzx_world->change_game_state)
+      return PREDECODE_RETURN;
+
+    // Some specials might have changed this
+    s->program = cur_robot->program_bytecode;
+
+    // See ROBOTIC_CMD_SET.
+    if(mzx_world->special_counter_return == FOPEN_SAVE_GAME)
+    {
+      if(mzx_world->version < V290)
+      {
+        if(!s->program[cur_robot->cur_prog_line])
+          cur_robot->cur_prog_line = 0;
+
+        return PREDECODE_END_CYCLE;
+      }
+    }
+  }
+  else
+    set_counter_handle(mzx_world, dest_handle, dest_string, value, s->id);
+
+  s->clear_last_label = true;
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_inc(struct predecode_state *s)
+{
+  struct world *mzx_world = s->mzx_world;
+  char *dest_string = predecode_param_pos(s, 0) + 1;
+  struct counter_handle *dest_handle;
+  int value;
+
+  dest_handle = get_param_counter_handle(mzx_world, s->cur_robot, dest_string);
+  if(!dest_handle)
+    return PREDECODE_FALLBACK;
+
+  value = predecode_param(s, 1);
+  inc_counter_handle(mzx_world, dest_handle, dest_string, value, s->id);
+
+  s->clear_last_label = true;
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_dec(struct predecode_state *s)
+{
+  struct world *mzx_world = s->mzx_world;
+  char *dest_string = predecode_param_pos(s, 0) + 1;
+  struct counter_handle *dest_handle;
+  int value;
+
+  dest_handle = get_param_counter_handle(mzx_world, s->cur_robot, dest_string);
+  if(!dest_handle)
+    return PREDECODE_FALLBACK;
+
+  value = predecode_param(s, 1);
+  dec_counter_handle(mzx_world, dest_handle, dest_string, value, s->id);
+
+  s->clear_last_label = true;
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_if(struct predecode_state *s)
+{
+  struct world *mzx_world = s->mzx_world;
+  char *dest_string = predecode_param_pos(s, 0);
+  enum equality comparison;
+  int dest_value;
+  int src_value;
+
+  if(!predecode_param_is_numeric(s, 1))
+    return PREDECODE_FALLBACK;
+
+  // See parse_param_eq.
+  comparison = (enum equality)(unsigned short)s->inst->value[1];
+
+  // Names without a counter handle might be strings.
+  if(is_name_param(mzx_world, dest_string))
+  {
+    struct counter_handle *dest_handle =
+     get_param_counter_handle(mzx_world, s->cur_robot, dest_string + 1);
+
+    if(!dest_handle)
+      return PREDECODE_FALLBACK;
+
+    dest_value =
+     get_counter_handle(mzx_world, dest_handle, dest_string + 1, s->id);
+  }
+  else
+    dest_value = predecode_param(s, 0);
+
+  src_value = predecode_param(s, 2);
+
+  if(compare_if_values(mzx_world, comparison, dest_value, src_value))
+  {
+    s->gotoed =
+     send_self_label_tr(mzx_world, predecode_param_pos(s, 3) + 1, s->id);
+  }
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_goto(struct predecode_state *s)
+{
+  s->gotoed =
+   send_self_label_tr(s->mzx_world, predecode_param_pos(s, 0) + 1, s->id);
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_loop_start(struct predecode_state *s)
+{
+  s->cur_robot->loop_count = 0;
+  return PREDECODE_NEXT;
+}
+
+static enum predecode_result predecode_loop_for(struct predecode_state *s)
+{
+  struct robot *cur_robot = s->cur_robot;
+  char *program = s->program;
+  int loop_amount = predecode_param(s, 0);
+  int loop_count = cur_robot->loop_count;
+  int back_cmd;
+
+  if(loop_count < loop_amount)
+  {
+    back_cmd = cur_robot->cur_prog_line;
+    do
+    {
+      if(program[back_cmd - 1] == 0xFF)
+        break;
+
+      back_cmd -= program[back_cmd - 1] + 2;
+    } while(program[back_cmd + 1] != ROBOTIC_CMD_LOOP_START);
+
+    cur_robot->cur_prog_line = back_cmd;
+  }
+
+  cur_robot->loop_count = loop_count + 1;
+  s->clear_last_label = true;
+  return PREDECODE_NEXT;
+}
+
+// Commands that rewrite their own command byte (labels, message box options)
+// must not be added here.
+static const predecode_handler predecode_handlers[256] =
+{
+  [ROBOTIC_CMD_WAIT]        = predecode_wait,
+  [ROBOTIC_CMD_CYCLE]       = predecode_cycle,
+  [ROBOTIC_CMD_CHAR]        = predecode_char,
+  [ROBOTIC_CMD_COLOR]       = predecode_color,
+  [ROBOTIC_CMD_SET]         = predecode_set,
+  [ROBOTIC_CMD_INC]         = predecode_inc,
+  [ROBOTIC_CMD_DEC]         = predecode_dec,
+  [ROBOTIC_CMD_IF]          = predecode_if,
+  [ROBOTIC_CMD_GOTO]        = predecode_goto,
+  [ROBOTIC_CMD_LOOP_START]  = predecode_loop_start,
+  [ROBOTIC_CMD_LOOP_FOR]    = predecode_loop_for,
+};
+
+// Get the record for the command at a program position, if it has a handler.
+static const struct robot_instruction *predecode_lookup(
+ struct robot *cur_robot, char *program, int pos, int cmd)
+{
+  const struct robot_instruction *inst;
+  int num;
+
+  if(!cur_robot->instruction_index || program != cur_robot->program_bytecode)
+    return NULL;
+
+  if(pos < 0 || pos >= cur_robot->program_bytecode_length)
+    return NULL;
+
+  num = cur_robot->instruction_index[pos];
+  if(num < 0)
+    return NULL;
+
+  // The command byte might have been rewritten since the record was made.
+  inst = cur_robot->instructions + num;
+  if(inst->cmd != (unsigned char)cmd || !predecode_handlers[inst->cmd])
+    return NULL;
+
+  return inst;
+}
+
+#endif /* CONFIG_PREDECODE */
+
 #define ADVANCE_LINE do{ advance_line(cur_robot, program); }while(0);
 
 // NOTE: Should always return after using one of these.
@@ -1113,7 +1555,7 @@ static void end_program(struct robot *cur_robot)
 
 // Run a single robot through a single cycle.
 // If id is negative, only run it if status is 2
-void run_robot(context *ctx, int id, int x, int y)
+static void __run_robot(context *ctx, int id, int x, int y)
 {
   struct world *mzx_world = ctx->world;
   struct board *src_board = mzx_world->current_board;
@@ -1137,6 +1579,10 @@ void run_robot(context *ctx, int id, int x, int y)
   char *level_under_id = src_board->level_under_id;
   int board_width = src_board->board_width;
   int board_height = src_board->board_height;
+#ifdef CONFIG_PREDECODE
+  struct predecode_state state;
+  enum predecode_result result;
+#endif
 
   if((id < 0) && ((src_board->robot_list[-id])->status != 2))
     return;
@@ -1287,6 +1733,11 @@ void run_robot(context *ctx, int id, int x, int y)
     // Get command number
     cmd = cmd_ptr[0];
 
+#ifdef CONFIG_EDITOR
+    if(mzx_world->editing && debug_robot_profile)
+      debug_robot_profile(mzx_world, cur_robot, id, old_pos);
+#endif
+
     // Check to see if the current command triggers a breakpoint.
     if(mzx_world->editing && debug_robot_break)
     {
@@ -1307,7 +1758,49 @@ void run_robot(context *ctx, int id, int x, int y)
       }
     }
 
+#ifdef CONFIG_PREDECODE
+    // Run the command from its pre-decoded record if it has a handler.
+    result = PREDECODE_FALLBACK;
+    state.inst = predecode_lookup(cur_robot, program, old_pos, cmd);
+    if(state.inst)
+    {
+      state.mzx_world = mzx_world;
+      state.cur_robot = cur_robot;
+      state.program = program;
+      state.cmd_ptr = cmd_ptr;
+      state.level_color = level_color;
+      state.board_width = board_width;
+      state.id = id;
+      state.x = x;
+      state.y = y;
+      state.first_cmd = first_cmd;
+      state.gotoed = 0;
+      state.done = false;
+      state.clear_last_label = false;
+
+      result = predecode_handlers[cmd](&state);
+      if(result == PREDECODE_RETURN)
+        return;
+
+      if(result == PREDECODE_END_CYCLE)
+      {
+        END_CYCLE;
+        return;
+      }
+
+      program = state.program;
+      gotoed = state.gotoed;
+      if(state.done)
+        done = 1;
+      if(state.clear_last_label)
+        last_label = -1;
+    }
+
+    // Otherwise, act according to command
+    if(result == PREDECODE_FALLBACK)
+#else
     // Act according to command
+#endif
     switch(cmd)
     {
       case ROBOTIC_CMD_END: // End
@@ -1546,28 +2039,42 @@ void run_robot(context *ctx, int id, int x, int y)
         char *src_string = next_param_pos(cmd_ptr + 1);
         char src_buffer[ROBOT_MAX_TR];
         char dest_buffer[ROBOT_MAX_TR];
-        tr_msg(mzx_world, dest_string, id, dest_buffer);
+        struct counter_handle *dest_handle = NULL;
+
+#ifndef CONFIG_DEBYTECODE
+        dest_handle =
+         get_param_counter_handle(mzx_world, cur_robot, dest_string);
+
+        if(dest_handle)
+          strcpy(dest_buffer, dest_string);
+        else
+#endif
+          tr_msg(mzx_world, dest_string, id, dest_buffer);
 
         // Setting a string
-        if(is_string(dest_buffer))
+        if(!dest_handle && is_string(dest_buffer))
         {
           struct string dest;
 
           // Is it a non-immediate
           if(*src_string)
           {
-            // Translate into src buffer
-            tr_msg(mzx_world, src_string + 1, id, src_buffer);
+            size_t src_length;
+            char *src = tr_param(mzx_world, src_string + 1, id, src_buffer,
+             &src_length);
 
-            if(is_string(src_buffer))
+            if(is_string(src))
             {
-              // Is it another string?
+              // Is it another string? get_string modifies the name.
+              if(src != src_buffer)
+                memcpy(src_buffer, src, src_length + 1);
+
               get_string(mzx_world, src_buffer, &dest, id);
             }
             else
             {
-              dest.value = src_buffer;
-              dest.length = strlen(src_buffer);
+              dest.value = src;
+              dest.length = src_length;
             }
           }
           else
@@ -1627,6 +2134,12 @@ void run_robot(context *ctx, int id, int x, int y)
             }
           }
           else
+
+          if(dest_handle)
+          {
+            set_counter_handle(mzx_world, dest_handle, dest_string, value, id);
+          }
+          else
           {
             set_counter(mzx_world, dest_buffer, value, id);
           }
@@ -1641,7 +2154,22 @@ void run_robot(context *ctx, int id, int x, int y)
         char *src_string = next_param_pos(cmd_ptr + 1);
         char src_buffer[ROBOT_MAX_TR];
         char dest_buffer[ROBOT_MAX_TR];
-        tr_msg(mzx_world, dest_string, id, dest_buffer);
+        struct counter_handle *dest_handle = NULL;
+
+#ifndef CONFIG_DEBYTECODE
+        dest_handle =
+         get_param_counter_handle(mzx_world, cur_robot, dest_string);
+
+        if(!dest_handle)
+#endif
+          tr_msg(mzx_world, dest_string, id, dest_buffer);
+
+        if(dest_handle)
+        {
+          int value = parse_param(mzx_world, src_string, id);
+          inc_counter_handle(mzx_world, dest_handle, dest_string, value, id);
+        }
+        else
 
         // Incrementing a string
         if(is_string(dest_buffer))
@@ -1683,11 +2211,25 @@ void run_robot(context *ctx, int id, int x, int y)
         char *dest_string = cmd_ptr + 2;
         char *src_string = next_param_pos(cmd_ptr + 1);
         char dest_buffer[ROBOT_MAX_TR];
+        struct counter_handle *dest_handle = NULL;
         int value;
 
-        tr_msg(mzx_world, dest_string, id, dest_buffer);
+#ifndef CONFIG_DEBYTECODE
+        dest_handle =
+         get_param_counter_handle(mzx_world, cur_robot, dest_string);
+
+        if(!dest_handle)
+#endif
+          tr_msg(mzx_world, dest_string, id, dest_buffer);
+
         value = parse_param(mzx_world, src_string, id);
 
+        if(dest_handle)
+        {
+          dec_counter_handle(mzx_world, dest_handle, dest_string, value, id);
+        }
+        else
+
         // Decrementing a string
         if(is_string(dest_buffer))
         {
@@ -1714,12 +2256,21 @@ void run_robot(context *ctx, int id, int x, int y)
         char dest_buffer[ROBOT_MAX_TR];
         int success = 0;
         boolean has_dest_buffer = false;
+        struct counter_handle *dest_handle = NULL;
 
         // NOTE: versions prior to 2.92 never did this before is_string.
         if(is_name_param(mzx_world, dest_string))
         {
-          tr_msg(mzx_world, dest_string + 1, id, dest_buffer);
-          has_dest_buffer = true;
+#ifndef CONFIG_DEBYTECODE
+          dest_handle =
+           get_param_counter_handle(mzx_world, cur_robot, dest_string + 1);
+
+          if(!dest_handle)
+#endif
+          {
+            tr_msg(mzx_world, dest_string + 1, id, dest_buffer);
+            has_dest_buffer = true;
+          }
         }
 
         if(has_dest_buffer && is_string(dest_buffer))
@@ -1782,6 +2333,14 @@ void run_robot(context *ctx, int id, int x, int y)
         }
         else
 
+        if(dest_handle)
+        {
+          dest_value =
+           get_counter_handle(mzx_world, dest_handle, dest_string + 1, id);
+          src_value = parse_param(mzx_world, src_string, id);
+        }
+        else
+
         if(has_dest_buffer)
         {
           dest_value = get_counter(mzx_world, dest_buffer, id);
@@ -1794,64 +2353,8 @@ void run_robot(context *ctx, int id, int x, int y)
           src_value = parse_param(mzx_world, src_string, id);
         }
 
-        if(mzx_world->version < V290)
-        {
-          // In port releases prior to 2.90b there was a horrible
-          // bug stopping comparisons between numbers with a
-          // difference greater than 2^31-1.
-          // To our great regret we must support this functionality
-          // for older worlds.
-          dest_value = dest_value - src_value;
-          src_value = 0;
-        }
-
-        switch(comparison)
-        {
-          case EQUAL:
-          case EXACTLY_EQUAL:
-          case WILD_EQUAL:
-          case WILD_EXACTLY_EQUAL:
-          {
-            if(dest_value == src_value)
-              success = 1;
-            break;
-          }
-
-          case LESS_THAN:
-          {
-            if(dest_value < src_value)
-              success = 1;
-            break;
-          }
-
-          case GREATER_THAN:
-          {
-            if(dest_value > src_value)
-              success = 1;
-            break;
-          }
-
-          case GREATER_THAN_OR_EQUAL:
-          {
-            if(dest_value >= src_value)
-              success = 1;
-            break;
-          }
-
-          case LESS_THAN_OR_EQUAL:
-          {
-            if(dest_value <= src_value)
-              success = 1;
-            break;
-          }
-
-          case NOT_EQUAL:
-          {
-            if(dest_value != src_value)
-              success = 1;
-            break;
-          }
-        }
+        success = compare_if_values(mzx_world, comparison,
+         dest_value, src_value);
 
         if(success)
         {
@@ -2457,10 +2960,13 @@ void run_robot(context *ctx, int id, int x, int y)
         char robot_name_buffer[ROBOT_MAX_TR];
         char label_buffer[ROBOT_MAX_TR];
         char *p2 = next_param_pos(cmd_ptr + 1);
-        tr_msg(mzx_world, cmd_ptr + 2, id, robot_name_buffer);
-        tr_msg(mzx_world, p2 + 1, id, label_buffer);
+        size_t name_length, label_length;
+        char *robot_name = tr_param(mzx_world, cmd_ptr + 2, id,
+         robot_name_buffer, &name_length);
+        char *label = tr_param(mzx_world, p2 + 1, id, label_buffer,
+         &label_length);
 
-        send_robot(mzx_world, robot_name_buffer, label_buffer, 0);
+        send_robot(mzx_world, robot_name, label, 0);
 
         // Did the position get changed? (send to self)
         if(old_pos != cur_robot->cur_prog_line)
@@ -3299,7 +3805,7 @@ void run_robot(context *ctx, int id, int x, int y)
 
       case ROBOTIC_CMD_COPYROBOT_NAMED: // copyrobot ""
       {
-        int first, last;
+        int count;
         char robot_name_buffer[ROBOT_MAX_TR];
         // Get the robot name
         tr_msg(mzx_world, cmd_ptr + 2, id, robot_name_buffer);
@@ -3313,10 +3819,12 @@ void run_robot(context *ctx, int id, int x, int y)
         else
         {
           // Find the first robot that matches
-          if(find_robot(src_board, robot_name_buffer, &first, &last))
+          struct robot **found_robots =
+           find_robots(src_board, robot_name_buffer, &count);
+
+          if(found_robots)
           {
-            struct robot *found_robot =
-             src_board->robot_list_name_sorted[first];
+            struct robot *found_robot = found_robots[0];
 
             if(found_robot != cur_robot)
             {
@@ -3735,9 +4243,10 @@ void run_robot(context *ctx, int id, int x, int y)
       case ROBOTIC_CMD_MESSAGE_LINE: // Mesg
       {
         char message_buffer[ROBOT_MAX_TR];
+        size_t message_length;
 
-        tr_msg(mzx_world, cmd_ptr + 2, id, message_buffer);
-        set_mesg_direct(src_board, message_buffer);
+        set_mesg_direct(src_board, tr_param(mzx_world, cmd_ptr + 2, id,
+         message_buffer, &message_length));
         break;
       }
 
@@ -3828,11 +4337,25 @@ void run_robot(context *ctx, int id, int x, int y)
 
         if(board_id != NO_BOARD)
         {
-          set_current_board_ext(mzx_world, mzx_world->board_list[board_id]);
+          struct board *dest_board = mzx_world->board_list[board_id];
+
+          // Don't put the current board in extra memory to do this, since
+          // that can move this robot's program (and the board) elsewhere.
+          if(dest_board != cur_board)
+          {
+            retrieve_board_from_extram(dest_board);
+            if(dest_board->is_lazy)
+              load_board_lazy(mzx_world, dest_board);
+          }
+
+          mzx_world->current_board = dest_board;
           prefix_mid_xy(mzx_world, &teleport_x, &teleport_y, x, y);
 
           // And switch back
-          set_current_board_ext(mzx_world, cur_board);
+          mzx_world->current_board = cur_board;
+          if(dest_board != cur_board)
+            store_board_to_extram(dest_board);
+
           mzx_world->target_board = board_id;
           mzx_world->target_x = teleport_x;
           mzx_world->target_y = teleport_y;
@@ -3909,8 +4432,11 @@ void run_robot(context *ctx, int id, int x, int y)
       case ROBOTIC_CMD_IF_INPUT: // If string "" "l"
       {
         char cmp_buffer[ROBOT_MAX_TR];
-        tr_msg(mzx_world, cmd_ptr + 2, id, cmp_buffer);
-        if(!strcasecmp(cmp_buffer, src_board->input_string))
+        size_t cmp_length;
+        char *cmp = tr_param(mzx_world, cmd_ptr + 2, id, cmp_buffer,
+         &cmp_length);
+
+        if(!strcasecmp(cmp, src_board->input_string))
         {
           char *p2 = next_param_pos(cmd_ptr + 1);
           gotoed = send_self_label_tr(mzx_world, p2 + 1, id);
@@ -3921,8 +4447,11 @@ void run_robot(context *ctx, int id, int x, int y)
       case ROBOTIC_CMD_IF_INPUT_NOT: // If string not "" "l"
       {
         char cmp_buffer[ROBOT_MAX_TR];
-        tr_msg(mzx_world, cmd_ptr + 2, id, cmp_buffer);
-        if(strcasecmp(cmp_buffer, src_board->input_string))
+        size_t cmp_length;
+        char *cmp = tr_param(mzx_world, cmd_ptr + 2, id, cmp_buffer,
+         &cmp_length);
+
+        if(strcasecmp(cmp, src_board->input_string))
         {
           char *p2 = next_param_pos(cmd_ptr + 1);
           gotoed = send_self_label_tr(mzx_world, p2 + 1, id);
@@ -5590,16 +6119,34 @@ void run_robot(context *ctx, int id, int x, int y)
       {
         if(id)
         {
+          struct robot **dest_robots;
           struct robot *dest_robot;
           int dest_x, dest_y;
-          int first, last;
+          int count;
+          int i;
           char robot_name_buffer[ROBOT_MAX_TR];
           tr_msg(mzx_world, cmd_ptr + 2, id, robot_name_buffer);
 
-          find_robot(src_board, robot_name_buffer, &first, &last);
-          while(first <= last)
+          dest_robots = find_robots(src_board, robot_name_buffer, &count);
+          if(!dest_robots)
+          {
+            // When no robot has this name, this has always checked the robot
+            // sorted after where the name would be instead.
+            int first, last;
+
+            update_robot_name_list(src_board);
+            find_robot(src_board, robot_name_buffer, &first, &last);
+
+            if(first < src_board->num_robots_active)
+            {
+              dest_robots = src_board->robot_list_name_sorted + first;
+              count = 1;
+            }
+          }
+
+          for(i = 0; i < count; i++)
           {
-            dest_robot = src_board->robot_list_name_sorted[first];
+            dest_robot = dest_robots[i];
             get_robot_position(dest_robot, &dest_x, &dest_y);
 
             if(dest_robot && ((dest_x == x) || (dest_y == y)))
@@ -5607,7 +6154,6 @@ void run_robot(context *ctx, int id, int x, int y)
               char *p2 = next_param_pos(cmd_ptr + 1);
               gotoed = send_self_label_tr(mzx_world, p2 + 1, id);
             }
-            first++;
           }
         }
         break;
@@ -5838,15 +6384,15 @@ void run_robot(context *ctx, int id, int x, int y)
         int write_y = parse_param(mzx_world, p4, id);
         int offset;
         char string_buffer[ROBOT_MAX_TR];
+        size_t write_length;
         char current_char;
         char *overlay, *overlay_color;
 
         prefix_mid_xy(mzx_world, &write_x, &write_y, x, y);
         offset = write_x + (write_y * board_width);
 
-        tr_msg(mzx_world, write_string, id, string_buffer);
-
-        write_string = string_buffer;
+        write_string = tr_param(mzx_world, write_string, id, string_buffer,
+         &write_length);
         current_char = *write_string;
 
         if(!src_board->overlay_mode)
@@ -6048,3 +6594,28 @@ void run_robot(context *ctx, int id, int x, int y)
 
   END_CYCLE;
 }
+
+void run_robot(context *ctx, int id, int x, int y)
+{
+#ifdef CONFIG_EDITOR
+  struct world *mzx_world = ctx->world;
+
+  if(mzx_world->editing && debug_robot_profile)
+  {
+    struct robot *cur_robot =
+     mzx_world->current_board->robot_list[id < 0 ? -id : id];
+
+    // Time spent before the first command (walking etc.) goes to position 0.
+    debug_robot_profile(mzx_world, cur_robot, id, 0);
+    __run_robot(ctx, id, x, y);
+
+    // The robot may not exist anymore, so only signal the end of the cycle.
+    // The profiler might also have been turned off from the debugger.
+    if(debug_robot_profile)
+      debug_robot_profile(mzx_world, NULL, id, 0);
+    return;
+  }
+#endif
+
+  __run_robot(ctx, id, x, y);
+}
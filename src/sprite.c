@@ -26,6 +26,7 @@
 #include "graphics.h"
 #include "idput.h"
 #include "sprite.h"
+#include "util.h"
 #include "world.h"
 #include "world_struct.h"
 
@@ -109,50 +110,143 @@ static int compare_spr_yorder(const void *dest, const void *src)
   return diff ? diff : (spr_dest->qsort_order - spr_src->qsort_order);
 }
 
-static inline void sort_sprites(struct sprite **sorted_list,
- struct sprite **sprite_list, int spr_yorder)
+/**
+ * Put the active sprites in the order they should be drawn in. The order from
+ * the last frame is kept in the world, so when only a few sprites moved or
+ * changed since then, insertion sort only needs about one comparison for each
+ * of the others. Since qsort_order breaks every tie, this gives the same
+ * order qsort would. Returns the number of active sprites.
+ */
+static int sort_sprites(struct world *mzx_world, struct sprite **sorted_list)
 {
-  // Fill the sorted list with the active sprites in the beginning
-  // and the inactive sprites in the end.
+  struct sprite **sprite_list = mzx_world->sprite_list;
+  unsigned char *draw_order = mzx_world->sprite_draw_order;
+  boolean listed[MAX_SPRITES];
   struct sprite *cur_sprite;
-  int i;
-  int i_active;
-  int i_inactive;
   int (*spr_compare)(const void *, const void *);
+  int num_active = 0;
+  int i;
+  int j;
 
-  for(i = 0, i_active = 0, i_inactive = MAX_SPRITES - 1; i < MAX_SPRITES; i++)
-  {
-    cur_sprite = sprite_list[i];
+  memset(listed, 0, sizeof(listed));
 
-    // This is used to stabilize the sort
-    cur_sprite->qsort_order = i;
+  // This is used to stabilize the sort
+  for(i = 0; i < MAX_SPRITES; i++)
+    sprite_list[i]->qsort_order = i;
+
+  // Start with the sprites from last frame that are still active...
+  for(i = 0; i < mzx_world->sprite_draw_count; i++)
+  {
+    cur_sprite = sprite_list[draw_order[i]];
 
     if(cur_sprite->flags & SPRITE_INITIALIZED)
     {
-      sorted_list[i_active] = cur_sprite;
-      i_active++;
-    }
-    else
-    {
-      sorted_list[i_inactive] = cur_sprite;
-      i_inactive--;
+      sorted_list[num_active++] = cur_sprite;
+      listed[draw_order[i]] = true;
     }
   }
 
-  if(spr_yorder)
+  // ...then add any that were turned on since.
+  for(i = 0; i < MAX_SPRITES; i++)
+  {
+    cur_sprite = sprite_list[i];
+
+    if((cur_sprite->flags & SPRITE_INITIALIZED) && !listed[i])
+      sorted_list[num_active++] = cur_sprite;
+  }
+
+  if(mzx_world->sprite_y_order)
     spr_compare = compare_spr_yorder;
 
   else
     spr_compare = compare_spr_normal;
 
-  qsort(sorted_list, i_active, sizeof(struct sprite *), spr_compare);
+  for(i = 1; i < num_active; i++)
+  {
+    cur_sprite = sorted_list[i];
+
+    for(j = i; j > 0 && spr_compare(&sorted_list[j - 1], &cur_sprite) > 0; j--)
+      sorted_list[j] = sorted_list[j - 1];
+
+    sorted_list[j] = cur_sprite;
+  }
+
+  for(i = 0; i < num_active; i++)
+    draw_order[i] = sorted_list[i]->qsort_order;
+
+  mzx_world->sprite_draw_count = num_active;
+  return num_active;
+}
+
+/**
+ * Check the area of the vlayer an unbound sprite is about to draw against the
+ * copy kept from the last time it was drawn, and update the copy. Returns
+ * true if the sprite would draw something different.
+ */
+static boolean sprite_cache_update(struct world *mzx_world,
+ struct sprite *cur_sprite, int src_offset, int width, int height)
+{
+  int stride = mzx_world->vlayer_width;
+  int color = (cur_sprite->flags & SPRITE_SRC_COLORS) ? -1 : cur_sprite->color;
+  int flags = cur_sprite->flags &
+   (SPRITE_SRC_COLORS | SPRITE_CHAR_CHECK | SPRITE_CHAR_CHECK2);
+  size_t size = (size_t)width * height;
+  char *src_chars = mzx_world->vlayer_chars + src_offset;
+  char *src_colors = mzx_world->vlayer_colors + src_offset;
+  char *chars;
+  char *colors;
+  boolean changed = false;
+  int y;
+
+  if(cur_sprite->cache_offset != src_offset ||
+   cur_sprite->cache_stride != stride ||
+   cur_sprite->cache_width != width ||
+   cur_sprite->cache_height != height ||
+   cur_sprite->cache_color != color ||
+   cur_sprite->cache_flags != flags)
+  {
+    cur_sprite->cache_offset = src_offset;
+    cur_sprite->cache_stride = stride;
+    cur_sprite->cache_width = width;
+    cur_sprite->cache_height = height;
+    cur_sprite->cache_color = color;
+    cur_sprite->cache_flags = flags;
+    changed = true;
+  }
+
+  if(cur_sprite->cache_alloc < size)
+  {
+    cur_sprite->cache_chars = crealloc(cur_sprite->cache_chars, size * 2);
+    cur_sprite->cache_alloc = size;
+    changed = true;
+  }
+
+  chars = cur_sprite->cache_chars;
+  colors = cur_sprite->cache_chars + cur_sprite->cache_alloc;
+  cur_sprite->cache_colors = colors;
+
+  for(y = 0; y < height; y++)
+  {
+    if(changed || memcmp(chars, src_chars, width) ||
+     memcmp(colors, src_colors, width))
+    {
+      memcpy(chars, src_chars, width);
+      memcpy(colors, src_colors, width);
+      changed = true;
+    }
+    chars += width;
+    colors += width;
+    src_chars += stride;
+    src_colors += stride;
+  }
+  return changed;
 }
 
 void draw_sprites(struct world *mzx_world)
 {
   struct board *src_board = mzx_world->current_board;
   int start_x, start_y, offset_x, offset_y;
-  int i, x, y;
+  int i, j, x, y, n;
   int src_offset;
   int screen_offset;
   int overlay_offset;
@@ -163,8 +257,8 @@ void draw_sprites(struct world *mzx_world)
   int src_width;
   int src_height;
   boolean use_vlayer;
-  struct sprite **sprite_list = mzx_world->sprite_list;
   struct sprite *sorted_list[MAX_SPRITES];
+  struct char_element row[SCREEN_W];
   struct sprite *cur_sprite;
   Uint16 ch;
   char color;
@@ -180,20 +274,20 @@ void draw_sprites(struct world *mzx_world)
   Uint32 layer;
   int draw_layer_order;
   boolean unbound;
+  boolean char_check;
+  boolean kept;
   int transparent_color;
+  int num_active;
 
   calculate_xytop(mzx_world, &screen_x, &screen_y);
 
-  sort_sprites(sorted_list, sprite_list, mzx_world->sprite_y_order);
+  num_active = sort_sprites(mzx_world, sorted_list);
 
   // draw this on top of the SCREEN window.
-  for(i = 0; i < MAX_SPRITES; i++)
+  for(i = 0; i < num_active; i++)
   {
     cur_sprite = sorted_list[i];
 
-    if(!(cur_sprite->flags & SPRITE_INITIALIZED))
-      continue;
-
     if(cur_sprite->flags & SPRITE_UNBOUND)
       unbound = true;
     else
@@ -357,80 +451,116 @@ void draw_sprites(struct world *mzx_world)
     else
       transparent_color = -1;
 
-    layer = create_layer(start_x * CHAR_W, start_y * CHAR_H, draw_width,
-     draw_height, draw_layer_order, transparent_color, cur_sprite->offset,
-     unbound);
-    select_layer(layer);
-
     // Offset and skip value for sprite reference
     src_offset = (ref_y + offset_y) * src_width + ref_x + offset_x;
     src_skip = src_width - draw_width;
 
-    // Offset and skip value for the screen
-    screen_offset = start_x + start_y * SCREEN_W;
-    screen_skip = SCREEN_W - draw_width;
+    // If only CHAR_CHECK2 is set, blank chars aren't drawn.
+    char_check = (cur_sprite->flags &
+     (SPRITE_CHAR_CHECK | SPRITE_CHAR_CHECK2)) == SPRITE_CHAR_CHECK2;
 
-    // Offset and skip value for overlay (as it may cover part of a sprite)
-    overlay_skip = board_width - draw_width;
-    if(overlay_mode == 2)
+    // An unbound vlayer sprite draws the same chars as last frame if its area
+    // of the vlayer didn't change, so it can keep its layer from last frame.
+    // Which chars are blank depends on the charset, so don't bother with
+    // sprites that check for them.
+    if(unbound && use_vlayer && !char_check)
     {
-      // Static overlay
-      overlay_offset = ((start_y - viewport_y) * board_width) +
-       start_x - viewport_x;
+      if(sprite_cache_update(mzx_world, cur_sprite, src_offset,
+       draw_width, draw_height))
+        cur_sprite->layer_serial = 0;
+
+      kept = create_layer_cached(&layer, &cur_sprite->layer_serial,
+       start_x * CHAR_W, start_y * CHAR_H, draw_width, draw_height,
+       draw_layer_order, transparent_color, cur_sprite->offset, unbound);
     }
     else
     {
-      // Normal overlay
-      overlay_offset = ((cur_sprite->y + offset_y) * board_width) +
-       cur_sprite->x + offset_x;
+      layer = create_layer(start_x * CHAR_W, start_y * CHAR_H, draw_width,
+       draw_height, draw_layer_order, transparent_color, cur_sprite->offset,
+       unbound);
+      kept = false;
     }
+    select_layer(layer);
 
-    for(y = 0; y < draw_height; y++)
+    if(!kept)
     {
-      for(x = 0; x < draw_width; x++)
+      // Offset and skip value for the screen
+      screen_offset = start_x + start_y * SCREEN_W;
+      screen_skip = SCREEN_W - draw_width;
+
+      // Offset and skip value for overlay (as it may cover part of a sprite)
+      overlay_skip = board_width - draw_width;
+      if(overlay_mode == 2)
       {
-        if(use_vlayer)
-        {
-          color = src_colors[src_offset];
-          ch = src_chars[src_offset];
-        }
-        else
+        // Static overlay
+        overlay_offset = ((start_y - viewport_y) * board_width) +
+         start_x - viewport_x;
+      }
+      else
+      {
+        // Normal overlay
+        overlay_offset = ((cur_sprite->y + offset_y) * board_width) +
+         cur_sprite->x + offset_x;
+      }
+
+      // Work out a row of chars at a time, then copy the row to the layer.
+      for(y = 0; y < draw_height; y++)
+      {
+        for(x = 0; x < draw_width; x += n)
         {
-          color = get_id_color(src_board, src_offset);
-          ch = get_id_char(src_board, src_offset);
-        }
+          n = MIN(draw_width - x, SCREEN_W);
+
+          for(j = 0; j < n; j++)
+          {
+            if(use_vlayer)
+            {
+              color = src_colors[src_offset];
+              ch = src_chars[src_offset];
+            }
+            else
+            {
+              color = get_id_color(src_board, src_offset);
+              ch = get_id_char(src_board, src_offset);
+            }
 
-        if(!(cur_sprite->flags & SPRITE_SRC_COLORS))
-          color = cur_sprite->color;
+            if(!(cur_sprite->flags & SPRITE_SRC_COLORS))
+              color = cur_sprite->color;
 
-        // Legacy sprite "transparency" effect.
-        if(!unbound)
-          if(!(color & 0xF0))
-            color = (color & 0x0F) | (get_color_linear(screen_offset) & 0xF0);
+            // Legacy sprite "transparency" effect.
+            if(!unbound)
+              if(!(color & 0xF0))
+                color = (color & 0x0F) |
+                 (get_color_linear(screen_offset) & 0xF0);
 
-        if(unbound || (cur_sprite->flags & SPRITE_OVER_OVERLAY) ||
-         !(overlay_mode && overlay_mode != 3 && overlay[overlay_offset] != 32))
-        {
-          if(unbound || ch != 32)
-          {
-            if((cur_sprite->flags &
-             (SPRITE_CHAR_CHECK | SPRITE_CHAR_CHECK2)) != SPRITE_CHAR_CHECK2 ||
-             !is_blank((ch + cur_sprite->offset) % PROTECTED_CHARSET_POSITION))
+            row[j].char_value = INVISIBLE_CHAR;
+            row[j].bg_color = 0xFF;
+            row[j].fg_color = 0xFF;
+
+            if(unbound || (cur_sprite->flags & SPRITE_OVER_OVERLAY) ||
+             !(overlay_mode && overlay_mode != 3 &&
+             overlay[overlay_offset] != 32))
             {
-              if(!unbound)
-                draw_char_linear_ext(color, ch, screen_offset, 0, 0);
-              else
-                draw_char_to_layer(color, ch, x, y, 0, 0);
+              if(unbound || ch != 32)
+              {
+                if(!char_check || !is_blank((ch + cur_sprite->offset) %
+                 PROTECTED_CHARSET_POSITION))
+                {
+                  row[j].char_value = (Uint8)ch;
+                  row[j].bg_color = (Uint8)color >> 4;
+                  row[j].fg_color = color & 0x0F;
+                }
+              }
             }
+            src_offset++;
+            screen_offset++;
+            overlay_offset++;
           }
+          draw_layer_row(row, n, x, y, !unbound);
         }
-        src_offset++;
-        screen_offset++;
-        overlay_offset++;
+        src_offset += src_skip;
+        screen_offset += screen_skip;
+        overlay_offset += overlay_skip;
       }
-      src_offset += src_skip;
-      screen_offset += screen_skip;
-      overlay_offset += overlay_skip;
     }
 
     if(unbound)
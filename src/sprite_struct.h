@@ -21,6 +21,9 @@
 #define __SPRITE_STRUCT_H
 
 #include "compat.h"
+#include "platform.h"
+
+#include <stddef.h>
 
 __M_BEGIN_DECLS
 
@@ -44,6 +47,19 @@ struct sprite
   int offset;
   int qsort_order;
   int z;
+
+  // What an unbound vlayer sprite drew last frame, so draw_sprites can skip
+  // drawing it again if nothing changed.
+  Uint32 layer_serial;
+  int cache_offset;
+  int cache_stride;
+  int cache_width;
+  int cache_height;
+  int cache_color;
+  int cache_flags;
+  char *cache_chars;
+  char *cache_colors;
+  size_t cache_alloc;
 };
 
 struct collision_list
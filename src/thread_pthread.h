@@ -27,6 +27,7 @@ __M_BEGIN_DECLS
 
 #include <sched.h>
 #include <time.h>
+#include <unistd.h>
 #include "pthread.h"
 
 #define THREAD_RES void *
@@ -122,6 +123,15 @@ static inline void platform_yield(void)
   sched_yield();
 }
 
+static inline int platform_get_cpu_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+  return sysconf(_SC_NPROCESSORS_ONLN);
+#else
+  return 1;
+#endif
+}
+
 __M_END_DECLS
 
 #endif // __THREAD_PTHREAD_H
@@ -24,6 +24,7 @@
 
 __M_BEGIN_DECLS
 
+#include <SDL_cpuinfo.h>
 #include <SDL_thread.h>
 #include <SDL_version.h>
 
@@ -127,6 +128,15 @@ static inline void platform_yield(void)
   // FIXME
 }
 
+static inline int platform_get_cpu_count(void)
+{
+#if SDL_VERSION_ATLEAST(2,0,0)
+  return SDL_GetCPUCount();
+#else
+  return 1;
+#endif
+}
+
 __M_END_DECLS
 
 #endif // __THREAD_SDL_H
@@ -30,12 +30,18 @@
 #include <unistd.h>
 #endif
 
+#ifdef __WIN32__
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
 #include <inttypes.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "const.h" // for MAX_PATH
 #include "error.h"
+#include "platform.h"
 #include "io/path.h"
 
 struct mzx_resource
@@ -452,6 +458,34 @@ unsigned int Random(uint64_t range)
   return ((x * 0x2545F4914F6CDD1D) >> 32) * range / 0xFFFFFFFF;
 }
 
+/**
+ * Monotonic time in nanoseconds for timing code. This uses the best clock
+ * the platform provides and falls back to get_ticks otherwise.
+ */
+uint64_t get_time_ns(void)
+{
+#if defined(__WIN32__)
+  static LARGE_INTEGER frequency;
+  LARGE_INTEGER count;
+
+  if(!frequency.QuadPart)
+    QueryPerformanceFrequency(&frequency);
+
+  QueryPerformanceCounter(&count);
+  return (uint64_t)(count.QuadPart / frequency.QuadPart) * 1000000000 +
+   (uint64_t)(count.QuadPart % frequency.QuadPart) * 1000000000 /
+   frequency.QuadPart;
+
+#elif defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+#else
+  return (uint64_t)get_ticks() * 1000000;
+#endif
+}
+
 int create_path_if_not_exists(const char *filename)
 {
   struct stat stat_info;
@@ -101,6 +101,8 @@ uint64_t rng_get_seed(void);
 void rng_set_seed(uint64_t seed);
 unsigned int Random(uint64_t range);
 
+CORE_LIBSPEC uint64_t get_time_ns(void);
+
 CORE_LIBSPEC int create_path_if_not_exists(const char *filename);
 
 typedef void (*fn_ptr)(void);
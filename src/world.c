@@ -45,6 +45,7 @@
 #include "game_player.h"
 #include "graphics.h"
 #include "idput.h"
+#include "mzm.h"
 #include "robot.h"
 #include "sprite.h"
 #include "str.h"
@@ -53,7 +54,9 @@
 #include "io/fsafeopen.h"
 #include "io/memfile.h"
 #include "io/path.h"
+#include "io/vfile.h"
 #include "io/zip.h"
+#include "io/zip_threads.h"
 
 #include "audio/audio.h"
 #include "audio/sfx.h"
@@ -1882,7 +1885,9 @@ static int save_world_zip(struct world *mzx_world, const char *file,
 {
   FILE *fp;
   struct zip_archive *zp = NULL;
+  struct zip_worker *worker = NULL;
   struct board *cur_board;
+  enum zip_error result;
   int i;
 
   int meter_curr = 0;
@@ -1932,6 +1937,11 @@ static int save_world_zip(struct world *mzx_world, const char *file,
   if(!zp)
     goto err_close;
 
+  // Files are compressed on other threads while the rest of the world is
+  // being saved, but they're still written in this order.
+  worker = zip_threads_init(get_config()->zip_threads);
+  zip_set_worker(zp, worker);
+
   if(save_world_info(mzx_world, zp, savegame, file_version, "world"))
     goto err_close;
 
@@ -1960,8 +1970,22 @@ static int save_world_zip(struct world *mzx_world, const char *file,
     cur_board = mzx_world->board_list[i];
 
     if(cur_board)
-      if(save_board(mzx_world, cur_board, zp, savegame, file_version, i))
+    {
+      // The original of a temporary board is in extra memory too.
+      boolean is_extram = (cur_board != mzx_world->current_board);
+      int ret;
+
+      if(is_extram)
+        retrieve_board_from_extram(cur_board);
+
+      ret = save_board(mzx_world, cur_board, zp, savegame, file_version, i);
+
+      if(is_extram)
+        store_board_to_extram(cur_board);
+
+      if(ret)
         goto err_close;
+    }
 
     meter_update_screen(&meter_curr, meter_target);
   }
@@ -1977,9 +2001,13 @@ static int save_world_zip(struct world *mzx_world, const char *file,
 
   meter_update_screen(&meter_curr, meter_target);
 
-  meter_restore_screen();
+  // With a worker, errors writing the last files will only show up here.
+  result = zip_close(zp, NULL);
+  zip_threads_free(worker);
+  if(result)
+    goto err;
 
-  zip_close(zp, NULL);
+  meter_restore_screen();
   return 0;
 
 err_close:
@@ -1988,6 +2016,8 @@ err_close:
   else
     fclose(fp);
 
+  zip_threads_free(worker);
+
 err:
   error_message(E_WORLD_IO_SAVING, 0, NULL);
   meter_restore_screen();
@@ -2001,9 +2031,149 @@ err:
 #define if_savegame_or_291  if(!savegame && mzx_world->version < V291) \
                              { zip_skip_file(zp); break; }
 
+/**
+ * With lazy_boards, try_load_zip_world maps the world file into memory and
+ * only the board info of each board is loaded with the rest of the world. The
+ * archive stays open after loading so the rest of each board can be loaded
+ * from it the first time the board becomes the current board.
+ */
+struct board_source
+{
+  struct zip_archive *zp;
+  boolean savegame;
+  int file_version;
+
+  // Board IDs changed by refactor_board_list while the board source was open,
+  // which still need to be fixed in the boards loaded from it.
+  int *board_id_translation_list;
+  int num_boards;
+};
+
+/**
+ * Close a world archive opened by try_load_zip_world. If it was read from a
+ * mapping of the world file, unmap the world file too.
+ */
+static void close_world_zip(struct zip_archive *zp)
+{
+  if(zp->is_memory)
+  {
+    struct memfile *mf = vfile_get_memfile(zp->vf);
+    void *map = mf->start;
+    size_t map_len = mf->end - mf->start;
+
+    zip_close(zp, NULL);
+    vfunmap(map, map_len);
+  }
+  else
+    zip_close(zp, NULL);
+}
+
+static void free_board_source(struct world *mzx_world)
+{
+  struct board_source *src = mzx_world->board_source;
+
+  if(src)
+  {
+    close_world_zip(src->zp);
+    free(src->board_id_translation_list);
+    free(src);
+    mzx_world->board_source = NULL;
+  }
+}
+
+/**
+ * Fix the entrances and exits of a board after board IDs have changed.
+ */
+static void refactor_board(struct board *cur_board,
+ int *board_id_translation_list, int num_boards)
+{
+  char *level_id = cur_board->level_id;
+  char *level_param = cur_board->level_param;
+  int board_size = cur_board->board_width * cur_board->board_height;
+  int offset;
+  int d_param;
+  int i;
+
+  // Fix entrances
+  for(offset = 0; offset < board_size; offset++)
+  {
+    if(flags[(int)level_id[offset]] & A_ENTRANCE)
+    {
+      d_param = level_param[offset];
+      if(d_param < num_boards)
+        level_param[offset] = board_id_translation_list[d_param];
+      else
+        level_param[offset] = NO_BOARD;
+    }
+  }
+
+  // Fix exits
+  for(i = 0; i < 4; i++)
+  {
+    d_param = cur_board->board_dir[i];
+
+    if(d_param < num_boards)
+      cur_board->board_dir[i] = board_id_translation_list[d_param];
+    else
+      cur_board->board_dir[i] = NO_BOARD;
+  }
+}
+
+void load_board_lazy(struct world *mzx_world, struct board *cur_board)
+{
+  struct board_source *src = mzx_world->board_source;
+  unsigned int file_id;
+  unsigned int board_id;
+
+  assert(src);
+  cur_board->is_lazy = false;
+
+  zip_set_position(src->zp, cur_board->lazy_pos);
+  zip_get_next_prop(src->zp, &file_id, &board_id, NULL);
+
+  load_board_direct(mzx_world, cur_board, src->zp, src->savegame,
+   src->file_version, board_id);
+
+  if(src->board_id_translation_list)
+  {
+    refactor_board(cur_board, src->board_id_translation_list,
+     src->num_boards);
+  }
+}
+
+/**
+ * Load every board that hasn't been loaded yet and close the world file they
+ * were being loaded from. This needs to happen before anything could write to
+ * the world file (i.e. saving) or touch boards other than the current board
+ * (i.e. the editor).
+ */
+void load_all_boards(struct world *mzx_world)
+{
+  struct board *cur_board;
+  int i;
+
+  if(!mzx_world->board_source)
+    return;
+
+  for(i = 0; i < mzx_world->num_boards; i++)
+  {
+    cur_board = mzx_world->board_list[i];
+
+    if(cur_board && cur_board->is_lazy)
+    {
+      retrieve_board_from_extram(cur_board);
+      load_board_lazy(mzx_world, cur_board);
+      store_board_to_extram(cur_board);
+    }
+  }
+
+  free_board_source(mzx_world);
+}
+
 static int load_world_zip(struct world *mzx_world, struct zip_archive *zp,
  boolean savegame, int file_version, boolean *faded)
 {
+  struct zip_worker *worker;
   unsigned int file_id;
   unsigned int board_id;
   enum zip_error err;
@@ -2013,9 +2183,21 @@ static int load_world_zip(struct world *mzx_world, struct zip_archive *zp,
   int meter_curr = 0;
   int meter_target = 2;
 
+  // try_load_zip_world only reads the world from memory if it was mapped for
+  // lazy board loading.
+  boolean lazy = zp->is_memory;
+
   meter_initial_draw(meter_curr, meter_target, "Loading...");
 
   // The directory has already been read by this point, and we're at the start.
+  // Compressed files are read ahead and decompressed on other threads. This
+  // would mostly decompress boards that aren't being loaded yet if lazy.
+  worker = NULL;
+  if(!lazy)
+  {
+    worker = zip_threads_init(get_config()->zip_threads);
+    zip_set_worker(zp, worker);
+  }
 
   while(ZIP_SUCCESS == zip_get_next_prop(zp, &file_id, &board_id, NULL))
   {
@@ -2098,8 +2280,16 @@ static int load_world_zip(struct world *mzx_world, struct zip_archive *zp,
       {
         if((int)board_id < mzx_world->num_boards)
         {
-          mzx_world->board_list[board_id] =
-           load_board_allocate(mzx_world, zp, savegame, file_version, board_id);
+          if(lazy)
+          {
+            mzx_world->board_list[board_id] = load_board_lazy_allocate(
+             mzx_world, zp, savegame, file_version, board_id);
+          }
+          else
+          {
+            mzx_world->board_list[board_id] = load_board_allocate(
+             mzx_world, zp, savegame, file_version, board_id);
+          }
 
           store_board_to_extram(mzx_world->board_list[board_id]);
           meter_update_screen(&meter_curr, meter_target);
@@ -2170,7 +2360,18 @@ static int load_world_zip(struct world *mzx_world, struct zip_archive *zp,
 
   meter_restore_screen();
 
+  if(lazy)
+  {
+    struct board_source *src = ccalloc(1, sizeof(struct board_source));
+    src->zp = zp;
+    src->savegame = savegame;
+    src->file_version = file_version;
+    mzx_world->board_source = src;
+    return 0;
+  }
+
   zip_close(zp, NULL);
+  zip_threads_free(worker);
   return 0;
 }
 
@@ -2217,6 +2418,9 @@ int save_world(struct world *mzx_world, const char *file, boolean savegame,
   }
 #endif /* CONFIG_DEBYTECODE */
 
+  // The file being saved to might be the mapped world file.
+  load_all_boards(mzx_world);
+
   // Prepare input pos
   if(!mzx_world->input_is_dir && mzx_world->input_file)
   {
@@ -2313,17 +2517,12 @@ void refactor_board_list(struct world *mzx_world,
  int *board_id_translation_list)
 {
   int i;
-  int i2;
-  int offset;
-  char *level_id;
-  char *level_param;
-  int d_param, d_flag;
-  int board_width;
-  int board_height;
+  int d_param;
   int new_current_id = NO_BOARD;
 
   int num_boards = mzx_world->num_boards;
   struct board **board_list = mzx_world->board_list;
+  struct board_source *src = mzx_world->board_source;
   struct board *cur_board;
 
   if(board_list[mzx_world->current_board_id])
@@ -2336,45 +2535,45 @@ void refactor_board_list(struct world *mzx_world,
   mzx_world->num_boards = new_list_size;
   mzx_world->num_boards_allocated = new_list_size;
 
-  // Fix all entrances and exits in each board
-  for(i = 0; i < new_list_size; i++)
+  // Boards that haven't been loaded yet are fixed when they're loaded.
+  if(src)
   {
-    cur_board = board_list[i];
-    board_width = cur_board->board_width;
-    board_height = cur_board->board_height;
-
-    if(i != new_current_id)
-      retrieve_board_from_extram(cur_board);
+    int *prev_list = src->board_id_translation_list;
+    int *list;
 
-    level_id = cur_board->level_id;
-    level_param = cur_board->level_param;
-
-    // Fix entrances
-    for(offset = 0; offset < board_width * board_height; offset++)
+    if(prev_list)
     {
-      d_flag = flags[(int)level_id[offset]];
-
-      if(d_flag & A_ENTRANCE)
+      list = cmalloc(src->num_boards * sizeof(int));
+      for(i = 0; i < src->num_boards; i++)
       {
-        d_param = level_param[offset];
-        if(d_param < num_boards)
-          level_param[offset] = board_id_translation_list[d_param];
-        else
-          level_param[offset] = NO_BOARD;
+        d_param = prev_list[i];
+        list[i] = (d_param < num_boards) ?
+         board_id_translation_list[d_param] : NO_BOARD;
       }
     }
-
-    // Fix exits
-    for(i2 = 0; i2 < 4; i2++)
+    else
     {
-      d_param = cur_board->board_dir[i2];
-
-      if(d_param < num_boards)
-        cur_board->board_dir[i2] = board_id_translation_list[d_param];
-      else
-        cur_board->board_dir[i2] = NO_BOARD;
+      src->num_boards = num_boards;
+      list = cmalloc(num_boards * sizeof(int));
+      memcpy(list, board_id_translation_list, num_boards * sizeof(int));
     }
 
+    free(prev_list);
+    src->board_id_translation_list = list;
+  }
+
+  // Fix all entrances and exits in each board
+  for(i = 0; i < new_list_size; i++)
+  {
+    cur_board = board_list[i];
+    if(cur_board->is_lazy)
+      continue;
+
+    if(i != new_current_id)
+      retrieve_board_from_extram(cur_board);
+
+    refactor_board(cur_board, board_id_translation_list, num_boards);
+
     if(i != new_current_id)
       store_board_to_extram(cur_board);
   }
@@ -2521,6 +2720,9 @@ static void load_world(struct world *mzx_world, struct zip_archive *zp,
       chdir(file_path);
   }
 
+  // Cached MZMs are keyed by their paths relative to the old directory.
+  mzm_cache_clear();
+
   // load world config file
   memcpy(config_file_name, file, file_name_len);
   strncpy(config_file_name + file_name_len, ".cnf", 5);
@@ -2716,7 +2918,29 @@ static struct zip_archive *try_load_zip_world(struct world *mzx_world,
   *file_version = 0;
   v = 0;
 
-  zp = zip_open_fp_read(fp);
+  // With lazy_boards, read the world from a mapping of the world file so the
+  // boards can be loaded from it as they're needed (see load_world_zip).
+  if(get_config()->lazy_boards && !mzx_world->editing)
+  {
+    size_t map_len;
+    void *map = vfmap(fp, &map_len);
+
+    if(map)
+    {
+      fclose(fp);
+      fp = NULL;
+
+      zp = zip_open_mem_read(map, map_len);
+      if(!zp)
+      {
+        vfunmap(map, map_len);
+        goto err_close;
+      }
+    }
+  }
+
+  if(!zp)
+    zp = zip_open_fp_read(fp);
 
   if(!zp)
   {
@@ -2790,7 +3014,7 @@ err_protected:
   *protected = pr;
   if(zp)
   {
-    zip_close(zp, NULL);
+    close_world_zip(zp);
   }
   else
 
@@ -3169,6 +3393,8 @@ void clear_world(struct world *mzx_world)
   mzx_world->current_board = NULL;
   mzx_world->board_list = NULL;
 
+  free_board_source(mzx_world);
+
   clear_robot_contents(&mzx_world->global_robot);
 
   if(!mzx_world->input_is_dir && mzx_world->input_file)
@@ -3216,12 +3442,14 @@ void clear_global_data(struct world *mzx_world)
 
   for(i = 0; i < MAX_SPRITES; i++)
   {
+    free(sprite_list[i]->cache_chars);
     free(sprite_list[i]);
   }
 
   free(sprite_list);
   mzx_world->sprite_list = NULL;
   mzx_world->num_sprites = 0;
+  mzx_world->sprite_draw_count = 0;
 
   free(mzx_world->collision_list);
   mzx_world->collision_list = NULL;
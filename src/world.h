@@ -174,6 +174,7 @@ CORE_LIBSPEC void default_scroll_values(struct world *mzx_world);
 CORE_LIBSPEC void change_board(struct world *mzx_world, int board_id);
 CORE_LIBSPEC void change_board_set_values(struct world *mzx_world);
 CORE_LIBSPEC void change_board_load_assets(struct world *mzx_world);
+CORE_LIBSPEC void load_all_boards(struct world *mzx_world);
 
 CORE_LIBSPEC void remap_vlayer(struct world *mzx_world,
  int new_width, int new_height);
@@ -32,6 +32,8 @@ __M_BEGIN_DECLS
 #include "io/dir.h"
 #include "audio/sfx.h"
 
+struct board_source;
+
 enum change_game_state_value
 {
   CHANGE_STATE_NONE,
@@ -108,6 +110,8 @@ struct world
   struct sprite **sprite_list;
   int active_sprites;
   int sprite_y_order;
+  int sprite_draw_count;
+  unsigned char sprite_draw_order[MAX_SPRITES];
   int collision_count;
   int *collision_list;
   int multiplier;
@@ -140,6 +144,9 @@ struct world
   int current_board_id;
   int temporary_board;
 
+  // Source of boards that haven't been loaded yet (see lazy_boards).
+  struct board_source *board_source;
+
   struct robot global_robot;
 
   int custom_sfx_on;
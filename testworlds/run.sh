@@ -43,7 +43,9 @@ if [ -n "$2" ]; then
 	preload="./$2";
 fi
 
-# Coupled with the software renderer, this will disable video in MZX, speeding things up
+# The headless renderer draws every frame to memory without a display, so the tests
+# exercise the real drawing code. Builds without it fall back to the first renderer,
+# which with the dummy SDL video driver will disable video in MZX, speeding things up
 # and allowing for automated testing. Disabling the SDL audio driver will prevent annoying
 # noises from occuring during tests, but shouldn't affect audio-related tests.
 export SDL_VIDEODRIVER=dummy
@@ -60,7 +62,7 @@ printf "Running test worlds"
 LD_PRELOAD="$preload" \
 ./mzxrun \
   "$TESTS_DIR/tests.mzx" \
-  video_output=software \
+  video_output=headless \
   update_auto_check=off \
   standalone_mode=1 \
   no_titlescreen=1 \
@@ -405,6 +405,11 @@ UNITTEST(Settings)
     TEST_ENUM("gl_vsync", conf->gl_vsync, data);
   }
 
+  SECTION(render_threads)
+  {
+    TEST_INT("render_threads", conf->render_threads, 0, 64);
+  }
+
   SECTION(allow_screenshots)
   {
     TEST_ENUM("allow_screenshots", conf->allow_screenshots, boolean_data);
@@ -527,6 +532,16 @@ UNITTEST(Settings)
     TEST_INT("mzx_speed", conf->mzx_speed, 1, 16);
   }
 
+  SECTION(frame_skip)
+  {
+    TEST_INT("frame_skip", conf->frame_skip, 0, 16);
+  }
+
+  SECTION(frame_histogram)
+  {
+    TEST_ENUM("frame_histogram", conf->frame_histogram, boolean_data);
+  }
+
   SECTION(allow_cheats)
   {
     static const config_test_single data[] =
@@ -587,6 +602,26 @@ UNITTEST(Settings)
     TEST_STRING("save_slots_ext", conf->save_slots_ext, string_data);
   }
 
+  SECTION(zip_threads)
+  {
+    TEST_INT("zip_threads", conf->zip_threads, 0, 64);
+  }
+
+  SECTION(lazy_boards)
+  {
+    TEST_ENUM("lazy_boards", conf->lazy_boards, boolean_data);
+  }
+
+  SECTION(board_compression)
+  {
+    TEST_INT("board_compression", conf->board_compression, 0, 9);
+  }
+
+  SECTION(mzm_cache_size)
+  {
+    TEST_INT("mzm_cache_size", conf->mzm_cache_size, 0, 1048576);
+  }
+
   // Editor options used by core.
 
   SECTION(test_mode)
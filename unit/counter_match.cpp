@@ -0,0 +1,306 @@
+/* MegaZeux
+ *
+ * Copyright (C) 1996 Greg Janson
+ * Copyright (C) 1999 Charles Goetzman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Test the function counter perfect hash against the first letter index and
+ * binary search it replaced. The hash should find exactly the same counter
+ * for any name.
+ *
+ * Built with UNIT_BENCHMARK (make unitbench), this also compares how long
+ * both take to find builtin counters and to reject user counters.
+ */
+
+#include "Unit.hpp"
+#include "../src/counter_match.c"
+
+#include <string>
+
+#ifdef UNIT_BENCHMARK
+#include <chrono>
+#endif
+
+/**
+ * Names of builtin_counters in counter.c, in the same order.
+ */
+static const char * const builtin_names[] =
+{
+#define COUNTER(name, version, read, write) name,
+#include "../src/counter_list.h"
+#undef COUNTER
+};
+
+static const char * const user_names[] =
+{
+  "health", "score", "x", "y", "loop", "i", "j", "temp", "tmp", "count",
+  "state", "timer", "frame", "enemy_hp", "boss_phase", "playerhp", "dx",
+  "dy", "spr_timer", "spritecount", "board_state", "fwrite_buffer", "lives",
+  "level", "keys_held", "inventory", "arrow_x", "arrow_y", "wave", "zzz",
+};
+
+/**
+ * The lookup removed from counter.c, for comparison.
+ */
+struct legacy_index
+{
+  int first_letter[512];
+};
+
+static void legacy_init(legacy_index &index)
+{
+  int num_names = arraysize(builtin_names);
+  char cur_char = builtin_names[0][0];
+  char old_char;
+  int i, i2;
+
+  for(i = 0, i2 = 0; i < 256; i++)
+  {
+    if(i != cur_char)
+    {
+      index.first_letter[i * 2] = -1;
+      index.first_letter[(i * 2) + 1] = -1;
+    }
+    else
+    {
+      index.first_letter[i * 2] = i2;
+      old_char = cur_char;
+
+      while(cur_char == old_char)
+      {
+        i2++;
+        if(i2 == num_names)
+          break;
+        cur_char = builtin_names[i2][0];
+      }
+
+      index.first_letter[(i * 2) + 1] = i2 - 1;
+    }
+  }
+}
+
+static int legacy_find(const legacy_index &index, const char *name)
+{
+  int first_letter = tolower((int)name[0]) * 2;
+  int bottom, top, middle;
+  int cmpval;
+
+  bottom = index.first_letter[first_letter];
+  top = index.first_letter[first_letter + 1];
+
+  if(bottom != -1)
+  {
+    while(bottom <= top)
+    {
+      middle = (top + bottom) / 2;
+      cmpval = match_function_counter(name + 1, builtin_names[middle] + 1);
+
+      if(cmpval > 0)
+        bottom = middle + 1;
+      else
+
+      if(cmpval < 0)
+        top = middle - 1;
+      else
+        return middle;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Generate names from a pattern by replacing each wildcard.
+ */
+static void expand_pattern(std::vector<std::string> &out, const char *pattern)
+{
+  static const char * const numbers[] = { "", "0", "7", "12", "-1", "255" };
+  static const char * const rest[] = { "", "x", ".abc", "5", "_id" };
+  std::string name;
+  int i, j;
+
+  for(i = 0; i < arraysize(numbers); i++)
+  {
+    for(j = 0; j < arraysize(rest); j++)
+    {
+      const char *p;
+      name.clear();
+
+      for(p = pattern; *p; p++)
+      {
+        if(*p == '!' || *p == '?')
+          name += numbers[i];
+        else
+
+        if(*p == '*')
+          name += rest[j];
+        else
+          name += (p - pattern) & 1 ? toupper(*p) : *p;
+      }
+      out.push_back(name);
+    }
+  }
+}
+
+static void generate_names(std::vector<std::string> &out)
+{
+  std::string name;
+  int i;
+
+  for(i = 0; i < arraysize(builtin_names); i++)
+  {
+    expand_pattern(out, builtin_names[i]);
+
+    // Near misses.
+    name = builtin_names[i];
+    out.push_back(name + "z");
+    out.push_back(name.substr(0, name.length() - 1));
+    out.push_back("q" + name);
+  }
+
+  for(i = 0; i < arraysize(user_names); i++)
+    out.push_back(user_names[i]);
+
+  // Random junk, including characters that compare equal to numbers.
+  srand(1234);
+  for(i = 0; i < 20000; i++)
+  {
+    static const char chars[] = "abcdeilmoprsxyz_.,!?*$-0123456789\x12\x0d";
+    int length = rand() % 12;
+    int j;
+
+    name.clear();
+    for(j = 0; j < length; j++)
+      name += chars[rand() % (arraysize(chars) - 1)];
+
+    out.push_back(name);
+  }
+}
+
+/**
+ * counter_fsg builds this table from builtin_counters[] at startup. If that
+ * ever failed, every function counter lookup would fall back to a linear
+ * search, so the shipped list must always produce a valid table.
+ */
+UNITTEST(BuiltinCountersValid)
+{
+  struct function_counter_index index;
+  boolean ret = init_function_counter_index(&index, builtin_names,
+   sizeof(const char *), arraysize(builtin_names));
+
+  ASSERT(ret);
+  ASSERT(index.valid);
+  ASSERT(index.num_other <= 8);
+}
+
+UNITTEST(Lookup)
+{
+  struct function_counter_index index;
+  legacy_index legacy;
+  std::vector<std::string> names;
+  size_t i;
+
+  init_function_counter_index(&index, builtin_names, sizeof(const char *),
+   arraysize(builtin_names));
+  legacy_init(legacy);
+  generate_names(names);
+
+  SECTION(Builtin)
+  {
+    for(i = 0; i < (size_t)arraysize(builtin_names); i++)
+    {
+      std::vector<std::string> expanded;
+      expand_pattern(expanded, builtin_names[i]);
+
+      // Not every expansion is valid (e.g. "!" with no number), but the
+      // first one with a number should always find the original pattern.
+      ASSERTEQX(find_function_counter_index(&index, expanded[5].c_str()),
+       (int)i, expanded[5].c_str());
+    }
+  }
+
+  SECTION(MatchesLegacy)
+  {
+    for(i = 0; i < names.size(); i++)
+    {
+      const char *name = names[i].c_str();
+      ASSERTEQX(find_function_counter_index(&index, name),
+       legacy_find(legacy, name), name);
+    }
+  }
+}
+
+#ifdef UNIT_BENCHMARK
+
+UNITTEST(Benchmark)
+{
+  struct function_counter_index index;
+  legacy_index legacy;
+  std::vector<std::string> hits;
+  std::vector<std::string> misses;
+  volatile int result = 0;
+  size_t i;
+  int j;
+
+  init_function_counter_index(&index, builtin_names, sizeof(const char *),
+   arraysize(builtin_names));
+  legacy_init(legacy);
+
+  for(i = 0; i < (size_t)arraysize(builtin_names); i++)
+  {
+    std::vector<std::string> expanded;
+    expand_pattern(expanded, builtin_names[i]);
+
+    for(j = 0; j < (int)expanded.size(); j++)
+      if(legacy_find(legacy, expanded[j].c_str()) >= 0)
+        hits.push_back(expanded[j]);
+  }
+
+  for(i = 0; i < (size_t)arraysize(user_names); i++)
+    misses.push_back(user_names[i]);
+
+  for(i = 0; i < 2; i++)
+  {
+    const std::vector<std::string> &names = i ? misses : hits;
+    const char *type = i ? "miss" : "hit";
+    size_t count = 0;
+    size_t k;
+
+    auto start = std::chrono::steady_clock::now();
+    for(j = 0; j < 200; j++)
+      for(k = 0; k < names.size(); k++, count++)
+        result += legacy_find(legacy, names[k].c_str());
+
+    auto middle = std::chrono::steady_clock::now();
+    for(j = 0; j < 200; j++)
+      for(k = 0; k < names.size(); k++)
+        result += find_function_counter_index(&index, names[k].c_str());
+
+    auto end = std::chrono::steady_clock::now();
+
+    double legacy_ns = std::chrono::duration<double, std::nano>(
+     middle - start).count() / count;
+    double hash_ns = std::chrono::duration<double, std::nano>(
+     end - middle).count() / count;
+
+    std::cerr << "  " << type << ": binary search " << legacy_ns
+     << "ns, hash " << hash_ns << "ns\n";
+  }
+  (void)result;
+}
+
+#endif /* UNIT_BENCHMARK */
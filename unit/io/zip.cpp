@@ -752,6 +752,46 @@ static const char *zip_get_contents(const zip_test_file_data &df, char *buf,
 
 #define ZIP_GET_CONTENTS(df) zip_get_contents(df, db64_ptr.get(), BUFFER_SIZE)
 
+/**
+ * Worker that doesn't run jobs until the archive waits on them, and then runs
+ * every job it has been given in reverse order. This shouldn't change the
+ * archive or the data read from it.
+ */
+struct zip_test_worker
+{
+  struct zip_worker worker;
+  struct zip_job *pending;
+  int total;
+
+  zip_test_worker(int max_jobs): pending(nullptr), total(0)
+  {
+    worker.start = start;
+    worker.wait = wait;
+    worker.max_jobs = max_jobs;
+  }
+
+  static void start(struct zip_worker *w, struct zip_job *job)
+  {
+    zip_test_worker *tw = reinterpret_cast<zip_test_worker *>(w);
+    job->done = false;
+    job->next = tw->pending;
+    tw->pending = job;
+    tw->total++;
+  }
+
+  static void wait(struct zip_worker *w, struct zip_job *job)
+  {
+    zip_test_worker *tw = reinterpret_cast<zip_test_worker *>(w);
+    while(!job->done && tw->pending)
+    {
+      struct zip_job *next = tw->pending;
+      tw->pending = next->next;
+      zip_run_job(next);
+      next->done = true;
+    }
+  }
+};
+
 UNITTEST(ZipRead)
 {
   std::unique_ptr<char> buffer_ptr(new char[BUFFER_SIZE]);
@@ -836,6 +876,114 @@ UNITTEST(ZipRead)
       FAIL("Add test zips with files to read!");
   }
 
+  SECTION(ReadFileWorker)
+  {
+    for(int i = 0; i < arraysize(raw_zip_data); i++)
+    {
+      const zip_test_data &d = raw_zip_data[i];
+      if(d.num_files)
+      {
+        zip_test_worker tw(3);
+        snprintf(desc, arraysize(desc), "%d", i);
+        has_files = true;
+        zp = zip_test_open(d);
+        ZIP_CHECK(d, zp);
+
+        result = zip_set_worker(zp, &tw.worker);
+        ASSERTEQX(result, ZIP_SUCCESS, desc);
+
+        int num_compressed = 0;
+        for(size_t j = 0; j < d.num_files; j++)
+        {
+          snprintf(desc2, arraysize(desc2), "%d file %zu", i, j);
+          const zip_test_file_data &df = d.files[j];
+          size_t real_length = 0;
+
+          if(df.method != ZIP_M_NONE && df.compressed_size)
+            num_compressed++;
+
+          // Streamed files should also be read from their job.
+          if((i + j) & 1)
+          {
+            result = zip_read_open_file_stream(zp, &real_length);
+            ASSERTEQX(result, ZIP_SUCCESS, desc2);
+            result = zread(buffer, real_length, zp);
+            ASSERTEQX(result, real_length ? ZIP_SUCCESS : ZIP_EOF, desc2);
+            result = zip_read_close_stream(zp);
+          }
+          else
+            result = zip_read_file(zp, buffer, BUFFER_SIZE, &real_length);
+
+          ASSERTEQX(result, ZIP_SUCCESS, desc2);
+          ASSERTEQX(real_length, df.uncompressed_size, desc2);
+
+          if(real_length)
+          {
+            const char *contents = ZIP_GET_CONTENTS(df);
+            cmp = memcmp(buffer, contents, real_length);
+            ASSERTEQX(cmp, 0, desc2);
+          }
+        }
+        result = zip_close(zp, nullptr);
+        ASSERTEQX(result, ZIP_SUCCESS, desc);
+        ASSERTEQX(tw.pending, nullptr, desc);
+
+        // Every compressed file should have been decompressed exactly once.
+        if(num_compressed)
+          ASSERT(tw.total > 0);
+        ASSERT(tw.total <= num_compressed);
+      }
+    }
+    if(!has_files)
+      FAIL("Add test zips with files to read!");
+  }
+
+  SECTION(SetPosition)
+  {
+    for(int i = 0; i < arraysize(raw_zip_data); i++)
+    {
+      const zip_test_data &d = raw_zip_data[i];
+      if(d.num_files)
+      {
+        snprintf(desc, arraysize(desc), "%d", i);
+        has_files = true;
+        zp = zip_test_open(d);
+        ZIP_CHECK(d, zp);
+
+        // Read the files backwards.
+        for(size_t j = d.num_files; j > 0; j--)
+        {
+          snprintf(desc2, arraysize(desc2), "%d file %zu", i, j - 1);
+          const zip_test_file_data &df = d.files[j - 1];
+          size_t real_length = 0;
+
+          result = zip_set_position(zp, j - 1);
+          ASSERTEQX(result, ZIP_SUCCESS, desc2);
+          ASSERTEQX(zp->pos, j - 1, desc2);
+
+          result = zip_read_file(zp, buffer, BUFFER_SIZE, &real_length);
+          ASSERTEQX(result, ZIP_SUCCESS, desc2);
+          ASSERTEQX(real_length, df.uncompressed_size, desc2);
+
+          if(real_length)
+          {
+            const char *contents = ZIP_GET_CONTENTS(df);
+            cmp = memcmp(buffer, contents, real_length);
+            ASSERTEQX(cmp, 0, desc2);
+          }
+        }
+
+        result = zip_set_position(zp, d.num_files);
+        ASSERTEQX(result, ZIP_EOF, desc);
+
+        result = zip_close(zp, nullptr);
+        ASSERTEQX(result, ZIP_SUCCESS, desc);
+      }
+    }
+    if(!has_files)
+      FAIL("Add test zips with files to read!");
+  }
+
   SECTION(ReadStream)
   {
     for(int i = 0; i < arraysize(raw_zip_data); i++)
@@ -1011,6 +1159,67 @@ UNITTEST(ZipWrite)
     }
   }
 
+  SECTION(WriteFileWorker)
+  {
+    const char *label = "Worker";
+    char *serial_buffer = (char *)cmalloc(32);
+    size_t serial_buffer_size = 32;
+    size_t serial_size;
+    uint32_t timestamp;
+
+    for(int i = 0; i < arraysize(raw_zip_data); i++)
+    {
+      const zip_test_data &d = raw_zip_data[i];
+      zip_test_worker tw(2);
+      snprintf(desc, arraysize(desc), "%s %d", label, i);
+
+      zp = zip_open_mem_write_ext((void **)&serial_buffer, &serial_buffer_size, 0);
+      ASSERTX(zp, desc);
+      timestamp = zp->header_timestamp;
+
+      for(size_t j = 0; j < d.num_files; j++)
+      {
+        const zip_test_file_data &df = d.files[j];
+        const char *contents = ZIP_GET_CONTENTS(df);
+        result = zip_write_file(zp, df.filename, (const void *)contents,
+         df.uncompressed_size, df.method);
+        ASSERTEQX(result, ZIP_SUCCESS, desc);
+      }
+      result = zip_close(zp, &serial_size);
+      ASSERTEQX(result, ZIP_SUCCESS, desc);
+
+      zp = zip_open_mem_write_ext((void **)&ext_buffer, &ext_buffer_size, 0);
+      ASSERTX(zp, desc);
+      zp->header_timestamp = timestamp;
+
+      result = zip_set_worker(zp, &tw.worker);
+      ASSERTEQX(result, ZIP_SUCCESS, desc);
+
+      for(size_t j = 0; j < d.num_files; j++)
+      {
+        const zip_test_file_data &df = d.files[j];
+        const char *contents = ZIP_GET_CONTENTS(df);
+        snprintf(desc2, arraysize(desc2), "%s %d %zu", label, i, j);
+        result = zip_write_file(zp, df.filename, (const void *)contents,
+         df.uncompressed_size, df.method);
+        ASSERTEQX(result, ZIP_SUCCESS, desc2);
+      }
+      result = zip_close(zp, &final_size);
+      ASSERTEQX(result, ZIP_SUCCESS, desc);
+      ASSERTEQX(tw.total, (int)d.num_files, desc);
+      ASSERTEQX(tw.pending, nullptr, desc);
+
+      // The output should be identical to writing without a worker.
+      ASSERTEQX(final_size, serial_size, desc);
+      int cmp = memcmp(ext_buffer, serial_buffer, final_size);
+      ASSERTEQX(cmp, 0, desc);
+
+      zp = zip_open_mem_read(ext_buffer, final_size);
+      VERIFY_BOILERPLATE(zp);
+    }
+    free(serial_buffer);
+  }
+
   SECTION(WriteStream)
   {
     for(int type = 0; type < 2; type++)
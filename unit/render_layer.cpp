@@ -0,0 +1,408 @@
+/* MegaZeux
+ *
+ * Copyright (C) 2020 Alice Rowan <petrifiedrowan@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * Check the 32bpp layer renderers against the slow reference renderer. Every
+ * vector kernel this CPU supports and the glyph cache must produce exactly the
+ * same pixels as the reference for MZX and SMZX layers, with and without a
+ * transparent color.
+ */
+
+#include "Unit.hpp"
+
+#define RENDER_LAYER_REFERENCE
+#include "../src/render_layer.cpp"
+
+#define LAYER_W 80
+#define LAYER_H 25
+
+// Kernel 0 is the template renderer used when there's no vector kernel.
+// The glyph cache goes after the vector kernels.
+#ifdef HAS_LAYER_SIMD
+#define CACHE_KERNEL NUM_LAYER_SIMD
+#else
+#define CACHE_KERNEL 1
+#endif
+#define NUM_KERNELS (CACHE_KERNEL + 1)
+
+static struct glyph_cache test_cache;
+
+static const char *kernel_name(int kernel)
+{
+  if(kernel == CACHE_KERNEL)
+    return "cache";
+
+#ifdef HAS_LAYER_SIMD
+  switch(kernel)
+  {
+    case LAYER_SIMD_SSE2_KERNEL:
+      return "sse2";
+    case LAYER_SIMD_AVX2_KERNEL:
+      return "avx2";
+    case LAYER_SIMD_NEON_KERNEL:
+      return "neon";
+  }
+#endif
+  return "template";
+}
+
+static boolean kernel_supported(int kernel)
+{
+  if(kernel == CACHE_KERNEL)
+    return true;
+
+#ifdef HAS_LAYER_SIMD
+  return !kernel || layer_simd_supported(kernel);
+#else
+  return !kernel;
+#endif
+}
+
+static void render_kernel(int kernel, Uint32 *pixels,
+ struct graphics_data *graphics, struct video_layer *layer)
+{
+  Uint32 pitch = SCREEN_PIX_W * sizeof(Uint32);
+
+  if(kernel == CACHE_KERNEL)
+  {
+    render_layer_cached(pixels, 32, pitch, graphics, layer, &test_cache,
+     layer->mode, layer->transparent_col != -1);
+    return;
+  }
+
+#ifdef HAS_LAYER_SIMD
+  if(kernel)
+  {
+    render_layer_simd(pixels, pitch, graphics, layer, kernel,
+     layer->mode, layer->transparent_col != -1);
+    return;
+  }
+#endif
+
+  render_layer_func(pixels, pitch, graphics, layer, 32, 32, layer->mode,
+   graphics->protected_pal_position, layer->transparent_col != -1, 0);
+}
+
+static void random_graphics(struct graphics_data *graphics)
+{
+  int i;
+
+  for(i = 0; i < arraysize(graphics->charset); i++)
+    graphics->charset[i] = rand();
+
+  // Make sure the fully transparent row shortcuts are hit.
+  for(i = 0; i < arraysize(graphics->charset); i += 5)
+    graphics->charset[i] = (i & 1) ? 0xFF : 0x00;
+
+  for(i = 0; i < arraysize(graphics->flat_intensity_palette); i++)
+    graphics->flat_intensity_palette[i] = (rand() << 16) ^ rand();
+
+  for(i = 0; i < arraysize(graphics->smzx_indices); i++)
+    graphics->smzx_indices[i] = rand() % 16;
+}
+
+/**
+ * 16bpp palettes never have anything in the upper bits, and the renderers
+ * don't expect them to.
+ */
+static void fix_palette(struct graphics_data *graphics, int bpp)
+{
+  int i;
+
+  if(bpp == 16)
+  {
+    for(i = 0; i < arraysize(graphics->flat_intensity_palette); i++)
+      graphics->flat_intensity_palette[i] &= 0xFFFF;
+
+    graphics->palette_version++;
+  }
+}
+
+static void random_layer(struct video_layer *layer, struct char_element *data,
+ int mode, boolean trans, int w, int h)
+{
+  int i;
+
+  layer->w = w;
+  layer->h = h;
+  layer->x = rand() % (SCREEN_PIX_W - w * CHAR_W + 1);
+  layer->y = rand() % (SCREEN_PIX_H - h * CHAR_H + 1);
+  layer->mode = mode;
+  layer->offset = rand() % 3 ? 0 : rand() % PROTECTED_CHARSET_POSITION;
+  layer->data = data;
+
+  // Use few enough colors that the transparent color actually shows up.
+  for(i = 0; i < w * h; i++)
+  {
+    data[i].char_value = rand() % 10 ? rand() % 512 : INVISIBLE_CHAR;
+    data[i].bg_color = rand() % 4 ? rand() % 4 : rand() % 32;
+    data[i].fg_color = rand() % 4 ? rand() % 4 : rand() % 32;
+  }
+
+  if(trans)
+    layer->transparent_col = mode ? rand() % 16 : rand() % 4;
+  else
+    layer->transparent_col = -1;
+}
+
+UNITTEST(Reference)
+{
+  static struct graphics_data graphics;
+  static struct char_element data[LAYER_W * LAYER_H];
+  static Uint32 base[SCREEN_PIX_W * SCREEN_PIX_H];
+  static Uint32 expected[SCREEN_PIX_W * SCREEN_PIX_H];
+  static Uint32 result[SCREEN_PIX_W * SCREEN_PIX_H];
+  struct video_layer layer;
+  int kernel;
+  int mode;
+  int trans;
+  int ppal;
+  int i;
+  int j;
+
+  srand(1234);
+  random_graphics(&graphics);
+
+  for(kernel = 0; kernel < NUM_KERNELS; kernel++)
+  {
+    if(!kernel_supported(kernel))
+      continue;
+
+    for(mode = 0; mode < 4; mode++)
+    {
+      for(trans = 0; trans < 2; trans++)
+      {
+        for(ppal = 16; ppal <= 256; ppal += 240)
+        {
+          // The protected palette is always at 256 in SMZX mode.
+          if(mode && ppal != 256)
+            continue;
+
+          // graphics.c does this when the protected palette moves.
+          graphics.protected_pal_position = ppal;
+          graphics.palette_version++;
+
+          for(i = 0; i < 50; i++)
+          {
+            random_layer(&layer, data, mode, trans,
+             rand() % LAYER_W + 1, rand() % LAYER_H + 1);
+
+            for(j = 0; j < arraysize(base); j++)
+              base[j] = (rand() << 16) ^ rand();
+
+            memcpy(expected, base, sizeof(base));
+            memcpy(result, base, sizeof(base));
+
+            reference_renderer(expected, SCREEN_PIX_W * sizeof(Uint32),
+             &graphics, &layer);
+            render_kernel(kernel, result, &graphics, &layer);
+
+            for(j = 0; j < arraysize(result); j++)
+            {
+              if(result[j] != expected[j])
+              {
+                char buf[128];
+                snprintf(buf, sizeof(buf),
+                 "%s mode=%d tcol=%d ppal=%d at (%d,%d)", kernel_name(kernel),
+                 mode, layer.transparent_col, ppal,
+                 j % SCREEN_PIX_W, j / SCREEN_PIX_W);
+                ASSERTEQX(result[j], expected[j], buf);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Banded rendering should be identical to drawing each layer in order over
+ * the whole screen, regardless of the number of threads or where the layers
+ * are. This includes layers that are partially offscreen or aren't aligned
+ * to char rows, which get split at the band edges.
+ */
+UNITTEST(Bands)
+{
+  static const int thread_counts[] = { 2, 3, 8, 0 };
+  static const int bpps[] = { 8, 16, 32 };
+  static struct graphics_data graphics;
+  static struct char_element data[8][LAYER_W * LAYER_H];
+  static Uint32 base[SCREEN_PIX_W * SCREEN_PIX_H];
+  static Uint32 expected[SCREEN_PIX_W * SCREEN_PIX_H];
+  static Uint32 result[SCREEN_PIX_W * SCREEN_PIX_H];
+  struct video_layer layers[8];
+  struct video_layer *sorted[8];
+  Uint32 pitch;
+  int b, t, j;
+  int i, k;
+
+  srand(4321);
+  random_graphics(&graphics);
+  graphics.protected_pal_position = 256;
+
+  for(b = 0; b < arraysize(bpps); b++)
+  {
+    pitch = SCREEN_PIX_W * bpps[b] / 8;
+    fix_palette(&graphics, bpps[b]);
+
+    for(i = 0; i < 20; i++)
+    {
+      for(k = 0; k < 8; k++)
+      {
+        random_layer(&layers[k], data[k], rand() % 4, rand() % 2,
+         rand() % LAYER_W + 1, rand() % LAYER_H + 1);
+
+        // Anywhere on or partially off the screen.
+        layers[k].x = rand() % (SCREEN_PIX_W + 200) - 200;
+        layers[k].y = rand() % (SCREEN_PIX_H + 100) - 100;
+        sorted[k] = &layers[k];
+      }
+
+      // The first layer is usually the board, which covers the screen.
+      random_layer(&layers[0], data[0], 0, false, SCREEN_W, SCREEN_H);
+
+      for(j = 0; j < arraysize(base); j++)
+        base[j] = (rand() << 16) ^ rand();
+
+      memcpy(expected, base, sizeof(base));
+      graphics.render_threads = 1;
+      render_layers(expected, bpps[b], pitch, &graphics, sorted, 8);
+
+      for(t = 0; t < arraysize(thread_counts); t++)
+      {
+        memcpy(result, base, sizeof(base));
+        graphics.render_threads = thread_counts[t];
+        render_layers(result, bpps[b], pitch, &graphics, sorted, 8);
+
+        if(memcmp(result, expected, sizeof(result)))
+        {
+          char buf[64];
+          snprintf(buf, sizeof(buf), "bpp=%d threads=%d", bpps[b],
+           thread_counts[t]);
+          FAIL(buf);
+        }
+      }
+    }
+  }
+  render_layers_free();
+}
+
+/**
+ * The glyph cache must redraw chars after they or the palette change, as long
+ * as the versions are bumped like graphics.c does. This also checks 16bpp,
+ * against the template renderer.
+ */
+UNITTEST(GlyphCache)
+{
+  static const int bpps[] = { 16, 32 };
+  static struct graphics_data graphics;
+  static struct char_element data[LAYER_W * LAYER_H];
+  static Uint32 expected[SCREEN_PIX_W * SCREEN_PIX_H];
+  static Uint32 result[SCREEN_PIX_W * SCREEN_PIX_H];
+  struct video_layer layer;
+  Uint32 pitch;
+  int b;
+  int mode;
+  int step;
+  int i;
+
+  srand(2468);
+  random_graphics(&graphics);
+  graphics.protected_pal_position = 256;
+
+  for(b = 0; b < arraysize(bpps); b++)
+  {
+    pitch = SCREEN_PIX_W * bpps[b] / 8;
+    fix_palette(&graphics, bpps[b]);
+
+    for(mode = 0; mode < 4; mode++)
+    {
+      random_layer(&layer, data, mode, rand() % 2, LAYER_W, LAYER_H);
+      layer.x = 0;
+      layer.y = 0;
+
+      // Fewer chars and colors, so more of them are repeated like in an
+      // actual game.
+      for(i = 0; i < LAYER_W * LAYER_H; i++)
+      {
+        if(data[i].char_value != INVISIBLE_CHAR)
+          data[i].char_value %= 32;
+
+        data[i].bg_color %= 4;
+        data[i].fg_color %= 4;
+      }
+
+      for(step = 0; step < 4; step++)
+      {
+        test_cache.hits = 0;
+        test_cache.misses = 0;
+
+        switch(step)
+        {
+          case 1:
+          {
+            // Change every char in use (and a few that aren't).
+            for(i = 0; i < PROTECTED_CHARSET_POSITION; i += 3)
+            {
+              graphics.charset[i * CHAR_SIZE + rand() % CHAR_SIZE] ^= 0x5A;
+              graphics.char_version[i]++;
+            }
+            break;
+          }
+
+          case 2:
+          {
+            for(i = 0; i < (int)arraysize(graphics.flat_intensity_palette); i++)
+              graphics.flat_intensity_palette[i] ^= 0x5AA5;
+
+            for(i = 0; i < (int)arraysize(graphics.smzx_indices); i++)
+              graphics.smzx_indices[i] = rand() % 16;
+
+            graphics.palette_version++;
+            break;
+          }
+        }
+
+        memset(expected, 0, sizeof(expected));
+        memset(result, 0, sizeof(result));
+
+        render_layer_func(expected, pitch, &graphics, &layer, bpps[b], 32,
+         layer.mode, graphics.protected_pal_position,
+         layer.transparent_col != -1, 0);
+
+        render_layer_cached(result, bpps[b], pitch, &graphics, &layer,
+         &test_cache, layer.mode, layer.transparent_col != -1);
+
+        if(memcmp(result, expected, sizeof(result)))
+        {
+          char buf[64];
+          snprintf(buf, sizeof(buf), "bpp=%d mode=%d step=%d", bpps[b], mode,
+           step);
+          FAIL(buf);
+        }
+
+        // Nothing changed since the last step, so this should mostly hit
+        // (there can still be a few collisions).
+        if(step == 3)
+          ASSERT(test_cache.hits > test_cache.misses * 4);
+      }
+    }
+  }
+}